@@ -0,0 +1,269 @@
+#include "Calibration.h"
+
+#include <algorithm>
+#include <cmath>
+
+double GammaFit::luminance(double level) const {
+    return minLuminance + (maxLuminance - minLuminance) * std::pow(std::clamp(level, 0.0, 1.0), gamma);
+}
+
+namespace {
+
+// Best offset and gain for a fixed gamma, returns the sum of squared residuals
+double solveOffsetGain(const PhotometerSample* samples, size_t count, double gamma, double& offset, double& gain) {
+    double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        double x = std::pow(std::clamp(samples[i].level, 0.0, 1.0), gamma);
+        double y = samples[i].luminance;
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+    }
+    double n = double(count);
+    double det = n * sxx - sx * sx;
+    gain = det != 0.0 ? (n * sxy - sx * sy) / det : 0.0;
+    offset = (sy - gain * sx) / n;
+
+    double error = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        double r = samples[i].luminance - (offset + gain * std::pow(std::clamp(samples[i].level, 0.0, 1.0), gamma));
+        error += r * r;
+    }
+    return error;
+}
+
+} // namespace
+
+GammaFit fitGamma(const PhotometerSample* samples, size_t count) {
+    GammaFit fit = { 0.0, 1.0, 2.2, 0.0 };
+    if (count < 2) {
+        return fit;
+    }
+
+    // The residual is unimodal in gamma for monotone readings
+    const double ratio = 0.61803398874989484820;
+    double a = 0.5, b = 5.0;
+    double offset, gain;
+    double c = b - ratio * (b - a);
+    double d = a + ratio * (b - a);
+    double fc = solveOffsetGain(samples, count, c, offset, gain);
+    double fd = solveOffsetGain(samples, count, d, offset, gain);
+    for (int iteration = 0; iteration < 60; ++iteration) {
+        if (fc < fd) {
+            b = d;
+            d = c;
+            fd = fc;
+            c = b - ratio * (b - a);
+            fc = solveOffsetGain(samples, count, c, offset, gain);
+        } else {
+            a = c;
+            c = d;
+            fc = fd;
+            d = a + ratio * (b - a);
+            fd = solveOffsetGain(samples, count, d, offset, gain);
+        }
+    }
+
+    fit.gamma = 0.5 * (a + b);
+    double error = solveOffsetGain(samples, count, fit.gamma, offset, gain);
+    fit.minLuminance = offset;
+    fit.maxLuminance = offset + gain;
+    fit.rmsError = std::sqrt(error / double(count));
+    return fit;
+}
+
+bool MonotoneSpline::fit(const PhotometerSample* samples, size_t count) {
+    std::vector<PhotometerSample> sorted(samples, samples + count);
+    std::sort(sorted.begin(), sorted.end(),
+              [](const PhotometerSample& a, const PhotometerSample& b) { return a.level < b.level; });
+
+    // Repeated readings at one level are averaged
+    levels.clear();
+    values.clear();
+    for (size_t i = 0; i < sorted.size();) {
+        size_t j = i;
+        double sum = 0.0;
+        for (; j < sorted.size() && sorted[j].level == sorted[i].level; ++j) {
+            sum += sorted[j].luminance;
+        }
+        levels.push_back(sorted[i].level);
+        values.push_back(sum / double(j - i));
+        i = j;
+    }
+
+    size_t n = levels.size();
+    tangents.assign(n, 0.0);
+    if (n < 2) {
+        return false;
+    }
+
+    std::vector<double> secants(n - 1);
+    for (size_t k = 0; k + 1 < n; ++k) {
+        secants[k] = (values[k + 1] - values[k]) / (levels[k + 1] - levels[k]);
+    }
+    tangents[0] = secants[0];
+    tangents[n - 1] = secants[n - 2];
+    for (size_t k = 1; k + 1 < n; ++k) {
+        tangents[k] = secants[k - 1] * secants[k] <= 0.0 ? 0.0 : 0.5 * (secants[k - 1] + secants[k]);
+    }
+
+    // Limit the tangents so no interval overshoots
+    for (size_t k = 0; k + 1 < n; ++k) {
+        if (secants[k] == 0.0) {
+            tangents[k] = tangents[k + 1] = 0.0;
+            continue;
+        }
+        double alpha = tangents[k] / secants[k];
+        double beta = tangents[k + 1] / secants[k];
+        double length = alpha * alpha + beta * beta;
+        if (length > 9.0) {
+            double tau = 3.0 / std::sqrt(length);
+            tangents[k] = tau * alpha * secants[k];
+            tangents[k + 1] = tau * beta * secants[k];
+        }
+    }
+    return true;
+}
+
+double MonotoneSpline::luminance(double level) const {
+    if (levels.empty()) {
+        return 0.0;
+    }
+    if (levels.size() == 1 || level <= levels.front()) {
+        return values.front();
+    }
+    if (level >= levels.back()) {
+        return values.back();
+    }
+
+    size_t k = std::upper_bound(levels.begin(), levels.end(), level) - levels.begin() - 1;
+    double h = levels[k + 1] - levels[k];
+    double t = (level - levels[k]) / h;
+    double t2 = t * t;
+    double t3 = t2 * t;
+    return (2.0 * t3 - 3.0 * t2 + 1.0) * values[k] + (t3 - 2.0 * t2 + t) * h * tangents[k] +
+           (-2.0 * t3 + 3.0 * t2) * values[k + 1] + (t3 - t2) * h * tangents[k + 1];
+}
+
+std::vector<float> invertLuminance(const std::function<double(double)>& model, uint32_t size) {
+    std::vector<float> lut(size, 0.0f);
+    if (size < 2) {
+        return lut;
+    }
+
+    double low = model(0.0);
+    double high = model(1.0);
+    for (uint32_t i = 0; i < size; ++i) {
+        double target = low + (high - low) * double(i) / double(size - 1);
+        // Bisection; 40 steps is far below one 16-bit code
+        double a = 0.0, b = 1.0;
+        for (int step = 0; step < 40; ++step) {
+            double mid = 0.5 * (a + b);
+            if (model(mid) < target) {
+                a = mid;
+            } else {
+                b = mid;
+            }
+        }
+        lut[i] = static_cast<float>(0.5 * (a + b));
+    }
+    return lut;
+}
+
+std::vector<float> gammaLut(const GammaFit& fit, uint32_t size) {
+    std::vector<float> lut(size, 0.0f);
+    if (size < 2) {
+        return lut;
+    }
+    for (uint32_t i = 0; i < size; ++i) {
+        double t = double(i) / double(size - 1);
+        lut[i] = static_cast<float>(std::pow(t, 1.0 / fit.gamma));
+    }
+    return lut;
+}
+
+std::vector<float> interleaveLut(const std::vector<float>& red, const std::vector<float>& green,
+                                 const std::vector<float>& blue) {
+    size_t size = std::min({ red.size(), green.size(), blue.size() });
+    std::vector<float> rgba(size * 4);
+    for (size_t i = 0; i < size; ++i) {
+        rgba[i * 4 + 0] = red[i];
+        rgba[i * 4 + 1] = green[i];
+        rgba[i * 4 + 2] = blue[i];
+        rgba[i * 4 + 3] = 1.0f;
+    }
+    return rgba;
+}
+
+std::vector<float> calibrateChannels(const PhotometerSample* const channels[3], size_t count,
+                                     CalibrationModel model, uint32_t size, GammaFit fits[3]) {
+    if (count < 2 || size < 2) {
+        return {};
+    }
+    std::vector<float> curves[3];
+    for (int c = 0; c < 3; ++c) {
+        if (model == CalibrationModel::Gamma) {
+            fits[c] = fitGamma(channels[c], count);
+            curves[c] = gammaLut(fits[c], size);
+            continue;
+        }
+
+        MonotoneSpline spline;
+        if (!spline.fit(channels[c], count)) {
+            return {};
+        }
+        fits[c] = { spline.minLuminance(), spline.maxLuminance(), 0.0, 0.0 };
+        curves[c] = invertLuminance([&spline](double level) { return spline.luminance(level); }, size);
+    }
+    return interleaveLut(curves[0], curves[1], curves[2]);
+}
+
+std::vector<float> lut3dFromCurves(const float* rgba1d, uint32_t size1d, uint32_t size3d) {
+    std::vector<float> rgba(size_t(size3d) * size3d * size3d * 4);
+    float* out = rgba.data();
+    float scale = 1.0f / float(std::max(size3d, 2u) - 1);
+    for (uint32_t b = 0; b < size3d; ++b) {
+        for (uint32_t g = 0; g < size3d; ++g) {
+            for (uint32_t r = 0; r < size3d; ++r) {
+                const float in[3] = { float(r) * scale, float(g) * scale, float(b) * scale };
+                applyLut1d(rgba1d, size1d, in, out);
+                out[3] = 1.0f;
+                out += 4;
+            }
+        }
+    }
+    return rgba;
+}
+
+void applyLut1d(const float* rgba, uint32_t size, const float in[3], float out[3]) {
+    for (int c = 0; c < 3; ++c) {
+        float x = std::clamp(in[c], 0.0f, 1.0f) * float(size - 1);
+        uint32_t i0 = static_cast<uint32_t>(std::floor(x));
+        uint32_t i1 = std::min(i0 + 1, size - 1);
+        float f = x - std::floor(x);
+        out[c] = rgba[i0 * 4 + c] + (rgba[i1 * 4 + c] - rgba[i0 * 4 + c]) * f;
+    }
+}
+
+void applyLut3d(const float* rgba, uint32_t size, const float in[3], float out[3]) {
+    uint32_t i0[3], i1[3];
+    float f[3];
+    for (int c = 0; c < 3; ++c) {
+        float x = std::clamp(in[c], 0.0f, 1.0f) * float(size - 1);
+        i0[c] = static_cast<uint32_t>(std::floor(x));
+        i1[c] = std::min(i0[c] + 1, size - 1);
+        f[c] = x - std::floor(x);
+    }
+
+    auto texel = [&](uint32_t r, uint32_t g, uint32_t b) { return rgba + ((size_t(b) * size + g) * size + r) * 4; };
+    for (int c = 0; c < 3; ++c) {
+        float c00 = texel(i0[0], i0[1], i0[2])[c] * (1.0f - f[0]) + texel(i1[0], i0[1], i0[2])[c] * f[0];
+        float c10 = texel(i0[0], i1[1], i0[2])[c] * (1.0f - f[0]) + texel(i1[0], i1[1], i0[2])[c] * f[0];
+        float c01 = texel(i0[0], i0[1], i1[2])[c] * (1.0f - f[0]) + texel(i1[0], i0[1], i1[2])[c] * f[0];
+        float c11 = texel(i0[0], i1[1], i1[2])[c] * (1.0f - f[0]) + texel(i1[0], i1[1], i1[2])[c] * f[0];
+        float c0 = c00 * (1.0f - f[1]) + c10 * f[1];
+        float c1 = c01 * (1.0f - f[1]) + c11 * f[1];
+        out[c] = c0 * (1.0f - f[2]) + c1 * f[2];
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Display calibration: turns photometer readings into the lookup tables the
+// output pass uses to linearize luminance. Stimuli are drawn in normalized
+// luminance (0 = darkest, 1 = brightest the display can show) and the LUT
+// maps each value to the drive level that produces it.
+
+// One photometer reading: normalized drive level (code / 255) and the
+// luminance measured at it, in any unit
+struct PhotometerSample {
+    double level;
+    double luminance;
+};
+
+// L(v) = minLuminance + (maxLuminance - minLuminance) * v^gamma
+struct GammaFit {
+    double minLuminance;
+    double maxLuminance;
+    double gamma;
+    double rmsError; // residual of the fit, in luminance units
+
+    double luminance(double level) const;
+};
+
+// Least-squares gamma fit; the offset and gain are solved exactly for each
+// gamma tried by a golden-section search over [0.5, 5]
+GammaFit fitGamma(const PhotometerSample* samples, size_t count);
+
+// Monotone cubic interpolation through the readings (Fritsch-Carlson), for
+// displays that do not follow a power law
+class MonotoneSpline {
+public:
+    // Returns false with fewer than two distinct levels
+    bool fit(const PhotometerSample* samples, size_t count);
+
+    double luminance(double level) const;
+    double minLuminance() const { return luminance(0.0); }
+    double maxLuminance() const { return luminance(1.0); }
+
+private:
+    std::vector<double> levels;
+    std::vector<double> values;
+    std::vector<double> tangents;
+};
+
+// Inverse of a luminance model as a 1D LUT of `size` drive levels: entry i
+// holds the level whose luminance is i / (size - 1) of the way from the
+// model's value at 0 to its value at 1. The model must be non-decreasing.
+std::vector<float> invertLuminance(const std::function<double(double)>& model, uint32_t size);
+
+// Closed-form inverse of a gamma fit
+std::vector<float> gammaLut(const GammaFit& fit, uint32_t size);
+
+// Interleave three channel curves (each `size` entries) into RGBA texels
+std::vector<float> interleaveLut(const std::vector<float>& red, const std::vector<float>& green,
+                                 const std::vector<float>& blue);
+
+// size^3 RGBA texels applying one curve per channel, red fastest; a
+// starting point for full color characterizations
+std::vector<float> lut3dFromCurves(const float* rgba1d, uint32_t size1d, uint32_t size3d);
+
+// How calibrateChannels() models each channel's readings
+enum class CalibrationModel : uint32_t {
+    Gamma = 0,  // fitGamma, inverted in closed form
+    Spline = 1, // MonotoneSpline, inverted by bisection
+};
+
+// Fit the R, G and B readings (`count` each) and build the interleaved 1D
+// LUT of `size` entries linearizing all three. fits receives each
+// channel's fit; with Spline only the end luminances are set, gamma and
+// rmsError are 0. Returns an empty LUT if a channel cannot be fitted.
+std::vector<float> calibrateChannels(const PhotometerSample* const channels[3], size_t count,
+                                     CalibrationModel model, uint32_t size, GammaFit fits[3]);
+
+// CPU references of the output shader's LUT lookups (linear and trilinear)
+void applyLut1d(const float* rgba, uint32_t size, const float in[3], float out[3]);
+void applyLut3d(const float* rgba, uint32_t size, const float in[3], float out[3]);
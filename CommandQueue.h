@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Bounded lock-free queues carrying commands into frame(). Items are stored
+// by value in a fixed ring, so neither side allocates; producers get false
+// instead of waiting when the ring is full, and the render loop drains
+// whatever is complete without ever blocking. A batch pushed in one call is
+// all-or-nothing and becomes visible to the consumer as a whole, so
+// frame() never applies half of one.
+
+constexpr size_t kQueueCacheLine = 64;
+
+// One producer thread, one consumer thread
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>, "items are copied in and out of the ring");
+
+public:
+    bool tryPush(const T& item) { return tryPush(&item, 1); }
+
+    bool tryPush(const T* items, size_t count) {
+        size_t tail = tailIndex.load(std::memory_order_relaxed);
+        size_t head = headIndex.load(std::memory_order_acquire);
+        if (count > Capacity - (tail - head)) {
+            return false;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            slots[(tail + i) & (Capacity - 1)] = items[i];
+        }
+        tailIndex.store(tail + count, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: apply(item) for each queued item, oldest first, up to `limit`
+    template <typename Apply>
+    size_t drain(Apply&& apply, size_t limit = SIZE_MAX) {
+        size_t head = headIndex.load(std::memory_order_relaxed);
+        size_t tail = tailIndex.load(std::memory_order_acquire);
+        size_t count = 0;
+        for (; head != tail && count < limit; ++head, ++count) {
+            apply(slots[head & (Capacity - 1)]);
+        }
+        headIndex.store(head, std::memory_order_release);
+        return count;
+    }
+
+private:
+    alignas(kQueueCacheLine) std::atomic<size_t> headIndex{ 0 };
+    alignas(kQueueCacheLine) std::atomic<size_t> tailIndex{ 0 };
+    alignas(kQueueCacheLine) T slots[Capacity];
+};
+
+// Any number of producer threads, one consumer thread. Each cell carries a
+// sequence number saying whose turn it is (Vyukov's bounded queue);
+// producers claim a run of cells with one compare-and-swap.
+template <typename T, size_t Capacity>
+class MpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>, "items are copied in and out of the ring");
+
+public:
+    MpscQueue() {
+        for (size_t i = 0; i < Capacity; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool tryPush(const T& item) { return tryPush(&item, 1); }
+
+    bool tryPush(const T* items, size_t count) {
+        if (count == 0) {
+            return true;
+        }
+        if (count > Capacity) {
+            return false;
+        }
+        size_t position = enqueueIndex.load(std::memory_order_relaxed);
+        while (true) {
+            // The consumer frees cells in order, so if the last cell of the
+            // run is free, all of them are
+            Cell& last = cells[(position + count - 1) & (Capacity - 1)];
+            size_t sequence = last.sequence.load(std::memory_order_acquire);
+            intptr_t difference = intptr_t(sequence) - intptr_t(position + count - 1);
+            if (difference == 0) {
+                if (enqueueIndex.compare_exchange_weak(position, position + count, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false; // full
+            } else {
+                position = enqueueIndex.load(std::memory_order_relaxed);
+            }
+        }
+
+        for (size_t i = 0; i < count; ++i) {
+            cells[(position + i) & (Capacity - 1)].value = items[i];
+        }
+        // Publish back to front: once the consumer sees the first cell, the
+        // rest of the batch is already visible
+        for (size_t i = count; i-- > 0;) {
+            cells[(position + i) & (Capacity - 1)].sequence.store(position + i + 1, std::memory_order_release);
+        }
+        return true;
+    }
+
+    template <typename Apply>
+    size_t drain(Apply&& apply, size_t limit = SIZE_MAX) {
+        size_t count = 0;
+        for (; count < limit; ++count, ++dequeueIndex) {
+            Cell& cell = cells[dequeueIndex & (Capacity - 1)];
+            if (cell.sequence.load(std::memory_order_acquire) != dequeueIndex + 1) {
+                break;
+            }
+            apply(cell.value);
+            cell.sequence.store(dequeueIndex + Capacity, std::memory_order_release);
+        }
+        return count;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    alignas(kQueueCacheLine) std::atomic<size_t> enqueueIndex{ 0 };
+    alignas(kQueueCacheLine) size_t dequeueIndex = 0; // consumer only
+    alignas(kQueueCacheLine) Cell cells[Capacity];
+};
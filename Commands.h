@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Dither.h"
+#include "Dots.h"
+#include "Filter.h"
+#include "Noise.h"
+#include "Procedural.h"
+
+// Changes to the schedule and stimulus parameters sent to the render loop
+// through a CommandQueue; frame() applies them in order before drawing.
+enum class CommandType : uint32_t {
+    ShowImage = 0,     // switch back to the loaded image
+    SetPattern = 1,    // pattern
+    SetNoise = 2,      // noise, flag = animated
+    SetDots = 3,       // dots, restarts the field
+    SetStimulus = 4,   // stimulus: transform, opacity, luminance
+    SetFilter = 5,     // filter
+    SetOutputMode = 6, // output, flag = temporal dithering
+    Callback = 7,      // callback: run(userData) on the render thread, e.g. to swap resources
+};
+
+struct StimulusCommand {
+    float transform[16]; // column-major
+    float opacity;
+    float luminance;
+};
+
+struct FilterCommand {
+    FilterType type;
+    float sigma;
+};
+
+struct OutputCommand {
+    OutputMode mode;
+    float weights[3]; // channel luminance weights
+};
+
+struct CallbackCommand {
+    void (*run)(void* userData);
+    void* userData;
+};
+
+// Plain data, so commands are copied through the queue without allocating
+struct Command {
+    CommandType type;
+    uint32_t flag;
+    union {
+        PatternUniforms pattern;
+        NoiseUniforms noise;
+        DotUniforms dots;
+        StimulusCommand stimulus;
+        FilterCommand filter;
+        OutputCommand output;
+        CallbackCommand callback;
+    };
+};
@@ -0,0 +1,166 @@
+#include "ContentHash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "Parallel.h"
+
+const char* const contentHashShaderCode = R"(
+@group(0) @binding(0) var image: texture_2d<f32>;
+@group(0) @binding(1) var<storage, read_write> sums: array<atomic<u32>, 2>;
+
+// Workgroup memory starts zeroed
+var<workgroup> partial: array<atomic<u32>, 2>;
+
+fn mix32(value: u32) -> u32 {
+    var h = value;
+    h ^= h >> 16u;
+    h *= 0x7feb352du;
+    h ^= h >> 15u;
+    h *= 0x846ca68bu;
+    h ^= h >> 16u;
+    return h;
+}
+
+@compute @workgroup_size(16, 16)
+fn main(@builtin(global_invocation_id) id: vec3<u32>, @builtin(local_invocation_index) local: u32) {
+    let size = textureDimensions(image);
+    if (id.x < size.x && id.y < size.y) {
+        let c = vec4<u32>(round(textureLoad(image, vec2<i32>(id.xy), 0) * 255.0));
+        let word = c.r | (c.g << 8u) | (c.b << 16u) | (c.a << 24u);
+        let index = id.y * size.x + id.x;
+        atomicAdd(&partial[0], mix32(word ^ mix32(index)));
+        atomicAdd(&partial[1], mix32(word + mix32(index ^ 0x9e3779b9u)));
+    }
+    workgroupBarrier();
+
+    if (local == 0u) {
+        atomicAdd(&sums[0], atomicLoad(&partial[0]));
+        atomicAdd(&sums[1], atomicLoad(&partial[1]));
+    }
+}
+)";
+
+namespace {
+
+inline uint32_t mix32(uint32_t h) {
+    h ^= h >> 16;
+    h *= 0x7feb352du;
+    h ^= h >> 15;
+    h *= 0x846ca68bu;
+    h ^= h >> 16;
+    return h;
+}
+
+} // namespace
+
+uint64_t contentHash(const uint8_t* rgba, uint32_t width, uint32_t height) {
+    return contentHash(rgba, width, height, parallelChunks(size_t(width) * height, 1 << 16));
+}
+
+uint64_t contentHash(const uint8_t* rgba, uint32_t width, uint32_t height, size_t stripes) {
+    size_t count = size_t(width) * height;
+    stripes = std::max<size_t>(stripes, 1);
+    std::vector<uint32_t> partial(stripes * 2, 0);
+    parallelFor(stripes, 1, [&](size_t, size_t firstStripe, size_t endStripe) {
+        for (size_t stripe = firstStripe; stripe < endStripe; ++stripe) {
+            uint32_t low = 0;
+            uint32_t high = 0;
+            for (size_t i = count * stripe / stripes; i < count * (stripe + 1) / stripes; ++i) {
+                uint32_t word;
+                std::memcpy(&word, rgba + i * 4, 4); // little endian, like the shader's packing
+                uint32_t index = static_cast<uint32_t>(i);
+                low += mix32(word ^ mix32(index));
+                high += mix32(word + mix32(index ^ 0x9e3779b9u));
+            }
+            partial[stripe * 2] = low;
+            partial[stripe * 2 + 1] = high;
+        }
+    });
+
+    uint32_t low = 0;
+    uint32_t high = 0;
+    for (size_t i = 0; i < partial.size(); i += 2) {
+        low += partial[i];
+        high += partial[i + 1];
+    }
+    return uint64_t(high) << 32 | low;
+}
+
+void FrameHasher::init(const wgpu::Device& device, uint32_t ringSize, size_t historySize) {
+    wgpu::BufferDescriptor desc = {};
+    desc.label = "Content hash sums";
+    desc.size = 2 * sizeof(uint32_t);
+    desc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc | wgpu::BufferUsage::CopyDst;
+    sumBuffer = device.CreateBuffer(&desc);
+
+    desc.label = "Content hash readback";
+    desc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::MapRead;
+    slots.assign(ringSize > 0 ? ringSize : 1, Slot());
+    for (Slot& slot : slots) {
+        slot.owner = this;
+        slot.buffer = device.CreateBuffer(&desc);
+    }
+    recording = nullptr;
+    cursor = 0;
+
+    history.assign(historySize > 0 ? historySize : 1, Record());
+    count = 0;
+    droppedFrames = 0;
+}
+
+bool FrameHasher::begin(uint64_t frameIndex, double vsyncTime) {
+    for (size_t i = 0; i < slots.size(); ++i) {
+        Slot& slot = slots[(cursor + i) % slots.size()];
+        if (!slot.busy) {
+            slot.busy = true;
+            slot.frameIndex = frameIndex;
+            slot.vsyncTime = vsyncTime;
+            recording = &slot;
+            cursor = (cursor + i + 1) % slots.size();
+            return true;
+        }
+    }
+    droppedFrames++;
+    return false;
+}
+
+void FrameHasher::encodeClear(wgpu::CommandEncoder& encoder) {
+    encoder.ClearBuffer(sumBuffer, 0, 2 * sizeof(uint32_t));
+}
+
+void FrameHasher::encodeCopy(wgpu::CommandEncoder& encoder) {
+    if (recording) {
+        encoder.CopyBufferToBuffer(sumBuffer, 0, recording->buffer, 0, 2 * sizeof(uint32_t));
+    }
+}
+
+void FrameHasher::submitted() {
+    if (!recording) {
+        return;
+    }
+    recording->buffer.MapAsync(wgpu::MapMode::Read, 0, 2 * sizeof(uint32_t), onMapped, recording);
+    recording = nullptr;
+}
+
+void FrameHasher::onMapped(WGPUBufferMapAsyncStatus status, void* userdata) {
+    // Maps resolve in submission order, so records stay in frame order
+    auto* slot = static_cast<Slot*>(userdata);
+    FrameHasher* owner = slot->owner;
+    if (status == WGPUBufferMapAsyncStatus_Success) {
+        uint32_t sums[2];
+        std::memcpy(sums, slot->buffer.GetConstMappedRange(0, sizeof(sums)), sizeof(sums));
+
+        Record& record = owner->history[owner->count % owner->history.size()];
+        record.frameIndex = slot->frameIndex;
+        record.vsyncTime = slot->vsyncTime;
+        record.hash = uint64_t(sums[1]) << 32 | sums[0];
+        owner->count++;
+    } else {
+        std::cerr << "Content hash readback failed to map." << std::endl;
+        owner->droppedFrames++;
+    }
+    slot->buffer.Unmap();
+    slot->busy = false;
+}
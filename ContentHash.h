@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <webgpu/webgpu_cpp.h>
+
+// 64-bit content hash of an 8-bit RGBA frame. Each pixel word
+// (r | g << 8 | b << 16 | a << 24) is mixed with its index by two
+// different 32-bit finalizers and the results are summed modulo 2^32, giving
+// the low and high halves. Sums commute, so the GPU can reduce with atomics
+// in any order and still match contentHash() bit for bit, while moving or
+// changing any pixel changes the hash.
+constexpr uint32_t kHashWorkgroupSize = 16; // 16 x 16 pixels per workgroup
+
+// Compute shader: group 0 holds the 8-bit frame (binding 0) and two atomic
+// u32 sums (binding 1, storage, cleared before the dispatch)
+extern const char* const contentHashShaderCode;
+
+// CPU equivalent over tightly packed RGBA rows, top row first
+uint64_t contentHash(const uint8_t* rgba, uint32_t width, uint32_t height);
+// The same hash with the pixels split into `stripes` ranges that are summed
+// separately, in parallel, and then combined; contentHash() uses one per worker
+uint64_t contentHash(const uint8_t* rgba, uint32_t width, uint32_t height, size_t stripes);
+
+// Reads the per-frame hash back from the GPU without stalling and keeps a
+// log of the most recent ones. Like FrameCapture, a small ring of MapRead
+// buffers lets each frame's sums be mapped a few frames later; frames that
+// find every buffer in flight go unhashed and are counted.
+class FrameHasher {
+public:
+    struct Record {
+        uint64_t frameIndex = 0;
+        double vsyncTime = 0.0; // requestAnimationFrame timestamp, ms
+        uint64_t hash = 0;
+    };
+
+    void init(const wgpu::Device& device, uint32_t ringSize = 8, size_t historySize = 4096);
+
+    // Storage buffer the shader accumulates into
+    const wgpu::Buffer& sums() const { return sumBuffer; }
+
+    // Reserve a readback buffer for this frame; false if none is free
+    bool begin(uint64_t frameIndex, double vsyncTime);
+    // Clear the sums before the dispatch and copy them out after it
+    void encodeClear(wgpu::CommandEncoder& encoder);
+    void encodeCopy(wgpu::CommandEncoder& encoder);
+    // After queue.Submit: start mapping the buffer
+    void submitted();
+
+    // Hashes in frame order; frames that were not rendered have no entry
+    uint64_t total() const { return count; }
+    size_t size() const { return count < history.size() ? size_t(count) : history.size(); }
+    // i = 0 is the oldest retained record
+    const Record& at(size_t i) const { return history[(count - size() + i) % history.size()]; }
+    uint64_t dropped() const { return droppedFrames; }
+
+private:
+    struct Slot {
+        FrameHasher* owner = nullptr;
+        wgpu::Buffer buffer;
+        bool busy = false;
+        uint64_t frameIndex = 0;
+        double vsyncTime = 0.0;
+    };
+
+    static void onMapped(WGPUBufferMapAsyncStatus status, void* userdata);
+
+    wgpu::Buffer sumBuffer;
+    std::vector<Slot> slots; // sized once in init; map callbacks point into it
+    Slot* recording = nullptr;
+    size_t cursor = 0;
+    std::vector<Record> history;
+    uint64_t count = 0;
+    uint64_t droppedFrames = 0;
+};
@@ -0,0 +1,65 @@
+#include "ControlBlock.h"
+
+#include <cstring>
+
+namespace {
+
+static_assert(sizeof(ControlRecord) == kControlRecordWords * 4, "records are read as 32-bit words by JS");
+static_assert(sizeof(PatternUniforms) <= sizeof(ControlRecord::payload), "pattern does not fit a record");
+static_assert(sizeof(NoiseUniforms) <= sizeof(ControlRecord::payload), "noise does not fit a record");
+static_assert(sizeof(DotUniforms) <= sizeof(ControlRecord::payload), "dots do not fit a record");
+static_assert(sizeof(StimulusCommand) <= sizeof(ControlRecord::payload), "stimulus does not fit a record");
+static_assert(sizeof(FilterCommand) <= sizeof(ControlRecord::payload), "filter does not fit a record");
+static_assert(sizeof(OutputCommand) <= sizeof(ControlRecord::payload), "output mode does not fit a record");
+
+template <typename T>
+void copyPayload(T& out, const ControlRecord& record) {
+    std::memcpy(&out, record.payload, sizeof(T));
+}
+
+bool decode(const ControlRecord& record, Command& command) {
+    command.type = static_cast<CommandType>(record.type);
+    command.flag = record.flag;
+    switch (command.type) {
+    case CommandType::ShowImage:
+        return true;
+    case CommandType::SetPattern:
+        copyPayload(command.pattern, record);
+        return command.pattern.type <= static_cast<uint32_t>(PatternType::Plaid);
+    case CommandType::SetNoise:
+        copyPayload(command.noise, record);
+        return command.noise.type <= static_cast<uint32_t>(NoiseType::Mondrian);
+    case CommandType::SetDots:
+        copyPayload(command.dots, record);
+        return command.dots.count > 0;
+    case CommandType::SetStimulus:
+        copyPayload(command.stimulus, record);
+        return true;
+    case CommandType::SetFilter:
+        copyPayload(command.filter, record);
+        return command.filter.type <= FilterType::HighPass;
+    case CommandType::SetOutputMode:
+        copyPayload(command.output, record);
+        return command.output.mode <= OutputMode::BitStealDither;
+    default:
+        return false;
+    }
+}
+
+} // namespace
+
+size_t decodeControlRecords(const ControlRecord* records, size_t count, Command* commands, uint32_t* rejected) {
+    size_t written = 0;
+    uint32_t skipped = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (decode(records[i], commands[written])) {
+            written++;
+        } else {
+            skipped++;
+        }
+    }
+    if (rejected) {
+        *rejected = skipped;
+    }
+    return written;
+}
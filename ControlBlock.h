@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Commands.h"
+
+// Shared-memory control surface for JavaScript. Instead of one exported call
+// per parameter, JS writes fixed-size records straight into a block in the
+// wasm heap through typed-array views and makes one call per frame to hand
+// the whole batch to the render loop.
+//
+// Record layout, 20 little-endian 32-bit words:
+//   word 0       CommandType
+//   word 1       flag (SetNoise: animated, SetOutputMode: temporal dithering)
+//   words 2..19  payload, the fields of the command's struct in declaration
+//                order: PatternUniforms, NoiseUniforms, DotUniforms,
+//                StimulusCommand, FilterCommand or OutputCommand
+constexpr uint32_t kControlVersion = 1;
+constexpr uint32_t kControlRecordWords = 20;
+constexpr uint32_t kControlPayloadWords = kControlRecordWords - 2;
+constexpr uint32_t kControlCapacity = 256;
+
+struct ControlRecord {
+    uint32_t type;
+    uint32_t flag;
+    uint32_t payload[kControlPayloadWords]; // floats as their bit patterns
+};
+
+struct ControlBlock {
+    uint32_t version = kControlVersion; // checked by JS before writing
+    uint32_t recordWords = kControlRecordWords;
+    uint32_t capacity = kControlCapacity;
+    uint32_t count = 0;    // records written by JS, cleared once they are queued
+    uint32_t rejected = 0; // records skipped by the last decode
+    uint32_t padding[3];
+    ControlRecord records[kControlCapacity];
+};
+
+// Turn records into commands, skipping unknown types, out-of-range enums and
+// callbacks (JS has no function pointers to give). Returns the number of
+// commands written to `commands`, which has room for `count`.
+size_t decodeControlRecords(const ControlRecord* records, size_t count, Command* commands, uint32_t* rejected);
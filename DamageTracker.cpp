@@ -0,0 +1,62 @@
+#include "DamageTracker.h"
+
+#include <algorithm>
+#include <cmath>
+
+void DamageTracker::resize(uint32_t width, uint32_t height) {
+    targetWidth = width;
+    targetHeight = height;
+    invalidateAll();
+}
+
+void DamageTracker::invalidateAll() {
+    region = { 0, 0, targetWidth, targetHeight };
+}
+
+void DamageTracker::invalidate(const PixelRect& rect) {
+    uint32_t x0 = std::min(rect.x, targetWidth);
+    uint32_t y0 = std::min(rect.y, targetHeight);
+    uint32_t x1 = std::min(rect.x + rect.width, targetWidth);
+    uint32_t y1 = std::min(rect.y + rect.height, targetHeight);
+    if (x1 <= x0 || y1 <= y0) {
+        return;
+    }
+
+    if (!region.empty()) {
+        x0 = std::min(x0, region.x);
+        y0 = std::min(y0, region.y);
+        x1 = std::max(x1, region.x + region.width);
+        y1 = std::max(y1, region.y + region.height);
+    }
+    region = { x0, y0, x1 - x0, y1 - y0 };
+}
+
+PixelRect DamageTracker::ndcToPixels(float minX, float minY, float maxX, float maxY, float pad) const {
+    // NDC y points up, pixel rows go down
+    float left = (minX * 0.5f + 0.5f) * targetWidth - pad;
+    float right = (maxX * 0.5f + 0.5f) * targetWidth + pad;
+    float top = (0.5f - maxY * 0.5f) * targetHeight - pad;
+    float bottom = (0.5f - minY * 0.5f) * targetHeight + pad;
+
+    left = std::clamp(std::floor(left), 0.0f, float(targetWidth));
+    right = std::clamp(std::ceil(right), 0.0f, float(targetWidth));
+    top = std::clamp(std::floor(top), 0.0f, float(targetHeight));
+    bottom = std::clamp(std::ceil(bottom), 0.0f, float(targetHeight));
+    if (right <= left || bottom <= top) {
+        return {};
+    }
+    return { uint32_t(left), uint32_t(top), uint32_t(right - left), uint32_t(bottom - top) };
+}
+
+void DamageTracker::invalidateNdc(float minX, float minY, float maxX, float maxY, float pad) {
+    PixelRect rect = ndcToPixels(minX, minY, maxX, maxY, pad);
+    if (!rect.empty()) {
+        invalidate(rect);
+    }
+}
+
+bool DamageTracker::containsNdc(float minX, float minY, float maxX, float maxY) const {
+    PixelRect rect = ndcToPixels(minX, minY, maxX, maxY, 1.0f);
+    return rect.empty() || (rect.x >= region.x && rect.y >= region.y && rect.x + rect.width <= region.x + region.width &&
+                            rect.y + rect.height <= region.y + region.height);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+// Axis-aligned rectangle in target pixels
+struct PixelRect {
+    uint32_t x = 0;
+    uint32_t y = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    bool empty() const { return width == 0 || height == 0; }
+    uint64_t area() const { return uint64_t(width) * height; }
+};
+
+// Accumulates the region of the render target that must be redrawn.
+// Nothing dirty means the previous frame is still on screen and the frame
+// can skip encoding and submission entirely.
+class DamageTracker {
+public:
+    void resize(uint32_t width, uint32_t height);
+
+    void invalidateAll();
+    void invalidate(const PixelRect& rect);
+
+    // Invalidate the pixels covered by an NDC-space box, padded by one pixel
+    // so bilinear filtering at the edges is redrawn too, or by `pad` pixels
+    void invalidateNdc(float minX, float minY, float maxX, float maxY, float pad = 1.0f);
+
+    // True when everything invalidateNdc() would mark for the box is
+    // already inside the damage
+    bool containsNdc(float minX, float minY, float maxX, float maxY) const;
+
+    bool dirty() const { return !region.empty(); }
+    // Redraw everything when the damage covers most of the target anyway
+    bool full() const { return region.area() * 2 > targetArea(); }
+    uint64_t targetArea() const { return uint64_t(targetWidth) * targetHeight; }
+    const PixelRect& bounds() const { return region; }
+
+    void clear() { region = {}; }
+
+private:
+    PixelRect ndcToPixels(float minX, float minY, float maxX, float maxY, float pad) const;
+
+    uint32_t targetWidth = 0;
+    uint32_t targetHeight = 0;
+    PixelRect region;
+};
@@ -0,0 +1,304 @@
+#include "Dither.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#include "Noise.h"
+
+const char* const outputShaderCode = R"(
+struct OutputUniforms {
+    mode: u32,
+    noiseSize: u32,
+    temporalOffset: f32,
+    lut: u32,
+    weights: vec4<f32>,
+    levels: array<vec4<f32>, 8>,
+};
+
+@group(0) @binding(0) var sceneTexture: texture_2d<f32>;
+@group(0) @binding(1) var blueNoise: texture_2d<f32>;
+@group(0) @binding(2) var<uniform> settings: OutputUniforms;
+@group(0) @binding(3) var lut1d: texture_2d<f32>;
+@group(0) @binding(4) var lut3d: texture_3d<f32>;
+
+// The LUTs are rgba32float, which is not filterable, so interpolate by hand
+fn applyLut1d(c: vec3<f32>) -> vec3<f32> {
+    let last = i32(textureDimensions(lut1d).x) - 1;
+    let x = c * f32(last);
+    let i0 = vec3<i32>(floor(x));
+    let i1 = min(i0 + 1, vec3<i32>(last));
+    let f = x - floor(x);
+    return vec3<f32>(
+        mix(textureLoad(lut1d, vec2<i32>(i0.r, 0), 0).r, textureLoad(lut1d, vec2<i32>(i1.r, 0), 0).r, f.r),
+        mix(textureLoad(lut1d, vec2<i32>(i0.g, 0), 0).g, textureLoad(lut1d, vec2<i32>(i1.g, 0), 0).g, f.g),
+        mix(textureLoad(lut1d, vec2<i32>(i0.b, 0), 0).b, textureLoad(lut1d, vec2<i32>(i1.b, 0), 0).b, f.b)
+    );
+}
+
+fn applyLut3d(c: vec3<f32>) -> vec3<f32> {
+    let last = i32(textureDimensions(lut3d).x) - 1;
+    let x = c * f32(last);
+    let i0 = vec3<i32>(floor(x));
+    let i1 = min(i0 + 1, vec3<i32>(last));
+    let f = x - floor(x);
+    let c00 = mix(textureLoad(lut3d, vec3<i32>(i0.x, i0.y, i0.z), 0).rgb, textureLoad(lut3d, vec3<i32>(i1.x, i0.y, i0.z), 0).rgb, f.x);
+    let c10 = mix(textureLoad(lut3d, vec3<i32>(i0.x, i1.y, i0.z), 0).rgb, textureLoad(lut3d, vec3<i32>(i1.x, i1.y, i0.z), 0).rgb, f.x);
+    let c01 = mix(textureLoad(lut3d, vec3<i32>(i0.x, i0.y, i1.z), 0).rgb, textureLoad(lut3d, vec3<i32>(i1.x, i0.y, i1.z), 0).rgb, f.x);
+    let c11 = mix(textureLoad(lut3d, vec3<i32>(i0.x, i1.y, i1.z), 0).rgb, textureLoad(lut3d, vec3<i32>(i1.x, i1.y, i1.z), 0).rgb, f.x);
+    return mix(mix(c00, c10, f.y), mix(c01, c11, f.y), f.z);
+}
+
+fn threshold(p: vec2<u32>) -> f32 {
+    let n = textureLoad(blueNoise, vec2<i32>(p % vec2<u32>(settings.noiseSize)), 0).r;
+    let d = n + settings.temporalOffset;
+    return d - floor(d);
+}
+
+fn bitSteal(color: vec3<f32>, t: f32) -> vec3<f32> {
+    // Each channel keeps its own base code, so colored stimuli keep their
+    // hue; the sub-code remainders are pooled by luminance
+    let s = color * 255.0;
+    let base = floor(s);
+    let f = dot(s - base, settings.weights.rgb);
+
+    var k = 0u;
+    for (var i = 1u; i < 7u; i++) {
+        if (settings.levels[i].w <= f) {
+            k = i;
+        }
+    }
+    let lo = settings.levels[k];
+    let hi = settings.levels[k + 1u];
+    let delta = select(lo.xyz, hi.xyz, f - lo.w > t * (hi.w - lo.w));
+    return base + delta;
+}
+
+@fragment
+fn main(@builtin(position) position: vec4<f32>) -> @location(0) vec4<f32> {
+    let p = vec2<u32>(position.xy);
+    var color = clamp(textureLoad(sceneTexture, vec2<i32>(p), 0).rgb, vec3<f32>(0.0), vec3<f32>(1.0));
+
+    // Linearize: normalized luminance to drive level
+    if (settings.lut == 1u) {
+        color = applyLut1d(color);
+    } else if (settings.lut == 2u) {
+        color = applyLut3d(color);
+    }
+
+    var codes: vec3<f32>;
+    switch settings.mode {
+        case 1u: {
+            codes = floor(color * 255.0 + threshold(p));
+        }
+        case 2u: {
+            codes = bitSteal(color, 0.5);
+        }
+        case 3u: {
+            codes = bitSteal(color, threshold(p));
+        }
+        default: {
+            codes = floor(color * 255.0 + 0.5);
+        }
+    }
+    // code / 255 converts back to exactly that UNORM8 code
+    return vec4<f32>(clamp(codes, vec3<f32>(0.0), vec3<f32>(255.0)) / 255.0, 1.0);
+}
+)";
+
+OutputUniforms makeOutputUniforms(OutputMode mode, float lumR, float lumG, float lumB, uint32_t noiseSize) {
+    OutputUniforms params = {};
+    params.mode = static_cast<uint32_t>(mode);
+    params.noiseSize = noiseSize;
+
+    float total = lumR + lumG + lumB;
+    params.weights[0] = lumR / total;
+    params.weights[1] = lumG / total;
+    params.weights[2] = lumB / total;
+
+    // All eight ways of adding one code to a subset of the channels
+    std::array<std::array<float, 4>, 8> levels;
+    for (uint32_t i = 0; i < 8; ++i) {
+        float dr = float(i & 1u);
+        float dg = float((i >> 1) & 1u);
+        float db = float((i >> 2) & 1u);
+        levels[i] = { dr, dg, db, dr * params.weights[0] + dg * params.weights[1] + db * params.weights[2] };
+    }
+    std::sort(levels.begin(), levels.end(), [](const auto& a, const auto& b) { return a[3] < b[3]; });
+    // Pin the ends so rounding in the weights cannot reorder them
+    levels[0][3] = 0.0f;
+    levels[7][3] = 1.0f;
+
+    for (uint32_t i = 0; i < 8; ++i) {
+        std::copy(levels[i].begin(), levels[i].end(), params.levels[i]);
+    }
+    return params;
+}
+
+float temporalDitherOffset(uint32_t frame) {
+    const double golden = 0.61803398874989484820;
+    double offset = double(frame) * golden;
+    return static_cast<float>(offset - std::floor(offset));
+}
+
+std::vector<float> generateBlueNoise(uint32_t size, uint32_t seed) {
+    const uint32_t n = size * size;
+    const float sigma = 1.5f;
+
+    // Toroidal Gaussian energy of one point, indexed by wrapped offset
+    std::vector<float> kernel(n);
+    for (uint32_t dy = 0; dy < size; ++dy) {
+        for (uint32_t dx = 0; dx < size; ++dx) {
+            float x = float(std::min(dx, size - dx));
+            float y = float(std::min(dy, size - dy));
+            kernel[dy * size + dx] = std::exp(-(x * x + y * y) / (2.0f * sigma * sigma));
+        }
+    }
+
+    std::vector<uint8_t> pattern(n, 0);
+    std::vector<float> energy(n, 0.0f);
+
+    auto toggle = [&](uint32_t index, bool on) {
+        pattern[index] = on ? 1 : 0;
+        float sign = on ? 1.0f : -1.0f;
+        uint32_t px = index % size;
+        uint32_t py = index / size;
+        for (uint32_t y = 0; y < size; ++y) {
+            uint32_t ky = (y + size - py) % size;
+            for (uint32_t x = 0; x < size; ++x) {
+                uint32_t kx = (x + size - px) % size;
+                energy[y * size + x] += sign * kernel[ky * size + kx];
+            }
+        }
+    };
+    // Tightest cluster among pixels equal to `value`, largest void among the others
+    auto extreme = [&](uint8_t value, bool largest) {
+        uint32_t best = 0;
+        float bestEnergy = largest ? -1e30f : 1e30f;
+        for (uint32_t i = 0; i < n; ++i) {
+            if (pattern[i] != value) {
+                continue;
+            }
+            if (largest ? energy[i] > bestEnergy : energy[i] < bestEnergy) {
+                bestEnergy = energy[i];
+                best = i;
+            }
+        }
+        return best;
+    };
+
+    // Initial binary pattern: about a tenth of the pixels, placed by the noise hash
+    uint32_t ones = std::max(1u, n / 10);
+    for (uint32_t placed = 0, attempt = 0; placed < ones; ++attempt) {
+        uint32_t index = noiseHash(attempt, 0, 0, seed).x % n;
+        if (!pattern[index]) {
+            toggle(index, true);
+            placed++;
+        }
+    }
+
+    // Relax: move the tightest cluster into the largest void until stable
+    for (uint32_t iteration = 0; iteration < n; ++iteration) {
+        uint32_t cluster = extreme(1, true);
+        toggle(cluster, false);
+        uint32_t hole = extreme(0, false);
+        if (hole == cluster) {
+            toggle(cluster, true);
+            break;
+        }
+        toggle(hole, true);
+    }
+    std::vector<uint8_t> prototype = pattern;
+    std::vector<float> prototypeEnergy = energy;
+
+    std::vector<uint32_t> rank(n, 0);
+
+    // Phase 1: remove clusters from the prototype, ranking downwards
+    for (uint32_t r = ones; r-- > 0;) {
+        uint32_t cluster = extreme(1, true);
+        toggle(cluster, false);
+        rank[cluster] = r;
+    }
+
+    // Phases 2 and 3: fill the largest void until every pixel is ranked. The
+    // energy of the zeros is the kernel sum minus the energy of the ones, so
+    // the tightest cluster of zeros (phase 3) is also the largest void here.
+    pattern = prototype;
+    energy = prototypeEnergy;
+    for (uint32_t r = ones; r < n; ++r) {
+        uint32_t hole = extreme(0, false);
+        toggle(hole, true);
+        rank[hole] = r;
+    }
+
+    std::vector<float> noise(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        noise[i] = (float(rank[i]) + 0.5f) / float(n);
+    }
+    return noise;
+}
+
+namespace {
+
+float threshold(const OutputUniforms& params, const float* blueNoise, uint32_t x, uint32_t y) {
+    float n = blueNoise[(y % params.noiseSize) * params.noiseSize + (x % params.noiseSize)];
+    float d = n + params.temporalOffset;
+    return d - std::floor(d);
+}
+
+void bitSteal(const OutputUniforms& params, const float color[3], float t, float codes[3]) {
+    float base[3];
+    float f = 0.0f;
+    for (int c = 0; c < 3; ++c) {
+        float s = color[c] * 255.0f;
+        base[c] = std::floor(s);
+        f += (s - base[c]) * params.weights[c];
+    }
+
+    uint32_t k = 0;
+    for (uint32_t i = 1; i < 7; ++i) {
+        if (params.levels[i][3] <= f) {
+            k = i;
+        }
+    }
+    const float* lo = params.levels[k];
+    const float* hi = params.levels[k + 1];
+    const float* delta = f - lo[3] > t * (hi[3] - lo[3]) ? hi : lo;
+    for (int c = 0; c < 3; ++c) {
+        codes[c] = base[c] + delta[c];
+    }
+}
+
+} // namespace
+
+void encodeOutputPixel(const OutputUniforms& params, const float* blueNoise,
+                       float r, float g, float b, uint32_t x, uint32_t y, uint8_t out[3]) {
+    const float color[3] = { std::clamp(r, 0.0f, 1.0f), std::clamp(g, 0.0f, 1.0f), std::clamp(b, 0.0f, 1.0f) };
+    float codes[3];
+
+    switch (static_cast<OutputMode>(params.mode)) {
+        case OutputMode::Dither: {
+            float t = threshold(params, blueNoise, x, y);
+            for (int c = 0; c < 3; ++c) {
+                codes[c] = std::floor(color[c] * 255.0f + t);
+            }
+            break;
+        }
+        case OutputMode::BitSteal:
+            bitSteal(params, color, 0.5f, codes);
+            break;
+        case OutputMode::BitStealDither:
+            bitSteal(params, color, threshold(params, blueNoise, x, y), codes);
+            break;
+        case OutputMode::Quantize:
+        default:
+            for (int c = 0; c < 3; ++c) {
+                codes[c] = std::floor(color[c] * 255.0f + 0.5f);
+            }
+            break;
+    }
+
+    for (int c = 0; c < 3; ++c) {
+        out[c] = static_cast<uint8_t>(std::clamp(codes[c], 0.0f, 255.0f));
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Final output stage: turns the high-precision scene target into 8-bit
+// swap chain codes with more effective luminance resolution than 256 levels.
+enum class OutputMode : uint32_t {
+    Quantize = 0,       // plain rounding, 8 bits
+    Dither = 1,         // blue-noise dithering per channel
+    BitSteal = 2,       // achromatic: steal sub-levels by bumping R, G, B independently
+    BitStealDither = 3, // bit-stealing, dithered between neighbouring sub-levels
+};
+
+// Calibration LUT applied before quantizing, see Calibration.h
+enum class OutputLut : uint32_t {
+    None = 0,
+    Curves = 1, // 1D: one curve per channel, binding 3
+    Cube = 2,   // 3D: full color table, binding 4
+};
+
+// Mirrors OutputUniforms in outputShaderCode
+struct OutputUniforms {
+    uint32_t mode;         // OutputMode
+    uint32_t noiseSize;    // blue-noise tile edge length
+    float temporalOffset;  // added to the tile each frame; 0 for static dithering
+    uint32_t lut;          // OutputLut
+    float weights[4];      // luminance weights of R, G, B (sum to 1)
+    // Bit-stealing sub-levels in ascending luminance: dR, dG, dB, increment.
+    // Entry 0 is (0, 0, 0, 0) and entry 7 is (1, 1, 1, 1).
+    float levels[8][4];
+};
+
+// Fragment shader of the output pass: group 0 holds the scene texture
+// (binding 0), the blue-noise tile (binding 1, r32float), the
+// OutputUniforms (binding 2, dynamic offset) and the calibration LUTs as
+// rgba32float textures: 1D as a size x 1 2D texture (binding 3) and 3D
+// (binding 4). Both LUTs are always bound; `lut` picks which one applies.
+extern const char* const outputShaderCode;
+
+// Build the uniforms for a mode and the display's measured channel luminances
+OutputUniforms makeOutputUniforms(OutputMode mode, float lumR, float lumG, float lumB, uint32_t noiseSize);
+
+// Per-frame offset of the threshold pattern, from the golden-ratio sequence
+// so every pixel walks through its thresholds evenly over time
+float temporalDitherOffset(uint32_t frame);
+
+// Void-and-cluster blue noise, size * size ranks normalized to [0, 1)
+std::vector<float> generateBlueNoise(uint32_t size, uint32_t seed);
+
+// CPU reference of the output shader for one pixel; writes R, G, B codes.
+// r, g, b are drive levels, i.e. already through any calibration LUT.
+void encodeOutputPixel(const OutputUniforms& params, const float* blueNoise,
+                       float r, float g, float b, uint32_t x, uint32_t y, uint8_t out[3]);
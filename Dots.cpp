@@ -0,0 +1,275 @@
+#include "Dots.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
+#include "Noise.h"
+
+namespace {
+
+// Decorrelates the dot hash stream from the noise generator's
+constexpr uint32_t kDotStream = 0xD07D07u;
+constexpr float kTau = 6.28318530717958647692f;
+
+const char* const dotsCommonShaderCode = R"(
+struct Dot {
+    x: f32,
+    y: f32,
+    age: u32,
+    coherent: u32,
+};
+
+struct DotUniforms {
+    count: u32,
+    frame: u32,
+    seed: u32,
+    lifetime: u32,
+    coherence: f32,
+    direction: f32,
+    speed: f32,
+    dotSize: f32,
+    centerX: f32,
+    centerY: f32,
+    radius: f32,
+    luminance: f32,
+    reset: u32,
+};
+
+const TAU: f32 = 6.28318530717958647692;
+const DOT_STREAM: u32 = 0xD07D07u;
+)";
+
+} // namespace
+
+const std::string dotsComputeShaderCode = std::string(pcg4dShaderCode) + dotsCommonShaderCode + R"(
+@group(0) @binding(0) var<storage, read_write> dots: array<Dot>;
+@group(0) @binding(1) var<uniform> params: DotUniforms;
+
+// 24-bit uniform in [0, 1), exact in f32 on both CPU and GPU
+fn unorm(h: u32) -> f32 {
+    return f32(h >> 8u) * (1.0 / 16777216.0);
+}
+
+fn wrapField(v: f32) -> f32 {
+    return v - 2.0 * floor((v + 1.0) * 0.5);
+}
+
+@compute @workgroup_size(64)
+fn main(@builtin(global_invocation_id) id: vec3<u32>) {
+    let i = id.x;
+    if (i >= params.count) {
+        return;
+    }
+
+    let h = pcg4d(vec4<u32>(i, params.frame, params.seed, DOT_STREAM));
+    var d = dots[i];
+
+    if (params.reset != 0u) {
+        d.x = unorm(h.x) * 2.0 - 1.0;
+        d.y = unorm(h.y) * 2.0 - 1.0;
+        d.age = select(0u, h.z % max(params.lifetime, 1u), params.lifetime > 0u);
+        d.coherent = 0u;
+        dots[i] = d;
+        return;
+    }
+
+    d.age += 1u;
+    if (params.lifetime > 0u && d.age >= params.lifetime) {
+        d.x = unorm(h.x) * 2.0 - 1.0;
+        d.y = unorm(h.y) * 2.0 - 1.0;
+        d.age = 0u;
+        d.coherent = 0u;
+    } else {
+        let coherent = unorm(h.z) < params.coherence;
+        let angle = select(unorm(h.w) * TAU, params.direction, coherent);
+        d.x = wrapField(d.x + cos(angle) * params.speed);
+        d.y = wrapField(d.y + sin(angle) * params.speed);
+        d.coherent = select(0u, 1u, coherent);
+    }
+    dots[i] = d;
+}
+)";
+
+const std::string dotsRenderShaderCode = std::string(dotsCommonShaderCode) + R"(
+@group(0) @binding(0) var<storage, read> dots: array<Dot>;
+@group(0) @binding(1) var<uniform> params: DotUniforms;
+
+@vertex
+fn vs_main(@builtin(vertex_index) vertexIndex: u32, @builtin(instance_index) instance: u32) -> @builtin(position) vec4<f32> {
+    var corners = array<vec2<f32>, 6>(
+        vec2<f32>(-0.5, -0.5),
+        vec2<f32>(0.5, -0.5),
+        vec2<f32>(0.5, 0.5),
+        vec2<f32>(-0.5, -0.5),
+        vec2<f32>(0.5, 0.5),
+        vec2<f32>(-0.5, 0.5)
+    );
+    let d = dots[instance];
+    if (d.x * d.x + d.y * d.y > 1.0) {
+        // Outside the aperture: push the whole quad past the far plane
+        return vec4<f32>(0.0, 0.0, 2.0, 1.0);
+    }
+    let center = vec2<f32>(params.centerX, params.centerY) + vec2<f32>(d.x, d.y) * params.radius;
+    return vec4<f32>(center + corners[vertexIndex] * params.dotSize, 0.0, 1.0);
+}
+
+@fragment
+fn fs_main() -> @location(0) vec4<f32> {
+    return vec4<f32>(vec3<f32>(params.luminance), 1.0);
+}
+)";
+
+namespace {
+
+float unorm(uint32_t h) {
+    return float(h >> 8) * (1.0f / 16777216.0f);
+}
+
+float wrapField(float v) {
+    return v - 2.0f * std::floor((v + 1.0f) * 0.5f);
+}
+
+#ifdef __wasm_simd128__
+
+struct Hash4 {
+    v128_t x, y, z, w;
+};
+
+// Four lanes of noiseHash()
+Hash4 noiseHash4(v128_t x, v128_t y, v128_t z, v128_t w) {
+    const v128_t mul = wasm_i32x4_splat(1664525);
+    const v128_t add = wasm_i32x4_splat(1013904223);
+    Hash4 v = {
+        wasm_i32x4_add(wasm_i32x4_mul(x, mul), add),
+        wasm_i32x4_add(wasm_i32x4_mul(y, mul), add),
+        wasm_i32x4_add(wasm_i32x4_mul(z, mul), add),
+        wasm_i32x4_add(wasm_i32x4_mul(w, mul), add),
+    };
+    for (int round = 0; round < 2; ++round) {
+        v.x = wasm_i32x4_add(v.x, wasm_i32x4_mul(v.y, v.w));
+        v.y = wasm_i32x4_add(v.y, wasm_i32x4_mul(v.z, v.x));
+        v.z = wasm_i32x4_add(v.z, wasm_i32x4_mul(v.x, v.y));
+        v.w = wasm_i32x4_add(v.w, wasm_i32x4_mul(v.y, v.z));
+        if (round == 0) {
+            v.x = wasm_v128_xor(v.x, wasm_u32x4_shr(v.x, 16));
+            v.y = wasm_v128_xor(v.y, wasm_u32x4_shr(v.y, 16));
+            v.z = wasm_v128_xor(v.z, wasm_u32x4_shr(v.z, 16));
+            v.w = wasm_v128_xor(v.w, wasm_u32x4_shr(v.w, 16));
+        }
+    }
+    return v;
+}
+
+v128_t unorm4(v128_t h) {
+    return wasm_f32x4_mul(wasm_f32x4_convert_u32x4(wasm_u32x4_shr(h, 8)), wasm_f32x4_splat(1.0f / 16777216.0f));
+}
+
+v128_t wrapField4(v128_t v) {
+    v128_t cells = wasm_f32x4_floor(wasm_f32x4_mul(wasm_f32x4_add(v, wasm_f32x4_splat(1.0f)), wasm_f32x4_splat(0.5f)));
+    return wasm_f32x4_sub(v, wasm_f32x4_mul(cells, wasm_f32x4_splat(2.0f)));
+}
+
+#endif
+
+} // namespace
+
+DotFieldCpu::DotFieldCpu(size_t count)
+    : x(count, 0.0f), y(count, 0.0f), age(count, 0), coherent(count, 0) {}
+
+void DotFieldCpu::step(const DotUniforms& p) {
+    size_t n = std::min<size_t>(p.count, x.size());
+
+    if (p.reset) {
+        for (size_t i = 0; i < n; ++i) {
+            NoiseHash h = noiseHash(uint32_t(i), p.frame, p.seed, kDotStream);
+            x[i] = unorm(h.x) * 2.0f - 1.0f;
+            y[i] = unorm(h.y) * 2.0f - 1.0f;
+            age[i] = p.lifetime > 0 ? h.z % p.lifetime : 0;
+            coherent[i] = 0;
+        }
+        return;
+    }
+
+    size_t i = 0;
+#ifdef __wasm_simd128__
+    const v128_t one = wasm_i32x4_splat(1);
+    const v128_t signalX = wasm_f32x4_splat(std::cos(p.direction) * p.speed);
+    const v128_t signalY = wasm_f32x4_splat(std::sin(p.direction) * p.speed);
+    const v128_t coherence = wasm_f32x4_splat(p.coherence);
+    const v128_t lifetime = wasm_i32x4_splat(int32_t(p.lifetime));
+    const v128_t frame = wasm_i32x4_splat(int32_t(p.frame));
+    const v128_t seed = wasm_i32x4_splat(int32_t(p.seed));
+    const v128_t stream = wasm_i32x4_splat(int32_t(kDotStream));
+
+    for (; i + 4 <= n; i += 4) {
+        v128_t index = wasm_i32x4_make(int32_t(i), int32_t(i + 1), int32_t(i + 2), int32_t(i + 3));
+        Hash4 h = noiseHash4(index, frame, seed, stream);
+
+        v128_t a = wasm_i32x4_add(wasm_v128_load(&age[i]), one);
+        v128_t expired = p.lifetime > 0 ? wasm_u32x4_ge(a, lifetime) : wasm_i32x4_splat(0);
+        v128_t isCoherent = wasm_f32x4_lt(unorm4(h.z), coherence);
+
+        // Random directions need sin/cos, which have no SIMD form; do those per lane
+        float angles[4];
+        float noiseX[4];
+        float noiseY[4];
+        wasm_v128_store(angles, wasm_f32x4_mul(unorm4(h.w), wasm_f32x4_splat(kTau)));
+        for (int lane = 0; lane < 4; ++lane) {
+            noiseX[lane] = std::cos(angles[lane]) * p.speed;
+            noiseY[lane] = std::sin(angles[lane]) * p.speed;
+        }
+        v128_t stepX = wasm_v128_bitselect(signalX, wasm_v128_load(noiseX), isCoherent);
+        v128_t stepY = wasm_v128_bitselect(signalY, wasm_v128_load(noiseY), isCoherent);
+
+        v128_t movedX = wrapField4(wasm_f32x4_add(wasm_v128_load(&x[i]), stepX));
+        v128_t movedY = wrapField4(wasm_f32x4_add(wasm_v128_load(&y[i]), stepY));
+        v128_t spawnX = wasm_f32x4_sub(wasm_f32x4_mul(unorm4(h.x), wasm_f32x4_splat(2.0f)), wasm_f32x4_splat(1.0f));
+        v128_t spawnY = wasm_f32x4_sub(wasm_f32x4_mul(unorm4(h.y), wasm_f32x4_splat(2.0f)), wasm_f32x4_splat(1.0f));
+
+        wasm_v128_store(&x[i], wasm_v128_bitselect(spawnX, movedX, expired));
+        wasm_v128_store(&y[i], wasm_v128_bitselect(spawnY, movedY, expired));
+        wasm_v128_store(&age[i], wasm_v128_andnot(a, expired));
+        wasm_v128_store(&coherent[i], wasm_v128_andnot(wasm_v128_and(isCoherent, one), expired));
+    }
+#endif
+
+    for (; i < n; ++i) {
+        NoiseHash h = noiseHash(uint32_t(i), p.frame, p.seed, kDotStream);
+        age[i] += 1;
+        if (p.lifetime > 0 && age[i] >= p.lifetime) {
+            x[i] = unorm(h.x) * 2.0f - 1.0f;
+            y[i] = unorm(h.y) * 2.0f - 1.0f;
+            age[i] = 0;
+            coherent[i] = 0;
+        } else {
+            bool isCoherent = unorm(h.z) < p.coherence;
+            float angle = isCoherent ? p.direction : unorm(h.w) * kTau;
+            x[i] = wrapField(x[i] + std::cos(angle) * p.speed);
+            y[i] = wrapField(y[i] + std::sin(angle) * p.speed);
+            coherent[i] = isCoherent ? 1 : 0;
+        }
+    }
+}
+
+double DotFieldCpu::coherentFraction() const {
+    if (coherent.empty()) {
+        return 0.0;
+    }
+    size_t count = std::count(coherent.begin(), coherent.end(), 1u);
+    return double(count) / double(coherent.size());
+}
+
+std::vector<uint32_t> DotFieldCpu::ageHistogram(size_t bins) const {
+    std::vector<uint32_t> histogram(bins, 0);
+    if (bins == 0) {
+        return histogram;
+    }
+    for (uint32_t a : age) {
+        histogram[std::min<size_t>(a, bins - 1)]++;
+    }
+    return histogram;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Random-dot kinematogram. Dot state lives in a storage buffer updated by a
+// compute pass each frame and the dots are drawn as instanced quads, so the
+// CPU cost per frame is one dispatch and one draw whatever the dot count.
+//
+// Dots live in a square field of [-1, 1]^2 field units that wraps at the
+// edges; only dots inside the unit circle are drawn (circular aperture).
+// Each frame every dot independently joins the signal with probability
+// `coherence` and steps in `direction`, otherwise it steps in a random
+// direction. Dots older than `lifetime` frames are replotted at random.
+
+// Mirrors Dot in the dot shaders; one element of the storage buffer
+struct Dot {
+    float x;
+    float y;
+    uint32_t age;
+    uint32_t coherent; // 1 if the dot moved with the signal this frame
+};
+
+// Mirrors DotUniforms in the dot shaders
+struct DotUniforms {
+    uint32_t count;
+    uint32_t frame;    // frames since onset
+    uint32_t seed;
+    uint32_t lifetime; // frames, 0 = unlimited
+    float coherence;   // 0..1
+    float direction;   // radians
+    float speed;       // field units per frame
+    float dotSize;     // edge length in NDC
+    float centerX;     // NDC
+    float centerY;
+    float radius;      // NDC radius of the aperture
+    float luminance;
+    uint32_t reset;    // 1 on the first frame: scatter dots and stagger their ages
+    uint32_t padding[3];
+};
+
+// Compute shader: group 0 binding 0 is the read-write Dot array, binding 1 the DotUniforms
+extern const std::string dotsComputeShaderCode;
+// Render shader: group 0 binding 0 is the read-only Dot array, binding 1 the DotUniforms
+extern const std::string dotsRenderShaderCode;
+
+constexpr uint32_t kDotsWorkgroupSize = 64;
+
+// CPU reference of the compute pass, struct-of-arrays and 4-wide SIMD where
+// wasm SIMD is enabled. Follows the same hash streams as the shader so its
+// statistics can be compared with the GPU field.
+class DotFieldCpu {
+public:
+    explicit DotFieldCpu(size_t count);
+
+    void step(const DotUniforms& params);
+
+    size_t size() const { return x.size(); }
+    Dot dot(size_t i) const { return { x[i], y[i], age[i], coherent[i] }; }
+
+    // Fraction of dots that moved with the signal on the last step
+    double coherentFraction() const;
+    // Count of dots per age, ages >= histogram size land in the last bin
+    std::vector<uint32_t> ageHistogram(size_t bins) const;
+
+private:
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<uint32_t> age;
+    std::vector<uint32_t> coherent;
+};
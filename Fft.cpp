@@ -0,0 +1,262 @@
+#include "Fft.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
+#include "Parallel.h"
+
+FftPlan::FftPlan(uint32_t size) : n(size), reversed(size), twiddleRe(size > 1 ? size - 1 : 0), twiddleIm(size > 1 ? size - 1 : 0) {
+    uint32_t bits = 0;
+    while ((1u << bits) < n) {
+        bits++;
+    }
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t r = 0;
+        for (uint32_t b = 0; b < bits; ++b) {
+            r |= ((i >> b) & 1u) << (bits - 1 - b);
+        }
+        reversed[i] = r;
+    }
+
+    const double pi = 3.14159265358979323846;
+    for (uint32_t m = 1; m < n; m *= 2) {
+        for (uint32_t j = 0; j < m; ++j) {
+            double angle = -pi * double(j) / double(m);
+            twiddleRe[m - 1 + j] = static_cast<float>(std::cos(angle));
+            twiddleIm[m - 1 + j] = static_cast<float>(std::sin(angle));
+        }
+    }
+}
+
+void FftPlan::forward(float* re, float* im) const {
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t r = reversed[i];
+        if (i < r) {
+            std::swap(re[i], re[r]);
+            std::swap(im[i], im[r]);
+        }
+    }
+
+    uint32_t m = 1;
+    // Odd power of two: one plain radix-2 stage (twiddle 1) first
+    if (n > 1 && (__builtin_ctz(n) & 1u)) {
+        for (uint32_t k = 0; k < n; k += 2) {
+            float ar = re[k], ai = im[k];
+            float br = re[k + 1], bi = im[k + 1];
+            re[k] = ar + br;
+            im[k] = ai + bi;
+            re[k + 1] = ar - br;
+            im[k + 1] = ai - bi;
+        }
+        m = 2;
+    }
+
+    // Two radix-2 stages (half-sizes m and 2m) per pass
+    for (; m < n; m *= 4) {
+        const float* w1r = &twiddleRe[m - 1];
+        const float* w1i = &twiddleIm[m - 1];
+        const float* w2r = &twiddleRe[2 * m - 1];
+        const float* w2i = &twiddleIm[2 * m - 1];
+
+        for (uint32_t base = 0; base < n; base += 4 * m) {
+            float* r0 = re + base;
+            float* i0 = im + base;
+            float* r1 = r0 + m;
+            float* i1 = i0 + m;
+            float* r2 = r1 + m;
+            float* i2 = i1 + m;
+            float* r3 = r2 + m;
+            float* i3 = i2 + m;
+
+            uint32_t j = 0;
+#ifdef __wasm_simd128__
+            for (; j + 4 <= m; j += 4) {
+                v128_t ar0 = wasm_v128_load(r0 + j), ai0 = wasm_v128_load(i0 + j);
+                v128_t ar1 = wasm_v128_load(r1 + j), ai1 = wasm_v128_load(i1 + j);
+                v128_t ar2 = wasm_v128_load(r2 + j), ai2 = wasm_v128_load(i2 + j);
+                v128_t ar3 = wasm_v128_load(r3 + j), ai3 = wasm_v128_load(i3 + j);
+                v128_t wr1 = wasm_v128_load(w1r + j), wi1 = wasm_v128_load(w1i + j);
+                v128_t wr2 = wasm_v128_load(w2r + j), wi2 = wasm_v128_load(w2i + j);
+
+                // First stage: w1 * a1 and w1 * a3
+                v128_t tr = wasm_f32x4_sub(wasm_f32x4_mul(wr1, ar1), wasm_f32x4_mul(wi1, ai1));
+                v128_t ti = wasm_f32x4_add(wasm_f32x4_mul(wr1, ai1), wasm_f32x4_mul(wi1, ar1));
+                v128_t ur = wasm_f32x4_sub(wasm_f32x4_mul(wr1, ar3), wasm_f32x4_mul(wi1, ai3));
+                v128_t ui = wasm_f32x4_add(wasm_f32x4_mul(wr1, ai3), wasm_f32x4_mul(wi1, ar3));
+                v128_t br0 = wasm_f32x4_add(ar0, tr), bi0 = wasm_f32x4_add(ai0, ti);
+                v128_t br1 = wasm_f32x4_sub(ar0, tr), bi1 = wasm_f32x4_sub(ai0, ti);
+                v128_t br2 = wasm_f32x4_add(ar2, ur), bi2 = wasm_f32x4_add(ai2, ui);
+                v128_t br3 = wasm_f32x4_sub(ar2, ur), bi3 = wasm_f32x4_sub(ai2, ui);
+
+                // Second stage: w2 * b2 and -i * w2 * b3
+                tr = wasm_f32x4_sub(wasm_f32x4_mul(wr2, br2), wasm_f32x4_mul(wi2, bi2));
+                ti = wasm_f32x4_add(wasm_f32x4_mul(wr2, bi2), wasm_f32x4_mul(wi2, br2));
+                ur = wasm_f32x4_sub(wasm_f32x4_mul(wr2, br3), wasm_f32x4_mul(wi2, bi3));
+                ui = wasm_f32x4_add(wasm_f32x4_mul(wr2, bi3), wasm_f32x4_mul(wi2, br3));
+                wasm_v128_store(r0 + j, wasm_f32x4_add(br0, tr));
+                wasm_v128_store(i0 + j, wasm_f32x4_add(bi0, ti));
+                wasm_v128_store(r2 + j, wasm_f32x4_sub(br0, tr));
+                wasm_v128_store(i2 + j, wasm_f32x4_sub(bi0, ti));
+                wasm_v128_store(r1 + j, wasm_f32x4_add(br1, ui));
+                wasm_v128_store(i1 + j, wasm_f32x4_sub(bi1, ur));
+                wasm_v128_store(r3 + j, wasm_f32x4_sub(br1, ui));
+                wasm_v128_store(i3 + j, wasm_f32x4_add(bi1, ur));
+            }
+#endif
+            for (; j < m; ++j) {
+                float tr = w1r[j] * r1[j] - w1i[j] * i1[j];
+                float ti = w1r[j] * i1[j] + w1i[j] * r1[j];
+                float ur = w1r[j] * r3[j] - w1i[j] * i3[j];
+                float ui = w1r[j] * i3[j] + w1i[j] * r3[j];
+                float br0 = r0[j] + tr, bi0 = i0[j] + ti;
+                float br1 = r0[j] - tr, bi1 = i0[j] - ti;
+                float br2 = r2[j] + ur, bi2 = i2[j] + ui;
+                float br3 = r2[j] - ur, bi3 = i2[j] - ui;
+
+                tr = w2r[j] * br2 - w2i[j] * bi2;
+                ti = w2r[j] * bi2 + w2i[j] * br2;
+                ur = w2r[j] * br3 - w2i[j] * bi3;
+                ui = w2r[j] * bi3 + w2i[j] * br3;
+                r0[j] = br0 + tr;
+                i0[j] = bi0 + ti;
+                r2[j] = br0 - tr;
+                i2[j] = bi0 - ti;
+                // -i * (ur + i ui) = ui - i ur
+                r1[j] = br1 + ui;
+                i1[j] = bi1 - ur;
+                r3[j] = br1 - ui;
+                i3[j] = bi1 + ur;
+            }
+        }
+    }
+}
+
+void FftPlan::inverse(float* re, float* im) const {
+    // ifft(x) = swap(fft(swap(x))) / n, where swap exchanges re and im
+    forward(im, re);
+    float scale = 1.0f / float(n);
+    for (uint32_t i = 0; i < n; ++i) {
+        re[i] *= scale;
+        im[i] *= scale;
+    }
+}
+
+uint32_t fftSize(uint32_t value) {
+    uint32_t size = 1;
+    while (size < value) {
+        size *= 2;
+    }
+    return size;
+}
+
+namespace {
+
+void transpose(const float* in, uint32_t width, uint32_t height, float* out) {
+    const uint32_t block = 32;
+    for (uint32_t by = 0; by < height; by += block) {
+        for (uint32_t bx = 0; bx < width; bx += block) {
+            uint32_t ey = std::min(by + block, height);
+            uint32_t ex = std::min(bx + block, width);
+            for (uint32_t y = by; y < ey; ++y) {
+                for (uint32_t x = bx; x < ex; ++x) {
+                    out[size_t(x) * height + y] = in[size_t(y) * width + x];
+                }
+            }
+        }
+    }
+}
+
+template <typename Body>
+void forRows(size_t count, bool parallel, Body&& body) {
+    if (parallel) {
+        parallelFor(count, 16, [&](size_t, size_t begin, size_t end) { body(begin, end); });
+    } else {
+        body(size_t(0), count);
+    }
+}
+
+// Complex FFT of every column, through a transpose so each runs on contiguous rows
+void columnPass(float* re, float* im, uint32_t width, uint32_t height, bool inverse, bool parallel) {
+    FftPlan plan(height);
+    std::vector<float> tre(size_t(width) * height);
+    std::vector<float> tim(size_t(width) * height);
+    transpose(re, width, height, tre.data());
+    transpose(im, width, height, tim.data());
+    forRows(width, parallel, [&](size_t begin, size_t end) {
+        for (size_t x = begin; x < end; ++x) {
+            if (inverse) {
+                plan.inverse(&tre[x * height], &tim[x * height]);
+            } else {
+                plan.forward(&tre[x * height], &tim[x * height]);
+            }
+        }
+    });
+    transpose(tre.data(), height, width, re);
+    transpose(tim.data(), height, width, im);
+}
+
+} // namespace
+
+void forwardReal2d(const float* plane, uint32_t width, uint32_t height, float* re, float* im, bool parallel) {
+    FftPlan plan(width);
+    uint32_t pairs = (height + 1) / 2;
+
+    forRows(pairs, parallel, [&](size_t begin, size_t end) {
+        std::vector<float> zr(width), zi(width);
+        for (size_t pair = begin; pair < end; ++pair) {
+            size_t a = pair * 2;
+            size_t b = a + 1;
+            std::copy(plane + a * width, plane + (a + 1) * width, zr.begin());
+            if (b < height) {
+                std::copy(plane + b * width, plane + (b + 1) * width, zi.begin());
+            } else {
+                std::fill(zi.begin(), zi.end(), 0.0f);
+            }
+            plan.forward(zr.data(), zi.data());
+
+            // X_a[k] = (Z[k] + conj(Z[-k])) / 2, X_b[k] = (Z[k] - conj(Z[-k])) / 2i
+            for (uint32_t k = 0; k < width; ++k) {
+                uint32_t mirror = (width - k) & (width - 1);
+                float pr = zr[k], pi = zi[k];
+                float qr = zr[mirror], qi = -zi[mirror];
+                re[a * width + k] = 0.5f * (pr + qr);
+                im[a * width + k] = 0.5f * (pi + qi);
+                if (b < height) {
+                    re[b * width + k] = 0.5f * (pi - qi);
+                    im[b * width + k] = -0.5f * (pr - qr);
+                }
+            }
+        }
+    });
+
+    columnPass(re, im, width, height, false, parallel);
+}
+
+void inverseReal2d(float* re, float* im, uint32_t width, uint32_t height, float* plane, bool parallel) {
+    columnPass(re, im, width, height, true, parallel);
+
+    // Both rows of a pair are real, so one complex inverse recovers both
+    FftPlan plan(width);
+    uint32_t pairs = (height + 1) / 2;
+    forRows(pairs, parallel, [&](size_t begin, size_t end) {
+        std::vector<float> zr(width), zi(width);
+        for (size_t pair = begin; pair < end; ++pair) {
+            size_t a = pair * 2;
+            size_t b = a + 1;
+            for (uint32_t k = 0; k < width; ++k) {
+                // Z = X_a + i X_b
+                zr[k] = re[a * width + k] - (b < height ? im[b * width + k] : 0.0f);
+                zi[k] = im[a * width + k] + (b < height ? re[b * width + k] : 0.0f);
+            }
+            plan.inverse(zr.data(), zi.data());
+            std::copy(zr.begin(), zr.end(), plane + a * width);
+            if (b < height) {
+                std::copy(zi.begin(), zi.end(), plane + b * width);
+            }
+        }
+    });
+}
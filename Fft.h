@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Complex FFT of one power-of-two length on split real/imaginary arrays.
+// Stages are fused in pairs into radix-4 butterflies, with a leading
+// radix-2 stage for odd powers, and run four butterflies per step with
+// wasm SIMD. A plan holds only read-only tables, so one plan can be shared
+// by any number of threads.
+class FftPlan {
+public:
+    explicit FftPlan(uint32_t size);
+
+    uint32_t size() const { return n; }
+
+    // In place and unscaled
+    void forward(float* re, float* im) const;
+    // In place, scaled by 1 / size
+    void inverse(float* re, float* im) const;
+
+private:
+    uint32_t n;
+    std::vector<uint32_t> reversed;
+    // W_2m^j = exp(-i pi j / m) for the stage of half-size m, at offset m - 1
+    std::vector<float> twiddleRe;
+    std::vector<float> twiddleIm;
+};
+
+// Smallest power of two >= value
+uint32_t fftSize(uint32_t value);
+
+// Full 2D spectrum of a real plane; width and height must be powers of
+// two. Rows are transformed two at a time as one complex row (the
+// real-input trick) and columns through a transpose. `parallel` splits
+// rows across threads; pass false when already running on a worker.
+void forwardReal2d(const float* plane, uint32_t width, uint32_t height, float* re, float* im, bool parallel = true);
+
+// Inverse of forwardReal2d for Hermitian spectra; `re` and `im` are
+// overwritten and the real result is written to `plane`
+void inverseReal2d(float* re, float* im, uint32_t width, uint32_t height, float* plane, bool parallel = true);
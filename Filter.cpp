@@ -0,0 +1,144 @@
+#include "Filter.h"
+
+#include <algorithm>
+#include <cmath>
+
+const char* const filterShaderCode = R"(
+struct FilterUniforms {
+    direction: u32,
+    radius: u32,
+    highPass: u32,
+    offset: f32,
+    weights: array<vec4<f32>, 17>,
+};
+
+@group(0) @binding(0) var source: texture_2d<f32>;
+@group(0) @binding(1) var destination: texture_storage_2d<rgba16float, write>;
+@group(0) @binding(2) var<uniform> params: FilterUniforms;
+@group(0) @binding(3) var original: texture_2d<f32>;
+
+const TILE: u32 = 128u;
+const MAX_RADIUS: u32 = 64u;
+
+var<workgroup> tile: array<vec4<f32>, 256>;
+
+fn weight(i: u32) -> f32 {
+    return params.weights[i / 4u][i % 4u];
+}
+
+fn texel(along: i32, across: i32) -> vec2<i32> {
+    return select(vec2<i32>(across, along), vec2<i32>(along, across), params.direction == 0u);
+}
+
+@compute @workgroup_size(128)
+fn main(@builtin(workgroup_id) group: vec3<u32>, @builtin(local_invocation_index) local: u32) {
+    let size = vec2<i32>(textureDimensions(source));
+    let extent = select(size.y, size.x, params.direction == 0u);
+    let across = i32(group.y);
+    let start = i32(group.x * TILE);
+    let radius = min(params.radius, MAX_RADIUS);
+
+    // Tile plus apron, clamped at the edges; two loads per invocation
+    for (var t = local; t < TILE + 2u * radius; t += TILE) {
+        let along = clamp(start + i32(t) - i32(radius), 0, extent - 1);
+        tile[t] = textureLoad(source, texel(along, across), 0);
+    }
+    workgroupBarrier();
+
+    let along = start + i32(local);
+    if (along >= extent) {
+        return;
+    }
+
+    let center = local + radius;
+    var sum = tile[center] * weight(0u);
+    for (var i = 1u; i <= radius; i++) {
+        sum += (tile[center - i] + tile[center + i]) * weight(i);
+    }
+
+    let position = texel(along, across);
+    if (params.highPass != 0u) {
+        let image = textureLoad(original, position, 0);
+        sum = vec4<f32>(image.rgb - sum.rgb + vec3<f32>(params.offset), image.a);
+    }
+    textureStore(destination, position, sum);
+}
+)";
+
+void setGaussianKernel(FilterUniforms& params, float sigma) {
+    std::fill(std::begin(params.weights), std::end(params.weights), 0.0f);
+    if (sigma <= 0.0f) {
+        params.radius = 0;
+        params.weights[0] = 1.0f;
+        return;
+    }
+
+    uint32_t radius = std::min(kFilterMaxRadius, static_cast<uint32_t>(std::ceil(3.0f * sigma)));
+    double total = 0.0;
+    for (uint32_t i = 0; i <= radius; ++i) {
+        double w = std::exp(-double(i) * i / (2.0 * sigma * sigma));
+        params.weights[i] = static_cast<float>(w);
+        total += i == 0 ? w : 2.0 * w;
+    }
+    for (uint32_t i = 0; i <= radius; ++i) {
+        params.weights[i] = static_cast<float>(params.weights[i] / total);
+    }
+    params.radius = radius;
+}
+
+void filterDispatchSize(uint32_t direction, uint32_t width, uint32_t height, uint32_t& x, uint32_t& y) {
+    uint32_t length = direction == 0 ? width : height;
+    x = (length + kFilterTileSize - 1) / kFilterTileSize;
+    y = direction == 0 ? height : width;
+}
+
+namespace {
+
+void convolve(const float* in, uint32_t width, uint32_t height, uint32_t direction, const FilterUniforms& params,
+              float* out) {
+    int length = int(direction == 0 ? width : height);
+    int lines = int(direction == 0 ? height : width);
+    int radius = int(params.radius);
+    for (int across = 0; across < lines; ++across) {
+        for (int along = 0; along < length; ++along) {
+            float sum[4] = {};
+            for (int k = -radius; k <= radius; ++k) {
+                int a = std::clamp(along + k, 0, length - 1);
+                size_t index = direction == 0 ? size_t(across) * width + a : size_t(a) * width + across;
+                float w = params.weights[std::abs(k)];
+                for (int c = 0; c < 4; ++c) {
+                    sum[c] += in[index * 4 + c] * w;
+                }
+            }
+            size_t index = direction == 0 ? size_t(across) * width + along : size_t(along) * width + across;
+            std::copy(sum, sum + 4, out + index * 4);
+        }
+    }
+}
+
+} // namespace
+
+std::vector<float> filterImage(const float* rgba, uint32_t width, uint32_t height, FilterType type, float sigma,
+                               float offset) {
+    size_t count = size_t(width) * height * 4;
+    std::vector<float> out(rgba, rgba + count);
+    if (type == FilterType::None || count == 0) {
+        return out;
+    }
+
+    FilterUniforms params = {};
+    setGaussianKernel(params, sigma);
+    std::vector<float> rows(count);
+    convolve(rgba, width, height, 0, params, rows.data());
+    convolve(rows.data(), width, height, 1, params, out.data());
+
+    if (type == FilterType::HighPass) {
+        for (size_t i = 0; i < count; i += 4) {
+            for (int c = 0; c < 3; ++c) {
+                out[i + c] = rgba[i + c] - out[i + c] + offset;
+            }
+            out[i + 3] = rgba[i + 3];
+        }
+    }
+    return out;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Separable Gaussian filtering of the stimulus image in two compute
+// passes (rows, then columns). Each workgroup loads a tile of the row or
+// column plus the kernel apron into shared memory once and convolves from
+// there, so every texel is fetched about once per pass.
+enum class FilterType : uint32_t {
+    None = 0,
+    LowPass = 1,  // Gaussian blur
+    HighPass = 2, // image - blur + offset
+};
+
+constexpr uint32_t kFilterMaxRadius = 64;
+constexpr uint32_t kFilterTileSize = 128; // texels per workgroup along the filter axis
+
+// Mirrors FilterUniforms in filterShaderCode
+struct FilterUniforms {
+    uint32_t direction; // 0 = along rows, 1 = along columns
+    uint32_t radius;    // taps on each side, <= kFilterMaxRadius
+    uint32_t highPass;  // column pass only: write original - blurred + offset
+    float offset;       // high-pass mean level, usually the image's mean luminance
+    float weights[68];  // weights[i] for tap distance i, 0..radius
+};
+
+// Compute shader: group 0 holds the pass input (binding 0), the rgba16float
+// storage output (binding 1), the FilterUniforms (binding 2, dynamic
+// offset) and the unfiltered image (binding 3)
+extern const char* const filterShaderCode;
+
+// Normalized half-kernel for `sigma` texels, radius ceil(3 sigma) capped at
+// kFilterMaxRadius; fills `params.weights` and `params.radius`
+void setGaussianKernel(FilterUniforms& params, float sigma);
+
+// Workgroups to dispatch for one pass over a width x height image
+void filterDispatchSize(uint32_t direction, uint32_t width, uint32_t height, uint32_t& x, uint32_t& y);
+
+// CPU reference: both passes over RGBA float texels with clamped edges.
+// The GPU keeps the intermediate in half floats, so results agree to
+// about 1e-3.
+std::vector<float> filterImage(const float* rgba, uint32_t width, uint32_t height, FilterType type, float sigma,
+                               float offset);
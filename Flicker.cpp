@@ -0,0 +1,104 @@
+#include "Flicker.h"
+
+#include <algorithm>
+#include <cmath>
+
+const char* const flickerShaderCode = R"(
+struct FlickerTarget {
+    centerX: f32,
+    centerY: f32,
+    halfWidth: f32,
+    halfHeight: f32,
+    phaseStep: u32,
+    phaseOffset: u32,
+    meanLuminance: f32,
+    depth: f32,
+};
+
+struct FlickerUniforms {
+    frame: u32,
+};
+
+@group(0) @binding(0) var<storage, read> targets: array<FlickerTarget>;
+@group(1) @binding(0) var<uniform> flicker: FlickerUniforms;
+
+const TAU: f32 = 6.28318530717958647692;
+
+struct VertexOut {
+    @builtin(position) position: vec4<f32>,
+    @location(0) @interpolate(flat) luminance: f32,
+};
+
+@vertex
+fn vs_main(@builtin(vertex_index) vertexIndex: u32, @builtin(instance_index) instance: u32) -> VertexOut {
+    var corners = array<vec2<f32>, 6>(
+        vec2<f32>(-1.0, -1.0),
+        vec2<f32>(1.0, -1.0),
+        vec2<f32>(1.0, 1.0),
+        vec2<f32>(-1.0, -1.0),
+        vec2<f32>(1.0, 1.0),
+        vec2<f32>(-1.0, 1.0)
+    );
+    let t = targets[instance];
+    let corner = corners[vertexIndex];
+
+    // u32 arithmetic wraps modulo 2^32, i.e. modulo one cycle
+    let phase = flicker.frame * t.phaseStep + t.phaseOffset;
+    let angle = f32(phase) * (TAU / 4294967296.0);
+
+    var out: VertexOut;
+    out.position = vec4<f32>(t.centerX + corner.x * t.halfWidth, t.centerY + corner.y * t.halfHeight, 0.0, 1.0);
+    out.luminance = clamp(t.meanLuminance * (1.0 + t.depth * sin(angle)), 0.0, 1.0);
+    return out;
+}
+
+@fragment
+fn fs_main(@location(0) @interpolate(flat) luminance: f32) -> @location(0) vec4<f32> {
+    return vec4<f32>(vec3<f32>(luminance), 1.0);
+}
+)";
+
+namespace {
+
+constexpr double kTwoPow32 = 4294967296.0;
+constexpr double kTau = 6.28318530717958647692;
+
+// Fraction of a cycle to 2^-32 units, wrapped into [0, 2^32)
+uint32_t cycleFraction(double cycles) {
+    double fraction = cycles - std::floor(cycles);
+    return static_cast<uint32_t>(static_cast<uint64_t>(std::llround(fraction * kTwoPow32)) & 0xFFFFFFFFull);
+}
+
+} // namespace
+
+FlickerTarget makeFlickerTarget(const FlickerSpec& spec, double refreshHz) {
+    FlickerTarget target = {};
+    target.centerX = spec.centerX;
+    target.centerY = spec.centerY;
+    target.halfWidth = spec.width * 0.5f;
+    target.halfHeight = spec.height * 0.5f;
+    target.phaseStep = cycleFraction(spec.frequencyHz / refreshHz);
+    target.phaseOffset = cycleFraction(spec.phase / kTau);
+    target.meanLuminance = spec.meanLuminance;
+    target.depth = spec.depth;
+    return target;
+}
+
+uint32_t flickerPhase(const FlickerTarget& target, uint32_t frame) {
+    return frame * target.phaseStep + target.phaseOffset;
+}
+
+float flickerLuminance(const FlickerTarget& target, uint32_t frame) {
+    const float tau = 6.28318530717958647692f;
+    float angle = static_cast<float>(flickerPhase(target, frame)) * (tau / 4294967296.0f);
+    return std::clamp(target.meanLuminance * (1.0f + target.depth * std::sin(angle)), 0.0f, 1.0f);
+}
+
+double flickerRealizedFrequency(const FlickerTarget& target, double refreshHz) {
+    // Steps above half a cycle alias to negative frequencies, same as the display would
+    double cycles = target.phaseStep / kTwoPow32;
+    if (cycles > 0.5) {
+        cycles -= 1.0;
+    }
+    return std::abs(cycles) * refreshHz;
+}
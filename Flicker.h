@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+
+// Frequency-tagging targets, each sinusoidally modulated at its own rate.
+// Phase is kept as a 32-bit fraction of a cycle and advanced by integer
+// arithmetic from the frame counter, so it cannot drift no matter how long
+// the session runs, and frequencies need not divide the refresh rate.
+
+// What the caller asks for
+struct FlickerSpec {
+    float centerX;      // NDC
+    float centerY;
+    float width;        // NDC
+    float height;
+    double frequencyHz;
+    double phase;       // radians at frame 0
+    float meanLuminance;
+    float depth;        // modulation depth, 0..1
+};
+static_assert(sizeof(FlickerSpec) == 40, "FlasherControl.startFlicker() in index.html writes 40-byte specs");
+
+// Mirrors FlickerTarget in flickerShaderCode; one element of the storage buffer
+struct FlickerTarget {
+    float centerX;
+    float centerY;
+    float halfWidth;
+    float halfHeight;
+    uint32_t phaseStep;   // cycles per frame in units of 2^-32
+    uint32_t phaseOffset; // phase at frame 0 in units of 2^-32 cycles
+    float meanLuminance;
+    float depth;
+};
+
+// Mirrors FlickerUniforms in flickerShaderCode
+struct FlickerUniforms {
+    uint32_t frame; // frames since onset
+    uint32_t padding[3];
+};
+
+// Vertex + fragment shader drawing all targets as one instanced draw:
+// group 0 binding 0 is the read-only target array, group 1 the FlickerUniforms.
+extern const char* const flickerShaderCode;
+
+FlickerTarget makeFlickerTarget(const FlickerSpec& spec, double refreshHz);
+
+// Exact phase of a target at a frame, in units of 2^-32 cycles
+uint32_t flickerPhase(const FlickerTarget& target, uint32_t frame);
+
+// CPU reference of the luminance the shader outputs for a target at a frame
+float flickerLuminance(const FlickerTarget& target, uint32_t frame);
+
+// Frequency actually produced after quantizing the phase step
+double flickerRealizedFrequency(const FlickerTarget& target, double refreshHz);
@@ -0,0 +1,194 @@
+#include "FrameCapture.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+void FrameCapture::init(const wgpu::Device& dev, uint32_t ringSize, size_t maxQueued) {
+    shutdown();
+    device = dev;
+    slots.assign(std::max(ringSize, 1u), Slot());
+    for (Slot& slot : slots) {
+        slot.owner = this;
+    }
+    recording = nullptr;
+    cursor = 0;
+    maxQueue = std::max<size_t>(maxQueued, 1);
+    stopping = false;
+    worker = std::thread(&FrameCapture::run, this);
+}
+
+void FrameCapture::shutdown() {
+    if (!worker.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        queued.clear();
+    }
+    wake.notify_all();
+    worker.join();
+}
+
+void FrameCapture::setInterval(uint32_t every) {
+    interval = every;
+    nextFrame = 0;
+}
+
+void FrameCapture::setConsumer(Consumer newConsumer) {
+    std::lock_guard<std::mutex> lock(mutex);
+    consumer = std::move(newConsumer);
+}
+
+bool FrameCapture::begin(uint64_t frameIndex, double vsyncTime, uint32_t width, uint32_t height) {
+    // Undamaged frames are not rendered, so a due capture waits for the next
+    // frame that is; the display did not change in between
+    if (interval == 0 || frameIndex < nextFrame || slots.empty() || width == 0 || height == 0) {
+        return false;
+    }
+    nextFrame = frameIndex + interval;
+
+    Slot* slot = nullptr;
+    for (size_t i = 0; i < slots.size() && !slot; ++i) {
+        Slot& candidate = slots[(cursor + i) % slots.size()];
+        if (candidate.state == SlotState::Free) {
+            slot = &candidate;
+        }
+    }
+    if (!slot) {
+        std::lock_guard<std::mutex> lock(mutex);
+        counters.droppedBusy++;
+        return false;
+    }
+    cursor = size_t(slot - slots.data() + 1) % slots.size();
+
+    // Rows of a texture-to-buffer copy are padded to 256 bytes
+    uint32_t bytesPerRow = (width * 4 + 255) / 256 * 256;
+    uint64_t size = uint64_t(bytesPerRow) * height;
+    if (slot->size != size) {
+        if (slot->buffer) {
+            slot->buffer.Destroy();
+        }
+        wgpu::BufferDescriptor desc = {};
+        desc.label = "Capture readback";
+        desc.size = size;
+        desc.usage = wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::MapRead;
+        slot->buffer = device.CreateBuffer(&desc);
+        slot->size = size;
+    }
+
+    slot->state = SlotState::Recording;
+    slot->frameIndex = frameIndex;
+    slot->vsyncTime = vsyncTime;
+    slot->width = width;
+    slot->height = height;
+    slot->bytesPerRow = bytesPerRow;
+    recording = slot;
+    return true;
+}
+
+void FrameCapture::encodeCopy(wgpu::CommandEncoder& encoder, const wgpu::Texture& texture) {
+    if (!recording) {
+        return;
+    }
+    wgpu::ImageCopyTexture source = {};
+    source.texture = texture;
+
+    wgpu::ImageCopyBuffer destination = {};
+    destination.buffer = recording->buffer;
+    destination.layout.bytesPerRow = recording->bytesPerRow;
+    destination.layout.rowsPerImage = recording->height;
+
+    wgpu::Extent3D extent = { recording->width, recording->height, 1 };
+    encoder.CopyTextureToBuffer(&source, &destination, &extent);
+}
+
+void FrameCapture::submitted() {
+    if (!recording) {
+        return;
+    }
+    recording->state = SlotState::Mapping;
+    recording->buffer.MapAsync(wgpu::MapMode::Read, 0, recording->size, onMapped, recording);
+    recording = nullptr;
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.captured++;
+}
+
+void FrameCapture::onMapped(WGPUBufferMapAsyncStatus status, void* userdata) {
+    auto* slot = static_cast<Slot*>(userdata);
+    if (status == WGPUBufferMapAsyncStatus_Success) {
+        slot->owner->deliver(*slot);
+    } else {
+        std::cerr << "Capture readback failed to map." << std::endl;
+        std::lock_guard<std::mutex> lock(slot->owner->mutex);
+        slot->owner->counters.failed++;
+    }
+    slot->buffer.Unmap();
+    slot->state = SlotState::Free;
+}
+
+void FrameCapture::deliver(Slot& slot) {
+    Frame frame;
+    frame.frameIndex = slot.frameIndex;
+    frame.vsyncTime = slot.vsyncTime;
+    frame.width = slot.width;
+    frame.height = slot.height;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (queued.size() >= maxQueue) {
+            counters.droppedQueue++;
+            return;
+        }
+        if (!spare.empty()) {
+            frame.rgba = std::move(spare.back());
+            spare.pop_back();
+        }
+    }
+
+    // Only strip the row padding here; the mapped range is only valid until
+    // Unmap, everything else happens on the worker
+    size_t rowBytes = size_t(slot.width) * 4;
+    frame.rgba.resize(rowBytes * slot.height);
+    const auto* mapped = static_cast<const uint8_t*>(slot.buffer.GetConstMappedRange(0, slot.size));
+    for (uint32_t y = 0; y < slot.height; ++y) {
+        std::memcpy(frame.rgba.data() + y * rowBytes, mapped + size_t(y) * slot.bytesPerRow, rowBytes);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued.push_back(std::move(frame));
+    }
+    wake.notify_one();
+}
+
+void FrameCapture::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !queued.empty(); });
+        if (stopping) {
+            return;
+        }
+        Frame frame = std::move(queued.front());
+        queued.pop_front();
+        Consumer current = consumer;
+        lock.unlock();
+
+        // The capture texture is BGRA like the swap chain
+        for (size_t i = 0; i < frame.rgba.size(); i += 4) {
+            std::swap(frame.rgba[i], frame.rgba[i + 2]);
+        }
+        if (current) {
+            current(frame);
+        }
+
+        lock.lock();
+        counters.delivered++;
+        spare.push_back(std::move(frame.rgba));
+    }
+}
+
+FrameCapture::Stats FrameCapture::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
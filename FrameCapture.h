@@ -0,0 +1,101 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <webgpu/webgpu_cpp.h>
+
+// Audit capture of what was presented. Every Nth rendered frame the output
+// pass is repeated into an offscreen texture, which is copied into one of a
+// ring of MapRead buffers and mapped asynchronously once the GPU gets there,
+// usually a few frames later. frame() never waits on the GPU: when every
+// buffer is still in flight the capture is skipped and counted as dropped.
+// Mapped frames are unpacked on a worker thread and handed to a consumer
+// for hashing or encoding.
+class FrameCapture {
+public:
+    struct Frame {
+        uint64_t frameIndex = 0;
+        double vsyncTime = 0.0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> rgba; // width * height * 4, top row first
+    };
+
+    // Runs on the worker thread, one frame at a time in capture order
+    using Consumer = std::function<void(const Frame& frame)>;
+
+    struct Stats {
+        uint64_t captured = 0;     // copies recorded into a readback buffer
+        uint64_t delivered = 0;    // frames handed to the consumer
+        uint64_t droppedBusy = 0;  // no free readback buffer, GPU too far behind
+        uint64_t droppedQueue = 0; // worker too far behind
+        uint64_t failed = 0;       // map errors
+    };
+
+    // The texture format captured frames are rendered in; matches the swap chain
+    static constexpr wgpu::TextureFormat kFormat = wgpu::TextureFormat::BGRA8Unorm;
+
+    ~FrameCapture() { shutdown(); }
+
+    void init(const wgpu::Device& device, uint32_t ringSize = 4, size_t maxQueued = 8);
+    // Stop the worker, dropping frames it has not started on
+    void shutdown();
+
+    // Capture every `every` rendered frames; 0 turns capture off
+    void setInterval(uint32_t every);
+    void setConsumer(Consumer consumer);
+
+    // Whether the frame being built should be captured. On true a readback
+    // buffer is reserved and encodeCopy and submitted must follow this frame.
+    bool begin(uint64_t frameIndex, double vsyncTime, uint32_t width, uint32_t height);
+    // Copy the rendered capture texture into the reserved buffer
+    void encodeCopy(wgpu::CommandEncoder& encoder, const wgpu::Texture& texture);
+    // After queue.Submit: start mapping the buffer
+    void submitted();
+
+    Stats stats() const;
+
+private:
+    enum class SlotState { Free, Recording, Mapping };
+
+    struct Slot {
+        FrameCapture* owner = nullptr;
+        wgpu::Buffer buffer;
+        uint64_t size = 0;
+        SlotState state = SlotState::Free;
+        uint64_t frameIndex = 0;
+        double vsyncTime = 0.0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t bytesPerRow = 0;
+    };
+
+    static void onMapped(WGPUBufferMapAsyncStatus status, void* userdata);
+    void deliver(Slot& slot);
+    void run();
+
+    wgpu::Device device;
+    std::vector<Slot> slots; // sized once in init; map callbacks point into it
+    Slot* recording = nullptr;
+    size_t cursor = 0;
+    uint32_t interval = 0;
+    uint64_t nextFrame = 0;
+
+    // Worker side: frames waiting for the consumer and spare pixel storage
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Frame> queued;
+    std::vector<std::vector<uint8_t>> spare;
+    size_t maxQueue = 8;
+    bool stopping = false;
+    Consumer consumer;
+    std::thread worker;
+    Stats counters; // every field, including the render thread's, under mutex
+};
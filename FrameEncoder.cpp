@@ -0,0 +1,541 @@
+#include "FrameEncoder.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
+#include "Parallel.h"
+
+namespace {
+
+// Rows per stripe so each thread gets at least ~64k pixels
+size_t minStripeRows(uint32_t width) {
+    return std::max<size_t>(1, 65536 / std::max(width, 1u));
+}
+
+void putBigEndian(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(uint8_t(value >> 24));
+    out.push_back(uint8_t(value >> 16));
+    out.push_back(uint8_t(value >> 8));
+    out.push_back(uint8_t(value));
+}
+
+// ---------------------------------------------------------------------------
+// Checksums
+
+// Slicing-by-8 tables: table[k][n] is the CRC of byte n followed by k zeros
+using CrcTables = std::array<std::array<uint32_t, 256>, 8>;
+
+const CrcTables& crcTables() {
+    static const CrcTables tables = [] {
+        CrcTables t = {};
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            t[0][n] = c;
+        }
+        for (uint32_t n = 0; n < 256; ++n) {
+            for (int k = 1; k < 8; ++k) {
+                t[k][n] = t[0][t[k - 1][n] & 0xff] ^ (t[k - 1][n] >> 8);
+            }
+        }
+        return t;
+    }();
+    return tables;
+}
+
+uint32_t crc32(const uint8_t* data, size_t size) {
+    const CrcTables& t = crcTables();
+    uint32_t c = 0xffffffffu;
+    for (; size >= 8; data += 8, size -= 8) {
+        uint32_t low, high;
+        std::memcpy(&low, data, 4);
+        std::memcpy(&high, data + 4, 4);
+        low ^= c;
+        c = t[7][low & 0xff] ^ t[6][(low >> 8) & 0xff] ^ t[5][(low >> 16) & 0xff] ^ t[4][low >> 24] ^
+            t[3][high & 0xff] ^ t[2][(high >> 8) & 0xff] ^ t[1][(high >> 16) & 0xff] ^ t[0][high >> 24];
+    }
+    for (; size > 0; ++data, --size) {
+        c = t[0][(c ^ *data) & 0xff] ^ (c >> 8);
+    }
+    return c ^ 0xffffffffu;
+}
+
+constexpr uint32_t kAdlerBase = 65521;
+
+uint32_t adler32(const uint8_t* data, size_t size) {
+    uint32_t a = 1;
+    uint32_t b = 0;
+    while (size > 0) {
+        // Largest run that cannot overflow 32 bits before the modulo
+        size_t n = std::min<size_t>(size, 5552);
+        for (size_t i = 0; i < n; ++i) {
+            a += data[i];
+            b += a;
+        }
+        a %= kAdlerBase;
+        b %= kAdlerBase;
+        data += n;
+        size -= n;
+    }
+    return b << 16 | a;
+}
+
+// Adler-32 of A followed by B from the checksums of each and B's length
+uint32_t adler32Combine(uint32_t first, uint32_t second, size_t secondSize) {
+    uint32_t remainder = uint32_t(secondSize % kAdlerBase);
+    uint32_t sum1 = first & 0xffff;
+    uint32_t sum2 = uint32_t((uint64_t(remainder) * sum1) % kAdlerBase);
+    sum1 += (second & 0xffff) + kAdlerBase - 1;
+    sum2 += ((first >> 16) & 0xffff) + ((second >> 16) & 0xffff) + kAdlerBase - remainder;
+    if (sum1 >= kAdlerBase) sum1 -= kAdlerBase;
+    if (sum1 >= kAdlerBase) sum1 -= kAdlerBase;
+    if (sum2 >= kAdlerBase * 2) sum2 -= kAdlerBase * 2;
+    if (sum2 >= kAdlerBase) sum2 -= kAdlerBase;
+    return sum2 << 16 | sum1;
+}
+
+// ---------------------------------------------------------------------------
+// PNG chunks and filtering
+
+// Appends the length placeholder and type; returns where the chunk starts
+size_t beginChunk(std::vector<uint8_t>& out, const char* type) {
+    size_t start = out.size();
+    putBigEndian(out, 0);
+    out.insert(out.end(), type, type + 4);
+    return start;
+}
+
+void endChunk(std::vector<uint8_t>& out, size_t start) {
+    uint32_t length = uint32_t(out.size() - start - 8);
+    out[start] = uint8_t(length >> 24);
+    out[start + 1] = uint8_t(length >> 16);
+    out[start + 2] = uint8_t(length >> 8);
+    out[start + 3] = uint8_t(length);
+    putBigEndian(out, crc32(out.data() + start + 4, length + 4));
+}
+
+// Up filter against the row above, Sub for the first row; both are a
+// plain bytewise subtraction
+void filterRow(const uint8_t* row, const uint8_t* above, size_t bytes, uint8_t* out) {
+    *out++ = above ? 2 : 1;
+    size_t i = 0;
+    const uint8_t* reference = above;
+    if (!above) {
+        size_t first = std::min<size_t>(4, bytes);
+        std::memcpy(out, row, first);
+        i = first;
+        reference = row - 4;
+    }
+#ifdef __wasm_simd128__
+    for (; i + 16 <= bytes; i += 16) {
+        wasm_v128_store(out + i, wasm_i8x16_sub(wasm_v128_load(row + i), wasm_v128_load(reference + i)));
+    }
+#endif
+    for (; i < bytes; ++i) {
+        out[i] = uint8_t(row[i] - reference[i]);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Deflate
+
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : out(out) {}
+
+    // `count` bits of `bits`, least significant first
+    void put(uint32_t bits, uint32_t count) {
+        buffer |= uint64_t(bits) << used;
+        used += count;
+        if (used >= 32) {
+            uint8_t bytes[4] = { uint8_t(buffer), uint8_t(buffer >> 8), uint8_t(buffer >> 16), uint8_t(buffer >> 24) };
+            out.insert(out.end(), bytes, bytes + 4);
+            buffer >>= 32;
+            used -= 32;
+        }
+    }
+
+    void align() {
+        while (used > 0) {
+            out.push_back(uint8_t(buffer));
+            buffer >>= 8;
+            used = used > 8 ? used - 8 : 0;
+        }
+        buffer = 0;
+    }
+
+private:
+    std::vector<uint8_t>& out;
+    uint64_t buffer = 0;
+    uint32_t used = 0;
+};
+
+const uint16_t kLengthBase[29] = { 3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                   31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+const uint8_t kLengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+const uint16_t kDistanceBase[30] = { 1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+                                     193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+const uint8_t kDistanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+uint32_t reverseBits(uint32_t code, uint32_t count) {
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        result = (result << 1) | ((code >> i) & 1);
+    }
+    return result;
+}
+
+// Fixed Huffman codes (RFC 1951, 3.2.6), bit-reversed for LSB-first output
+struct FixedCodes {
+    uint16_t literal[288];
+    uint8_t literalBits[288];
+    uint8_t distance[30];
+    uint8_t lengthIndex[259];    // match length -> index into kLengthBase
+    uint8_t distanceIndex[512];  // see distanceCode()
+
+    FixedCodes() {
+        for (uint32_t s = 0; s < 288; ++s) {
+            uint32_t code, bits;
+            if (s < 144) {
+                code = 0x30 + s, bits = 8;
+            } else if (s < 256) {
+                code = 0x190 + s - 144, bits = 9;
+            } else if (s < 280) {
+                code = s - 256, bits = 7;
+            } else {
+                code = 0xc0 + s - 280, bits = 8;
+            }
+            literal[s] = uint16_t(reverseBits(code, bits));
+            literalBits[s] = uint8_t(bits);
+        }
+        for (uint32_t d = 0; d < 30; ++d) {
+            distance[d] = uint8_t(reverseBits(d, 5));
+        }
+        for (uint32_t i = 0; i < 29; ++i) {
+            uint32_t end = i + 1 < 29 ? kLengthBase[i + 1] : 259;
+            for (uint32_t length = kLengthBase[i]; length < end; ++length) {
+                lengthIndex[length] = uint8_t(i);
+            }
+        }
+        // Distances up to 256 directly, larger ones in steps of 128
+        for (uint32_t i = 0; i < 30; ++i) {
+            uint32_t end = i + 1 < 30 ? kDistanceBase[i + 1] : 32769;
+            for (uint32_t d = kDistanceBase[i]; d < end; ++d) {
+                uint32_t slot = d - 1 < 256 ? d - 1 : 256 + ((d - 1) >> 7);
+                distanceIndex[slot] = uint8_t(i);
+            }
+        }
+    }
+
+    uint32_t distanceCode(uint32_t d) const { return distanceIndex[d - 1 < 256 ? d - 1 : 256 + ((d - 1) >> 7)]; }
+};
+
+const FixedCodes& fixedCodes() {
+    static const FixedCodes codes;
+    return codes;
+}
+
+// Ends a stripe: the last one closes the stream, others append an empty
+// stored block so the next stripe starts on a byte boundary
+void finishSegment(BitWriter& bits, std::vector<uint8_t>& out, bool last) {
+    if (!last) {
+        bits.put(0, 3);
+    }
+    bits.align();
+    if (!last) {
+        const uint8_t empty[4] = { 0x00, 0x00, 0xff, 0xff };
+        out.insert(out.end(), empty, empty + 4);
+    }
+}
+
+void deflateStored(const uint8_t* data, size_t size, bool last, std::vector<uint8_t>& out) {
+    size_t offset = 0;
+    do {
+        size_t n = std::min<size_t>(size - offset, 65535);
+        bool final = last && offset + n == size;
+        uint8_t header[5] = { uint8_t(final ? 1 : 0), uint8_t(n), uint8_t(n >> 8), uint8_t(~n), uint8_t(~n >> 8) };
+        out.insert(out.end(), header, header + 5);
+        out.insert(out.end(), data + offset, data + offset + n);
+        offset += n;
+    } while (offset < size);
+}
+
+// Greedy LZ77 with a one-entry hash table and fixed Huffman codes; filtered
+// stimulus rows are mostly runs of zeros, which this handles well
+void deflateFast(const uint8_t* data, size_t size, bool last, std::vector<uint8_t>& out) {
+    constexpr uint32_t kHashBits = 15;
+    constexpr uint32_t kNone = 0xffffffffu;
+    const FixedCodes& codes = fixedCodes();
+    std::vector<uint32_t> table(size_t(1) << kHashBits, kNone);
+
+    BitWriter bits(out);
+    bits.put(last ? 1 : 0, 1);
+    bits.put(1, 2); // fixed Huffman block
+
+    size_t i = 0;
+    while (i < size) {
+        if (i + 4 <= size) {
+            uint32_t word;
+            std::memcpy(&word, data + i, 4);
+            uint32_t h = (word * 2654435761u) >> (32 - kHashBits);
+            uint32_t candidate = table[h];
+            table[h] = uint32_t(i);
+            uint32_t other;
+            if (candidate != kNone && i - candidate <= 32768 && (std::memcpy(&other, data + candidate, 4), other == word)) {
+                size_t maxLength = std::min<size_t>(258, size - i);
+                size_t length = 4;
+                while (length < maxLength && data[candidate + length] == data[i + length]) {
+                    ++length;
+                }
+
+                uint32_t li = codes.lengthIndex[length];
+                uint32_t symbol = 257 + li;
+                bits.put(codes.literal[symbol], codes.literalBits[symbol]);
+                bits.put(uint32_t(length - kLengthBase[li]), kLengthExtra[li]);
+
+                uint32_t distance = uint32_t(i - candidate);
+                uint32_t di = codes.distanceCode(distance);
+                bits.put(codes.distance[di], 5);
+                bits.put(distance - kDistanceBase[di], kDistanceExtra[di]);
+
+                i += length;
+                continue;
+            }
+        }
+        bits.put(codes.literal[data[i]], codes.literalBits[data[i]]);
+        ++i;
+    }
+    bits.put(codes.literal[256], codes.literalBits[256]);
+    finishSegment(bits, out, last);
+}
+
+struct PngStripe {
+    std::vector<uint8_t> filtered;
+    std::vector<uint8_t> chunk; // complete IDAT chunk
+    uint32_t adler = 1;
+};
+
+// ---------------------------------------------------------------------------
+// QOI
+
+constexpr uint32_t kQoiOpaqueBlack = 0xff000000u; // r, g, b, a = 0, 0, 0, 255 in memory order
+
+inline uint32_t loadPixel(const uint8_t* rgba, size_t i) {
+    uint32_t px;
+    std::memcpy(&px, rgba + i * 4, 4);
+    return px;
+}
+
+inline uint32_t qoiHash(uint32_t px) {
+    uint32_t r = px & 0xff, g = (px >> 8) & 0xff, b = (px >> 16) & 0xff, a = px >> 24;
+    return (r * 3 + g * 5 + b * 7 + a * 11) % 64;
+}
+
+// What a stripe contributes to the index seen by the stripes after it
+struct QoiScan {
+    uint32_t last[64];
+    bool has[64];
+    bool leadBlack; // starts with the encoder's initial previous pixel
+    bool allBlack;  // consists only of it
+};
+
+void scanQoiStripe(const uint8_t* rgba, size_t begin, size_t end, QoiScan& scan) {
+    std::fill(scan.has, scan.has + 64, false);
+    size_t i = begin;
+    while (i < end && loadPixel(rgba, i) == kQoiOpaqueBlack) {
+        ++i;
+    }
+    scan.leadBlack = i > begin;
+    scan.allBlack = i == end;
+    for (; i < end; ++i) {
+        uint32_t px = loadPixel(rgba, i);
+        uint32_t h = qoiHash(px);
+        scan.last[h] = px;
+        scan.has[h] = true;
+    }
+}
+
+void encodeQoiStripe(const uint8_t* rgba, size_t begin, size_t end, uint32_t previous, uint32_t index[64],
+                     std::vector<uint8_t>& out) {
+    uint32_t run = 0;
+    for (size_t i = begin; i < end; ++i) {
+        uint32_t px = loadPixel(rgba, i);
+        if (px == previous) {
+            if (++run == 62) {
+                out.push_back(uint8_t(0xc0 | (run - 1)));
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0) {
+            out.push_back(uint8_t(0xc0 | (run - 1)));
+            run = 0;
+        }
+
+        uint32_t h = qoiHash(px);
+        if (index[h] == px) {
+            out.push_back(uint8_t(h));
+        } else {
+            index[h] = px;
+            uint8_t r = uint8_t(px), g = uint8_t(px >> 8), b = uint8_t(px >> 16), a = uint8_t(px >> 24);
+            if (a == uint8_t(previous >> 24)) {
+                int vr = int8_t(r - uint8_t(previous));
+                int vg = int8_t(g - uint8_t(previous >> 8));
+                int vb = int8_t(b - uint8_t(previous >> 16));
+                int vgr = vr - vg;
+                int vgb = vb - vg;
+                if (vr >= -2 && vr <= 1 && vg >= -2 && vg <= 1 && vb >= -2 && vb <= 1) {
+                    out.push_back(uint8_t(0x40 | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2)));
+                } else if (vgr >= -8 && vgr <= 7 && vg >= -32 && vg <= 31 && vgb >= -8 && vgb <= 7) {
+                    out.push_back(uint8_t(0x80 | (vg + 32)));
+                    out.push_back(uint8_t((vgr + 8) << 4 | (vgb + 8)));
+                } else {
+                    const uint8_t op[4] = { 0xfe, r, g, b };
+                    out.insert(out.end(), op, op + 4);
+                }
+            } else {
+                const uint8_t op[5] = { 0xff, r, g, b, a };
+                out.insert(out.end(), op, op + 5);
+            }
+        }
+        previous = px;
+    }
+    if (run > 0) {
+        out.push_back(uint8_t(0xc0 | (run - 1)));
+    }
+}
+
+} // namespace
+
+void encodePng(const uint8_t* rgba, uint32_t width, uint32_t height, bool compress, std::vector<uint8_t>& out) {
+    encodePng(rgba, width, height, compress, parallelChunks(height, minStripeRows(width)), out);
+}
+
+void encodePng(const uint8_t* rgba, uint32_t width, uint32_t height, bool compress, size_t stripeCount,
+               std::vector<uint8_t>& out) {
+    out.clear();
+    const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    out.insert(out.end(), signature, signature + 8);
+
+    size_t start = beginChunk(out, "IHDR");
+    putBigEndian(out, width);
+    putBigEndian(out, height);
+    const uint8_t format[5] = { 8, 6, 0, 0, 0 }; // 8-bit RGBA, deflate, adaptive filters, no interlace
+    out.insert(out.end(), format, format + 5);
+    endChunk(out, start);
+
+    // Stripe buffers are reused by later frames encoded on the same thread
+    size_t rowBytes = size_t(width) * 4;
+    stripeCount = std::clamp<size_t>(stripeCount, 1, std::max<uint32_t>(height, 1));
+    thread_local std::vector<PngStripe> stripes;
+    stripes.resize(stripeCount);
+    parallelFor(stripeCount, 1, [&](size_t, size_t firstStripe, size_t endStripe) {
+        for (size_t chunk = firstStripe; chunk < endStripe; ++chunk) {
+            size_t begin = height * chunk / stripeCount, end = height * (chunk + 1) / stripeCount;
+            PngStripe& stripe = stripes[chunk];
+            stripe.filtered.resize((end - begin) * (rowBytes + 1));
+            for (size_t y = begin; y < end; ++y) {
+                filterRow(rgba + y * rowBytes, y > 0 ? rgba + (y - 1) * rowBytes : nullptr, rowBytes,
+                          stripe.filtered.data() + (y - begin) * (rowBytes + 1));
+            }
+            stripe.adler = adler32(stripe.filtered.data(), stripe.filtered.size());
+
+            stripe.chunk.clear();
+            size_t chunkStart = beginChunk(stripe.chunk, "IDAT");
+            if (chunk == 0) {
+                stripe.chunk.push_back(0x78); // zlib header: deflate, 32k window, no dictionary
+                stripe.chunk.push_back(0x01);
+            }
+            bool last = chunk + 1 == stripeCount;
+            if (compress) {
+                deflateFast(stripe.filtered.data(), stripe.filtered.size(), last, stripe.chunk);
+            } else {
+                deflateStored(stripe.filtered.data(), stripe.filtered.size(), last, stripe.chunk);
+            }
+            endChunk(stripe.chunk, chunkStart);
+        }
+    });
+
+    uint32_t adler = 1;
+    for (const PngStripe& stripe : stripes) {
+        out.insert(out.end(), stripe.chunk.begin(), stripe.chunk.end());
+        adler = adler32Combine(adler, stripe.adler, stripe.filtered.size());
+    }
+
+    // The zlib trailer as a chunk of its own, once every stripe is in
+    start = beginChunk(out, "IDAT");
+    putBigEndian(out, adler);
+    endChunk(out, start);
+    start = beginChunk(out, "IEND");
+    endChunk(out, start);
+}
+
+void encodeQoi(const uint8_t* rgba, uint32_t width, uint32_t height, std::vector<uint8_t>& out) {
+    out.clear();
+    const uint8_t magic[4] = { 'q', 'o', 'i', 'f' };
+    out.insert(out.end(), magic, magic + 4);
+    putBigEndian(out, width);
+    putBigEndian(out, height);
+    out.push_back(4); // RGBA
+    out.push_back(0); // sRGB with linear alpha
+
+    // Rows per stripe; QOI output is at most 5 bytes per pixel
+    size_t minRows = minStripeRows(width);
+    size_t chunks = std::max<size_t>(1, parallelChunks(height, minRows));
+    thread_local std::vector<QoiScan> scans;
+    thread_local std::vector<std::vector<uint8_t>> encoded;
+    scans.resize(chunks);
+    encoded.resize(chunks);
+
+    parallelFor(height, minRows, [&](size_t chunk, size_t begin, size_t end) {
+        scanQoiStripe(rgba, begin * width, end * width, scans[chunk]);
+    });
+
+    parallelFor(height, minRows, [&](size_t chunk, size_t begin, size_t end) {
+        // Replay the scans of the stripes before this one into the index.
+        // Pixels in the image's leading run of opaque black are encoded as a
+        // run and never enter the index.
+        uint32_t index[64] = {};
+        bool prefixBlack = true;
+        const uint32_t blackSlot = qoiHash(kQoiOpaqueBlack);
+        for (size_t j = 0; j < chunk; ++j) {
+            const QoiScan& scan = scans[j];
+            if (!prefixBlack && scan.leadBlack) {
+                index[blackSlot] = kQoiOpaqueBlack;
+            }
+            for (int h = 0; h < 64; ++h) {
+                if (scan.has[h]) {
+                    index[h] = scan.last[h];
+                }
+            }
+            prefixBlack = prefixBlack && scan.allBlack;
+        }
+        uint32_t previous = begin > 0 ? loadPixel(rgba, begin * width - 1) : kQoiOpaqueBlack;
+
+        std::vector<uint8_t>& stripe = encoded[chunk];
+        stripe.clear();
+        stripe.reserve((end - begin) * width * 5);
+        encodeQoiStripe(rgba, begin * width, end * width, previous, index, stripe);
+    });
+
+    for (const std::vector<uint8_t>& stripe : encoded) {
+        out.insert(out.end(), stripe.begin(), stripe.end());
+    }
+    const uint8_t padding[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+    out.insert(out.end(), padding, padding + 8);
+}
+
+void encodeImage(const uint8_t* rgba, uint32_t width, uint32_t height, ImageFormat format, std::vector<uint8_t>& out) {
+    if (format == ImageFormat::Qoi) {
+        encodeQoi(rgba, width, height, out);
+    } else {
+        encodePng(rgba, width, height, format == ImageFormat::PngFast, out);
+    }
+}
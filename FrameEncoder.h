@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Encoders for captured RGBA8 frames, fast enough to run on the capture
+// worker without it falling behind. The image is cut into stripes of rows
+// that are filtered and compressed on separate threads and concatenated.
+enum class ImageFormat : uint32_t {
+    PngStored = 0, // PNG with uncompressed deflate blocks: fastest, largest
+    PngFast = 1,   // PNG with greedy LZ77 and fixed Huffman codes
+    Qoi = 2,       // Quite OK Image format
+};
+
+// PNG, 8-bit RGBA. Rows use the Up filter (Sub for the first row); each
+// stripe is an independent deflate segment ending on a byte boundary and
+// goes in its own IDAT chunk, so stripes never wait on each other.
+void encodePng(const uint8_t* rgba, uint32_t width, uint32_t height, bool compress, std::vector<uint8_t>& out);
+
+// The same with a given number of stripes, clamped to [1, height];
+// encodePng() above uses one per worker with enough rows each
+void encodePng(const uint8_t* rgba, uint32_t width, uint32_t height, bool compress, size_t stripes,
+               std::vector<uint8_t>& out);
+
+// QOI. The format is sequential, but the encoder state at the start of a
+// stripe only depends on the last pixel before it and the last pixel seen
+// for each of the 64 index slots, which a quick parallel scan recovers; the
+// stripes then encode independently into a byte-identical stream.
+void encodeQoi(const uint8_t* rgba, uint32_t width, uint32_t height, std::vector<uint8_t>& out);
+
+// Replaces `out` with the encoded image; capacity is kept for the next frame
+void encodeImage(const uint8_t* rgba, uint32_t width, uint32_t height, ImageFormat format, std::vector<uint8_t>& out);
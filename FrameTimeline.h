@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Per-vsync record, kept whether or not the frame was actually rendered
+struct FrameRecord {
+    uint32_t frameIndex = 0;
+    double vsyncTime = 0.0;   // requestAnimationFrame timestamp, ms
+    double cpuStart = 0.0;    // emscripten_get_now() at frame() entry, ms
+    double cpuEnd = 0.0;      // emscripten_get_now() at frame() exit, ms
+    bool submitted = false;   // false when nothing changed and the frame was skipped
+    uint64_t redrawnPixels = 0;
+    uint32_t commands = 0;    // taken from the command queue at frame() entry
+    double latchTime = 0.0;   // stimulus uniforms late-latched, 0 when not
+    double submitTime = 0.0;  // queue.Submit returned
+    double inputTime = 0.0;   // sampling time of the latched input, 0 if none yet
+};
+
+// Late-latch timing of one frame, ms
+struct LatchTiming {
+    uint32_t frameIndex;
+    uint32_t padding;
+    double latchToSubmit;
+    double inputAge; // input sample to latch; negative when nothing was published yet
+};
+
+// Spread of the intervals between successive frame() calls, in ms. The vsync
+// figures use the rAF timestamps, which the browser snaps to the display's
+// vsync; the callback figures use cpuStart, so they also show a loop whose
+// thread was busy with other work when the frame was due.
+struct JitterStats {
+    uint32_t intervals = 0;
+    double medianInterval = 0.0;   // vsync
+    double vsyncStddev = 0.0;
+    double callbackStddev = 0.0;
+    double callbackMaxDeviation = 0.0; // largest |interval - median|
+    uint32_t longIntervals = 0;        // vsync intervals over 1.5 medians: missed frames
+};
+
+// Fixed-size history of the most recent frames; recording never allocates.
+class FrameTimeline {
+public:
+    explicit FrameTimeline(size_t capacity = 4096) : records(capacity) {}
+
+    void record(const FrameRecord& frame) {
+        records[count % records.size()] = frame;
+        count++;
+    }
+
+    // Total frames recorded, including ones already overwritten
+    uint64_t total() const { return count; }
+    size_t size() const { return count < records.size() ? size_t(count) : records.size(); }
+
+    // i = 0 is the oldest retained frame
+    const FrameRecord& at(size_t i) const {
+        uint64_t first = count - size();
+        return records[(first + i) % records.size()];
+    }
+
+    // Display refresh rate from the median of the last kRefreshWindow vsync
+    // intervals; fallback if too few frames. Called every frame, so the
+    // median is cached and only recomputed every kRefreshEvery records, in
+    // a fixed scratch array.
+    double estimateRefreshHz(double fallback) const {
+        if (size() < 8) {
+            return fallback;
+        }
+        if (refreshAt == 0 || count - refreshAt >= kRefreshEvery) {
+            size_t n = std::min(size() - 1, kRefreshWindow);
+            for (size_t i = 0; i < n; ++i) {
+                size_t newer = size() - 1 - i;
+                refreshScratch[i] = at(newer).vsyncTime - at(newer - 1).vsyncTime;
+            }
+            std::nth_element(refreshScratch.begin(), refreshScratch.begin() + n / 2, refreshScratch.begin() + n);
+            refreshInterval = refreshScratch[n / 2];
+            refreshAt = count;
+        }
+        return refreshInterval > 0.0 ? 1000.0 / refreshInterval : fallback;
+    }
+
+    JitterStats jitterStats() const {
+        JitterStats stats;
+        size_t n = size();
+        if (n < 2) {
+            return stats;
+        }
+        std::vector<double> vsync(n - 1);
+        std::vector<double> callback(n - 1);
+        for (size_t i = 1; i < n; ++i) {
+            vsync[i - 1] = at(i).vsyncTime - at(i - 1).vsyncTime;
+            callback[i - 1] = at(i).cpuStart - at(i - 1).cpuStart;
+        }
+        stats.intervals = static_cast<uint32_t>(vsync.size());
+        stats.vsyncStddev = stddev(vsync);
+        stats.callbackStddev = stddev(callback);
+
+        std::vector<double> sorted = vsync;
+        std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
+        stats.medianInterval = sorted[sorted.size() / 2];
+        for (size_t i = 0; i < vsync.size(); ++i) {
+            stats.callbackMaxDeviation = std::max(stats.callbackMaxDeviation,
+                                                  std::abs(callback[i] - stats.medianInterval));
+            if (vsync[i] > 1.5 * stats.medianInterval) {
+                stats.longIntervals++;
+            }
+        }
+        return stats;
+    }
+
+    std::vector<LatchTiming> latchTimings() const {
+        std::vector<LatchTiming> timings;
+        for (size_t i = 0; i < size(); ++i) {
+            const FrameRecord& frame = at(i);
+            if (frame.latchTime > 0.0) {
+                double inputAge = frame.inputTime > 0.0 ? frame.latchTime - frame.inputTime : -1.0;
+                timings.push_back({ frame.frameIndex, 0, frame.submitTime - frame.latchTime, inputAge });
+            }
+        }
+        return timings;
+    }
+
+    const FrameRecord* latest() const { return count ? &records[(count - 1) % records.size()] : nullptr; }
+
+private:
+    static double stddev(const std::vector<double>& values) {
+        double mean = 0.0;
+        for (double v : values) {
+            mean += v;
+        }
+        mean /= values.size();
+        double variance = 0.0;
+        for (double v : values) {
+            variance += (v - mean) * (v - mean);
+        }
+        return std::sqrt(variance / values.size());
+    }
+
+    static constexpr size_t kRefreshWindow = 240;
+    static constexpr uint64_t kRefreshEvery = 60;
+
+    std::vector<FrameRecord> records;
+    uint64_t count = 0;
+    mutable std::array<double, kRefreshWindow> refreshScratch;
+    mutable double refreshInterval = 0.0; // cached median vsync interval, ms
+    mutable uint64_t refreshAt = 0;       // count when it was computed
+};
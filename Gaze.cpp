@@ -0,0 +1,183 @@
+#include "Gaze.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "Noise.h"
+
+const char* const gazeShaderCode = R"(
+struct GazeUniforms {
+    center: vec2<f32>,
+    radius: f32,
+    feather: f32,
+    mode: u32,
+    blurPerPixel: f32,
+    maxBlur: f32,
+    valid: u32,
+};
+
+override backgroundR: f32;
+override backgroundG: f32;
+override backgroundB: f32;
+
+@group(0) @binding(0) var sceneTexture: texture_2d<f32>;
+@group(0) @binding(1) var<uniform> gaze: GazeUniforms;
+
+fn load(p: vec2<f32>) -> vec4<f32> {
+    let last = vec2<i32>(textureDimensions(sceneTexture)) - 1;
+    return textureLoad(sceneTexture, clamp(vec2<i32>(p), vec2<i32>(0), last), 0);
+}
+
+// 16 taps on a Vogel spiral filling a disk of `radius` pixels
+fn blurred(p: vec2<f32>, radius: f32) -> vec4<f32> {
+    var sum = vec4<f32>(0.0);
+    for (var i = 0u; i < 16u; i++) {
+        let r = sqrt((f32(i) + 0.5) / 16.0) * radius;
+        let theta = f32(i) * 2.39996323;
+        sum += load(p + r * vec2<f32>(cos(theta), sin(theta)));
+    }
+    return sum / 16.0;
+}
+
+@fragment
+fn main(@builtin(position) position: vec4<f32>) -> @location(0) vec4<f32> {
+    let background = vec4<f32>(backgroundR, backgroundG, backgroundB, 1.0);
+    let dist = length(position.xy - gaze.center);
+    // 1 inside the circle, 0 outside, with a soft edge of `feather` pixels
+    var inside = smoothstep(0.0, 1.0, clamp((gaze.radius - dist) / max(gaze.feather, 1e-3), 0.0, 1.0));
+
+    if (gaze.mode == 3u) {
+        var radius = gaze.maxBlur;
+        if (gaze.valid != 0u) {
+            radius = min(max(dist - gaze.radius, 0.0) * gaze.blurPerPixel, gaze.maxBlur);
+        }
+        if (radius < 0.5) {
+            return load(position.xy);
+        }
+        return blurred(position.xy, radius);
+    }
+
+    if (gaze.valid == 0u) {
+        return background;
+    }
+    if (gaze.mode == 2u) {
+        inside = 1.0 - inside;
+    }
+    return mix(background, load(position.xy), inside);
+}
+)";
+
+void encodeGazeSample(const GazeSample& sample, uint8_t* out) {
+    std::memcpy(out, &kGazeMagic, 4);
+    std::memcpy(out + 4, &sample.sequence, 4);
+    std::memcpy(out + 8, &sample.time, 8);
+    std::memcpy(out + 16, &sample.x, 4);
+    std::memcpy(out + 20, &sample.y, 4);
+    std::memcpy(out + 24, &sample.pupil, 4);
+    std::memcpy(out + 28, &sample.flags, 4);
+}
+
+GazeSample GazeDecoder::parse(const uint8_t* record) {
+    GazeSample sample = {};
+    std::memcpy(&sample.sequence, record + 4, 4);
+    std::memcpy(&sample.time, record + 8, 8);
+    std::memcpy(&sample.x, record + 16, 4);
+    std::memcpy(&sample.y, record + 20, 4);
+    std::memcpy(&sample.pupil, record + 24, 4);
+    std::memcpy(&sample.flags, record + 28, 4);
+    return sample;
+}
+
+SyntheticGaze::~SyntheticGaze() {
+    stop();
+}
+
+bool SyntheticGaze::start(double rateHz, uint32_t randomSeed, uint32_t batch, Clock sampleClock, Sink bytes) {
+    if (active.load() || rateHz <= 0.0 || !sampleClock || !bytes) {
+        return false;
+    }
+    samplePeriod = 1000.0 / rateHz;
+    recordsPerMessage = std::clamp(batch, 1u, 64u);
+    clock = sampleClock;
+    sink = std::move(bytes);
+
+    seed = randomSeed;
+    counter = 0;
+    sequence = 0;
+    fixationX = fixationY = startX = startY = 0.5f;
+    saccade = false;
+    phaseStart = phaseEnd = clock();
+
+    active = true;
+    worker = std::thread(&SyntheticGaze::run, this);
+    return true;
+}
+
+void SyntheticGaze::stop() {
+    active = false;
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+float SyntheticGaze::random() {
+    return float(noiseHash(counter++, 0, 0, seed).x >> 8) * (1.0f / 16777216.0f);
+}
+
+GazeSample SyntheticGaze::next(double time) {
+    if (time >= phaseEnd) {
+        phaseStart = time;
+        if (saccade) {
+            // Land and fixate for 150-450 ms
+            saccade = false;
+            phaseEnd = time + 150.0 + 300.0 * random();
+        } else {
+            // Saccade to a new target; the display is taken as 40 degrees
+            // wide for the main sequence, 21 ms + 2.2 ms per degree
+            startX = fixationX;
+            startY = fixationY;
+            fixationX = 0.1f + 0.8f * random();
+            fixationY = 0.1f + 0.8f * random();
+            float amplitude = std::hypot(fixationX - startX, fixationY - startY) * 40.0f;
+            saccade = true;
+            phaseEnd = time + 21.0 + 2.2 * amplitude;
+        }
+    }
+
+    GazeSample sample = {};
+    sample.time = time;
+    sample.sequence = sequence++;
+    sample.pupil = 3.5f + 0.1f * random();
+    sample.flags = kGazeValid;
+    if (saccade) {
+        double t = std::clamp((time - phaseStart) / (phaseEnd - phaseStart), 0.0, 1.0);
+        float s = static_cast<float>(t * t * t * (10.0 - 15.0 * t + 6.0 * t * t));
+        sample.x = startX + (fixationX - startX) * s;
+        sample.y = startY + (fixationY - startY) * s;
+        sample.flags |= kGazeSaccade;
+    } else {
+        // Tremor as the sum of two uniforms, about 0.1% of the display
+        sample.x = fixationX + 0.002f * (random() + random() - 1.0f);
+        sample.y = fixationY + 0.002f * (random() + random() - 1.0f);
+    }
+    return sample;
+}
+
+void SyntheticGaze::run() {
+    uint8_t message[64 * kGazeRecordSize];
+    auto period = std::chrono::duration<double, std::milli>(samplePeriod);
+    auto due = std::chrono::steady_clock::now();
+    uint32_t records = 0;
+    while (active.load()) {
+        std::this_thread::sleep_until(due);
+        due += std::chrono::duration_cast<std::chrono::steady_clock::duration>(period);
+
+        encodeGazeSample(next(clock()), message + records * kGazeRecordSize);
+        if (++records == recordsPerMessage) {
+            sink(message, records * kGazeRecordSize);
+            emittedSamples.fetch_add(records, std::memory_order_relaxed);
+            records = 0;
+        }
+    }
+}
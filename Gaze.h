@@ -0,0 +1,171 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+// Gaze-contingent display: the scene is shown through a window around the
+// point of gaze, hidden under a mask there, or blurred with eccentricity.
+enum class GazeMode : uint32_t {
+    Off = 0,
+    MovingWindow = 1, // scene inside the window, background outside
+    MovingMask = 2,   // background inside the mask, scene outside
+    FoveatedBlur = 3, // sharp inside the fovea, blur grows with distance beyond it
+};
+
+// Mirrors GazeUniforms in gazeShaderCode; positions and sizes in target pixels
+struct GazeUniforms {
+    float centerX;
+    float centerY;
+    float radius;       // window, mask or fovea radius
+    float feather;      // width of the soft edge
+    uint32_t mode;      // GazeMode
+    float blurPerPixel; // blur radius per pixel of eccentricity beyond the fovea
+    float maxBlur;
+    uint32_t valid;     // 0 without a tracked sample: window and mask show only
+                        // the background, the blur mode blurs everything
+};
+
+// Fragment shader for the gaze pass. Group 0: binding 0 the scene texture,
+// binding 1 the GazeUniforms. Overrides backgroundR/G/B set the background.
+extern const char* const gazeShaderCode;
+
+constexpr uint32_t kGazeValid = 1;   // the tracker found the eye
+constexpr uint32_t kGazeSaccade = 2; // synthetic samples: ground truth, inside a saccade
+
+struct GazeSample {
+    double time;       // ms on the emscripten_get_now() clock
+    float x;           // 0..1 across the display from the left
+    float y;           // 0..1 down the display from the top
+    float pupil;       // diameter in tracker units, 0 if not reported
+    uint32_t sequence; // per-source counter, gaps are dropped samples
+    uint32_t flags;
+    uint32_t padding;
+};
+
+// Wire format of one sample: 32 little-endian bytes
+//   0  u32 magic kGazeMagic     4  u32 sequence
+//   8  f64 time                16  f32 x   20 f32 y
+//  24  f32 pupil               28  u32 flags
+// Messages may hold any number of records, and a byte stream may split a
+// record anywhere; the decoder resynchronizes on the magic after garbage.
+constexpr uint32_t kGazeMagic = 0x315A4147; // "GAZ1"
+constexpr size_t kGazeRecordSize = 32;
+
+void encodeGazeSample(const GazeSample& sample, uint8_t* out);
+
+// Incremental decoder for one source; never allocates. Not thread-safe:
+// feed it from one thread at a time.
+class GazeDecoder {
+public:
+    // Decode every complete record in `data`, calling sink(sample) for each,
+    // and keep a trailing partial record for the next call. Returns the
+    // number of samples delivered.
+    template <typename Sink>
+    size_t feed(const uint8_t* data, size_t size, Sink&& sink) {
+        size_t decoded = 0;
+        while (size > 0) {
+            if (pendingSize == 0 && size >= kGazeRecordSize) {
+                // Whole record in place
+                if (readMagic(data) != kGazeMagic) {
+                    data++;
+                    size--;
+                    skipped.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                sink(parse(data));
+                data += kGazeRecordSize;
+                size -= kGazeRecordSize;
+                decoded++;
+                continue;
+            }
+
+            size_t take = std::min(kGazeRecordSize - pendingSize, size);
+            std::memcpy(pending + pendingSize, data, take);
+            pendingSize += take;
+            data += take;
+            size -= take;
+            if (pendingSize >= 4 && readMagic(pending) != kGazeMagic) {
+                std::memmove(pending, pending + 1, --pendingSize);
+                skipped.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            if (pendingSize == kGazeRecordSize) {
+                sink(parse(pending));
+                pendingSize = 0;
+                decoded++;
+            }
+        }
+        samples.fetch_add(decoded, std::memory_order_relaxed);
+        return decoded;
+    }
+
+    void reset() { pendingSize = 0; }
+
+    // Readable from any thread
+    uint64_t sampleCount() const { return samples.load(std::memory_order_relaxed); }
+    uint64_t skippedBytes() const { return skipped.load(std::memory_order_relaxed); }
+
+private:
+    static uint32_t readMagic(const uint8_t* record) {
+        uint32_t magic;
+        std::memcpy(&magic, record, sizeof(magic));
+        return magic;
+    }
+
+    static GazeSample parse(const uint8_t* record);
+
+    uint8_t pending[kGazeRecordSize];
+    size_t pendingSize = 0;
+    std::atomic<uint64_t> samples{ 0 };
+    std::atomic<uint64_t> skipped{ 0 };
+};
+
+// Stand-in for an eye tracker: fixations with tremor, joined by
+// saccades on a minimum-jerk trajectory whose duration follows the main
+// sequence. Samples are encoded in the wire format and handed over in
+// messages of `batch` records at the requested rate from a thread of its
+// own, so the whole decode and latch path runs as with real hardware.
+class SyntheticGaze {
+public:
+    using Clock = double (*)();
+    using Sink = std::function<void(const uint8_t* data, size_t size)>;
+
+    ~SyntheticGaze();
+
+    bool start(double rateHz, uint32_t seed, uint32_t batch, Clock clock, Sink sink);
+    // Waits for the thread, at most about one sample period
+    void stop();
+    bool running() const { return active.load(); }
+    uint64_t emitted() const { return emittedSamples.load(std::memory_order_relaxed); }
+
+private:
+    GazeSample next(double time);
+    float random();
+    void run();
+
+    double samplePeriod = 1.0;
+    uint32_t recordsPerMessage = 1;
+    Clock clock = nullptr;
+    Sink sink;
+
+    // Eye model, generator thread only
+    uint32_t seed = 0;
+    uint32_t counter = 0;
+    uint32_t sequence = 0;
+    float fixationX = 0.5f;
+    float fixationY = 0.5f;
+    float startX = 0.5f;
+    float startY = 0.5f;
+    double phaseStart = 0.0;
+    double phaseEnd = 0.0;
+    bool saccade = false;
+
+    std::atomic<bool> active{ false };
+    std::atomic<uint64_t> emittedSamples{ 0 };
+    std::thread worker;
+};
@@ -0,0 +1,177 @@
+#include "GpuCache.h"
+
+#include <bit>
+#include <iostream>
+
+namespace {
+
+uint64_t handleWord(const void* handle) {
+    return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(handle));
+}
+
+uint64_t mix(uint64_t h, uint64_t v) {
+    // splitmix64 finalizer folded into a running hash
+    h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ull;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebull;
+    h ^= h >> 31;
+    return h;
+}
+
+} // namespace
+
+void GpuCache::init(const wgpu::Device& dev) {
+    clear();
+    device = dev;
+}
+
+void GpuCache::finalize(Key& key) {
+    uint64_t h = key.length;
+    for (uint32_t i = 0; i < key.length; ++i) {
+        h = mix(h, key.words[i]);
+    }
+    key.hash = static_cast<size_t>(h);
+}
+
+wgpu::Sampler GpuCache::sampler(const wgpu::SamplerDescriptor& desc) {
+    Key key;
+    key.append({
+        static_cast<uint64_t>(desc.addressModeU),
+        static_cast<uint64_t>(desc.addressModeV),
+        static_cast<uint64_t>(desc.addressModeW),
+        static_cast<uint64_t>(desc.magFilter),
+        static_cast<uint64_t>(desc.minFilter),
+        static_cast<uint64_t>(desc.mipmapFilter),
+        std::bit_cast<uint32_t>(desc.lodMinClamp),
+        std::bit_cast<uint32_t>(desc.lodMaxClamp),
+        static_cast<uint64_t>(desc.compare),
+        desc.maxAnisotropy,
+    });
+    finalize(key);
+
+    auto it = samplers.find(key);
+    if (it != samplers.end()) {
+        counters.hits++;
+        return it->second.sampler;
+    }
+
+    wgpu::Sampler created = device.CreateSampler(&desc);
+    counters.samplersCreated++;
+    samplers.emplace(std::move(key), SamplerEntry{created});
+    return created;
+}
+
+wgpu::BindGroupLayout GpuCache::bindGroupLayout(const wgpu::BindGroupLayoutEntry* entries, size_t entryCount) {
+    wgpu::BindGroupLayoutDescriptor desc = {};
+    desc.entryCount = entryCount;
+    desc.entries = entries;
+    if (entryCount > kMaxEntries) {
+        std::cerr << "Bind group layout of " << entryCount << " entries is not cached." << std::endl;
+        counters.layoutsCreated++;
+        return device.CreateBindGroupLayout(&desc);
+    }
+
+    Key key;
+    for (size_t i = 0; i < entryCount; ++i) {
+        const wgpu::BindGroupLayoutEntry& e = entries[i];
+        key.append({
+            e.binding,
+            static_cast<uint64_t>(e.visibility),
+            static_cast<uint64_t>(e.buffer.type),
+            e.buffer.hasDynamicOffset ? 1u : 0u,
+            e.buffer.minBindingSize,
+            static_cast<uint64_t>(e.sampler.type),
+            static_cast<uint64_t>(e.texture.sampleType),
+            static_cast<uint64_t>(e.texture.viewDimension),
+            e.texture.multisampled ? 1u : 0u,
+            static_cast<uint64_t>(e.storageTexture.access),
+            static_cast<uint64_t>(e.storageTexture.format),
+            static_cast<uint64_t>(e.storageTexture.viewDimension),
+        });
+    }
+    finalize(key);
+
+    auto it = layouts.find(key);
+    if (it != layouts.end()) {
+        counters.hits++;
+        return it->second.layout;
+    }
+
+    wgpu::BindGroupLayout created = device.CreateBindGroupLayout(&desc);
+    counters.layoutsCreated++;
+    layouts.emplace(std::move(key), LayoutEntry{created});
+    return created;
+}
+
+wgpu::BindGroup GpuCache::bindGroup(const wgpu::BindGroupLayout& layout, const wgpu::BindGroupEntry* entries, size_t entryCount) {
+    wgpu::BindGroupDescriptor desc = {};
+    desc.layout = layout;
+    desc.entryCount = entryCount;
+    desc.entries = entries;
+    if (entryCount > kMaxEntries) {
+        std::cerr << "Bind group of " << entryCount << " entries is not cached." << std::endl;
+        counters.bindGroupsCreated++;
+        return device.CreateBindGroup(&desc);
+    }
+
+    Key key;
+    key.append({ handleWord(layout.Get()) });
+    for (size_t i = 0; i < entryCount; ++i) {
+        const wgpu::BindGroupEntry& e = entries[i];
+        key.append({
+            e.binding,
+            handleWord(e.buffer.Get()),
+            e.offset,
+            e.size,
+            handleWord(e.sampler.Get()),
+            handleWord(e.textureView.Get()),
+        });
+    }
+    finalize(key);
+
+    auto it = groups.find(key);
+    if (it != groups.end()) {
+        counters.hits++;
+        return it->second.group;
+    }
+
+    GroupEntry entry;
+    entry.group = device.CreateBindGroup(&desc);
+    entry.layout = layout;
+    entry.entries.assign(entries, entries + entryCount);
+    counters.bindGroupsCreated++;
+
+    wgpu::BindGroup created = entry.group;
+    groups.emplace(std::move(key), std::move(entry));
+    return created;
+}
+
+bool GpuCache::references(const GroupEntry& entry, const void* handle) {
+    if (entry.layout.Get() == handle) {
+        return true;
+    }
+    for (const wgpu::BindGroupEntry& e : entry.entries) {
+        if (e.buffer.Get() == handle || e.sampler.Get() == handle || e.textureView.Get() == handle) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void GpuCache::invalidate(const void* handle) {
+    if (!handle) {
+        return;
+    }
+
+    std::erase_if(groups, [handle](const auto& item) { return references(item.second, handle); });
+    std::erase_if(samplers, [handle](const auto& item) { return item.second.sampler.Get() == handle; });
+    std::erase_if(layouts, [handle](const auto& item) { return item.second.layout.Get() == handle; });
+}
+
+void GpuCache::clear() {
+    groups.clear();
+    layouts.clear();
+    samplers.clear();
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <unordered_map>
+#include <vector>
+
+#include <webgpu/webgpu_cpp.h>
+
+// Hash-consed caches for samplers, bind group layouts and bind groups.
+// Objects are keyed by the contents of their descriptors, so asking for the
+// same sampler/layout/group twice hands back the object created the first time.
+class GpuCache {
+public:
+    // Entries per layout or bind group the cache can key; larger ones are
+    // created uncached
+    static constexpr size_t kMaxEntries = 8;
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t samplersCreated = 0;
+        uint64_t layoutsCreated = 0;
+        uint64_t bindGroupsCreated = 0;
+    };
+
+    void init(const wgpu::Device& device);
+
+    wgpu::Sampler sampler(const wgpu::SamplerDescriptor& desc);
+    wgpu::BindGroupLayout bindGroupLayout(const wgpu::BindGroupLayoutEntry* entries, size_t entryCount);
+    wgpu::BindGroup bindGroup(const wgpu::BindGroupLayout& layout, const wgpu::BindGroupEntry* entries, size_t entryCount);
+
+    // Drop every cached object created from (or referencing) the given handle.
+    // Call this before destroying a buffer, texture view, sampler or layout.
+    void invalidate(const void* handle);
+    void clear();
+
+    const Stats& stats() const { return counters; }
+
+private:
+    // Descriptor contents flattened into words, stored inline so building a
+    // key for a lookup never allocates; the hash is precomputed once.
+    struct Key {
+        static constexpr size_t kWords = kMaxEntries * 12;
+
+        std::array<uint64_t, kWords> words = {};
+        uint32_t length = 0;
+        size_t hash = 0;
+
+        void append(std::initializer_list<uint64_t> values) {
+            for (uint64_t v : values) {
+                words[length++] = v;
+            }
+        }
+
+        bool operator==(const Key& other) const {
+            return hash == other.hash && length == other.length &&
+                   std::equal(words.begin(), words.begin() + length, other.words.begin());
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const { return key.hash; }
+    };
+
+    struct SamplerEntry {
+        wgpu::Sampler sampler;
+    };
+
+    struct LayoutEntry {
+        wgpu::BindGroupLayout layout;
+    };
+
+    struct GroupEntry {
+        wgpu::BindGroup group;
+        // Keeps the referenced handles alive so their addresses cannot be reused
+        // by another object while this key is still in the map.
+        wgpu::BindGroupLayout layout;
+        std::vector<wgpu::BindGroupEntry> entries;
+    };
+
+    static void finalize(Key& key);
+    static bool references(const GroupEntry& entry, const void* handle);
+
+    wgpu::Device device;
+    std::unordered_map<Key, SamplerEntry, KeyHash> samplers;
+    std::unordered_map<Key, LayoutEntry, KeyHash> layouts;
+    std::unordered_map<Key, GroupEntry, KeyHash> groups;
+    Stats counters;
+};
@@ -0,0 +1,216 @@
+#include "ImageDiff.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
+#include "Parallel.h"
+
+namespace {
+
+constexpr uint32_t kBlockSize = 8;
+
+struct PartialDiff {
+    uint64_t squaredError = 0;
+    uint64_t differing = 0;
+    uint32_t maxAbs = 0;
+    double ssimSum = 0.0;
+    uint64_t blocks = 0;
+};
+
+// Per-column sums of luma over the rows of one band of blocks
+struct ColumnSums {
+    std::vector<int32_t> x, y, xx, yy, xy;
+
+    void reset(uint32_t width) {
+        for (std::vector<int32_t>* v : { &x, &y, &xx, &yy, &xy }) {
+            v->assign(width, 0);
+        }
+    }
+};
+
+// Integer Rec. 601 luma, 0..255
+inline int32_t luma(const uint8_t* p) {
+    return (77 * p[0] + 150 * p[1] + 29 * p[2] + 128) >> 8;
+}
+
+// One row: squared error, largest difference and differing pixels go into
+// `partial`, luma moments into the column sums
+void accumulateRow(const uint8_t* a, const uint8_t* b, uint32_t width, PartialDiff& partial, ColumnSums& sums) {
+    uint32_t x = 0;
+    uint64_t squaredError = 0;
+#ifdef __wasm_simd128__
+    const v128_t rgbMask = wasm_i32x4_splat(0x00ffffff);
+    const v128_t byteMask = wasm_i32x4_splat(0xff);
+    const v128_t zero = wasm_i32x4_splat(0);
+    v128_t squares = zero;
+    v128_t maxAbs = zero;
+    v128_t differing = zero;
+
+    for (; x + 4 <= width; x += 4) {
+        v128_t pa = wasm_v128_load(a + x * 4);
+        v128_t pb = wasm_v128_load(b + x * 4);
+        v128_t d = wasm_v128_and(wasm_v128_or(wasm_u8x16_sub_sat(pa, pb), wasm_u8x16_sub_sat(pb, pa)), rgbMask);
+        maxAbs = wasm_u8x16_max(maxAbs, d);
+        differing = wasm_i32x4_sub(differing, wasm_i32x4_ne(d, zero));
+        squares = wasm_i32x4_add(squares, wasm_u32x4_extadd_pairwise_u16x8(wasm_u16x8_extmul_low_u8x16(d, d)));
+        squares = wasm_i32x4_add(squares, wasm_u32x4_extadd_pairwise_u16x8(wasm_u16x8_extmul_high_u8x16(d, d)));
+
+        v128_t la = wasm_i32x4_add(wasm_i32x4_mul(wasm_v128_and(pa, byteMask), wasm_i32x4_splat(77)),
+                                   wasm_i32x4_mul(wasm_v128_and(wasm_u32x4_shr(pa, 8), byteMask), wasm_i32x4_splat(150)));
+        la = wasm_i32x4_add(la, wasm_i32x4_mul(wasm_v128_and(wasm_u32x4_shr(pa, 16), byteMask), wasm_i32x4_splat(29)));
+        la = wasm_i32x4_shr(wasm_i32x4_add(la, wasm_i32x4_splat(128)), 8);
+        v128_t lb = wasm_i32x4_add(wasm_i32x4_mul(wasm_v128_and(pb, byteMask), wasm_i32x4_splat(77)),
+                                   wasm_i32x4_mul(wasm_v128_and(wasm_u32x4_shr(pb, 8), byteMask), wasm_i32x4_splat(150)));
+        lb = wasm_i32x4_add(lb, wasm_i32x4_mul(wasm_v128_and(wasm_u32x4_shr(pb, 16), byteMask), wasm_i32x4_splat(29)));
+        lb = wasm_i32x4_shr(wasm_i32x4_add(lb, wasm_i32x4_splat(128)), 8);
+
+        wasm_v128_store(&sums.x[x], wasm_i32x4_add(wasm_v128_load(&sums.x[x]), la));
+        wasm_v128_store(&sums.y[x], wasm_i32x4_add(wasm_v128_load(&sums.y[x]), lb));
+        wasm_v128_store(&sums.xx[x], wasm_i32x4_add(wasm_v128_load(&sums.xx[x]), wasm_i32x4_mul(la, la)));
+        wasm_v128_store(&sums.yy[x], wasm_i32x4_add(wasm_v128_load(&sums.yy[x]), wasm_i32x4_mul(lb, lb)));
+        wasm_v128_store(&sums.xy[x], wasm_i32x4_add(wasm_v128_load(&sums.xy[x]), wasm_i32x4_mul(la, lb)));
+    }
+
+    uint32_t lanes[4];
+    wasm_v128_store(lanes, squares);
+    squaredError += uint64_t(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+    wasm_v128_store(lanes, differing);
+    partial.differing += uint64_t(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+    uint8_t bytes[16];
+    wasm_v128_store(bytes, maxAbs);
+    partial.maxAbs = std::max<uint32_t>(partial.maxAbs, *std::max_element(bytes, bytes + 16));
+#endif
+
+    for (; x < width; ++x) {
+        const uint8_t* pa = a + x * 4;
+        const uint8_t* pb = b + x * 4;
+        uint32_t pixelMax = 0;
+        for (int c = 0; c < 3; ++c) {
+            uint32_t d = uint32_t(std::abs(int(pa[c]) - int(pb[c])));
+            squaredError += d * d;
+            pixelMax = std::max(pixelMax, d);
+        }
+        partial.maxAbs = std::max(partial.maxAbs, pixelMax);
+        partial.differing += pixelMax != 0;
+
+        int32_t la = luma(pa);
+        int32_t lb = luma(pb);
+        sums.x[x] += la;
+        sums.y[x] += lb;
+        sums.xx[x] += la * la;
+        sums.yy[x] += lb * lb;
+        sums.xy[x] += la * lb;
+    }
+    partial.squaredError += squaredError;
+}
+
+// SSIM of each block in a band from its column sums; edge blocks are smaller
+void accumulateBlocks(const ColumnSums& sums, uint32_t width, uint32_t rows, PartialDiff& partial) {
+    const double c1 = (0.01 * 255.0) * (0.01 * 255.0);
+    const double c2 = (0.03 * 255.0) * (0.03 * 255.0);
+    for (uint32_t start = 0; start < width; start += kBlockSize) {
+        uint32_t end = std::min(width, start + kBlockSize);
+        int64_t sx = 0, sy = 0, sxx = 0, syy = 0, sxy = 0;
+        for (uint32_t x = start; x < end; ++x) {
+            sx += sums.x[x];
+            sy += sums.y[x];
+            sxx += sums.xx[x];
+            syy += sums.yy[x];
+            sxy += sums.xy[x];
+        }
+        double n = double(end - start) * rows;
+        double mx = sx / n;
+        double my = sy / n;
+        double vx = sxx / n - mx * mx;
+        double vy = syy / n - my * my;
+        double cov = sxy / n - mx * my;
+        partial.ssimSum += ((2.0 * mx * my + c1) * (2.0 * cov + c2)) / ((mx * mx + my * my + c1) * (vx + vy + c2));
+        partial.blocks++;
+    }
+}
+
+} // namespace
+
+ImageDiff compareImages(const uint8_t* actual, const uint8_t* expected, uint32_t width, uint32_t height) {
+    ImageDiff result = {};
+    result.width = width;
+    result.height = height;
+    if (width == 0 || height == 0) {
+        result.psnr = std::numeric_limits<double>::infinity();
+        result.ssim = 1.0;
+        return result;
+    }
+
+    // Bands of block rows, so no block straddles two threads
+    size_t bands = (height + kBlockSize - 1) / kBlockSize;
+    size_t minBands = std::max<size_t>(1, 65536 / (size_t(width) * kBlockSize));
+    std::vector<PartialDiff> partials(parallelChunks(bands, minBands));
+    parallelFor(bands, minBands, [&](size_t chunk, size_t begin, size_t end) {
+        PartialDiff& partial = partials[chunk];
+        ColumnSums sums;
+        for (size_t band = begin; band < end; ++band) {
+            sums.reset(width);
+            uint32_t first = uint32_t(band) * kBlockSize;
+            uint32_t rows = std::min(kBlockSize, height - first);
+            for (uint32_t y = first; y < first + rows; ++y) {
+                size_t offset = size_t(y) * width * 4;
+                accumulateRow(actual + offset, expected + offset, width, partial, sums);
+            }
+            accumulateBlocks(sums, width, rows, partial);
+        }
+    });
+
+    PartialDiff merged;
+    for (const PartialDiff& partial : partials) {
+        merged.squaredError += partial.squaredError;
+        merged.differing += partial.differing;
+        merged.maxAbs = std::max(merged.maxAbs, partial.maxAbs);
+        merged.ssimSum += partial.ssimSum;
+        merged.blocks += partial.blocks;
+    }
+
+    result.mse = double(merged.squaredError) / (double(width) * height * 3.0);
+    result.psnr = merged.squaredError == 0 ? std::numeric_limits<double>::infinity()
+                                           : 10.0 * std::log10(255.0 * 255.0 / result.mse);
+    result.ssim = merged.ssimSum / double(merged.blocks);
+    result.maxAbsDiff = merged.maxAbs;
+    result.differingPixels = merged.differing;
+    return result;
+}
+
+bool diffPasses(const ImageDiff& diff, const DiffTolerance& tolerance) {
+    return diff.psnr >= tolerance.minPsnr && diff.ssim >= tolerance.minSsim && diff.maxAbsDiff <= tolerance.maxAbsDiff;
+}
+
+void diffHeatmap(const uint8_t* actual, const uint8_t* expected, uint32_t width, uint32_t height, uint32_t scale,
+                 uint8_t* heatmap) {
+    scale = std::max(scale, 1u);
+    parallelFor(height, std::max<size_t>(1, 65536 / std::max(width, 1u)), [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin * width; i < end * width; ++i) {
+            const uint8_t* pa = actual + i * 4;
+            const uint8_t* pb = expected + i * 4;
+            uint8_t* out = heatmap + i * 4;
+            uint32_t d = 0;
+            for (int c = 0; c < 3; ++c) {
+                d = std::max(d, uint32_t(std::abs(int(pa[c]) - int(pb[c]))));
+            }
+            if (d == 0) {
+                uint8_t dim = uint8_t(luma(pb) / 4);
+                out[0] = out[1] = out[2] = dim;
+            } else {
+                // Dark red at one code, through red to yellow
+                uint32_t heat = std::min(255u, d * scale);
+                out[0] = uint8_t(std::min(255u, 96 + heat * 2));
+                out[1] = uint8_t(heat > 128 ? (heat - 128) * 2 : 0);
+                out[2] = 0;
+            }
+            out[3] = 255;
+        }
+    });
+}
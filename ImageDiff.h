@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+// Comparison of a rendered RGBA8 frame against a golden image. Errors are
+// measured on the RGB codes; alpha is ignored since the canvas is opaque.
+struct ImageDiff {
+    uint32_t width;
+    uint32_t height;
+    double mse;              // mean squared code error over R, G and B
+    double psnr;             // dB against a peak of 255; infinite when identical
+    double ssim;             // mean SSIM over 8x8 blocks of luma
+    uint32_t maxAbsDiff;     // largest code difference in any channel
+    uint64_t differingPixels;
+};
+
+// Pass thresholds for a golden comparison
+struct DiffTolerance {
+    double minPsnr = 40.0;
+    double minSsim = 0.99;
+    uint32_t maxAbsDiff = 2; // dithering may move a code by one either way
+};
+
+// Vectorized where wasm SIMD is enabled and split over bands of rows across
+// threads; one pass computes every metric
+ImageDiff compareImages(const uint8_t* actual, const uint8_t* expected, uint32_t width, uint32_t height);
+
+bool diffPasses(const ImageDiff& diff, const DiffTolerance& tolerance);
+
+// RGBA8 heatmap of the largest channel difference per pixel: matching pixels
+// show the expected image dimmed to a quarter for orientation, differing
+// ones ramp from dark red to yellow, reaching yellow at 255 / scale codes
+void diffHeatmap(const uint8_t* actual, const uint8_t* expected, uint32_t width, uint32_t height, uint32_t scale,
+                 uint8_t* heatmap);
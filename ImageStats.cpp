@@ -0,0 +1,129 @@
+#include "ImageStats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
+#include "Parallel.h"
+
+namespace {
+
+struct PartialStats {
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    float min = 255.0f;
+    float max = 0.0f;
+    uint32_t histogram[256] = {};
+};
+
+// One row; luminance stays in 8-bit code units until the final division.
+// Sums are kept in double even in the SIMD lanes: the variance comes from
+// E[y^2] - mean^2, which in float cancels away the contrast of a dim or
+// low-contrast image.
+void accumulateRow(const uint8_t* row, uint32_t width, const float weights[3], PartialStats& stats) {
+    uint32_t x = 0;
+#ifdef __wasm_simd128__
+    const v128_t mask = wasm_i32x4_splat(0xff);
+    const v128_t wr = wasm_f32x4_splat(weights[0]);
+    const v128_t wg = wasm_f32x4_splat(weights[1]);
+    const v128_t wb = wasm_f32x4_splat(weights[2]);
+    v128_t sum = wasm_f64x2_splat(0.0);
+    v128_t sumSquares = wasm_f64x2_splat(0.0);
+    v128_t low = wasm_f32x4_splat(stats.min);
+    v128_t high = wasm_f32x4_splat(stats.max);
+    uint32_t codes[4];
+
+    for (; x + 4 <= width; x += 4) {
+        v128_t pixels = wasm_v128_load(row + x * 4);
+        v128_t r = wasm_f32x4_convert_i32x4(wasm_v128_and(pixels, mask));
+        v128_t g = wasm_f32x4_convert_i32x4(wasm_v128_and(wasm_u32x4_shr(pixels, 8), mask));
+        v128_t b = wasm_f32x4_convert_i32x4(wasm_v128_and(wasm_u32x4_shr(pixels, 16), mask));
+        v128_t y = wasm_f32x4_add(wasm_f32x4_add(wasm_f32x4_mul(r, wr), wasm_f32x4_mul(g, wg)), wasm_f32x4_mul(b, wb));
+
+        v128_t y01 = wasm_f64x2_promote_low_f32x4(y);
+        v128_t y23 = wasm_f64x2_promote_low_f32x4(wasm_i32x4_shuffle(y, y, 2, 3, 0, 1));
+        sum = wasm_f64x2_add(sum, wasm_f64x2_add(y01, y23));
+        sumSquares = wasm_f64x2_add(sumSquares, wasm_f64x2_add(wasm_f64x2_mul(y01, y01), wasm_f64x2_mul(y23, y23)));
+        low = wasm_f32x4_min(low, y);
+        high = wasm_f32x4_max(high, y);
+
+        // Scatter into the histogram has no SIMD form
+        wasm_v128_store(codes, wasm_u32x4_trunc_sat_f32x4(wasm_f32x4_nearest(y)));
+        stats.histogram[std::min(codes[0], 255u)]++;
+        stats.histogram[std::min(codes[1], 255u)]++;
+        stats.histogram[std::min(codes[2], 255u)]++;
+        stats.histogram[std::min(codes[3], 255u)]++;
+    }
+
+    double sums[2];
+    wasm_v128_store(sums, sum);
+    stats.sum += sums[0] + sums[1];
+    wasm_v128_store(sums, sumSquares);
+    stats.sumSquares += sums[0] + sums[1];
+    float lanes[4];
+    wasm_v128_store(lanes, low);
+    stats.min = std::min({ stats.min, lanes[0], lanes[1], lanes[2], lanes[3] });
+    wasm_v128_store(lanes, high);
+    stats.max = std::max({ stats.max, lanes[0], lanes[1], lanes[2], lanes[3] });
+#endif
+
+    for (; x < width; ++x) {
+        const uint8_t* p = row + x * 4;
+        float y = float(p[0]) * weights[0] + float(p[1]) * weights[1] + float(p[2]) * weights[2];
+        stats.sum += y;
+        stats.sumSquares += double(y) * y;
+        stats.min = std::min(stats.min, y);
+        stats.max = std::max(stats.max, y);
+        stats.histogram[std::min(static_cast<uint32_t>(std::nearbyint(y)), 255u)]++;
+    }
+}
+
+} // namespace
+
+ImageStats computeImageStats(const uint8_t* rgba, uint32_t width, uint32_t height,
+                             float lumR, float lumG, float lumB) {
+    ImageStats result = {};
+    result.width = width;
+    result.height = height;
+    if (width == 0 || height == 0) {
+        return result;
+    }
+
+    float total = lumR + lumG + lumB;
+    const float weights[3] = { lumR / total, lumG / total, lumB / total };
+
+    // Rows per chunk so each thread gets at least ~64k pixels
+    size_t minRows = std::max<size_t>(1, 65536 / width);
+    std::vector<PartialStats> partials(parallelChunks(height, minRows));
+    parallelFor(height, minRows, [&](size_t chunk, size_t begin, size_t end) {
+        PartialStats& stats = partials[chunk];
+        for (size_t y = begin; y < end; ++y) {
+            accumulateRow(rgba + y * width * 4, width, weights, stats);
+        }
+    });
+
+    PartialStats merged;
+    for (const PartialStats& stats : partials) {
+        merged.sum += stats.sum;
+        merged.sumSquares += stats.sumSquares;
+        merged.min = std::min(merged.min, stats.min);
+        merged.max = std::max(merged.max, stats.max);
+        for (int i = 0; i < 256; ++i) {
+            merged.histogram[i] += stats.histogram[i];
+        }
+    }
+
+    double count = double(width) * height;
+    double mean = merged.sum / count;
+    double variance = std::max(0.0, merged.sumSquares / count - mean * mean);
+    result.meanLuminance = mean / 255.0;
+    result.rmsContrast = std::sqrt(variance) / 255.0;
+    result.minLuminance = merged.min / 255.0;
+    result.maxLuminance = merged.max / 255.0;
+    std::copy(merged.histogram, merged.histogram + 256, result.histogram);
+    return result;
+}
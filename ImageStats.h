@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+// Luminance statistics of an RGBA8 image, computed once when it is loaded.
+// Luminance is the weighted sum of the 8-bit codes, normalized to [0, 1];
+// the weights default to Rec. 709 and should be the display's measured
+// channel luminances when a calibration is loaded.
+struct ImageStats {
+    uint32_t width;
+    uint32_t height;
+    double meanLuminance;
+    double rmsContrast;        // standard deviation of luminance
+    double minLuminance;
+    double maxLuminance;
+    uint32_t histogram[256];   // pixels per rounded 8-bit luminance code
+};
+
+// Vectorized where wasm SIMD is enabled, split over rows across threads
+ImageStats computeImageStats(const uint8_t* rgba, uint32_t width, uint32_t height,
+                             float lumR = 0.2126f, float lumG = 0.7152f, float lumB = 0.0722f);
@@ -0,0 +1,27 @@
+#include "Input.h"
+
+#include "Noise.h"
+
+void MockResponder::configure(bool enabled, double meanReactionTime, double jitter, uint32_t randomSeed,
+                              uint32_t keyCode) {
+    active = enabled;
+    mean = meanReactionTime;
+    spread = jitter;
+    seed = randomSeed;
+    counter = 0;
+    code = keyCode;
+    pendingCount = 0;
+}
+
+void MockResponder::onset(double presentTime) {
+    if (!active || pendingCount == kPending) {
+        return;
+    }
+    double u = double(noiseHash(counter++, 0, 0, seed).x >> 8) * (1.0 / 16777216.0);
+    InputEvent& press = pending[pendingCount++];
+    press = {};
+    press.time = presentTime + mean + spread * (2.0 * u - 1.0);
+    press.type = static_cast<uint32_t>(InputType::KeyDown);
+    press.code = code;
+    press.source = static_cast<uint32_t>(InputSource::Mock);
+}
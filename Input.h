@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Participant responses, timestamped on the emscripten_get_now() clock that
+// all threads share and related to the frames that were on screen.
+enum class InputType : uint32_t {
+    KeyDown = 0,
+    KeyUp = 1,
+    MouseDown = 2,
+    MouseUp = 3,
+};
+
+enum class InputSource : uint32_t {
+    Browser = 0,  // html5 keyboard and mouse callbacks
+    Mock = 1,     // MockResponder
+    Injected = 2, // injectResponse() with an explicit timestamp
+};
+
+struct InputEvent {
+    double time;   // when the event happened, not when it was handled, ms
+    uint32_t type; // InputType
+    uint32_t code; // keyCode, or mouse button
+    uint32_t source;
+    uint32_t padding;
+};
+
+struct Response {
+    InputEvent event;
+    double reactionTime; // ms since the onset presented before the event; negative without one
+    uint32_t onsetFrame; // frameIndex of that onset
+    uint32_t padding;
+};
+
+// Fixed-size history of responses with their reaction times; nothing is
+// allocated after construction. Onsets are the estimated presentation times
+// of frames that changed the stimulus; each response is measured from the
+// last onset presented at or before it, also when it is added after later
+// onsets were already recorded.
+class ResponseLog {
+public:
+    explicit ResponseLog(size_t capacity = 4096) : responses(capacity) {}
+
+    void onset(uint32_t frameIndex, double presentTime) {
+        onsets[onsetCount % kOnsets] = { frameIndex, presentTime };
+        onsetCount++;
+    }
+
+    void add(const InputEvent& event) {
+        Response& response = responses[count % responses.size()];
+        response = {};
+        response.event = event;
+        response.reactionTime = -1.0;
+        // Newest onset first; onsets are recorded in presentation order
+        uint64_t retained = onsetCount < kOnsets ? onsetCount : kOnsets;
+        for (uint64_t i = 0; i < retained; ++i) {
+            const Onset& onset = onsets[(onsetCount - 1 - i) % kOnsets];
+            if (onset.presentTime <= event.time) {
+                response.reactionTime = event.time - onset.presentTime;
+                response.onsetFrame = onset.frameIndex;
+                break;
+            }
+        }
+        count++;
+    }
+
+    uint64_t total() const { return count; }
+    size_t size() const { return count < responses.size() ? size_t(count) : responses.size(); }
+
+    // i = 0 is the oldest retained response
+    const Response& at(size_t i) const {
+        uint64_t first = count - size();
+        return responses[(first + i) % responses.size()];
+    }
+
+private:
+    struct Onset {
+        uint32_t frameIndex;
+        double presentTime;
+    };
+    static constexpr size_t kOnsets = 64;
+
+    std::vector<Response> responses;
+    uint64_t count = 0;
+    Onset onsets[kOnsets] = {};
+    uint64_t onsetCount = 0;
+};
+
+// Headless stand-in for a participant: answers every onset with one key
+// press after a reaction time drawn from mean +- jitter (uniform). The press
+// is released to the input path only once its timestamp has passed, so it
+// travels the same queue and matching as a real response.
+class MockResponder {
+public:
+    void configure(bool enabled, double meanReactionTime, double jitter, uint32_t seed, uint32_t keyCode);
+    bool enabled() const { return active; }
+
+    // Render thread: a stimulus onset was presented at `presentTime`
+    void onset(double presentTime);
+
+    // Render thread: hand every due press to push(event)
+    template <typename Push>
+    void release(double now, Push&& push) {
+        size_t kept = 0;
+        for (size_t i = 0; i < pendingCount; ++i) {
+            if (pending[i].time <= now) {
+                push(pending[i]);
+            } else {
+                pending[kept++] = pending[i];
+            }
+        }
+        pendingCount = kept;
+    }
+
+private:
+    static constexpr size_t kPending = 16;
+
+    bool active = false;
+    double mean = 400.0;
+    double spread = 0.0;
+    uint32_t seed = 0;
+    uint32_t counter = 0;
+    uint32_t code = 0;
+    InputEvent pending[kPending] = {};
+    size_t pendingCount = 0;
+};
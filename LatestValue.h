@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+// Latest-value slot for data sampled faster than frames are drawn, such as
+// input-derived stimulus placement. A triple buffer: the writer fills a
+// spare copy and swaps it into the middle slot, and the reader takes the
+// middle slot in exchange for the copy it read last, so loading never waits
+// and always returns one complete value, the newest. Older values are simply
+// overwritten. Only one thread may load; concurrent writers are serialized
+// by a short spin among themselves and never wait on the reader.
+template <typename T>
+class LatestValue {
+    static_assert(std::is_trivially_copyable_v<T>, "values are copied in and out of the buffers");
+
+public:
+    void store(const T& value) {
+        while (writerBusy.test_and_set(std::memory_order_acquire)) {
+        }
+        buffers[writeIndex] = value;
+        uint32_t previous = middle.exchange(writeIndex | kFresh, std::memory_order_acq_rel);
+        writeIndex = previous & kIndexMask;
+        writerBusy.clear(std::memory_order_release);
+    }
+
+    // Reader thread only. False until the first store; `fresh`, if given,
+    // tells whether a store arrived since the previous load.
+    bool load(T& value, bool* fresh = nullptr) {
+        bool arrived = middle.load(std::memory_order_relaxed) & kFresh;
+        if (arrived) {
+            readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & kIndexMask;
+            received = true;
+        }
+        if (fresh) {
+            *fresh = arrived;
+        }
+        if (!received) {
+            return false;
+        }
+        value = buffers[readIndex];
+        return true;
+    }
+
+private:
+    static constexpr uint32_t kIndexMask = 3;
+    static constexpr uint32_t kFresh = 4;
+
+    T buffers[3] = {};
+    std::atomic<uint32_t> middle{ 1 };
+    std::atomic_flag writerBusy = ATOMIC_FLAG_INIT;
+    uint32_t writeIndex = 0; // guarded by writerBusy
+    uint32_t readIndex = 2;  // reader only
+    bool received = false;   // reader only
+};
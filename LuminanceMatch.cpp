@@ -0,0 +1,233 @@
+#include "LuminanceMatch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+#include "Parallel.h"
+
+namespace {
+
+// Luminance of every pixel in 8-bit code units
+void imageLuminance(const MatchImage& image, const float weights[3], std::vector<float>& y) {
+    size_t n = size_t(image.width) * image.height;
+    y.resize(n);
+    const uint8_t* p = image.rgba;
+    for (size_t i = 0; i < n; ++i, p += 4) {
+        y[i] = float(p[0]) * weights[0] + float(p[1]) * weights[1] + float(p[2]) * weights[2];
+    }
+}
+
+// Write gray codes back, leaving alpha alone
+void storeGray(const MatchImage& image, size_t index, uint8_t code) {
+    uint8_t* p = image.rgba + index * 4;
+    p[0] = p[1] = p[2] = code;
+}
+
+void normalizeWeights(float lumR, float lumG, float lumB, float weights[3]) {
+    float total = lumR + lumG + lumB;
+    weights[0] = lumR / total;
+    weights[1] = lumG / total;
+    weights[2] = lumB / total;
+}
+
+// 3x3 box mean with clamped edges, the secondary sort key
+void localMean(const std::vector<float>& y, uint32_t width, uint32_t height, std::vector<float>& rows,
+               std::vector<float>& out) {
+    rows.resize(y.size());
+    out.resize(y.size());
+    for (uint32_t r = 0; r < height; ++r) {
+        const float* in = &y[size_t(r) * width];
+        float* dst = &rows[size_t(r) * width];
+        for (uint32_t x = 0; x < width; ++x) {
+            dst[x] = in[x > 0 ? x - 1 : 0] + in[x] + in[std::min(x + 1, width - 1)];
+        }
+    }
+    for (uint32_t r = 0; r < height; ++r) {
+        const float* up = &rows[size_t(r > 0 ? r - 1 : 0) * width];
+        const float* mid = &rows[size_t(r) * width];
+        const float* down = &rows[size_t(std::min(r + 1, height - 1)) * width];
+        float* dst = &out[size_t(r) * width];
+        for (uint32_t x = 0; x < width; ++x) {
+            dst[x] = (up[x] + mid[x] + down[x]) * (1.0f / 9.0f);
+        }
+    }
+}
+
+// Stable LSD radix sort on the upper 32 bits, two 16-bit digits; the pixel
+// index in the lower bits keeps ties in scan order
+void radixSortKeys(std::vector<uint64_t>& keys, std::vector<uint64_t>& scratch, std::vector<uint32_t>& counts) {
+    scratch.resize(keys.size());
+    counts.resize(65536);
+    for (int shift = 32; shift < 64; shift += 16) {
+        std::fill(counts.begin(), counts.end(), 0u);
+        for (uint64_t key : keys) {
+            counts[(key >> shift) & 0xffff]++;
+        }
+        uint32_t offset = 0;
+        for (uint32_t& c : counts) {
+            uint32_t n = c;
+            c = offset;
+            offset += n;
+        }
+        for (uint64_t key : keys) {
+            scratch[counts[(key >> shift) & 0xffff]++] = key;
+        }
+        keys.swap(scratch);
+    }
+}
+
+uint32_t toFixed16(float value) {
+    return static_cast<uint32_t>(std::clamp(value, 0.0f, 255.0f) * 257.0f + 0.5f);
+}
+
+} // namespace
+
+MatchResult matchMeanContrast(MatchImage* images, size_t count, double targetMean, double targetContrast,
+                              float lumR, float lumG, float lumB) {
+    MatchResult result = {};
+    if (count == 0) {
+        return result;
+    }
+    float weights[3];
+    normalizeWeights(lumR, lumG, lumB, weights);
+
+    std::vector<double> means(count);
+    std::vector<double> deviations(count);
+    parallelFor(count, 1, [&](size_t, size_t begin, size_t end) {
+        std::vector<float> y;
+        for (size_t i = begin; i < end; ++i) {
+            imageLuminance(images[i], weights, y);
+            double sum = 0.0, sumSquares = 0.0;
+            for (float v : y) {
+                sum += v;
+                sumSquares += double(v) * v;
+            }
+            double n = std::max<double>(1.0, double(y.size()));
+            means[i] = sum / n;
+            deviations[i] = std::sqrt(std::max(0.0, sumSquares / n - means[i] * means[i]));
+        }
+    });
+
+    double mean = targetMean >= 0.0 ? targetMean * 255.0 : std::accumulate(means.begin(), means.end(), 0.0) / double(count);
+    double deviation = targetContrast >= 0.0 ? targetContrast * 255.0
+                                             : std::accumulate(deviations.begin(), deviations.end(), 0.0) / double(count);
+
+    std::vector<size_t> clipped(parallelChunks(count, 1), 0);
+    parallelFor(count, 1, [&](size_t chunk, size_t begin, size_t end) {
+        std::vector<float> y;
+        for (size_t i = begin; i < end; ++i) {
+            imageLuminance(images[i], weights, y);
+            double gain = deviations[i] > 0.0 ? deviation / deviations[i] : 0.0;
+            for (size_t p = 0; p < y.size(); ++p) {
+                double v = std::nearbyint((y[p] - means[i]) * gain + mean);
+                if (v < 0.0 || v > 255.0) {
+                    clipped[chunk]++;
+                }
+                storeGray(images[i], p, static_cast<uint8_t>(std::clamp(v, 0.0, 255.0)));
+            }
+        }
+    });
+
+    result.meanLuminance = mean / 255.0;
+    result.rmsContrast = deviation / 255.0;
+    result.clippedPixels = std::accumulate(clipped.begin(), clipped.end(), size_t(0));
+    return result;
+}
+
+MatchResult matchHistograms(MatchImage* images, size_t count, const double* targetHistogram,
+                            float lumR, float lumG, float lumB) {
+    MatchResult result = {};
+    if (count == 0) {
+        return result;
+    }
+    float weights[3];
+    normalizeWeights(lumR, lumG, lumB, weights);
+
+    // Target: the given weights, or the average of the normalized histograms
+    std::vector<double> target(256, 0.0);
+    if (targetHistogram) {
+        std::copy(targetHistogram, targetHistogram + 256, target.begin());
+    } else {
+        std::vector<std::vector<double>> partials(parallelChunks(count, 1), std::vector<double>(256, 0.0));
+        parallelFor(count, 1, [&](size_t chunk, size_t begin, size_t end) {
+            std::vector<float> y;
+            for (size_t i = begin; i < end; ++i) {
+                imageLuminance(images[i], weights, y);
+                uint32_t histogram[256] = {};
+                for (float v : y) {
+                    histogram[std::min(static_cast<uint32_t>(std::nearbyint(v)), 255u)]++;
+                }
+                double scale = 1.0 / std::max<double>(1.0, double(y.size()));
+                for (int k = 0; k < 256; ++k) {
+                    partials[chunk][k] += histogram[k] * scale;
+                }
+            }
+        });
+        for (const std::vector<double>& partial : partials) {
+            for (int k = 0; k < 256; ++k) {
+                target[k] += partial[k];
+            }
+        }
+    }
+    double total = std::accumulate(target.begin(), target.end(), 0.0);
+    for (double& t : target) {
+        t = total > 0.0 ? t / total : 1.0 / 256.0;
+    }
+
+    parallelFor(count, 1, [&](size_t, size_t begin, size_t end) {
+        std::vector<float> y, rows, mean;
+        std::vector<uint64_t> keys, scratch;
+        std::vector<uint32_t> counts;
+        for (size_t i = begin; i < end; ++i) {
+            const MatchImage& image = images[i];
+            size_t n = size_t(image.width) * image.height;
+            if (n == 0) {
+                continue;
+            }
+            imageLuminance(image, weights, y);
+            localMean(y, image.width, image.height, rows, mean);
+
+            keys.resize(n);
+            for (size_t p = 0; p < n; ++p) {
+                uint64_t key = (uint64_t(toFixed16(y[p])) << 16) | toFixed16(mean[p]);
+                keys[p] = (key << 32) | p;
+            }
+            radixSortKeys(keys, scratch, counts);
+
+            // Target counts for this size, largest remainders rounded up
+            uint32_t binCounts[256];
+            double remainders[256];
+            size_t assigned = 0;
+            for (int k = 0; k < 256; ++k) {
+                double exact = target[k] * double(n);
+                binCounts[k] = static_cast<uint32_t>(exact);
+                remainders[k] = exact - binCounts[k];
+                assigned += binCounts[k];
+            }
+            int order[256];
+            std::iota(order, order + 256, 0);
+            std::stable_sort(order, order + 256, [&](int a, int b) { return remainders[a] > remainders[b]; });
+            for (size_t r = 0; assigned < n; ++r, ++assigned) {
+                binCounts[order[r % 256]]++;
+            }
+
+            size_t rank = 0;
+            for (int k = 0; k < 256; ++k) {
+                for (uint32_t c = 0; c < binCounts[k]; ++c, ++rank) {
+                    storeGray(image, keys[rank] & 0xffffffffu, static_cast<uint8_t>(k));
+                }
+            }
+        }
+    });
+
+    double mean = 0.0, meanSquares = 0.0;
+    for (int k = 0; k < 256; ++k) {
+        mean += target[k] * k;
+        meanSquares += target[k] * k * k;
+    }
+    result.meanLuminance = mean / 255.0;
+    result.rmsContrast = std::sqrt(std::max(0.0, meanSquares - mean * mean)) / 255.0;
+    return result;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Batch equalization of a stimulus set in the manner of the SHINE toolbox
+// (Willenbockel et al., 2010). Images are RGBA8 buffers matched in place;
+// matching works on luminance, so the results are achromatic (R = G = B)
+// and alpha is left untouched. Images are processed in parallel.
+struct MatchImage {
+    uint8_t* rgba;
+    uint32_t width;
+    uint32_t height;
+};
+
+struct MatchResult {
+    double meanLuminance;  // target mean, normalized to [0, 1]
+    double rmsContrast;    // target standard deviation, normalized
+    size_t clippedPixels;  // pixels pushed outside [0, 255] by mean/contrast matching
+};
+
+// Give every image the same mean and standard deviation of luminance.
+// Negative targets mean "the average over the set".
+MatchResult matchMeanContrast(MatchImage* images, size_t count, double targetMean = -1.0,
+                              double targetContrast = -1.0, float lumR = 0.2126f, float lumG = 0.7152f,
+                              float lumB = 0.0722f);
+
+// Exact histogram specification: every image ends up with the same
+// 256-bin histogram, the average of the set's (or `targetHistogram`, 256
+// weights, when given). Ties in luminance are broken by the 3x3 local mean
+// and then by position, so the target counts are met exactly.
+MatchResult matchHistograms(MatchImage* images, size_t count, const double* targetHistogram = nullptr,
+                            float lumR = 0.2126f, float lumG = 0.7152f, float lumB = 0.0722f);
@@ -0,0 +1,210 @@
+#include "Noise.h"
+
+#include <algorithm>
+
+const char* const pcg4dShaderCode = R"(
+fn pcg4d(input: vec4<u32>) -> vec4<u32> {
+    var v = input * 1664525u + 1013904223u;
+    v.x += v.y * v.w;
+    v.y += v.z * v.x;
+    v.z += v.x * v.y;
+    v.w += v.y * v.z;
+    v = v ^ (v >> vec4<u32>(16u));
+    v.x += v.y * v.w;
+    v.y += v.z * v.x;
+    v.z += v.x * v.y;
+    v.w += v.y * v.z;
+    return v;
+}
+)";
+
+const std::string noiseFragmentShaderCode = std::string(pcg4dShaderCode) + R"(
+struct NoiseUniforms {
+    kind: u32,
+    seed: u32,
+    frame: u32,
+    width: u32,
+    height: u32,
+    low: u32,
+    high: u32,
+    octaves: u32,
+    rectangles: u32,
+};
+
+struct StimulusUniforms {
+    transform: mat4x4<f32>,
+    opacity: f32,
+    luminance: f32,
+    frameIndex: u32,
+};
+
+@group(0) @binding(0) var<uniform> noise: NoiseUniforms;
+@group(1) @binding(0) var<uniform> stimulus: StimulusUniforms;
+
+fn scaleCode(value: u32, n: NoiseUniforms) -> u32 {
+    // value is 0..255; map onto [low, high]
+    return n.low + (value * (n.high - n.low + 1u)) / 256u;
+}
+
+fn pinkValue(n: NoiseUniforms, x: u32, y: u32) -> u32 {
+    let octaves = min(max(n.octaves, 1u), 10u);
+    var sum = 0u;
+    var weights = 0u;
+    for (var k = 0u; k < octaves; k++) {
+        let cell = 1u << k;
+        let cx = x >> k;
+        let cy = y >> k;
+        let fx = x & (cell - 1u);
+        let fy = y & (cell - 1u);
+        let octaveSeed = n.seed + k * 0x9E3779B9u;
+        let v00 = pcg4d(vec4<u32>(cx, cy, n.frame, octaveSeed)).x & 0xFFu;
+        let v10 = pcg4d(vec4<u32>(cx + 1u, cy, n.frame, octaveSeed)).x & 0xFFu;
+        let v01 = pcg4d(vec4<u32>(cx, cy + 1u, n.frame, octaveSeed)).x & 0xFFu;
+        let v11 = pcg4d(vec4<u32>(cx + 1u, cy + 1u, n.frame, octaveSeed)).x & 0xFFu;
+        let top = v00 * (cell - fx) + v10 * fx;
+        let bottom = v01 * (cell - fx) + v11 * fx;
+        let value = (top * (cell - fy) + bottom * fy) >> (2u * k);
+        // Amplitude proportional to wavelength gives the 1/f falloff
+        sum += value * cell;
+        weights += cell;
+    }
+    return n.low + (sum * (n.high - n.low + 1u)) / (256u * weights);
+}
+
+fn mondrianValue(n: NoiseUniforms, x: u32, y: u32) -> u32 {
+    // Later rectangles are drawn on top; background is the mid code
+    var value = 128u;
+    for (var i = 0u; i < n.rectangles; i++) {
+        let r = pcg4d(vec4<u32>(i, 0xFFFFFFFFu, n.frame, n.seed));
+        let x0 = r.x % n.width;
+        let y0 = r.y % n.height;
+        let w = 1u + r.z % max(n.width / 4u, 1u);
+        let h = 1u + r.w % max(n.height / 4u, 1u);
+        if (x >= x0 && x < x0 + w && y >= y0 && y < y0 + h) {
+            value = pcg4d(vec4<u32>(i, 0xFFFFFFFEu, n.frame, n.seed)).x & 0xFFu;
+        }
+    }
+    return scaleCode(value, n);
+}
+
+fn noiseCode(n: NoiseUniforms, x: u32, y: u32) -> u32 {
+    switch n.kind {
+        case 1u: {
+            return pinkValue(n, x, y);
+        }
+        case 2u: {
+            let h = pcg4d(vec4<u32>(x, y, n.frame, n.seed)).x;
+            return select(n.low, n.high, (h >> 31u) == 1u);
+        }
+        case 3u: {
+            return mondrianValue(n, x, y);
+        }
+        default: {
+            let h = pcg4d(vec4<u32>(x, y, n.frame, n.seed)).x;
+            return scaleCode(h >> 24u, n);
+        }
+    }
+}
+
+@fragment
+fn main(@location(0) uv: vec2<f32>) -> @location(0) vec4<f32> {
+    let x = min(u32(uv.x * f32(noise.width)), noise.width - 1u);
+    let y = min(u32(uv.y * f32(noise.height)), noise.height - 1u);
+    // code / 255 is exactly representable in UNORM8, so the output code is exact
+    let l = f32(noiseCode(noise, x, y)) / 255.0;
+    return vec4<f32>(vec3<f32>(l * stimulus.luminance), stimulus.opacity);
+}
+)";
+
+NoiseHash noiseHash(uint32_t x, uint32_t y, uint32_t frame, uint32_t seed) {
+    NoiseHash v = {
+        x * 1664525u + 1013904223u,
+        y * 1664525u + 1013904223u,
+        frame * 1664525u + 1013904223u,
+        seed * 1664525u + 1013904223u,
+    };
+    v.x += v.y * v.w;
+    v.y += v.z * v.x;
+    v.z += v.x * v.y;
+    v.w += v.y * v.z;
+    v.x ^= v.x >> 16;
+    v.y ^= v.y >> 16;
+    v.z ^= v.z >> 16;
+    v.w ^= v.w >> 16;
+    v.x += v.y * v.w;
+    v.y += v.z * v.x;
+    v.z += v.x * v.y;
+    v.w += v.y * v.z;
+    return v;
+}
+
+namespace {
+
+uint32_t scaleCode(uint32_t value, const NoiseUniforms& n) {
+    return n.low + (value * (n.high - n.low + 1u)) / 256u;
+}
+
+uint32_t pinkValue(const NoiseUniforms& n, uint32_t x, uint32_t y) {
+    uint32_t octaves = std::min(std::max(n.octaves, 1u), 10u);
+    uint32_t sum = 0;
+    uint32_t weights = 0;
+    for (uint32_t k = 0; k < octaves; ++k) {
+        uint32_t cell = 1u << k;
+        uint32_t cx = x >> k;
+        uint32_t cy = y >> k;
+        uint32_t fx = x & (cell - 1u);
+        uint32_t fy = y & (cell - 1u);
+        uint32_t octaveSeed = n.seed + k * 0x9E3779B9u;
+        uint32_t v00 = noiseHash(cx, cy, n.frame, octaveSeed).x & 0xFFu;
+        uint32_t v10 = noiseHash(cx + 1u, cy, n.frame, octaveSeed).x & 0xFFu;
+        uint32_t v01 = noiseHash(cx, cy + 1u, n.frame, octaveSeed).x & 0xFFu;
+        uint32_t v11 = noiseHash(cx + 1u, cy + 1u, n.frame, octaveSeed).x & 0xFFu;
+        uint32_t top = v00 * (cell - fx) + v10 * fx;
+        uint32_t bottom = v01 * (cell - fx) + v11 * fx;
+        uint32_t value = (top * (cell - fy) + bottom * fy) >> (2u * k);
+        sum += value * cell;
+        weights += cell;
+    }
+    return n.low + (sum * (n.high - n.low + 1u)) / (256u * weights);
+}
+
+uint32_t mondrianValue(const NoiseUniforms& n, uint32_t x, uint32_t y) {
+    uint32_t value = 128u;
+    for (uint32_t i = 0; i < n.rectangles; ++i) {
+        NoiseHash r = noiseHash(i, 0xFFFFFFFFu, n.frame, n.seed);
+        uint32_t x0 = r.x % n.width;
+        uint32_t y0 = r.y % n.height;
+        uint32_t w = 1u + r.z % std::max(n.width / 4u, 1u);
+        uint32_t h = 1u + r.w % std::max(n.height / 4u, 1u);
+        if (x >= x0 && x < x0 + w && y >= y0 && y < y0 + h) {
+            value = noiseHash(i, 0xFFFFFFFEu, n.frame, n.seed).x & 0xFFu;
+        }
+    }
+    return scaleCode(value, n);
+}
+
+} // namespace
+
+uint8_t evaluateNoise(const NoiseUniforms& params, uint32_t x, uint32_t y) {
+    switch (static_cast<NoiseType>(params.type)) {
+        case NoiseType::Pink:
+            return static_cast<uint8_t>(pinkValue(params, x, y));
+        case NoiseType::Binary: {
+            uint32_t h = noiseHash(x, y, params.frame, params.seed).x;
+            return static_cast<uint8_t>((h >> 31) == 1u ? params.high : params.low);
+        }
+        case NoiseType::Mondrian:
+            return static_cast<uint8_t>(mondrianValue(params, x, y));
+        case NoiseType::White:
+        default:
+            return static_cast<uint8_t>(scaleCode(noiseHash(x, y, params.frame, params.seed).x >> 24, params));
+    }
+}
+
+void renderNoise(const NoiseUniforms& params, uint8_t* out) {
+    for (uint32_t y = 0; y < params.height; ++y) {
+        for (uint32_t x = 0; x < params.width; ++x) {
+            out[size_t(y) * params.width + x] = evaluateNoise(params, x, y);
+        }
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Noise and mask fields generated in the fragment shader. Every value comes
+// from a counter-based hash of (seed, frame, pixel) and all arithmetic is
+// integer, so any frame can be regenerated exactly on the CPU.
+enum class NoiseType : uint32_t {
+    White = 0,    // independent uniform codes per noise pixel
+    Pink = 1,     // octaves of value noise weighted 1/f
+    Binary = 2,   // each noise pixel is low or high
+    Mondrian = 3, // overlapping random rectangles
+};
+
+// Mirrors NoiseUniforms in noiseFragmentShaderCode
+struct NoiseUniforms {
+    uint32_t type;       // NoiseType
+    uint32_t seed;
+    uint32_t frame;      // fresh field per frame; keep fixed for a static mask
+    uint32_t width;      // field size in noise pixels across the stimulus quad
+    uint32_t height;
+    uint32_t low;        // darkest 8-bit code
+    uint32_t high;       // brightest 8-bit code
+    uint32_t octaves;    // pink: number of octaves, 1..10
+    uint32_t rectangles; // mondrian: number of rectangles
+    uint32_t padding[3];
+};
+
+// WGSL pcg4d(vec4<u32>) -> vec4<u32>, for shaders that need the same hash
+extern const char* const pcg4dShaderCode;
+
+// Fragment shader for noise stimuli; group 0 binding 0 holds the
+// NoiseUniforms, group 1 the usual StimulusUniforms.
+extern const std::string noiseFragmentShaderCode;
+
+struct NoiseHash {
+    uint32_t x, y, z, w;
+};
+
+// pcg4d (Jarzynski & Olano, 2020), identical to the WGSL version
+NoiseHash noiseHash(uint32_t x, uint32_t y, uint32_t frame, uint32_t seed);
+
+// 8-bit code of one noise pixel, bit-exact with the shader
+uint8_t evaluateNoise(const NoiseUniforms& params, uint32_t x, uint32_t y);
+
+// Regenerate a whole field of width * height codes
+void renderNoise(const NoiseUniforms& params, uint8_t* out);
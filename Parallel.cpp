@@ -0,0 +1,80 @@
+#include "Parallel.h"
+
+namespace {
+
+thread_local bool onPoolWorker = false;
+
+} // namespace
+
+WorkerPool& WorkerPool::instance() {
+    // Leave one hardware thread to whoever submits
+    static WorkerPool pool(std::min(std::max(std::thread::hardware_concurrency(), 1u) - 1, kWorkerPoolBudget));
+    return pool;
+}
+
+WorkerPool::WorkerPool(unsigned count) {
+    threads.reserve(count);
+    for (unsigned i = 0; i < count; ++i) {
+        threads.emplace_back(&WorkerPool::workerMain, this);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkerPool::run(size_t chunks, void (*task)(void*, size_t), void* context) {
+    std::unique_lock<std::mutex> submit(submitMutex, std::try_to_lock);
+    if (onPoolWorker || !submit.owns_lock()) {
+        for (size_t chunk = 0; chunk < chunks; ++chunk) {
+            task(context, chunk);
+        }
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    jobTask = task;
+    jobContext = context;
+    jobChunks = chunks;
+    nextChunk = 0;
+    doneChunks = 0;
+    wake.notify_all();
+    work(lock);
+    finished.wait(lock, [this] { return doneChunks == jobChunks; });
+    jobTask = nullptr;
+}
+
+void WorkerPool::workerMain() {
+    onPoolWorker = true;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || (jobTask && nextChunk < jobChunks); });
+        if (stopping) {
+            return;
+        }
+        work(lock);
+    }
+}
+
+void WorkerPool::work(std::unique_lock<std::mutex>& lock) {
+    // Chunks are claimed under the lock, so a worker never picks up a chunk
+    // of a job that has already finished
+    while (jobTask && nextChunk < jobChunks) {
+        size_t chunk = nextChunk++;
+        void (*task)(void*, size_t) = jobTask;
+        void* context = jobContext;
+        lock.unlock();
+        task(context, chunk);
+        lock.lock();
+        if (++doneChunks == jobChunks) {
+            finished.notify_all();
+        }
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Thread budget against PTHREAD_POOL_SIZE=10, the workers the browser starts
+// up front: up to four are long-lived (the render thread with
+// RENDER_ON_WORKER, the capture worker, the video writer and the synthetic
+// gaze source), which leaves six for this pool. Past the pool size a new
+// pthread only starts once the calling thread yields to the browser, so the
+// pool stays within it and is started once, never per call.
+constexpr unsigned kWorkerPoolBudget = 6;
+
+// Persistent workers behind parallelFor. One job runs at a time; the
+// submitting thread works on it too.
+class WorkerPool {
+public:
+    // The pool parallelFor uses
+    static WorkerPool& instance();
+
+    explicit WorkerPool(unsigned count);
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    ~WorkerPool();
+
+    unsigned workers() const { return static_cast<unsigned>(threads.size()); }
+
+    // Run task(context, chunk) for every chunk in [0, chunks) and return when
+    // all are done. Runs them one after another on the calling thread when
+    // it is a pool worker itself (nested calls) or another job is running.
+    void run(size_t chunks, void (*task)(void* context, size_t chunk), void* context);
+
+private:
+    void workerMain();
+    // Claim and run chunks of the current job until none are left; `lock` held on entry and exit
+    void work(std::unique_lock<std::mutex>& lock);
+
+    std::mutex submitMutex; // held for the whole of a job
+    std::mutex mutex;       // guards the job fields below
+    std::condition_variable wake;
+    std::condition_variable finished;
+    void (*jobTask)(void*, size_t) = nullptr;
+    void* jobContext = nullptr;
+    size_t jobChunks = 0;
+    size_t nextChunk = 0;
+    size_t doneChunks = 0;
+    bool stopping = false;
+    std::vector<std::thread> threads;
+};
+
+// Threads parallelFor spreads work over: the pool plus the caller
+inline unsigned parallelWorkers() {
+    return WorkerPool::instance().workers() + 1;
+}
+
+// Number of chunks parallelFor will use for `count` items
+inline size_t parallelChunks(size_t count, size_t minChunk) {
+    return std::min<size_t>(parallelWorkers(), std::max<size_t>(1, count / std::max<size_t>(minChunk, 1)));
+}
+
+// Split [0, count) into one contiguous chunk per worker and run
+// body(chunk, begin, end) on each, on the pool and the calling thread.
+// Chunks are at least minChunk items, so small inputs stay on one thread.
+template <typename Body>
+void parallelFor(size_t count, size_t minChunk, Body&& body) {
+    size_t chunks = parallelChunks(count, minChunk);
+    if (chunks <= 1) {
+        body(size_t(0), size_t(0), count);
+        return;
+    }
+
+    struct Job {
+        Body& body;
+        size_t count;
+        size_t chunks;
+    } job{ body, count, chunks };
+    WorkerPool::instance().run(chunks, [](void* context, size_t chunk) {
+        Job& job = *static_cast<Job*>(context);
+        job.body(chunk, job.count * chunk / job.chunks, job.count * (chunk + 1) / job.chunks);
+    }, &job);
+}
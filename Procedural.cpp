@@ -0,0 +1,141 @@
+#include "Procedural.h"
+
+#include <algorithm>
+#include <cmath>
+
+const char* const proceduralFragmentShaderCode = R"(
+struct PatternUniforms {
+    kind: u32,
+    frequency: f32,
+    orientation: f32,
+    phase: f32,
+    contrast: f32,
+    meanLuminance: f32,
+    sigma: f32,
+    frequency2: f32,
+    orientation2: f32,
+    phase2: f32,
+};
+
+struct StimulusUniforms {
+    transform: mat4x4<f32>,
+    opacity: f32,
+    luminance: f32,
+    frameIndex: u32,
+};
+
+@group(0) @binding(0) var<uniform> pattern: PatternUniforms;
+@group(1) @binding(0) var<uniform> stimulus: StimulusUniforms;
+
+const TAU: f32 = 6.28318530717958647692;
+
+fn squareWave(v: f32) -> f32 {
+    return select(-1.0, 1.0, v >= 0.0);
+}
+
+fn grating(x: f32, y: f32, frequency: f32, orientation: f32, phase: f32) -> f32 {
+    let d = x * cos(orientation) + y * sin(orientation);
+    return sin(TAU * frequency * d + phase);
+}
+
+// Signed modulation in [-1, 1]; must stay in step with evaluatePattern()
+fn modulation(p: PatternUniforms, x: f32, y: f32) -> f32 {
+    switch p.kind {
+        case 1u: {
+            let envelope = exp(-(x * x + y * y) / (2.0 * p.sigma * p.sigma));
+            return envelope * grating(x, y, p.frequency, p.orientation, p.phase);
+        }
+        case 2u: {
+            let a = grating(x, y, p.frequency, p.orientation, p.phase);
+            let b = grating(x, y, p.frequency, p.orientation + TAU * 0.25, p.phase);
+            return squareWave(a * b);
+        }
+        case 3u: {
+            let rings = sin(TAU * p.frequency * sqrt(x * x + y * y) + p.phase);
+            if (p.frequency2 > 0.0) {
+                let spokes = sin(p.frequency2 * atan2(y, x) + p.phase2);
+                return squareWave(rings * spokes);
+            }
+            return rings;
+        }
+        case 4u: {
+            let a = grating(x, y, p.frequency, p.orientation, p.phase);
+            let b = grating(x, y, p.frequency2, p.orientation2, p.phase2);
+            return 0.5 * (a + b);
+        }
+        default: {
+            return grating(x, y, p.frequency, p.orientation, p.phase);
+        }
+    }
+}
+
+@fragment
+fn main(@location(0) uv: vec2<f32>) -> @location(0) vec4<f32> {
+    let x = uv.x - 0.5;
+    let y = 0.5 - uv.y;
+    let l = clamp(pattern.meanLuminance * (1.0 + pattern.contrast * modulation(pattern, x, y)), 0.0, 1.0);
+    return vec4<f32>(vec3<f32>(l * stimulus.luminance), stimulus.opacity);
+}
+)";
+
+namespace {
+
+constexpr float kTau = 6.28318530717958647692f;
+
+float squareWave(float v) {
+    return v >= 0.0f ? 1.0f : -1.0f;
+}
+
+float grating(float x, float y, float frequency, float orientation, float phase) {
+    float d = x * std::cos(orientation) + y * std::sin(orientation);
+    return std::sin(kTau * frequency * d + phase);
+}
+
+float modulation(const PatternUniforms& p, float x, float y) {
+    switch (static_cast<PatternType>(p.type)) {
+        case PatternType::Gabor: {
+            float envelope = std::exp(-(x * x + y * y) / (2.0f * p.sigma * p.sigma));
+            return envelope * grating(x, y, p.frequency, p.orientation, p.phase);
+        }
+        case PatternType::Checkerboard: {
+            float a = grating(x, y, p.frequency, p.orientation, p.phase);
+            float b = grating(x, y, p.frequency, p.orientation + kTau * 0.25f, p.phase);
+            return squareWave(a * b);
+        }
+        case PatternType::Radial: {
+            float rings = std::sin(kTau * p.frequency * std::sqrt(x * x + y * y) + p.phase);
+            if (p.frequency2 > 0.0f) {
+                float spokes = std::sin(p.frequency2 * std::atan2(y, x) + p.phase2);
+                return squareWave(rings * spokes);
+            }
+            return rings;
+        }
+        case PatternType::Plaid: {
+            float a = grating(x, y, p.frequency, p.orientation, p.phase);
+            float b = grating(x, y, p.frequency2, p.orientation2, p.phase2);
+            return 0.5f * (a + b);
+        }
+        case PatternType::Grating:
+        default:
+            return grating(x, y, p.frequency, p.orientation, p.phase);
+    }
+}
+
+} // namespace
+
+float evaluatePattern(const PatternUniforms& params, float x, float y) {
+    float l = params.meanLuminance * (1.0f + params.contrast * modulation(params, x, y));
+    return std::clamp(l, 0.0f, 1.0f);
+}
+
+void renderPattern(const PatternUniforms& params, uint32_t width, uint32_t height, uint8_t* out) {
+    for (uint32_t row = 0; row < height; ++row) {
+        float v = (float(row) + 0.5f) / float(height);
+        for (uint32_t col = 0; col < width; ++col) {
+            float u = (float(col) + 0.5f) / float(width);
+            float l = evaluatePattern(params, u - 0.5f, 0.5f - v);
+            // UNORM8 conversion as specified by WebGPU: round to nearest
+            out[size_t(row) * width + col] = static_cast<uint8_t>(std::lround(l * 255.0f));
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+// Stimuli generated in the fragment shader from uniform parameters, with no
+// texture memory and no upload. Coordinates are in stimulus units: the quad
+// spans [-0.5, 0.5] in x and y with y pointing up, so frequencies are in
+// cycles per stimulus width.
+enum class PatternType : uint32_t {
+    Grating = 0,      // sinusoidal grating
+    Gabor = 1,        // grating under a Gaussian envelope
+    Checkerboard = 2, // square-wave checks, rotatable
+    Radial = 3,       // concentric rings; with spokes a polar checkerboard
+    Plaid = 4,        // sum of two gratings
+};
+
+// Mirrors PatternUniforms in proceduralFragmentShaderCode
+struct PatternUniforms {
+    uint32_t type;       // PatternType
+    float frequency;     // cycles per stimulus width
+    float orientation;   // radians, counter-clockwise from the x axis
+    float phase;         // radians
+    float contrast;      // Michelson contrast, 0..1
+    float meanLuminance; // 0..1
+    float sigma;         // Gabor envelope standard deviation, stimulus widths
+    float frequency2;    // plaid: second frequency; radial: number of spokes
+    float orientation2;  // plaid: second orientation
+    float phase2;        // plaid / radial spokes: second phase
+    uint32_t padding[2];
+};
+
+// Fragment shader for the procedural pipeline. Group 0 binding 0 holds the
+// PatternUniforms, group 1 the usual StimulusUniforms.
+extern const char* const proceduralFragmentShaderCode;
+
+// CPU reference of the shader's pattern() function. Uses the same float
+// operations in the same order; results match the GPU to within one 8-bit
+// code (the WGSL sin/exp/atan2 builtins are not correctly rounded).
+float evaluatePattern(const PatternUniforms& params, float x, float y);
+
+// Rasterize a pattern as the GPU would, sampling at pixel centres, into
+// width * height 8-bit luminance codes.
+void renderPattern(const PatternUniforms& params, uint32_t width, uint32_t height, uint8_t* out);
@@ -0,0 +1,147 @@
+#include "RenderGraph.h"
+
+#include <algorithm>
+
+RenderGraph::Resource RenderGraph::importTexture(const char* name, const wgpu::TextureView& view) {
+    ResourceNode node = { name, false };
+    node.view = view;
+    resources.push_back(node);
+    return Resource(resources.size() - 1);
+}
+
+RenderGraph::Resource RenderGraph::importBuffer(const char* name) {
+    resources.push_back({ name, false });
+    return Resource(resources.size() - 1);
+}
+
+RenderGraph::Resource RenderGraph::createTexture(const char* name, const TexturePool::Desc& desc) {
+    ResourceNode node = { name, true };
+    node.desc = desc;
+    resources.push_back(node);
+    return Resource(resources.size() - 1);
+}
+
+void RenderGraph::addPass(const char* name, std::initializer_list<Resource> reads,
+                          std::initializer_list<Resource> writes, Execute execute) {
+    passes.push_back({ name, reads, writes, std::move(execute) });
+}
+
+void RenderGraph::markOutput(Resource resource) {
+    resources[resource].output = true;
+}
+
+void RenderGraph::cull() {
+    // Walk backwards from the outputs; a pass lives if anything it writes is
+    // needed, and then everything it reads is needed too
+    std::vector<bool> needed(resources.size(), false);
+    for (size_t i = 0; i < resources.size(); ++i) {
+        needed[i] = resources[i].output;
+    }
+    for (size_t p = passes.size(); p-- > 0;) {
+        PassNode& pass = passes[p];
+        pass.alive = std::any_of(pass.writes.begin(), pass.writes.end(), [&](Resource r) { return needed[r]; });
+        if (pass.alive) {
+            for (Resource r : pass.reads) {
+                needed[r] = true;
+            }
+        }
+    }
+}
+
+void RenderGraph::assignSlots() {
+    for (size_t p = 0; p < passes.size(); ++p) {
+        if (!passes[p].alive) {
+            continue;
+        }
+        auto touch = [&](Resource r) {
+            ResourceNode& node = resources[r];
+            if (node.first < 0) {
+                node.first = int(p);
+            }
+            node.last = int(p);
+        };
+        std::for_each(passes[p].reads.begin(), passes[p].reads.end(), touch);
+        std::for_each(passes[p].writes.begin(), passes[p].writes.end(), touch);
+    }
+
+    // Greedy interval allocation: a slot frees up after the last pass using it
+    std::vector<bool> slotFree;
+    slots.clear();
+    for (size_t p = 0; p < passes.size(); ++p) {
+        for (ResourceNode& node : resources) {
+            if (!node.transient || node.first != int(p)) {
+                continue;
+            }
+            for (size_t s = 0; s < slots.size() && node.slot < 0; ++s) {
+                if (slotFree[s] && slots[s] == node.desc) {
+                    node.slot = int(s);
+                    slotFree[s] = false;
+                }
+            }
+            if (node.slot < 0) {
+                node.slot = int(slots.size());
+                slots.push_back(node.desc);
+                slotFree.push_back(false);
+            }
+            counters.transients++;
+            counters.transientBytes += TexturePool::byteSize(node.desc);
+        }
+        for (ResourceNode& node : resources) {
+            if (node.transient && node.last == int(p)) {
+                slotFree[node.slot] = true;
+            }
+        }
+    }
+
+    counters.physical = slots.size();
+    for (const TexturePool::Desc& desc : slots) {
+        counters.physicalBytes += TexturePool::byteSize(desc);
+    }
+}
+
+void RenderGraph::execute(wgpu::CommandEncoder& encoder, TexturePool& pool) {
+    counters = {};
+    counters.passes = passes.size();
+    cull();
+    assignSlots();
+
+    std::vector<TexturePool::Texture> textures;
+    textures.reserve(slots.size());
+    for (const TexturePool::Desc& desc : slots) {
+        textures.push_back(pool.acquire(desc));
+    }
+    for (ResourceNode& node : resources) {
+        if (node.transient && node.slot >= 0) {
+            node.texture = textures[node.slot].texture;
+            node.view = textures[node.slot].view;
+        }
+    }
+
+    for (PassNode& pass : passes) {
+        if (pass.alive) {
+            pass.execute(encoder);
+        } else {
+            counters.culled++;
+        }
+    }
+
+    for (const TexturePool::Texture& texture : textures) {
+        pool.release(texture);
+    }
+}
+
+void RenderGraph::reset() {
+    resources.clear();
+    passes.clear();
+    slots.clear();
+}
+
+std::string RenderGraph::describe() const {
+    std::string text;
+    for (const PassNode& pass : passes) {
+        text += pass.alive ? "" : "(culled) ";
+        text += pass.name;
+        text += "\n";
+    }
+    return text;
+}
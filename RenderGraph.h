@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include <webgpu/webgpu_cpp.h>
+
+#include "TexturePool.h"
+
+// Minimal per-frame render graph. Passes declare the resources they read
+// and write; execute() then
+//  - culls passes whose writes never reach a resource marked as output,
+//  - computes the first and last pass using each transient texture,
+//  - aliases transients with equal descriptors whose lifetimes do not
+//    overlap onto one pooled texture,
+//  - records the surviving passes in declaration order.
+// Imported resources (swap chain, persistent targets, buffers) only carry
+// dependencies; the graph never allocates or frees them.
+class RenderGraph {
+public:
+    using Resource = uint32_t;
+    using Execute = std::function<void(wgpu::CommandEncoder& encoder)>;
+
+    struct Stats {
+        size_t passes = 0;
+        size_t culled = 0;
+        size_t transients = 0;       // transient textures declared and used
+        size_t physical = 0;         // pooled textures backing them
+        uint64_t transientBytes = 0; // memory without aliasing
+        uint64_t physicalBytes = 0;  // memory actually held this frame
+    };
+
+    Resource importTexture(const char* name, const wgpu::TextureView& view);
+    Resource importBuffer(const char* name);
+    Resource createTexture(const char* name, const TexturePool::Desc& desc);
+
+    void addPass(const char* name, std::initializer_list<Resource> reads, std::initializer_list<Resource> writes,
+                 Execute execute);
+    void markOutput(Resource resource);
+
+    // View of a texture resource; for transients only valid inside a pass
+    const wgpu::TextureView& view(Resource resource) const { return resources[resource].view; }
+    // Texture behind a transient, for copies; only valid inside a pass
+    const wgpu::Texture& texture(Resource resource) const { return resources[resource].texture; }
+
+    void execute(wgpu::CommandEncoder& encoder, TexturePool& pool);
+    // Forget all passes and resources, ready for the next frame
+    void reset();
+
+    const Stats& stats() const { return counters; }
+    // Names of the passes run by the last execute(), for debugging
+    std::string describe() const;
+
+private:
+    struct ResourceNode {
+        const char* name;
+        bool transient;
+        bool output = false;
+        TexturePool::Desc desc;
+        wgpu::Texture texture;
+        wgpu::TextureView view;
+        int first = -1;
+        int last = -1;
+        int slot = -1;
+    };
+
+    struct PassNode {
+        const char* name;
+        std::vector<Resource> reads;
+        std::vector<Resource> writes;
+        Execute execute;
+        bool alive = false;
+    };
+
+    void cull();
+    void assignSlots();
+
+    std::vector<ResourceNode> resources;
+    std::vector<PassNode> passes;
+    std::vector<TexturePool::Desc> slots;
+    Stats counters;
+};
@@ -0,0 +1,197 @@
+#include "Spectral.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+#include "Fft.h"
+#include "Noise.h"
+#include "Parallel.h"
+
+namespace {
+
+// Power-of-two working plane around one image
+struct PaddedPlane {
+    uint32_t width;
+    uint32_t height;
+    std::vector<float> values;
+    std::vector<float> re;
+    std::vector<float> im;
+
+    PaddedPlane(uint32_t imageWidth, uint32_t imageHeight)
+        : width(fftSize(imageWidth)),
+          height(fftSize(imageHeight)),
+          values(size_t(width) * height),
+          re(values.size()),
+          im(values.size()) {}
+};
+
+// Copy `channel` (0..2, or 3 for luminance with `weights`) into the plane, padding with its mean
+void loadPlane(const MatchImage& image, int channel, const float* weights, PaddedPlane& plane) {
+    double sum = 0.0;
+    for (uint32_t y = 0; y < image.height; ++y) {
+        const uint8_t* row = image.rgba + size_t(y) * image.width * 4;
+        float* dst = &plane.values[size_t(y) * plane.width];
+        for (uint32_t x = 0; x < image.width; ++x) {
+            const uint8_t* p = row + x * 4;
+            dst[x] = channel < 3 ? float(p[channel])
+                                 : float(p[0]) * weights[0] + float(p[1]) * weights[1] + float(p[2]) * weights[2];
+            sum += dst[x];
+        }
+    }
+    if (plane.width == image.width && plane.height == image.height) {
+        return;
+    }
+    float mean = static_cast<float>(sum / std::max<double>(1.0, double(image.width) * image.height));
+    for (uint32_t y = 0; y < plane.height; ++y) {
+        float* dst = &plane.values[size_t(y) * plane.width];
+        std::fill(dst + (y < image.height ? image.width : 0), dst + plane.width, mean);
+    }
+}
+
+// Crop the plane back into `channel`, or all three for luminance; returns clamped values
+size_t storePlane(const PaddedPlane& plane, int channel, MatchImage& image) {
+    size_t clipped = 0;
+    for (uint32_t y = 0; y < image.height; ++y) {
+        uint8_t* row = image.rgba + size_t(y) * image.width * 4;
+        const float* src = &plane.values[size_t(y) * plane.width];
+        for (uint32_t x = 0; x < image.width; ++x) {
+            float v = std::nearbyint(src[x]);
+            if (v < 0.0f || v > 255.0f) {
+                clipped++;
+            }
+            uint8_t code = static_cast<uint8_t>(std::clamp(v, 0.0f, 255.0f));
+            uint8_t* p = row + x * 4;
+            if (channel < 3) {
+                p[channel] = code;
+            } else {
+                p[0] = p[1] = p[2] = code;
+            }
+        }
+    }
+    return clipped;
+}
+
+void normalizeWeights(float lumR, float lumG, float lumB, float weights[3]) {
+    float total = lumR + lumG + lumB;
+    weights[0] = lumR / total;
+    weights[1] = lumG / total;
+    weights[2] = lumB / total;
+}
+
+} // namespace
+
+size_t phaseScramble(MatchImage& image, uint32_t seed, float amount, bool parallel) {
+    if (image.width == 0 || image.height == 0) {
+        return 0;
+    }
+    PaddedPlane plane(image.width, image.height);
+
+    // Phase of a white-noise field; Hermitian, so the result stays real
+    for (uint32_t y = 0; y < plane.height; ++y) {
+        for (uint32_t x = 0; x < plane.width; ++x) {
+            plane.values[size_t(y) * plane.width + x] = float(noiseHash(x, y, 0, seed).x >> 8) * (1.0f / 16777216.0f);
+        }
+    }
+    forwardReal2d(plane.values.data(), plane.width, plane.height, plane.re.data(), plane.im.data(), parallel);
+    std::vector<float> noisePhase(plane.values.size());
+    for (size_t i = 0; i < noisePhase.size(); ++i) {
+        noisePhase[i] = amount * std::atan2(plane.im[i], plane.re[i]);
+    }
+    // Bins that are their own mirror (DC and Nyquist) must stay real
+    for (uint32_t v : { 0u, plane.height / 2 }) {
+        for (uint32_t u : { 0u, plane.width / 2 }) {
+            noisePhase[size_t(v) * plane.width + u] = 0.0f;
+        }
+    }
+
+    size_t clipped = 0;
+    for (int channel = 0; channel < 3; ++channel) {
+        loadPlane(image, channel, nullptr, plane);
+        forwardReal2d(plane.values.data(), plane.width, plane.height, plane.re.data(), plane.im.data(), parallel);
+        for (size_t i = 0; i < noisePhase.size(); ++i) {
+            float c = std::cos(noisePhase[i]);
+            float s = std::sin(noisePhase[i]);
+            float re = plane.re[i] * c - plane.im[i] * s;
+            float im = plane.re[i] * s + plane.im[i] * c;
+            plane.re[i] = re;
+            plane.im[i] = im;
+        }
+        inverseReal2d(plane.re.data(), plane.im.data(), plane.width, plane.height, plane.values.data(), parallel);
+        clipped += storePlane(plane, channel, image);
+    }
+    return clipped;
+}
+
+bool matchSpectra(MatchImage* images, size_t count, size_t* clippedPixels, float lumR, float lumG, float lumB) {
+    if (clippedPixels) {
+        *clippedPixels = 0;
+    }
+    if (count == 0) {
+        return true;
+    }
+    for (size_t i = 1; i < count; ++i) {
+        if (images[i].width != images[0].width || images[i].height != images[0].height) {
+            std::cerr << "Spectrum matching needs images of one size." << std::endl;
+            return false;
+        }
+    }
+    float weights[3];
+    normalizeWeights(lumR, lumG, lumB, weights);
+
+    // Images are spread over threads, so each transform stays on its thread
+    uint32_t width = fftSize(images[0].width);
+    uint32_t height = fftSize(images[0].height);
+    size_t bins = size_t(width) * height;
+    size_t chunks = parallelChunks(count, 1);
+
+    std::vector<std::vector<double>> partials(chunks, std::vector<double>(bins, 0.0));
+    parallelFor(count, 1, [&](size_t chunk, size_t begin, size_t end) {
+        PaddedPlane plane(images[0].width, images[0].height);
+        for (size_t i = begin; i < end; ++i) {
+            loadPlane(images[i], 3, weights, plane);
+            forwardReal2d(plane.values.data(), width, height, plane.re.data(), plane.im.data(), false);
+            for (size_t k = 0; k < bins; ++k) {
+                partials[chunk][k] += std::hypot(plane.re[k], plane.im[k]);
+            }
+        }
+    });
+    std::vector<float> amplitude(bins, 0.0f);
+    for (size_t k = 0; k < bins; ++k) {
+        double sum = 0.0;
+        for (const std::vector<double>& partial : partials) {
+            sum += partial[k];
+        }
+        amplitude[k] = static_cast<float>(sum / double(count));
+    }
+    partials.clear();
+
+    std::vector<size_t> clipped(chunks, 0);
+    parallelFor(count, 1, [&](size_t chunk, size_t begin, size_t end) {
+        PaddedPlane plane(images[0].width, images[0].height);
+        for (size_t i = begin; i < end; ++i) {
+            loadPlane(images[i], 3, weights, plane);
+            forwardReal2d(plane.values.data(), width, height, plane.re.data(), plane.im.data(), false);
+            for (size_t k = 0; k < bins; ++k) {
+                float magnitude = std::hypot(plane.re[k], plane.im[k]);
+                if (magnitude > 0.0f) {
+                    float scale = amplitude[k] / magnitude;
+                    plane.re[k] *= scale;
+                    plane.im[k] *= scale;
+                } else {
+                    plane.re[k] = amplitude[k];
+                    plane.im[k] = 0.0f;
+                }
+            }
+            inverseReal2d(plane.re.data(), plane.im.data(), width, height, plane.values.data(), false);
+            clipped[chunk] += storePlane(plane, 3, images[i]);
+        }
+    });
+
+    if (clippedPixels) {
+        *clippedPixels = std::accumulate(clipped.begin(), clipped.end(), size_t(0));
+    }
+    return true;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "LuminanceMatch.h"
+
+// Fourier-domain stimulus operations on RGBA8 images, in place. Images
+// that are not a power of two on a side are padded with their mean and
+// cropped back. Results are clamped to 8-bit codes.
+
+// Phase scrambling: add `amount` (0..1) of the phase of a white-noise
+// field to every channel's phase, keeping each amplitude spectrum. The
+// noise comes from noiseHash(x, y, 0, seed), so a seed always gives the
+// same image, and all channels share it so colors stay coherent.
+// Returns the number of clamped channel values.
+size_t phaseScramble(MatchImage& image, uint32_t seed, float amount, bool parallel = true);
+
+// Amplitude spectrum matching as in SHINE's specMatch: every image keeps
+// its luminance phase and takes the set's average amplitude spectrum. All
+// images must share one size; the output is achromatic. Returns false on
+// mismatched sizes, otherwise stores the clamped pixel count.
+bool matchSpectra(MatchImage* images, size_t count, size_t* clippedPixels = nullptr,
+                  float lumR = 0.2126f, float lumG = 0.7152f, float lumB = 0.0722f);
@@ -0,0 +1,102 @@
+#include "TexturePool.h"
+
+#include <algorithm>
+
+#include "GpuCache.h"
+
+void TexturePool::init(const wgpu::Device& dev, GpuCache* gpuCache, uint32_t maxIdleFrames) {
+    device = dev;
+    cache = gpuCache;
+    maxIdle = maxIdleFrames;
+}
+
+TexturePool::Texture TexturePool::acquire(const Desc& desc) {
+    for (Entry& entry : entries) {
+        if (!entry.inUse && entry.desc == desc) {
+            entry.inUse = true;
+            entry.idleFrames = 0;
+            counters.reused++;
+            return entry.texture;
+        }
+    }
+
+    wgpu::TextureDescriptor texDesc = {};
+    texDesc.label = "Pooled texture";
+    texDesc.size = { desc.width, desc.height, 1 };
+    texDesc.format = desc.format;
+    texDesc.usage = desc.usage;
+
+    Entry entry;
+    entry.desc = desc;
+    entry.texture.texture = device.CreateTexture(&texDesc);
+    entry.texture.view = entry.texture.texture.CreateView();
+    entry.inUse = true;
+    entries.push_back(entry);
+
+    counters.created++;
+    counters.live = entries.size();
+    counters.liveBytes += byteSize(desc);
+    return entry.texture;
+}
+
+void TexturePool::release(const Texture& texture) {
+    for (Entry& entry : entries) {
+        if (entry.texture.texture.Get() == texture.texture.Get()) {
+            entry.inUse = false;
+            return;
+        }
+    }
+}
+
+void TexturePool::endFrame() {
+    for (Entry& entry : entries) {
+        if (!entry.inUse && ++entry.idleFrames > maxIdle) {
+            destroy(entry);
+        }
+    }
+    entries.erase(std::remove_if(entries.begin(), entries.end(), [](const Entry& e) { return !e.texture.texture; }),
+                  entries.end());
+    counters.live = entries.size();
+}
+
+void TexturePool::clear() {
+    for (Entry& entry : entries) {
+        destroy(entry);
+    }
+    entries.clear();
+    counters.live = 0;
+}
+
+uint64_t TexturePool::byteSize(const Desc& desc) {
+    uint64_t bytesPerTexel = 4;
+    switch (desc.format) {
+        case wgpu::TextureFormat::RGBA16Float:
+            bytesPerTexel = 8;
+            break;
+        case wgpu::TextureFormat::RGBA32Float:
+            bytesPerTexel = 16;
+            break;
+        case wgpu::TextureFormat::R8Unorm:
+            bytesPerTexel = 1;
+            break;
+        case wgpu::TextureFormat::R16Float:
+            bytesPerTexel = 2;
+            break;
+        default:
+            break;
+    }
+    return uint64_t(desc.width) * desc.height * bytesPerTexel;
+}
+
+void TexturePool::destroy(Entry& entry) {
+    if (!entry.texture.texture) {
+        return;
+    }
+    if (cache) {
+        cache->invalidate(entry.texture.view.Get());
+    }
+    entry.texture.texture.Destroy();
+    entry.texture = {};
+    counters.destroyed++;
+    counters.liveBytes -= byteSize(entry.desc);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <webgpu/webgpu_cpp.h>
+
+class GpuCache;
+
+// Recycles intermediate textures between passes and frames. A texture is
+// acquired for a pass, released when the encoder no longer needs it and
+// handed to the next acquire with the same size, format and usage; queue
+// ordering makes reuse safe without waiting for the GPU. Textures left
+// unused for `maxIdleFrames` frames are destroyed.
+class TexturePool {
+public:
+    struct Desc {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        wgpu::TextureFormat format = wgpu::TextureFormat::RGBA16Float;
+        wgpu::TextureUsage usage = wgpu::TextureUsage::TextureBinding;
+
+        bool operator==(const Desc& other) const {
+            return width == other.width && height == other.height && format == other.format && usage == other.usage;
+        }
+    };
+
+    struct Texture {
+        wgpu::Texture texture;
+        wgpu::TextureView view;
+    };
+
+    struct Stats {
+        uint64_t created = 0;
+        uint64_t reused = 0;
+        uint64_t destroyed = 0;
+        size_t live = 0;       // textures owned by the pool, in use or free
+        uint64_t liveBytes = 0;
+    };
+
+    // `cache` drops bind groups that reference a texture before it is destroyed
+    void init(const wgpu::Device& device, GpuCache* cache, uint32_t maxIdleFrames = 8);
+
+    Texture acquire(const Desc& desc);
+    void release(const Texture& texture);
+    // Once per frame, after submitting: ages free textures and trims old ones
+    void endFrame();
+    void clear();
+
+    const Stats& stats() const { return counters; }
+
+    static uint64_t byteSize(const Desc& desc);
+
+private:
+    struct Entry {
+        Desc desc;
+        Texture texture;
+        bool inUse = false;
+        uint32_t idleFrames = 0;
+    };
+
+    void destroy(Entry& entry);
+
+    wgpu::Device device;
+    GpuCache* cache = nullptr;
+    uint32_t maxIdle = 8;
+    std::vector<Entry> entries;
+    Stats counters;
+};
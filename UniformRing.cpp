@@ -0,0 +1,97 @@
+#include "UniformRing.h"
+
+#include <cassert>
+#include <iostream>
+
+void UniformRing::init(const wgpu::Device& device, uint64_t capacity) {
+    ringCapacity = (capacity + kAlignment - 1) / kAlignment * kAlignment;
+
+    wgpu::BufferDescriptor desc = {};
+    desc.label = "Uniform ring";
+    desc.size = ringCapacity;
+    desc.usage = wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst;
+    ringBuffer = device.CreateBuffer(&desc);
+
+    staging.assign(ringCapacity, 0);
+    head = 0;
+    usedBytes = 0;
+    frameStart = frameEnd = frameBytes = 0;
+    frameSplit = false;
+    inFlight.clear();
+}
+
+UniformRing::Allocation UniformRing::allocate(uint32_t size) {
+    uint64_t aligned = (uint64_t(size) + kAlignment - 1) / kAlignment * kAlignment;
+    bool firstInFrame = frameBytes == 0;
+
+    // A block that does not fit before the end of the buffer goes to its
+    // start. A frame may span that wrap once; its blocks before the wrap are
+    // then uploaded with a second write. The tail skipped on a wrap may be
+    // empty when head sits exactly at the end.
+    bool wrap = head + aligned > ringCapacity;
+    if (wrap && frameSplit) {
+        std::cerr << "Uniform ring: frame is larger than the buffer." << std::endl;
+        return {};
+    }
+    uint64_t skip = wrap ? ringCapacity - head : 0;
+
+    if (usedBytes + skip + aligned > ringCapacity) {
+        std::cerr << "Uniform ring full, GPU is too far behind." << std::endl;
+        return {};
+    }
+
+    if (wrap) {
+        if (!firstInFrame) {
+            splitStart = frameStart;
+            splitEnd = frameEnd;
+            frameSplit = true;
+        }
+        head = 0;
+        usedBytes += skip;
+        frameBytes += skip;
+    }
+    if (firstInFrame || wrap) {
+        frameStart = frameEnd = head;
+    }
+
+    assert(head + aligned <= ringCapacity);
+    Allocation alloc;
+    alloc.offset = static_cast<uint32_t>(head);
+    alloc.data = staging.data() + head;
+
+    head += aligned;
+    usedBytes += aligned;
+    frameBytes += aligned;
+    frameEnd = head;
+    return alloc;
+}
+
+void UniformRing::flush(const wgpu::Queue& queue) {
+    if (frameSplit && splitEnd > splitStart) {
+        queue.WriteBuffer(ringBuffer, splitStart, staging.data() + splitStart, splitEnd - splitStart);
+    }
+    if (frameEnd > frameStart) {
+        queue.WriteBuffer(ringBuffer, frameStart, staging.data() + frameStart, frameEnd - frameStart);
+    }
+}
+
+void UniformRing::submitted(const wgpu::Queue& queue) {
+    if (frameBytes > 0) {
+        inFlight.push_back(frameBytes);
+        queue.OnSubmittedWorkDone(onWorkDone, this);
+    }
+    frameStart = frameEnd = head;
+    frameBytes = 0;
+    frameSplit = false;
+}
+
+void UniformRing::onWorkDone(WGPUQueueWorkDoneStatus status, void* userdata) {
+    // Work-done callbacks fire in submission order, so the oldest frame is done.
+    // The region is reclaimed even on error; the device is unusable by then anyway.
+    auto* ring = static_cast<UniformRing*>(userdata);
+    if (!ring->inFlight.empty()) {
+        ring->usedBytes -= ring->inFlight.front();
+        ring->inFlight.pop_front();
+    }
+    (void)status;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include <webgpu/webgpu_cpp.h>
+
+// One persistent uniform buffer used as a ring of per-frame regions.
+// Draws suballocate 256-byte aligned blocks and bind them with a dynamic
+// offset, the whole frame is uploaded right before submission (with one
+// WriteBuffer, or two when it wraps around the end), and a frame's region is
+// reclaimed once its work is done.
+class UniformRing {
+public:
+    static constexpr uint32_t kAlignment = 256;
+    static constexpr uint32_t kInvalidOffset = 0xFFFFFFFFu;
+
+    struct Allocation {
+        uint32_t offset = kInvalidOffset;
+        void* data = nullptr;
+    };
+
+    void init(const wgpu::Device& device, uint64_t capacity);
+
+    // Reserve an aligned block for this frame; data is null when the ring is full.
+    Allocation allocate(uint32_t size);
+
+    template <typename T>
+    uint32_t push(const T& value) {
+        Allocation alloc = allocate(sizeof(T));
+        if (alloc.data) {
+            *static_cast<T*>(alloc.data) = value;
+        }
+        return alloc.offset;
+    }
+
+    // Upload everything allocated this frame. Call right before queue.Submit.
+    void flush(const wgpu::Queue& queue);
+
+    // Mark the frame as submitted; its region is freed when the GPU is done.
+    void submitted(const wgpu::Queue& queue);
+
+    const wgpu::Buffer& buffer() const { return ringBuffer; }
+    uint64_t capacity() const { return ringCapacity; }
+    uint64_t used() const { return usedBytes; }
+
+private:
+    static void onWorkDone(WGPUQueueWorkDoneStatus status, void* userdata);
+
+    wgpu::Buffer ringBuffer;
+    std::vector<uint8_t> staging; // CPU mirror, indexed by buffer offset
+    uint64_t ringCapacity = 0;
+    uint64_t head = 0;
+    uint64_t usedBytes = 0;
+
+    // Current frame: the contiguous range to upload and the bytes it consumed
+    uint64_t frameStart = 0;
+    uint64_t frameEnd = 0;
+    uint64_t frameBytes = 0;
+    // Its blocks before the end of the buffer, when it wrapped mid-frame
+    bool frameSplit = false;
+    uint64_t splitStart = 0;
+    uint64_t splitEnd = 0;
+
+    std::deque<uint64_t> inFlight; // bytes held by each submitted frame, oldest first
+};
@@ -0,0 +1,265 @@
+#include "VideoRecorder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+#ifdef __wasm_simd128__
+#include <wasm_simd128.h>
+#endif
+
+#include "Parallel.h"
+
+namespace {
+
+// Integer BT.709 limited-range coefficients, scaled by 256
+inline uint8_t lumaOf(const uint8_t* p) {
+    return uint8_t(((47 * p[0] + 157 * p[1] + 16 * p[2] + 128) >> 8) + 16);
+}
+
+// From the sums of four pixels, hence the extra factor of 4 in the shift
+inline uint8_t chromaU(int r, int g, int b) {
+    return uint8_t(std::clamp(((-26 * r - 86 * g + 112 * b + 512) >> 10) + 128, 0, 255));
+}
+
+inline uint8_t chromaV(int r, int g, int b) {
+    return uint8_t(std::clamp(((112 * r - 102 * g - 10 * b + 512) >> 10) + 128, 0, 255));
+}
+
+#ifdef __wasm_simd128__
+inline v128_t channel(v128_t pixels, int shift) {
+    return wasm_v128_and(wasm_u32x4_shr(pixels, shift), wasm_i32x4_splat(0xff));
+}
+
+inline v128_t lumaOf(v128_t pixels) {
+    v128_t y = wasm_i32x4_add(wasm_i32x4_mul(channel(pixels, 0), wasm_i32x4_splat(47)),
+                              wasm_i32x4_mul(channel(pixels, 8), wasm_i32x4_splat(157)));
+    y = wasm_i32x4_add(y, wasm_i32x4_add(wasm_i32x4_mul(channel(pixels, 16), wasm_i32x4_splat(16)), wasm_i32x4_splat(128)));
+    return wasm_i32x4_add(wasm_i32x4_shr(y, 8), wasm_i32x4_splat(16));
+}
+
+// Eight luma values from two vectors of four pixels
+inline void storeLuma(uint8_t* out, v128_t first, v128_t second) {
+    v128_t words = wasm_u16x8_narrow_i32x4(lumaOf(first), lumaOf(second));
+    wasm_v128_store64_lane(out, wasm_u8x16_narrow_i16x8(words, words), 0);
+}
+#endif
+
+// One output row pair: luma for both rows and chroma for the blocks they
+// share; `bottom` equals `top` on the last row of an odd height
+void convertRowPair(const uint8_t* top, const uint8_t* bottom, uint32_t width, uint8_t* yTop, uint8_t* yBottom,
+                    uint8_t* u, uint8_t* v) {
+    uint32_t x = 0;
+#ifdef __wasm_simd128__
+    for (; x + 8 <= width; x += 8) {
+        v128_t t0 = wasm_v128_load(top + x * 4);
+        v128_t t1 = wasm_v128_load(top + x * 4 + 16);
+        v128_t b0 = wasm_v128_load(bottom + x * 4);
+        v128_t b1 = wasm_v128_load(bottom + x * 4 + 16);
+        storeLuma(yTop + x, t0, t1);
+        if (yBottom) {
+            storeLuma(yBottom + x, b0, b1);
+        }
+
+        // Four 2x2 blocks: even and odd pixels of both rows
+        v128_t te = wasm_i32x4_shuffle(t0, t1, 0, 2, 4, 6);
+        v128_t to = wasm_i32x4_shuffle(t0, t1, 1, 3, 5, 7);
+        v128_t be = wasm_i32x4_shuffle(b0, b1, 0, 2, 4, 6);
+        v128_t bo = wasm_i32x4_shuffle(b0, b1, 1, 3, 5, 7);
+        v128_t sums[3];
+        for (int c = 0; c < 3; ++c) {
+            sums[c] = wasm_i32x4_add(wasm_i32x4_add(channel(te, c * 8), channel(to, c * 8)),
+                                     wasm_i32x4_add(channel(be, c * 8), channel(bo, c * 8)));
+        }
+        v128_t cu = wasm_i32x4_mul(sums[0], wasm_i32x4_splat(-26));
+        cu = wasm_i32x4_add(cu, wasm_i32x4_mul(sums[1], wasm_i32x4_splat(-86)));
+        cu = wasm_i32x4_add(cu, wasm_i32x4_mul(sums[2], wasm_i32x4_splat(112)));
+        cu = wasm_i32x4_add(wasm_i32x4_shr(wasm_i32x4_add(cu, wasm_i32x4_splat(512)), 10), wasm_i32x4_splat(128));
+        v128_t cv = wasm_i32x4_mul(sums[0], wasm_i32x4_splat(112));
+        cv = wasm_i32x4_add(cv, wasm_i32x4_mul(sums[1], wasm_i32x4_splat(-102)));
+        cv = wasm_i32x4_add(cv, wasm_i32x4_mul(sums[2], wasm_i32x4_splat(-10)));
+        cv = wasm_i32x4_add(wasm_i32x4_shr(wasm_i32x4_add(cv, wasm_i32x4_splat(512)), 10), wasm_i32x4_splat(128));
+
+        v128_t words = wasm_u16x8_narrow_i32x4(cu, cv);
+        v128_t bytes = wasm_u8x16_narrow_i16x8(words, words);
+        wasm_v128_store32_lane(u + x / 2, bytes, 0);
+        wasm_v128_store32_lane(v + x / 2, bytes, 1);
+    }
+#endif
+
+    for (uint32_t i = x; i < width; ++i) {
+        yTop[i] = lumaOf(top + i * 4);
+        if (yBottom) {
+            yBottom[i] = lumaOf(bottom + i * 4);
+        }
+    }
+    for (uint32_t cx = x / 2; cx < (width + 1) / 2; ++cx) {
+        uint32_t x0 = cx * 2;
+        uint32_t x1 = std::min(x0 + 1, width - 1);
+        const uint8_t* p[4] = { top + x0 * 4, top + x1 * 4, bottom + x0 * 4, bottom + x1 * 4 };
+        int r = p[0][0] + p[1][0] + p[2][0] + p[3][0];
+        int g = p[0][1] + p[1][1] + p[2][1] + p[3][1];
+        int b = p[0][2] + p[1][2] + p[2][2] + p[3][2];
+        u[cx] = chromaU(r, g, b);
+        v[cx] = chromaV(r, g, b);
+    }
+}
+
+} // namespace
+
+void rgbaToYuv420(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* y, uint8_t* u, uint8_t* v) {
+    size_t pairs = (height + 1) / 2;
+    size_t chromaWidth = (width + 1) / 2;
+    size_t minPairs = std::max<size_t>(1, 32768 / std::max(width, 1u));
+    parallelFor(pairs, minPairs, [&](size_t, size_t begin, size_t end) {
+        for (size_t pair = begin; pair < end; ++pair) {
+            size_t row = pair * 2;
+            bool hasBottom = row + 1 < height;
+            const uint8_t* top = rgba + row * width * 4;
+            convertRowPair(top, hasBottom ? top + size_t(width) * 4 : top, width, y + row * width,
+                           hasBottom ? y + (row + 1) * width : nullptr, u + pair * chromaWidth, v + pair * chromaWidth);
+        }
+    });
+}
+
+VideoRecorder::~VideoRecorder() {
+    stop();
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
+
+bool VideoRecorder::start(const char* path, Container container, uint32_t width, uint32_t height, double frameRate,
+                          size_t maxQueued) {
+    if (writing.load()) {
+        std::cerr << "Video recorder: previous recording is still being written." << std::endl;
+        return false;
+    }
+    if (writer.joinable()) {
+        writer.join(); // already finished, returns at once
+    }
+
+    video = std::fopen(path, "wb");
+    timestamps = std::fopen((std::string(path) + ".timestamps").c_str(), "w");
+    if (!video || !timestamps) {
+        std::cerr << "Video recorder: cannot open " << path << std::endl;
+        if (video) {
+            std::fclose(video);
+        }
+        if (timestamps) {
+            std::fclose(timestamps);
+        }
+        video = timestamps = nullptr;
+        return false;
+    }
+    // Large blocks keep the number of (possibly proxied) writes low
+    videoBuffer.resize(8 << 20);
+    std::setvbuf(video, videoBuffer.data(), _IOFBF, videoBuffer.size());
+
+    format = container;
+    frameWidth = width;
+    frameHeight = height;
+
+    // Frame rate as a fraction with millihertz precision
+    uint32_t rateNumerator = static_cast<uint32_t>(std::lround(frameRate * 1000.0));
+    if (container == Container::Y4m) {
+        std::fprintf(video, "YUV4MPEG2 W%u H%u F%u:1000 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n", width, height,
+                     rateNumerator);
+    }
+    std::fprintf(timestamps, "# %ux%u I420 BT.709 limited, nominal %.3f Hz; frameIndex vsyncTimeMs\n", width, height,
+                 frameRate);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        counters = {};
+        maxQueue = std::max<size_t>(maxQueued, 1);
+        accepting = true;
+        stopping = false;
+    }
+    writing = true;
+    writer = std::thread(&VideoRecorder::run, this);
+    return true;
+}
+
+void VideoRecorder::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        accepting = false;
+        stopping = true;
+    }
+    wake.notify_one();
+}
+
+void VideoRecorder::addFrame(const FrameCapture::Frame& frame) {
+    size_t lumaSize = size_t(frameWidth) * frameHeight;
+    size_t chromaSize = size_t((frameWidth + 1) / 2) * ((frameHeight + 1) / 2);
+
+    Buffer buffer;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!accepting) {
+            return;
+        }
+        // A resized canvas cannot go into the same stream
+        if (frame.width != frameWidth || frame.height != frameHeight || queued.size() >= maxQueue) {
+            counters.dropped++;
+            return;
+        }
+        if (!spare.empty()) {
+            buffer = std::move(spare.back());
+            spare.pop_back();
+        }
+    }
+
+    buffer.frameIndex = frame.frameIndex;
+    buffer.vsyncTime = frame.vsyncTime;
+    buffer.planes.resize(lumaSize + 2 * chromaSize);
+    uint8_t* y = buffer.planes.data();
+    rgbaToYuv420(frame.rgba.data(), frameWidth, frameHeight, y, y + lumaSize, y + lumaSize + chromaSize);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!accepting) {
+            return;
+        }
+        queued.push_back(std::move(buffer));
+    }
+    wake.notify_one();
+}
+
+void VideoRecorder::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !queued.empty(); });
+        if (queued.empty()) {
+            break; // stopping and drained
+        }
+        Buffer buffer = std::move(queued.front());
+        queued.pop_front();
+        lock.unlock();
+
+        size_t written = 0;
+        if (format == Container::Y4m) {
+            written += std::fwrite("FRAME\n", 1, 6, video);
+        }
+        written += std::fwrite(buffer.planes.data(), 1, buffer.planes.size(), video);
+        std::fprintf(timestamps, "%llu %.3f\n", static_cast<unsigned long long>(buffer.frameIndex), buffer.vsyncTime);
+
+        lock.lock();
+        counters.recorded++;
+        counters.bytesWritten += written;
+        spare.push_back(std::move(buffer));
+    }
+    lock.unlock();
+
+    std::fclose(video);
+    std::fclose(timestamps);
+    video = timestamps = nullptr;
+    writing = false;
+}
+
+VideoRecorder::Stats VideoRecorder::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "FrameCapture.h"
+
+// BT.709 limited-range 4:2:0 conversion of tightly packed RGBA8 rows; chroma
+// is the average of each 2x2 block, edge pixels repeat for odd sizes.
+// Vectorized where wasm SIMD is enabled, split over row pairs across threads.
+void rgbaToYuv420(const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* y, uint8_t* u, uint8_t* v);
+
+// Records captured frames as a Y4M or raw planar YUV stream, with a text
+// sidecar of "frameIndex vsyncTime" lines giving each frame's exact
+// presentation timestamp in ms. Frames are converted on the capture worker
+// and queued; a writer thread owns the files, so neither the render loop
+// nor the capture worker waits on the disk. When the writer falls behind
+// by more than the queue, frames are dropped and counted.
+//
+// Files go through the Emscripten file system: with the default JS file
+// system the writes are proxied to the main thread, in large buffered
+// blocks; a WASMFS build keeps them entirely off the main thread.
+class VideoRecorder {
+public:
+    enum class Container : uint32_t {
+        Y4m = 0,
+        RawYuv = 1, // bare I420 planes, geometry only in the sidecar header
+    };
+
+    struct Stats {
+        uint64_t recorded = 0;
+        uint64_t dropped = 0;
+        uint64_t bytesWritten = 0;
+    };
+
+    ~VideoRecorder();
+
+    // Open `path` and `path`.timestamps for frames of the given size. Returns
+    // false if a recording is still being flushed or a file cannot be opened.
+    bool start(const char* path, Container container, uint32_t width, uint32_t height, double frameRate,
+               size_t maxQueued = 16);
+    // Stop taking frames; the writer finishes the queue and closes the
+    // files in the background, and active() turns false once it is done
+    void stop();
+    bool active() const { return writing.load(); }
+
+    // From the capture worker
+    void addFrame(const FrameCapture::Frame& frame);
+
+    Stats stats() const;
+
+private:
+    struct Buffer {
+        uint64_t frameIndex = 0;
+        double vsyncTime = 0.0;
+        std::vector<uint8_t> planes; // Y, U, V
+    };
+
+    void run();
+
+    FILE* video = nullptr;
+    FILE* timestamps = nullptr;
+    std::vector<char> videoBuffer;
+    Container format = Container::Y4m;
+    uint32_t frameWidth = 0;
+    uint32_t frameHeight = 0;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Buffer> queued;
+    std::vector<Buffer> spare;
+    size_t maxQueue = 16;
+    bool accepting = false; // addFrame may queue
+    bool stopping = false;  // writer exits once the queue is empty
+    std::atomic<bool> writing{ false };
+    std::thread writer;
+    Stats counters;
+};
@@ -1,16 +1,69 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <deque>
 #include <iostream>
+#include <mutex>
+#include <type_traits>
 #include <vector>
 
 #include <emscripten.h>
 #include <emscripten/html5.h> // For emscripten_request_animation_frame_loop
 #include <emscripten/html5_webgpu.h>
+#include <emscripten/websocket.h>
+#ifdef RENDER_ON_WORKER
+#include <emscripten/proxying.h>
+#include <emscripten/threading.h>
+#endif
 
 #include <webgpu/webgpu_cpp.h>
 
+#include "Calibration.h"
+#include "CommandQueue.h"
+#include "Commands.h"
+#include "ControlBlock.h"
+#include "ContentHash.h"
+#include "DamageTracker.h"
+#include "Dither.h"
+#include "Dots.h"
+#include "Flicker.h"
+#include "Filter.h"
+#include "FrameCapture.h"
+#include "FrameEncoder.h"
+#include "FrameTimeline.h"
+#include "Gaze.h"
+#include "GpuCache.h"
+#include "ImageDiff.h"
+#include "ImageStats.h"
+#include "Input.h"
+#include "LatestValue.h"
+#include "LuminanceMatch.h"
+#include "Noise.h"
+#include "Procedural.h"
+#include "RenderGraph.h"
+#include "Spectral.h"
+#include "TexturePool.h"
+#include "UniformRing.h"
+#include "VideoRecorder.h"
+
 // Shader code remains the same...
 const char* vertexShaderCode = R"(
+struct StimulusUniforms {
+    transform: mat4x4<f32>,
+    opacity: f32,
+    luminance: f32,
+    frameIndex: u32,
+};
+
+@group(1) @binding(0) var<uniform> stimulus: StimulusUniforms;
+
+struct VertexOut {
+    @builtin(position) position: vec4<f32>,
+    @location(0) uv: vec2<f32>,
+};
+
 @vertex
-fn main(@builtin(vertex_index) VertexIndex: u32) -> @builtin(position) vec4<f32> {
+fn main(@builtin(vertex_index) VertexIndex: u32) -> VertexOut {
     var pos = array<vec2<f32>, 6>(
         vec2<f32>(-0.5, -0.5),
         vec2<f32>(0.5, -0.5),
@@ -19,22 +72,314 @@ fn main(@builtin(vertex_index) VertexIndex: u32) -> @builtin(position) vec4<f32>
         vec2<f32>(0.5, 0.5),
         vec2<f32>(-0.5, 0.5)
     );
-    return vec4<f32>(pos[VertexIndex], 0.0, 1.0);
+    var out: VertexOut;
+    out.position = stimulus.transform * vec4<f32>(pos[VertexIndex], 0.0, 1.0);
+    out.uv = vec2<f32>(pos[VertexIndex].x + 0.5, 0.5 - pos[VertexIndex].y);
+    return out;
 }
 )";
 
 const char* fragmentShaderCode = R"(
+struct StimulusUniforms {
+    transform: mat4x4<f32>,
+    opacity: f32,
+    luminance: f32,
+    frameIndex: u32,
+};
+
+@group(0) @binding(0) var stimulusSampler: sampler;
+@group(0) @binding(1) var stimulusTexture: texture_2d<f32>;
+@group(1) @binding(0) var<uniform> stimulus: StimulusUniforms;
+
+@fragment
+fn main(@location(0) uv: vec2<f32>) -> @location(0) vec4<f32> {
+    let color = textureSample(stimulusTexture, stimulusSampler, uv);
+    return vec4<f32>(color.rgb * stimulus.luminance, color.a * stimulus.opacity);
+}
+)";
+
+// Fullscreen triangle shared by the background and present passes
+const char* fullscreenVertexShaderCode = R"(
+@vertex
+fn main(@builtin(vertex_index) VertexIndex: u32) -> @builtin(position) vec4<f32> {
+    var pos = array<vec2<f32>, 3>(
+        vec2<f32>(-1.0, -1.0),
+        vec2<f32>(3.0, -1.0),
+        vec2<f32>(-1.0, 3.0)
+    );
+    return vec4<f32>(pos[VertexIndex], 0.0, 1.0);
+}
+)";
+
+// Fills the scissored region with the background color during partial redraws
+const char* backgroundShaderCode = R"(
+override backgroundR: f32;
+override backgroundG: f32;
+override backgroundB: f32;
+
 @fragment
 fn main() -> @location(0) vec4<f32> {
-    return vec4<f32>(1.0, 0.5, 0.0, 1.0); // Orange color
+    return vec4<f32>(backgroundR, backgroundG, backgroundB, 1.0);
 }
 )";
 
+// Per-draw parameters, mirrors StimulusUniforms in the shaders
+struct StimulusUniforms {
+    float transform[16]; // column-major
+    float opacity;
+    float luminance;
+    uint32_t frameIndex;
+    uint32_t padding;
+};
+
+#ifdef RENDER_ON_WORKER
+// Transferred canvases are looked up by id
+const char* const canvasSelector = "#canvas";
+pthread_t renderThread;
+#else
+const char* const canvasSelector = "canvas";
+#endif
+
+// GPU objects belong to the thread that created them, so exports that touch
+// the renderer run `fn` on the render thread and wait for it there
+template <typename Fn>
+void onRenderThread(Fn&& fn) {
+#ifdef RENDER_ON_WORKER
+    if (!pthread_equal(pthread_self(), renderThread)) {
+        emscripten_proxy_sync(emscripten_proxy_get_system_queue(), renderThread,
+                              [](void* arg) { (*static_cast<std::remove_reference_t<Fn>*>(arg))(); }, &fn);
+        return;
+    }
+#endif
+    fn();
+}
+
 // Global variables for device and so on
 wgpu::Device device;
 wgpu::Queue queue;
 wgpu::SwapChain swapChain;
 wgpu::RenderPipeline pipeline;
+wgpu::RenderPipeline proceduralPipeline;
+wgpu::RenderPipeline noisePipeline;
+wgpu::RenderPipeline flickerPipeline;
+wgpu::RenderPipeline dotsPipeline;
+wgpu::ComputePipeline dotsComputePipeline;
+wgpu::ComputePipeline filterPipeline;
+wgpu::ComputePipeline hashPipeline;
+wgpu::RenderPipeline backgroundPipeline;
+wgpu::RenderPipeline presentPipeline;
+
+const wgpu::Color backgroundColor = { 0.3f, 0.3f, 0.3f, 1.0f }; // Gray background
+
+// The scene is drawn into a persistent target so unchanged pixels survive
+// between frames; only damaged regions are redrawn before presenting. It is
+// half float so the output pass can dither or bit-steal below one 8-bit code.
+const wgpu::TextureFormat sceneFormat = wgpu::TextureFormat::RGBA16Float;
+// Usage of every half-float transient in the frame graph. The graph only
+// aliases equal descriptors, so the filter intermediate (storage) and the
+// gaze target (render attachment) share one so they can share a texture.
+const wgpu::TextureUsage transientUsage =
+    wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::StorageBinding;
+wgpu::Texture sceneTexture;
+wgpu::TextureView sceneView;
+DamageTracker damageTracker;
+FrameTimeline frameTimeline;
+
+// Output stage from the scene target to the 8-bit swap chain
+constexpr uint32_t kBlueNoiseSize = 64;
+wgpu::Texture blueNoiseTexture;
+wgpu::TextureView blueNoiseView;
+OutputUniforms outputParams = {};
+bool temporalDither = false;
+bool outputChanged = true; // re-run the output pass even if the scene is undamaged
+
+// Calibration LUTs; both stay bound and are replaced whole when a new
+// calibration is loaded, which only changes the output bind group
+wgpu::Texture lut1dTexture;
+wgpu::TextureView lut1dView;
+wgpu::Texture lut3dTexture;
+wgpu::TextureView lut3dView;
+
+// Cached samplers, layouts and bind groups, so repeated flashes reuse GPU objects
+GpuCache gpuCache;
+
+// Intermediate textures for offscreen passes, recycled across frames, and
+// the graph that schedules each frame's passes over them
+TexturePool texturePool;
+RenderGraph frameGraph;
+
+// Audit copies of presented frames, read back without stalling the loop,
+// and a content hash of every rendered frame logged with its timestamp
+FrameCapture frameCapture;
+FrameHasher frameHasher;
+bool frameHashing = false;
+
+// Captures encoded on the capture worker, waiting for JavaScript to take
+// them; the oldest is dropped when JavaScript falls behind
+struct EncodedFrame {
+    uint64_t frameIndex = 0;
+    double vsyncTime = 0.0;
+    std::vector<uint8_t> bytes;
+};
+constexpr size_t kMaxEncodedFrames = 8;
+constexpr uint32_t kNoEncoding = 0xFFFFFFFFu;
+std::atomic<uint32_t> captureEncoding{ kNoEncoding };
+std::mutex encodedMutex;
+std::deque<EncodedFrame> encodedFrames;
+
+// Session recording of every presented frame. While it takes frames, the
+// render loop does not skip unchanged ones, so the stream holds one frame
+// per vsync as its constant frame rate says.
+VideoRecorder videoRecorder;
+bool recordingFrames = false;
+
+// Runs on the capture worker for every captured frame
+void consumeCapture(const FrameCapture::Frame& frame) {
+    uint32_t format = captureEncoding.load();
+    if (format != kNoEncoding) {
+        EncodedFrame encoded;
+        encoded.frameIndex = frame.frameIndex;
+        encoded.vsyncTime = frame.vsyncTime;
+        encodeImage(frame.rgba.data(), frame.width, frame.height, static_cast<ImageFormat>(format), encoded.bytes);
+
+        std::lock_guard<std::mutex> lock(encodedMutex);
+        if (encodedFrames.size() >= kMaxEncodedFrames) {
+            encodedFrames.pop_front();
+        }
+        encodedFrames.push_back(std::move(encoded));
+    }
+    videoRecorder.addFrame(frame);
+}
+
+// Image currently shown by the quad
+wgpu::Texture stimulusTexture;
+wgpu::TextureView stimulusView;
+uint32_t stimulusGeneration = 0; // bumped whenever the image is replaced
+ImageStats stimulusStats = {};    // luminance statistics of that image, from load time
+
+// Optional filtering of the image, recomputed on the GPU whenever the
+// image or the filter changes and drawn in place of the original
+FilterType stimulusFilter = FilterType::None;
+float filterSigma = 0.0f;
+bool filterDirty = false;
+wgpu::Texture filteredTexture;
+wgpu::TextureView filteredView;
+
+// The quad shows either the image or a procedural pattern
+enum class StimulusSource : uint32_t {
+    Image,
+    Pattern,
+    Noise,
+    Flicker,
+    Dots,
+};
+StimulusSource stimulusSource = StimulusSource::Image;
+PatternUniforms patternParams = {
+    static_cast<uint32_t>(PatternType::Gabor),
+    4.0f,  // frequency
+    0.0f,  // orientation
+    0.0f,  // phase
+    1.0f,  // contrast
+    0.5f,  // mean luminance
+    0.15f, // sigma
+    0.0f,
+    0.0f,
+    0.0f,
+    { 0, 0 }
+};
+NoiseUniforms noiseParams = {
+    static_cast<uint32_t>(NoiseType::White),
+    1,   // seed
+    0,   // frame
+    256, // width
+    256, // height
+    0,   // low
+    255, // high
+    6,   // octaves
+    32,  // rectangles
+    { 0, 0, 0 }
+};
+bool noiseAnimated = false;
+
+// Frequency-tagging targets, uploaded once into a storage buffer
+std::vector<FlickerTarget> flickerTargets;
+wgpu::Buffer flickerBuffer;
+uint64_t flickerBufferCapacity = 0;
+uint32_t flickerStartFrame = 0;
+uint32_t flickerGeneration = 0;
+
+// Random-dot kinematogram; dot state stays on the GPU
+DotUniforms dotParams = {};
+wgpu::Buffer dotBuffer;
+uint64_t dotBufferCapacity = 0;
+uint32_t dotStartFrame = 0;
+uint32_t dotGeneration = 0;
+
+// Per-frame parameters live in one ring-allocated uniform buffer
+UniformRing uniformRing;
+StimulusUniforms stimulusParams = {
+    { 1.0f, 0.0f, 0.0f, 0.0f,
+      0.0f, 1.0f, 0.0f, 0.0f,
+      0.0f, 0.0f, 1.0f, 0.0f,
+      0.0f, 0.0f, 0.0f, 1.0f },
+    1.0f,
+    1.0f,
+    0,
+    0
+};
+uint32_t frameIndex = 0;
+
+// Late latching: placement published from input handlers replaces the
+// stimulus transform, opacity and luminance right before the frame is
+// submitted rather than when it is built
+struct LatchedStimulus {
+    StimulusCommand stimulus;
+    double inputTime; // emscripten_get_now() when the input was sampled, ms
+};
+LatestValue<LatchedStimulus> stimulusLatch;
+bool lateLatching = false;
+StimulusUniforms* latchSlot = nullptr; // this frame's stimulus block in the uniform ring
+// A placement latched at submission that landed outside the damage already
+// encoded; the next frame draws it
+LatchedStimulus deferredLatch;
+bool latchDeferred = false;
+// How far the stimulus may move between building and submitting a frame
+// and still take the newer placement, in pixels the damage is padded by
+const float kLatchMarginPixels = 32.0f;
+
+// Gaze-contingent mode: samples from the eye tracker socket or the
+// synthetic generator land in gazeLatest, which is latched every frame
+GazeMode gazeMode = GazeMode::Off;
+GazeUniforms gazeParams = {};
+GazeUniforms* gazeSlot = nullptr; // this frame's gaze block in the uniform ring
+GazeUniforms latchedGaze = {};     // what the last latch wrote there
+LatestValue<GazeSample> gazeLatest;      // loaded by the render thread only
+std::atomic<double> latestGazeTime{ 0.0 }; // for gazeStats() on other threads
+GazeDecoder socketGazeDecoder;
+GazeDecoder syntheticGazeDecoder;
+SyntheticGaze syntheticGaze;
+EMSCRIPTEN_WEBSOCKET_T gazeSocket = 0;
+wgpu::RenderPipeline gazePipeline;
+
+// Responses go from the input callbacks through a lock-free queue to the
+// render loop, which measures them against the presented onsets
+MpscQueue<InputEvent, 1024> inputQueue;
+std::atomic<uint64_t> droppedInputs{ 0 };
+ResponseLog responseLog;
+MockResponder mockResponder;
+
+// What the scene target currently shows, compared against each frame's state
+struct DrawnState {
+    StimulusSource source;
+    uint32_t generation;
+    uint32_t flickerFrame;
+    PatternUniforms pattern;
+    NoiseUniforms noise;
+    StimulusUniforms params; // frameIndex zeroed, it does not change the picture
+    float bounds[4];         // NDC footprint: minX, minY, maxX, maxY
+};
+DrawnState lastDrawn = {};
+bool sceneValid = false;
 
 // Forward declaration
 EM_BOOL frame(double time, void* userData);
@@ -50,15 +395,421 @@ wgpu::ShaderModule createShaderModule(const char* code) {
     return device.CreateShaderModule(&shaderDesc);
 }
 
-// Function to create the render pipeline
-void createRenderPipeline() {
-    wgpu::ShaderModule vsModule = createShaderModule(vertexShaderCode);
-    wgpu::ShaderModule fsModule = createShaderModule(fragmentShaderCode);
+// Layout of group 0: stimulus sampler + stimulus texture
+wgpu::BindGroupLayout stimulusBindGroupLayout() {
+    wgpu::BindGroupLayoutEntry entries[2] = {};
+    entries[0].binding = 0;
+    entries[0].visibility = wgpu::ShaderStage::Fragment;
+    entries[0].sampler.type = wgpu::SamplerBindingType::Filtering;
+
+    entries[1].binding = 1;
+    entries[1].visibility = wgpu::ShaderStage::Fragment;
+    entries[1].texture.sampleType = wgpu::TextureSampleType::Float;
+    entries[1].texture.viewDimension = wgpu::TextureViewDimension::e2D;
+
+    return gpuCache.bindGroupLayout(entries, 2);
+}
+
+wgpu::Sampler stimulusSampler() {
+    wgpu::SamplerDescriptor samplerDesc = {};
+    samplerDesc.addressModeU = wgpu::AddressMode::ClampToEdge;
+    samplerDesc.addressModeV = wgpu::AddressMode::ClampToEdge;
+    samplerDesc.magFilter = wgpu::FilterMode::Linear;
+    samplerDesc.minFilter = wgpu::FilterMode::Linear;
+
+    return gpuCache.sampler(samplerDesc);
+}
+
+// Bind group for the current stimulus; a cache hit unless the image changed
+wgpu::BindGroup stimulusBindGroup() {
+    wgpu::BindGroupEntry entries[2] = {};
+    entries[0].binding = 0;
+    entries[0].sampler = stimulusSampler();
+
+    entries[1].binding = 1;
+    entries[1].textureView = stimulusFilter != FilterType::None && filteredView ? filteredView : stimulusView;
+
+    return gpuCache.bindGroup(stimulusBindGroupLayout(), entries, 2);
+}
+
+// Single-binding layout for a block of the uniform ring bound with a dynamic offset
+wgpu::BindGroupLayout ringBindGroupLayout(uint64_t bindingSize, wgpu::ShaderStage visibility) {
+    wgpu::BindGroupLayoutEntry entry = {};
+    entry.binding = 0;
+    entry.visibility = visibility;
+    entry.buffer.type = wgpu::BufferBindingType::Uniform;
+    entry.buffer.hasDynamicOffset = true;
+    entry.buffer.minBindingSize = bindingSize;
+
+    return gpuCache.bindGroupLayout(&entry, 1);
+}
+
+// One bind group for the whole ring; draws differ only by dynamic offset
+wgpu::BindGroup ringBindGroup(uint64_t bindingSize, wgpu::ShaderStage visibility) {
+    wgpu::BindGroupEntry entry = {};
+    entry.binding = 0;
+    entry.buffer = uniformRing.buffer();
+    entry.size = bindingSize;
+
+    return gpuCache.bindGroup(ringBindGroupLayout(bindingSize, visibility), &entry, 1);
+}
+
+// Layout of group 1: per-draw stimulus uniforms
+wgpu::BindGroupLayout uniformBindGroupLayout() {
+    return ringBindGroupLayout(sizeof(StimulusUniforms), wgpu::ShaderStage::Vertex | wgpu::ShaderStage::Fragment);
+}
+
+wgpu::BindGroup uniformBindGroup() {
+    return ringBindGroup(sizeof(StimulusUniforms), wgpu::ShaderStage::Vertex | wgpu::ShaderStage::Fragment);
+}
+
+// Replace the displayed image with tightly packed RGBA8 pixels and their
+// statistics, computed by the caller so the render thread does not wait on them
+void setStimulusImage(const uint8_t* rgba, uint32_t width, uint32_t height, const ImageStats& stats) {
+    if (stimulusTexture) {
+        gpuCache.invalidate(stimulusView.Get());
+        stimulusTexture.Destroy();
+    }
+
+    wgpu::TextureDescriptor texDesc = {};
+    texDesc.size = { width, height, 1 };
+    texDesc.format = wgpu::TextureFormat::RGBA8Unorm;
+    texDesc.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst;
+
+    stimulusTexture = device.CreateTexture(&texDesc);
+    stimulusView = stimulusTexture.CreateView();
+    stimulusGeneration++;
+    stimulusSource = StimulusSource::Image;
+
+    wgpu::ImageCopyTexture destination = {};
+    destination.texture = stimulusTexture;
+
+    wgpu::TextureDataLayout dataLayout = {};
+    dataLayout.bytesPerRow = width * 4;
+    dataLayout.rowsPerImage = height;
+
+    queue.WriteTexture(&destination, rgba, size_t(width) * height * 4, &dataLayout, &texDesc.size);
+
+    stimulusStats = stats;
+    filterDirty = stimulusFilter != FilterType::None;
+}
+
+// Blur (low-pass) or sharpen (high-pass) the image with a Gaussian of
+// `sigma` texels; FilterType::None shows the original again
+void setStimulusFilter(FilterType type, float sigma) {
+    stimulusFilter = type;
+    filterSigma = sigma;
+    filterDirty = type != FilterType::None;
+    stimulusGeneration++;
+}
+
+wgpu::BindGroupLayout filterBindGroupLayout() {
+    wgpu::BindGroupLayoutEntry entries[4] = {};
+    entries[0].binding = 0;
+    entries[0].visibility = wgpu::ShaderStage::Compute;
+    entries[0].texture.sampleType = wgpu::TextureSampleType::Float;
+    entries[0].texture.viewDimension = wgpu::TextureViewDimension::e2D;
+
+    entries[1].binding = 1;
+    entries[1].visibility = wgpu::ShaderStage::Compute;
+    entries[1].storageTexture.access = wgpu::StorageTextureAccess::WriteOnly;
+    entries[1].storageTexture.format = wgpu::TextureFormat::RGBA16Float;
+    entries[1].storageTexture.viewDimension = wgpu::TextureViewDimension::e2D;
+
+    entries[2].binding = 2;
+    entries[2].visibility = wgpu::ShaderStage::Compute;
+    entries[2].buffer.type = wgpu::BufferBindingType::Uniform;
+    entries[2].buffer.hasDynamicOffset = true;
+    entries[2].buffer.minBindingSize = sizeof(FilterUniforms);
+
+    entries[3].binding = 3;
+    entries[3].visibility = wgpu::ShaderStage::Compute;
+    entries[3].texture.sampleType = wgpu::TextureSampleType::Float;
+    entries[3].texture.viewDimension = wgpu::TextureViewDimension::e2D;
+
+    return gpuCache.bindGroupLayout(entries, 4);
+}
+
+wgpu::BindGroup filterBindGroup(const wgpu::TextureView& source, const wgpu::TextureView& destination) {
+    wgpu::BindGroupEntry entries[4] = {};
+    entries[0].binding = 0;
+    entries[0].textureView = source;
+    entries[1].binding = 1;
+    entries[1].textureView = destination;
+    entries[2].binding = 2;
+    entries[2].buffer = uniformRing.buffer();
+    entries[2].size = sizeof(FilterUniforms);
+    entries[3].binding = 3;
+    entries[3].textureView = stimulusView;
+
+    return gpuCache.bindGroup(filterBindGroupLayout(), entries, 4);
+}
+
+// Layout for the content hash: the 8-bit frame and the atomic sums
+wgpu::BindGroupLayout hashBindGroupLayout() {
+    wgpu::BindGroupLayoutEntry entries[2] = {};
+    entries[0].binding = 0;
+    entries[0].visibility = wgpu::ShaderStage::Compute;
+    entries[0].texture.sampleType = wgpu::TextureSampleType::Float;
+    entries[0].texture.viewDimension = wgpu::TextureViewDimension::e2D;
+
+    entries[1].binding = 1;
+    entries[1].visibility = wgpu::ShaderStage::Compute;
+    entries[1].buffer.type = wgpu::BufferBindingType::Storage;
+    entries[1].buffer.minBindingSize = 2 * sizeof(uint32_t);
+
+    return gpuCache.bindGroupLayout(entries, 2);
+}
+
+wgpu::BindGroup hashBindGroup(const wgpu::TextureView& image) {
+    wgpu::BindGroupEntry entries[2] = {};
+    entries[0].binding = 0;
+    entries[0].textureView = image;
+    entries[1].binding = 1;
+    entries[1].buffer = frameHasher.sums();
+    entries[1].size = 2 * sizeof(uint32_t);
+
+    return gpuCache.bindGroup(hashBindGroupLayout(), entries, 2);
+}
+
+// Rows into a transient texture, then columns into the filtered texture.
+// Returns the filtered texture; the passes only run if something reads it.
+RenderGraph::Resource addStimulusFilterPasses(RenderGraph& graph) {
+    uint32_t width = stimulusStats.width;
+    uint32_t height = stimulusStats.height;
+
+    if (!filteredTexture || filteredTexture.GetWidth() != width || filteredTexture.GetHeight() != height) {
+        if (filteredTexture) {
+            gpuCache.invalidate(filteredView.Get());
+            filteredTexture.Destroy();
+        }
+        wgpu::TextureDescriptor texDesc = {};
+        texDesc.label = "Filtered stimulus";
+        texDesc.size = { width, height, 1 };
+        texDesc.format = wgpu::TextureFormat::RGBA16Float;
+        texDesc.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::StorageBinding;
+        filteredTexture = device.CreateTexture(&texDesc);
+        filteredView = filteredTexture.CreateView();
+    }
+    RenderGraph::Resource filtered = graph.importTexture("filtered stimulus", filteredView);
+    if (!filterDirty) {
+        return filtered;
+    }
+
+    FilterUniforms params = {};
+    setGaussianKernel(params, filterSigma);
+    params.direction = 0;
+    uint32_t rowOffset = uniformRing.push(params);
+    params.direction = 1;
+    params.highPass = stimulusFilter == FilterType::HighPass ? 1 : 0;
+    params.offset = static_cast<float>(stimulusStats.meanLuminance);
+    uint32_t columnOffset = uniformRing.push(params);
+    if (rowOffset == UniformRing::kInvalidOffset || columnOffset == UniformRing::kInvalidOffset) {
+        return filtered;
+    }
+
+    TexturePool::Desc desc;
+    desc.width = width;
+    desc.height = height;
+    desc.format = sceneFormat;
+    desc.usage = transientUsage;
+    RenderGraph::Resource image = graph.importTexture("stimulus", stimulusView);
+    RenderGraph::Resource rows = graph.createTexture("filter rows", desc);
+
+    graph.addPass("filter rows", { image }, { rows }, [&graph, rows, rowOffset, width, height](wgpu::CommandEncoder& encoder) {
+        uint32_t groupsX, groupsY;
+        filterDispatchSize(0, width, height, groupsX, groupsY);
+        wgpu::ComputePassEncoder pass = encoder.BeginComputePass();
+        pass.SetPipeline(filterPipeline);
+        pass.SetBindGroup(0, filterBindGroup(stimulusView, graph.view(rows)), 1, &rowOffset);
+        pass.DispatchWorkgroups(groupsX, groupsY);
+        pass.End();
+    });
+    graph.addPass("filter columns", { rows, image }, { filtered }, [&graph, rows, columnOffset, width, height](wgpu::CommandEncoder& encoder) {
+        uint32_t groupsX, groupsY;
+        filterDispatchSize(1, width, height, groupsX, groupsY);
+        wgpu::ComputePassEncoder pass = encoder.BeginComputePass();
+        pass.SetPipeline(filterPipeline);
+        pass.SetBindGroup(0, filterBindGroup(graph.view(rows), filteredView), 1, &columnOffset);
+        pass.DispatchWorkgroups(groupsX, groupsY);
+        pass.End();
+        filterDirty = false;
+    });
+    return filtered;
+}
+
+// Layout of group 0 for procedural stimuli: pattern parameters from the ring
+wgpu::BindGroupLayout patternBindGroupLayout() {
+    return ringBindGroupLayout(sizeof(PatternUniforms), wgpu::ShaderStage::Fragment);
+}
+
+wgpu::BindGroup patternBindGroup() {
+    return ringBindGroup(sizeof(PatternUniforms), wgpu::ShaderStage::Fragment);
+}
+
+// Layout of group 0 for noise stimuli
+wgpu::BindGroupLayout noiseBindGroupLayout() {
+    return ringBindGroupLayout(sizeof(NoiseUniforms), wgpu::ShaderStage::Fragment);
+}
+
+wgpu::BindGroup noiseBindGroup() {
+    return ringBindGroup(sizeof(NoiseUniforms), wgpu::ShaderStage::Fragment);
+}
+
+// Layout of group 0 for flicker targets: the read-only target array
+wgpu::BindGroupLayout flickerBindGroupLayout() {
+    wgpu::BindGroupLayoutEntry entry = {};
+    entry.binding = 0;
+    entry.visibility = wgpu::ShaderStage::Vertex;
+    entry.buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
+    entry.buffer.minBindingSize = sizeof(FlickerTarget);
+
+    return gpuCache.bindGroupLayout(&entry, 1);
+}
+
+wgpu::BindGroup flickerBindGroup() {
+    wgpu::BindGroupEntry entry = {};
+    entry.binding = 0;
+    entry.buffer = flickerBuffer;
+    entry.size = flickerTargets.size() * sizeof(FlickerTarget);
+
+    return gpuCache.bindGroup(flickerBindGroupLayout(), &entry, 1);
+}
+
+wgpu::BindGroupLayout flickerUniformBindGroupLayout() {
+    return ringBindGroupLayout(sizeof(FlickerUniforms), wgpu::ShaderStage::Vertex);
+}
+
+wgpu::BindGroup flickerUniformBindGroup() {
+    return ringBindGroup(sizeof(FlickerUniforms), wgpu::ShaderStage::Vertex);
+}
+
+// Start flickering a set of targets; phases count from the next rendered frame.
+// Pass refreshHz = 0 to use the refresh rate measured so far.
+void setFlickerTargets(const FlickerSpec* specs, size_t count, double refreshHz) {
+    if (count == 0) {
+        return;
+    }
+    if (refreshHz <= 0.0) {
+        refreshHz = frameTimeline.estimateRefreshHz(60.0);
+    }
+
+    flickerTargets.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        flickerTargets[i] = makeFlickerTarget(specs[i], refreshHz);
+    }
+
+    uint64_t size = count * sizeof(FlickerTarget);
+    if (size > flickerBufferCapacity) {
+        if (flickerBuffer) {
+            gpuCache.invalidate(flickerBuffer.Get());
+            flickerBuffer.Destroy();
+        }
+
+        wgpu::BufferDescriptor bufferDesc = {};
+        bufferDesc.label = "Flicker targets";
+        bufferDesc.size = size;
+        bufferDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst;
+        flickerBuffer = device.CreateBuffer(&bufferDesc);
+        flickerBufferCapacity = size;
+    }
+    queue.WriteBuffer(flickerBuffer, 0, flickerTargets.data(), size);
+
+    flickerStartFrame = frameIndex;
+    flickerGeneration++;
+    stimulusSource = StimulusSource::Flicker;
+}
+
+// Group 0 of the dot passes: the dot array plus the DotUniforms block from the ring
+wgpu::BindGroupLayout dotsBindGroupLayout(bool compute) {
+    wgpu::BindGroupLayoutEntry entries[2] = {};
+    entries[0].binding = 0;
+    entries[0].visibility = compute ? wgpu::ShaderStage::Compute : wgpu::ShaderStage::Vertex;
+    entries[0].buffer.type = compute ? wgpu::BufferBindingType::Storage : wgpu::BufferBindingType::ReadOnlyStorage;
+    entries[0].buffer.minBindingSize = sizeof(Dot);
+
+    entries[1].binding = 1;
+    entries[1].visibility = compute ? wgpu::ShaderStage::Compute : wgpu::ShaderStage::Vertex | wgpu::ShaderStage::Fragment;
+    entries[1].buffer.type = wgpu::BufferBindingType::Uniform;
+    entries[1].buffer.hasDynamicOffset = true;
+    entries[1].buffer.minBindingSize = sizeof(DotUniforms);
+
+    return gpuCache.bindGroupLayout(entries, 2);
+}
+
+wgpu::BindGroup dotsBindGroup(bool compute) {
+    wgpu::BindGroupEntry entries[2] = {};
+    entries[0].binding = 0;
+    entries[0].buffer = dotBuffer;
+    entries[0].size = uint64_t(dotParams.count) * sizeof(Dot);
+
+    entries[1].binding = 1;
+    entries[1].buffer = uniformRing.buffer();
+    entries[1].size = sizeof(DotUniforms);
+
+    return gpuCache.bindGroup(dotsBindGroupLayout(compute), entries, 2);
+}
+
+// Start a random-dot kinematogram. The dots are scattered on the GPU by the
+// first frame's compute pass; count, coherence etc. can be changed later by
+// calling this again.
+void setDotField(const DotUniforms& params) {
+    if (params.count == 0) {
+        return;
+    }
+
+    uint64_t size = uint64_t(params.count) * sizeof(Dot);
+    if (size > dotBufferCapacity) {
+        if (dotBuffer) {
+            gpuCache.invalidate(dotBuffer.Get());
+            dotBuffer.Destroy();
+        }
+
+        wgpu::BufferDescriptor bufferDesc = {};
+        bufferDesc.label = "Dots";
+        bufferDesc.size = size;
+        bufferDesc.usage = wgpu::BufferUsage::Storage;
+        dotBuffer = device.CreateBuffer(&bufferDesc);
+        dotBufferCapacity = size;
+    }
+
+    dotParams = params;
+    dotParams.reset = 1;
+    dotStartFrame = frameIndex;
+    dotGeneration++;
+    stimulusSource = StimulusSource::Dots;
+}
+
+// Show a noise field; an animated field is regenerated every frame with the
+// frame index as the PRNG counter
+void setStimulusNoise(const NoiseUniforms& params, bool animated) {
+    noiseParams = params;
+    noiseParams.width = std::max(noiseParams.width, 1u);
+    noiseParams.height = std::max(noiseParams.height, 1u);
+    noiseAnimated = animated;
+    stimulusSource = StimulusSource::Noise;
+}
+
+// Show a shader-generated pattern instead of the image
+void setStimulusPattern(const PatternUniforms& params) {
+    patternParams = params;
+    stimulusSource = StimulusSource::Pattern;
+}
+
+// Pipeline drawing into the scene target with alpha blending
+wgpu::RenderPipeline createScenePipeline(const char* vertexCode,
+                                         const char* vertexEntry,
+                                         const char* fragmentCode,
+                                         const char* fragmentEntry,
+                                         const wgpu::BindGroupLayout* bindGroupLayouts,
+                                         size_t bindGroupLayoutCount) {
+    wgpu::ShaderModule vsModule = createShaderModule(vertexCode);
+    wgpu::ShaderModule fsModule = vertexCode == fragmentCode ? vsModule : createShaderModule(fragmentCode);
 
     // Create pipeline layout
     wgpu::PipelineLayoutDescriptor layoutDesc = {};
-    layoutDesc.bindGroupLayoutCount = 0;
-    layoutDesc.bindGroupLayouts = nullptr;
+    layoutDesc.bindGroupLayoutCount = bindGroupLayoutCount;
+    layoutDesc.bindGroupLayouts = bindGroupLayouts;
 
     wgpu::PipelineLayout pipelineLayout = device.CreatePipelineLayout(&layoutDesc);
 
@@ -66,17 +817,27 @@ void createRenderPipeline() {
 
     // Vertex state
     desc.vertex.module = vsModule;
-    desc.vertex.entryPoint = "main";
+    desc.vertex.entryPoint = vertexEntry;
     desc.vertex.bufferCount = 0;
     desc.vertex.buffers = nullptr;
 
     // Fragment state
     wgpu::ColorTargetState colorTarget = {};
-    colorTarget.format = wgpu::TextureFormat::BGRA8Unorm; // Ensure this matches swap chain
+    colorTarget.format = sceneFormat;
+
+    // Straight alpha blending so opacity < 1 fades the stimulus into the background
+    wgpu::BlendState blend = {};
+    blend.color.srcFactor = wgpu::BlendFactor::SrcAlpha;
+    blend.color.dstFactor = wgpu::BlendFactor::OneMinusSrcAlpha;
+    blend.color.operation = wgpu::BlendOperation::Add;
+    blend.alpha.srcFactor = wgpu::BlendFactor::One;
+    blend.alpha.dstFactor = wgpu::BlendFactor::OneMinusSrcAlpha;
+    blend.alpha.operation = wgpu::BlendOperation::Add;
+    colorTarget.blend = &blend;
 
     wgpu::FragmentState fragmentState = {};
     fragmentState.module = fsModule;
-    fragmentState.entryPoint = "main";
+    fragmentState.entryPoint = fragmentEntry;
     fragmentState.targetCount = 1;
     fragmentState.targets = &colorTarget;
 
@@ -94,7 +855,370 @@ void createRenderPipeline() {
     desc.multisample.mask = ~0u;
     desc.multisample.alphaToCoverageEnabled = false;
 
-    pipeline = device.CreateRenderPipeline(&desc);
+    return device.CreateRenderPipeline(&desc);
+}
+
+// Quad pipeline shared by image and procedural stimuli; they differ in the
+// fragment shader and in what group 0 holds
+wgpu::RenderPipeline createStimulusPipeline(const char* fragmentCode, const wgpu::BindGroupLayout& group0Layout) {
+    wgpu::BindGroupLayout bindGroupLayouts[2] = { group0Layout, uniformBindGroupLayout() };
+    return createScenePipeline(vertexShaderCode, "main", fragmentCode, "main", bindGroupLayouts, 2);
+}
+
+wgpu::ComputePipeline createComputePipeline(const char* code,
+                                            const wgpu::BindGroupLayout* bindGroupLayouts,
+                                            size_t bindGroupLayoutCount) {
+    wgpu::PipelineLayoutDescriptor layoutDesc = {};
+    layoutDesc.bindGroupLayoutCount = bindGroupLayoutCount;
+    layoutDesc.bindGroupLayouts = bindGroupLayouts;
+
+    wgpu::ComputePipelineDescriptor desc = {};
+    desc.layout = device.CreatePipelineLayout(&layoutDesc);
+    desc.compute.module = createShaderModule(code);
+    desc.compute.entryPoint = "main";
+
+    return device.CreateComputePipeline(&desc);
+}
+
+// Function to create the render pipelines
+void createRenderPipeline() {
+    pipeline = createStimulusPipeline(fragmentShaderCode, stimulusBindGroupLayout());
+    proceduralPipeline = createStimulusPipeline(proceduralFragmentShaderCode, patternBindGroupLayout());
+    noisePipeline = createStimulusPipeline(noiseFragmentShaderCode.c_str(), noiseBindGroupLayout());
+
+    wgpu::BindGroupLayout flickerLayouts[2] = { flickerBindGroupLayout(), flickerUniformBindGroupLayout() };
+    flickerPipeline = createScenePipeline(flickerShaderCode, "vs_main", flickerShaderCode, "fs_main", flickerLayouts, 2);
+
+    wgpu::BindGroupLayout dotsRenderLayout = dotsBindGroupLayout(false);
+    dotsPipeline = createScenePipeline(dotsRenderShaderCode.c_str(), "vs_main", dotsRenderShaderCode.c_str(), "fs_main", &dotsRenderLayout, 1);
+    wgpu::BindGroupLayout dotsComputeLayout = dotsBindGroupLayout(true);
+    dotsComputePipeline = createComputePipeline(dotsComputeShaderCode.c_str(), &dotsComputeLayout, 1);
+    wgpu::BindGroupLayout filterLayout = filterBindGroupLayout();
+    filterPipeline = createComputePipeline(filterShaderCode, &filterLayout, 1);
+    wgpu::BindGroupLayout hashLayout = hashBindGroupLayout();
+    hashPipeline = createComputePipeline(contentHashShaderCode, &hashLayout, 1);
+}
+
+// Pipeline drawing a fullscreen triangle with the given fragment shader
+wgpu::RenderPipeline createFullscreenPipeline(const char* fragmentCode,
+                                              wgpu::TextureFormat format,
+                                              const wgpu::BindGroupLayout* bindGroupLayouts,
+                                              size_t bindGroupLayoutCount,
+                                              const wgpu::ConstantEntry* constants = nullptr,
+                                              size_t constantCount = 0) {
+    wgpu::PipelineLayoutDescriptor layoutDesc = {};
+    layoutDesc.bindGroupLayoutCount = bindGroupLayoutCount;
+    layoutDesc.bindGroupLayouts = bindGroupLayouts;
+
+    wgpu::ColorTargetState colorTarget = {};
+    colorTarget.format = format;
+
+    wgpu::FragmentState fragmentState = {};
+    fragmentState.module = createShaderModule(fragmentCode);
+    fragmentState.entryPoint = "main";
+    fragmentState.constantCount = constantCount;
+    fragmentState.constants = constants;
+    fragmentState.targetCount = 1;
+    fragmentState.targets = &colorTarget;
+
+    wgpu::RenderPipelineDescriptor desc = {};
+    desc.layout = device.CreatePipelineLayout(&layoutDesc);
+    desc.vertex.module = createShaderModule(fullscreenVertexShaderCode);
+    desc.vertex.entryPoint = "main";
+    desc.fragment = &fragmentState;
+    desc.primitive.topology = wgpu::PrimitiveTopology::TriangleList;
+    desc.multisample.count = 1;
+    desc.multisample.mask = ~0u;
+
+    return device.CreateRenderPipeline(&desc);
+}
+
+wgpu::BindGroupLayout presentBindGroupLayout() {
+    wgpu::BindGroupLayoutEntry entries[5] = {};
+    entries[0].binding = 0;
+    entries[0].visibility = wgpu::ShaderStage::Fragment;
+    entries[0].texture.sampleType = wgpu::TextureSampleType::Float;
+    entries[0].texture.viewDimension = wgpu::TextureViewDimension::e2D;
+
+    entries[1].binding = 1;
+    entries[1].visibility = wgpu::ShaderStage::Fragment;
+    entries[1].texture.sampleType = wgpu::TextureSampleType::UnfilterableFloat;
+    entries[1].texture.viewDimension = wgpu::TextureViewDimension::e2D;
+
+    entries[2].binding = 2;
+    entries[2].visibility = wgpu::ShaderStage::Fragment;
+    entries[2].buffer.type = wgpu::BufferBindingType::Uniform;
+    entries[2].buffer.hasDynamicOffset = true;
+    entries[2].buffer.minBindingSize = sizeof(OutputUniforms);
+
+    entries[3].binding = 3;
+    entries[3].visibility = wgpu::ShaderStage::Fragment;
+    entries[3].texture.sampleType = wgpu::TextureSampleType::UnfilterableFloat;
+    entries[3].texture.viewDimension = wgpu::TextureViewDimension::e2D;
+
+    entries[4].binding = 4;
+    entries[4].visibility = wgpu::ShaderStage::Fragment;
+    entries[4].texture.sampleType = wgpu::TextureSampleType::UnfilterableFloat;
+    entries[4].texture.viewDimension = wgpu::TextureViewDimension::e3D;
+
+    return gpuCache.bindGroupLayout(entries, 5);
+}
+
+// `source` is the scene target or, in gaze-contingent mode, the gaze pass output
+wgpu::BindGroup presentBindGroup(const wgpu::TextureView& source) {
+    wgpu::BindGroupEntry entries[5] = {};
+    entries[0].binding = 0;
+    entries[0].textureView = source;
+    entries[1].binding = 1;
+    entries[1].textureView = blueNoiseView;
+    entries[2].binding = 2;
+    entries[2].buffer = uniformRing.buffer();
+    entries[2].size = sizeof(OutputUniforms);
+    entries[3].binding = 3;
+    entries[3].textureView = lut1dView;
+    entries[4].binding = 4;
+    entries[4].textureView = lut3dView;
+
+    return gpuCache.bindGroup(presentBindGroupLayout(), entries, 5);
+}
+
+wgpu::BindGroupLayout gazeBindGroupLayout() {
+    wgpu::BindGroupLayoutEntry entries[2] = {};
+    entries[0].binding = 0;
+    entries[0].visibility = wgpu::ShaderStage::Fragment;
+    entries[0].texture.sampleType = wgpu::TextureSampleType::Float;
+    entries[0].texture.viewDimension = wgpu::TextureViewDimension::e2D;
+
+    entries[1].binding = 1;
+    entries[1].visibility = wgpu::ShaderStage::Fragment;
+    entries[1].buffer.type = wgpu::BufferBindingType::Uniform;
+    entries[1].buffer.hasDynamicOffset = true;
+    entries[1].buffer.minBindingSize = sizeof(GazeUniforms);
+
+    return gpuCache.bindGroupLayout(entries, 2);
+}
+
+wgpu::BindGroup gazeBindGroup(const wgpu::TextureView& scene) {
+    wgpu::BindGroupEntry entries[2] = {};
+    entries[0].binding = 0;
+    entries[0].textureView = scene;
+    entries[1].binding = 1;
+    entries[1].buffer = uniformRing.buffer();
+    entries[1].size = sizeof(GazeUniforms);
+
+    return gpuCache.bindGroup(gazeBindGroupLayout(), entries, 2);
+}
+
+// Precomputed blue-noise threshold tile for the output pass
+void createBlueNoiseTexture() {
+    std::vector<float> noise = generateBlueNoise(kBlueNoiseSize, 1);
+
+    wgpu::TextureDescriptor texDesc = {};
+    texDesc.label = "Blue noise";
+    texDesc.size = { kBlueNoiseSize, kBlueNoiseSize, 1 };
+    texDesc.format = wgpu::TextureFormat::R32Float;
+    texDesc.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst;
+    blueNoiseTexture = device.CreateTexture(&texDesc);
+    blueNoiseView = blueNoiseTexture.CreateView();
+
+    wgpu::ImageCopyTexture destination = {};
+    destination.texture = blueNoiseTexture;
+
+    wgpu::TextureDataLayout layout = {};
+    layout.bytesPerRow = kBlueNoiseSize * sizeof(float);
+    layout.rowsPerImage = kBlueNoiseSize;
+
+    queue.WriteTexture(&destination, noise.data(), noise.size() * sizeof(float), &layout, &texDesc.size);
+}
+
+// Upload an rgba32float LUT, replacing `texture` and dropping bind groups that used it
+void replaceLutTexture(wgpu::Texture& texture, wgpu::TextureView& view, wgpu::TextureDimension dimension,
+                       const float* rgba, uint32_t width, uint32_t height, uint32_t depth) {
+    if (texture) {
+        gpuCache.invalidate(view.Get());
+        texture.Destroy();
+    }
+
+    wgpu::TextureDescriptor texDesc = {};
+    texDesc.label = "Calibration LUT";
+    texDesc.dimension = dimension;
+    texDesc.size = { width, height, depth };
+    texDesc.format = wgpu::TextureFormat::RGBA32Float;
+    texDesc.usage = wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::CopyDst;
+    texture = device.CreateTexture(&texDesc);
+    view = texture.CreateView();
+
+    wgpu::ImageCopyTexture destination = {};
+    destination.texture = texture;
+
+    wgpu::TextureDataLayout layout = {};
+    layout.bytesPerRow = width * 4 * sizeof(float);
+    layout.rowsPerImage = height;
+
+    queue.WriteTexture(&destination, rgba, size_t(width) * height * depth * 4 * sizeof(float), &layout, &texDesc.size);
+}
+
+// Per-channel curves of `size` RGBA texels, e.g. from gammaLut() or invertLuminance()
+void setOutputLut1d(const float* rgba, uint32_t size) {
+    if (size < 2) {
+        std::cerr << "Calibration LUT needs at least two entries." << std::endl;
+        return;
+    }
+    replaceLutTexture(lut1dTexture, lut1dView, wgpu::TextureDimension::e2D, rgba, size, 1, 1);
+    outputParams.lut = static_cast<uint32_t>(OutputLut::Curves);
+    outputChanged = true;
+}
+
+// size^3 RGBA texels, red fastest
+void setOutputLut3d(const float* rgba, uint32_t size) {
+    if (size < 2) {
+        std::cerr << "Calibration LUT needs at least two entries." << std::endl;
+        return;
+    }
+    replaceLutTexture(lut3dTexture, lut3dView, wgpu::TextureDimension::e3D, rgba, size, size, size);
+    outputParams.lut = static_cast<uint32_t>(OutputLut::Cube);
+    outputChanged = true;
+}
+
+void clearOutputLut() {
+    outputParams.lut = static_cast<uint32_t>(OutputLut::None);
+    outputChanged = true;
+}
+
+// Identity LUTs so both bindings are always valid
+void createIdentityLuts() {
+    const float curve[8] = { 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f };
+    std::vector<float> cube = lut3dFromCurves(curve, 2, 2);
+    replaceLutTexture(lut1dTexture, lut1dView, wgpu::TextureDimension::e2D, curve, 2, 1, 1);
+    replaceLutTexture(lut3dTexture, lut3dView, wgpu::TextureDimension::e3D, cube.data(), 2, 2, 2);
+}
+
+// Choose how the scene is quantized to the swap chain. The channel
+// luminances come from the display's calibration; temporal dithering keeps
+// presenting every frame so the pattern can move even on a static scene.
+void setOutputMode(OutputMode mode, bool temporal, float lumR = 0.2126f, float lumG = 0.7152f, float lumB = 0.0722f) {
+    uint32_t lut = outputParams.lut;
+    outputParams = makeOutputUniforms(mode, lumR, lumG, lumB, kBlueNoiseSize);
+    outputParams.lut = lut;
+    outputChanged = true;
+    temporalDither = temporal && mode != OutputMode::Quantize && mode != OutputMode::BitSteal;
+}
+
+// Persistent scene target plus the pipelines that clear it and present it
+void createSceneTarget(uint32_t width, uint32_t height) {
+    wgpu::TextureDescriptor texDesc = {};
+    texDesc.label = "Scene target";
+    texDesc.size = { width, height, 1 };
+    texDesc.format = sceneFormat;
+    texDesc.usage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::TextureBinding;
+
+    sceneTexture = device.CreateTexture(&texDesc);
+    sceneView = sceneTexture.CreateView();
+
+    wgpu::ConstantEntry backgroundConstants[3] = {};
+    backgroundConstants[0].key = "backgroundR";
+    backgroundConstants[0].value = backgroundColor.r;
+    backgroundConstants[1].key = "backgroundG";
+    backgroundConstants[1].value = backgroundColor.g;
+    backgroundConstants[2].key = "backgroundB";
+    backgroundConstants[2].value = backgroundColor.b;
+    backgroundPipeline = createFullscreenPipeline(backgroundShaderCode, sceneFormat, nullptr, 0, backgroundConstants, 3);
+
+    wgpu::BindGroupLayout presentLayout = presentBindGroupLayout();
+    presentPipeline = createFullscreenPipeline(outputShaderCode, wgpu::TextureFormat::BGRA8Unorm, &presentLayout, 1);
+
+    wgpu::BindGroupLayout gazeLayout = gazeBindGroupLayout();
+    gazePipeline = createFullscreenPipeline(gazeShaderCode, sceneFormat, &gazeLayout, 1, backgroundConstants, 3);
+
+    damageTracker.resize(width, height);
+    sceneValid = false;
+}
+
+// Screen bounds of the quad under a transform, in NDC
+void stimulusBoundsNdc(const StimulusUniforms& params, float& minX, float& minY, float& maxX, float& maxY) {
+    const float* m = params.transform;
+    const float corners[4][2] = { { -0.5f, -0.5f }, { 0.5f, -0.5f }, { 0.5f, 0.5f }, { -0.5f, 0.5f } };
+
+    minX = minY = 1.0f;
+    maxX = maxY = -1.0f;
+    for (const auto& c : corners) {
+        float w = m[3] * c[0] + m[7] * c[1] + m[15];
+        if (w <= 0.0f) {
+            // Behind the viewer, give up on a tight bound
+            minX = minY = -1.0f;
+            maxX = maxY = 1.0f;
+            return;
+        }
+        float x = (m[0] * c[0] + m[4] * c[1] + m[12]) / w;
+        float y = (m[1] * c[0] + m[5] * c[1] + m[13]) / w;
+        minX = std::min(minX, x);
+        minY = std::min(minY, y);
+        maxX = std::max(maxX, x);
+        maxY = std::max(maxY, y);
+    }
+}
+
+// NDC footprint of everything the current source draws
+void currentBoundsNdc(float bounds[4]) {
+    if (stimulusSource == StimulusSource::Dots) {
+        float pad = dotParams.dotSize;
+        bounds[0] = dotParams.centerX - dotParams.radius - pad;
+        bounds[1] = dotParams.centerY - dotParams.radius - pad;
+        bounds[2] = dotParams.centerX + dotParams.radius + pad;
+        bounds[3] = dotParams.centerY + dotParams.radius + pad;
+        return;
+    }
+    if (stimulusSource == StimulusSource::Flicker) {
+        bounds[0] = bounds[1] = 1.0f;
+        bounds[2] = bounds[3] = -1.0f;
+        for (const FlickerTarget& t : flickerTargets) {
+            bounds[0] = std::min(bounds[0], t.centerX - t.halfWidth);
+            bounds[1] = std::min(bounds[1], t.centerY - t.halfHeight);
+            bounds[2] = std::max(bounds[2], t.centerX + t.halfWidth);
+            bounds[3] = std::max(bounds[3], t.centerY + t.halfHeight);
+        }
+        return;
+    }
+    stimulusBoundsNdc(stimulusParams, bounds[0], bounds[1], bounds[2], bounds[3]);
+}
+
+// Compare what is about to be drawn with what the scene target holds and
+// mark the old and new footprints of anything that moved or changed
+void updateDamage() {
+    DrawnState current = {};
+    current.source = stimulusSource;
+    if (stimulusSource == StimulusSource::Image) {
+        current.generation = stimulusGeneration;
+    } else if (stimulusSource == StimulusSource::Pattern) {
+        current.pattern = patternParams;
+    } else if (stimulusSource == StimulusSource::Noise) {
+        current.noise = noiseParams;
+    } else if (stimulusSource == StimulusSource::Flicker) {
+        // Flicker targets change luminance every frame
+        current.generation = flickerGeneration;
+        current.flickerFrame = frameIndex - flickerStartFrame;
+    } else {
+        // Dots move every frame
+        current.generation = dotGeneration;
+        current.flickerFrame = frameIndex - dotStartFrame;
+    }
+    current.params = stimulusParams;
+    current.params.frameIndex = 0;
+    currentBoundsNdc(current.bounds);
+
+    if (sceneValid && std::memcmp(&current, &lastDrawn, sizeof(DrawnState)) == 0) {
+        return;
+    }
+
+    if (sceneValid) {
+        damageTracker.invalidateNdc(lastDrawn.bounds[0], lastDrawn.bounds[1], lastDrawn.bounds[2], lastDrawn.bounds[3]);
+    } else {
+        damageTracker.invalidateAll();
+    }
+    damageTracker.invalidateNdc(current.bounds[0], current.bounds[1], current.bounds[2], current.bounds[3]);
+
+    lastDrawn = current;
+    sceneValid = true;
 }
 
 // Function to initialize the swap chain and pipeline
@@ -105,9 +1229,15 @@ void initializeSwapChainAndPipeline(wgpu::Surface surface) {
     swapChainDesc.usage = wgpu::TextureUsage::RenderAttachment;
     swapChainDesc.presentMode = wgpu::PresentMode::Fifo;
 
-    // Get canvas size
+    // Get canvas size; an OffscreenCanvas has no CSS size, main() fixed its
+    // drawing buffer to it before the transfer
+#ifdef RENDER_ON_WORKER
+    int canvasWidth, canvasHeight;
+    emscripten_get_canvas_element_size(canvasSelector, &canvasWidth, &canvasHeight);
+#else
     double canvasWidth, canvasHeight;
-    emscripten_get_element_css_size("canvas", &canvasWidth, &canvasHeight);
+    emscripten_get_element_css_size(canvasSelector, &canvasWidth, &canvasHeight);
+#endif
     std::cout << "Canvas size: " << canvasWidth << "x" << canvasHeight << std::endl;
 
     swapChainDesc.width = static_cast<uint32_t>(canvasWidth);
@@ -127,6 +1257,17 @@ void initializeSwapChainAndPipeline(wgpu::Surface surface) {
 
     // Create pipeline
     createRenderPipeline();
+    createSceneTarget(swapChainDesc.width, swapChainDesc.height);
+    createBlueNoiseTexture();
+    createIdentityLuts();
+    // Plain 8-bit quantization keeps output bit-exact and lets undamaged
+    // frames skip; dithering and bit-stealing are opted into per session
+    setOutputMode(OutputMode::Quantize, false);
+
+    // Start with a single orange pixel until an image is loaded
+    const uint8_t orange[4] = { 255, 128, 0, 255 };
+    setStimulusImage(orange, 1, 1, computeImageStats(orange, 1, 1, outputParams.weights[0], outputParams.weights[1],
+                                                     outputParams.weights[2]));
 
     // Start the main loop
     emscripten_request_animation_frame_loop(frame, nullptr);
@@ -140,6 +1281,12 @@ void onDeviceRequestEnded(WGPURequestDeviceStatus status,
     if (status == WGPURequestDeviceStatus_Success) {
         device = wgpu::Device::Acquire(cDevice);
         queue = device.GetQueue();
+        gpuCache.init(device);
+        texturePool.init(device, &gpuCache);
+        frameCapture.init(device);
+        frameCapture.setConsumer(consumeCapture);
+        frameHasher.init(device);
+        uniformRing.init(device, 64 * 1024);
 
         // Now that we have the device, initialize swap chain and pipeline
         WGPUSurface surface = static_cast<WGPUSurface>(userdata);
@@ -167,6 +1314,409 @@ void onAdapterRequestEnded(WGPURequestAdapterStatus status,
     }
 }
 
+// Bring the damaged part of the scene target up to date, after whatever
+// compute passes feed the current source
+void addScenePasses(RenderGraph& graph, RenderGraph::Resource scene, bool fullRedraw, PixelRect damage) {
+    // Whatever the scene pass samples besides uniforms
+    RenderGraph::Resource input = graph.importBuffer("stimulus inputs");
+
+    // Filter passes are declared whenever an image is loaded and culled
+    // unless the image is what gets drawn
+    if (stimulusFilter != FilterType::None && stimulusView) {
+        RenderGraph::Resource filtered = addStimulusFilterPasses(graph);
+        if (stimulusSource == StimulusSource::Image) {
+            input = filtered;
+        }
+    }
+
+    // Advance the dot field before drawing it
+    uint32_t dotOffset = UniformRing::kInvalidOffset;
+    if (stimulusSource == StimulusSource::Dots) {
+        dotParams.frame = frameIndex - dotStartFrame;
+        dotOffset = uniformRing.push(dotParams);
+        if (dotOffset != UniformRing::kInvalidOffset) {
+            input = graph.importBuffer("dots");
+            graph.addPass("dots update", {}, { input }, [dotOffset](wgpu::CommandEncoder& encoder) {
+                wgpu::ComputePassEncoder computePass = encoder.BeginComputePass();
+                computePass.SetPipeline(dotsComputePipeline);
+                computePass.SetBindGroup(0, dotsBindGroup(true), 1, &dotOffset);
+                computePass.DispatchWorkgroups((dotParams.count + kDotsWorkgroupSize - 1) / kDotsWorkgroupSize);
+                computePass.End();
+                dotParams.reset = 0;
+            });
+        }
+    }
+
+    stimulusParams.frameIndex = frameIndex;
+    UniformRing::Allocation stimulusBlock = uniformRing.allocate(sizeof(StimulusUniforms));
+    if (stimulusBlock.data) {
+        *static_cast<StimulusUniforms*>(stimulusBlock.data) = stimulusParams;
+        // Stays writable until the ring is flushed
+        latchSlot = lateLatching ? static_cast<StimulusUniforms*>(stimulusBlock.data) : nullptr;
+    }
+    uint32_t uniformOffset = stimulusBlock.offset;
+    uint32_t sourceOffset = UniformRing::kInvalidOffset;
+    if (stimulusSource == StimulusSource::Pattern) {
+        sourceOffset = uniformRing.push(patternParams);
+    } else if (stimulusSource == StimulusSource::Noise) {
+        sourceOffset = uniformRing.push(noiseParams);
+    } else if (stimulusSource == StimulusSource::Flicker) {
+        FlickerUniforms flickerParams = {};
+        flickerParams.frame = frameIndex - flickerStartFrame;
+        sourceOffset = uniformRing.push(flickerParams);
+    } else if (stimulusSource == StimulusSource::Dots) {
+        sourceOffset = dotOffset;
+    }
+
+    graph.addPass("scene", { input, scene }, { scene }, [fullRedraw, damage, uniformOffset, sourceOffset](wgpu::CommandEncoder& encoder) {
+        wgpu::RenderPassColorAttachment sceneAttachment = {};
+        sceneAttachment.view = sceneView;
+        sceneAttachment.loadOp = fullRedraw ? wgpu::LoadOp::Clear : wgpu::LoadOp::Load;
+        sceneAttachment.storeOp = wgpu::StoreOp::Store;
+        sceneAttachment.clearValue = backgroundColor;
+
+        wgpu::RenderPassDescriptor scenePassDesc = {};
+        scenePassDesc.colorAttachmentCount = 1;
+        scenePassDesc.colorAttachments = &sceneAttachment;
+
+        wgpu::RenderPassEncoder pass = encoder.BeginRenderPass(&scenePassDesc);
+
+        if (!fullRedraw) {
+            pass.SetScissorRect(damage.x, damage.y, damage.width, damage.height);
+            pass.SetPipeline(backgroundPipeline);
+            pass.Draw(3, 1, 0, 0);
+        }
+
+        if (stimulusSource == StimulusSource::Pattern) {
+            if (sourceOffset != UniformRing::kInvalidOffset && uniformOffset != UniformRing::kInvalidOffset) {
+                pass.SetPipeline(proceduralPipeline);
+                pass.SetBindGroup(0, patternBindGroup(), 1, &sourceOffset);
+                pass.SetBindGroup(1, uniformBindGroup(), 1, &uniformOffset);
+                pass.Draw(6, 1, 0, 0);
+            }
+        } else if (stimulusSource == StimulusSource::Dots) {
+            if (sourceOffset != UniformRing::kInvalidOffset) {
+                pass.SetPipeline(dotsPipeline);
+                pass.SetBindGroup(0, dotsBindGroup(false), 1, &sourceOffset);
+                pass.Draw(6, dotParams.count, 0, 0);
+            }
+        } else if (stimulusSource == StimulusSource::Flicker) {
+            if (sourceOffset != UniformRing::kInvalidOffset) {
+                pass.SetPipeline(flickerPipeline);
+                pass.SetBindGroup(0, flickerBindGroup());
+                pass.SetBindGroup(1, flickerUniformBindGroup(), 1, &sourceOffset);
+                pass.Draw(6, static_cast<uint32_t>(flickerTargets.size()), 0, 0);
+            }
+        } else if (stimulusSource == StimulusSource::Noise) {
+            if (sourceOffset != UniformRing::kInvalidOffset && uniformOffset != UniformRing::kInvalidOffset) {
+                pass.SetPipeline(noisePipeline);
+                pass.SetBindGroup(0, noiseBindGroup(), 1, &sourceOffset);
+                pass.SetBindGroup(1, uniformBindGroup(), 1, &uniformOffset);
+                pass.Draw(6, 1, 0, 0);
+            }
+        } else if (uniformOffset != UniformRing::kInvalidOffset) {
+            pass.SetPipeline(pipeline);
+            pass.SetBindGroup(0, stimulusBindGroup());
+            pass.SetBindGroup(1, uniformBindGroup(), 1, &uniformOffset);
+            pass.Draw(6, 1, 0, 0);
+        }
+        pass.End();
+    });
+}
+
+// Full-screen output draw from `source` into `view`
+void encodeOutput(wgpu::CommandEncoder& encoder, const wgpu::TextureView& source, const wgpu::TextureView& view,
+                  uint32_t outputOffset) {
+    wgpu::RenderPassColorAttachment colorAttachment = {};
+    colorAttachment.view = view;
+    colorAttachment.loadOp = wgpu::LoadOp::Clear;
+    colorAttachment.storeOp = wgpu::StoreOp::Store;
+    colorAttachment.clearValue = backgroundColor;
+
+    wgpu::RenderPassDescriptor renderPassDesc = {};
+    renderPassDesc.colorAttachmentCount = 1;
+    renderPassDesc.colorAttachments = &colorAttachment;
+
+    wgpu::RenderPassEncoder presentPass = encoder.BeginRenderPass(&renderPassDesc);
+    if (outputOffset != UniformRing::kInvalidOffset) {
+        presentPass.SetPipeline(presentPipeline);
+        presentPass.SetBindGroup(0, presentBindGroup(source), 1, &outputOffset);
+        presentPass.Draw(3, 1, 0, 0);
+    }
+    presentPass.End();
+}
+
+// Gaze uniforms for the newest tracked sample, or invalid ones without it
+GazeUniforms currentGazeUniforms(double* sampleTime) {
+    GazeUniforms uniforms = gazeParams;
+    uniforms.mode = static_cast<uint32_t>(gazeMode);
+    uniforms.valid = 0;
+    GazeSample sample;
+    if (gazeLatest.load(sample) && (sample.flags & kGazeValid)) {
+        uniforms.centerX = sample.x * sceneTexture.GetWidth();
+        uniforms.centerY = sample.y * sceneTexture.GetHeight();
+        uniforms.valid = 1;
+        if (sampleTime) {
+            *sampleTime = sample.time;
+        }
+    }
+    return uniforms;
+}
+
+// Window, mask or blur the scene around the point of gaze into a transient
+// texture, which replaces the scene as the input of the output pass. The
+// gaze position is written again at the late latch.
+RenderGraph::Resource addGazePass(RenderGraph& graph, RenderGraph::Resource scene) {
+    UniformRing::Allocation block = uniformRing.allocate(sizeof(GazeUniforms));
+    if (!block.data) {
+        return scene;
+    }
+    gazeSlot = static_cast<GazeUniforms*>(block.data);
+    *gazeSlot = currentGazeUniforms(nullptr);
+    uint32_t gazeOffset = block.offset;
+
+    TexturePool::Desc desc;
+    desc.width = sceneTexture.GetWidth();
+    desc.height = sceneTexture.GetHeight();
+    desc.format = sceneFormat;
+    desc.usage = transientUsage;
+    RenderGraph::Resource target = graph.createTexture("gaze", desc);
+
+    graph.addPass("gaze", { scene }, { target }, [&graph, scene, target, gazeOffset](wgpu::CommandEncoder& encoder) {
+        wgpu::RenderPassColorAttachment attachment = {};
+        attachment.view = graph.view(target);
+        attachment.loadOp = wgpu::LoadOp::Clear;
+        attachment.storeOp = wgpu::StoreOp::Store;
+        attachment.clearValue = backgroundColor;
+
+        wgpu::RenderPassDescriptor passDesc = {};
+        passDesc.colorAttachmentCount = 1;
+        passDesc.colorAttachments = &attachment;
+
+        wgpu::RenderPassEncoder pass = encoder.BeginRenderPass(&passDesc);
+        pass.SetPipeline(gazePipeline);
+        pass.SetBindGroup(0, gazeBindGroup(graph.view(scene)), 1, &gazeOffset);
+        pass.Draw(3, 1, 0, 0);
+        pass.End();
+    });
+    return target;
+}
+
+// Quantize the whole scene target into the swap chain; returns the output
+// uniforms so a capture can repeat the exact same draw
+uint32_t addOutputPass(RenderGraph& graph, RenderGraph::Resource scene, RenderGraph::Resource backbuffer) {
+    outputParams.temporalOffset = temporalDither ? temporalDitherOffset(frameIndex) : 0.0f;
+    uint32_t outputOffset = uniformRing.push(outputParams);
+
+    graph.addPass("output", { scene }, { backbuffer }, [&graph, scene, backbuffer, outputOffset](wgpu::CommandEncoder& encoder) {
+        encodeOutput(encoder, graph.view(scene), graph.view(backbuffer), outputOffset);
+    });
+    return outputOffset;
+}
+
+// Repeat the output draw into a transient texture, then copy it to the
+// capture's readback buffer and/or hash it
+void addCapturePasses(RenderGraph& graph, RenderGraph::Resource scene, uint32_t outputOffset, bool copy, bool hash) {
+    TexturePool::Desc desc;
+    desc.width = sceneTexture.GetWidth();
+    desc.height = sceneTexture.GetHeight();
+    desc.format = FrameCapture::kFormat;
+    desc.usage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::CopySrc | wgpu::TextureUsage::TextureBinding;
+    RenderGraph::Resource target = graph.createTexture("capture target", desc);
+
+    graph.addPass("capture", { scene }, { target }, [&graph, scene, target, outputOffset](wgpu::CommandEncoder& encoder) {
+        encodeOutput(encoder, graph.view(scene), graph.view(target), outputOffset);
+    });
+
+    if (copy) {
+        RenderGraph::Resource readback = graph.importBuffer("capture readback");
+        graph.markOutput(readback);
+        graph.addPass("capture copy", { target }, { readback }, [&graph, target](wgpu::CommandEncoder& encoder) {
+            frameCapture.encodeCopy(encoder, graph.texture(target));
+        });
+    }
+
+    if (hash) {
+        RenderGraph::Resource sums = graph.importBuffer("content hash");
+        graph.markOutput(sums);
+        uint32_t width = desc.width;
+        uint32_t height = desc.height;
+        graph.addPass("content hash", { target }, { sums }, [&graph, target, width, height](wgpu::CommandEncoder& encoder) {
+            frameHasher.encodeClear(encoder);
+            wgpu::ComputePassEncoder pass = encoder.BeginComputePass();
+            pass.SetPipeline(hashPipeline);
+            pass.SetBindGroup(0, hashBindGroup(graph.view(target)));
+            pass.DispatchWorkgroups((width + kHashWorkgroupSize - 1) / kHashWorkgroupSize,
+                                    (height + kHashWorkgroupSize - 1) / kHashWorkgroupSize);
+            pass.End();
+            frameHasher.encodeCopy(encoder);
+        });
+    }
+}
+
+// Commands from JavaScript and worker threads, applied at the top of frame()
+MpscQueue<Command, 1024> commandQueue;
+// Records written by JavaScript in place, see ControlBlock.h
+ControlBlock controlBlock;
+Command controlCommands[kControlCapacity];
+
+void applyCommand(const Command& command) {
+    switch (command.type) {
+    case CommandType::ShowImage:
+        if (stimulusView) {
+            stimulusSource = StimulusSource::Image;
+        }
+        break;
+    case CommandType::SetPattern:
+        setStimulusPattern(command.pattern);
+        break;
+    case CommandType::SetNoise:
+        setStimulusNoise(command.noise, command.flag != 0);
+        break;
+    case CommandType::SetDots:
+        setDotField(command.dots);
+        break;
+    case CommandType::SetStimulus:
+        std::memcpy(stimulusParams.transform, command.stimulus.transform, sizeof(stimulusParams.transform));
+        stimulusParams.opacity = command.stimulus.opacity;
+        stimulusParams.luminance = command.stimulus.luminance;
+        break;
+    case CommandType::SetFilter:
+        setStimulusFilter(command.filter.type, command.filter.sigma);
+        break;
+    case CommandType::SetOutputMode:
+        setOutputMode(command.output.mode, command.flag != 0, command.output.weights[0], command.output.weights[1],
+                      command.output.weights[2]);
+        break;
+    case CommandType::Callback:
+        if (command.callback.run) {
+            command.callback.run(command.callback.userData);
+        }
+        break;
+    default:
+        std::cerr << "Unknown command type " << static_cast<uint32_t>(command.type) << std::endl;
+        break;
+    }
+}
+
+// Output mode switches and callbacks do not start a new stimulus
+bool changesStimulus(CommandType type) {
+    return type != CommandType::SetOutputMode && type != CommandType::Callback;
+}
+
+// Copy a published placement into the stimulus uniforms
+void applyPlacement(const LatchedStimulus& latest, FrameRecord& record) {
+    std::memcpy(stimulusParams.transform, latest.stimulus.transform, sizeof(stimulusParams.transform));
+    stimulusParams.opacity = latest.stimulus.opacity;
+    stimulusParams.luminance = latest.stimulus.luminance;
+    record.inputTime = latest.inputTime;
+}
+
+// Take the newest published placement, or one deferred by the last frame,
+// before the frame is built, so the damage check redraws only its old and
+// new footprints. True when there was one.
+bool placeStimulus(FrameRecord& record) {
+    LatchedStimulus latest;
+    bool fresh = false;
+    if (stimulusLatch.load(latest, &fresh) && fresh) {
+        latchDeferred = false;
+    } else if (latchDeferred) {
+        latest = deferredLatch;
+        latchDeferred = false;
+    } else {
+        return false;
+    }
+    applyPlacement(latest, record);
+    return true;
+}
+
+// Overwrite this frame's stimulus block with a placement published since
+// placeStimulus(), as late as possible before submission, and remember it
+// as what the scene now shows. The scissor is already encoded, so unless
+// the whole scene is redrawn the new footprint must lie inside the damage
+// the frame was built with; otherwise the frame keeps its placement and
+// the next one takes the new. True when a placement was latched.
+bool latchStimulus(FrameRecord& record, bool fullRedraw) {
+    LatchedStimulus latest;
+    bool fresh = false;
+    if (!stimulusLatch.load(latest, &fresh) || !fresh) {
+        return false;
+    }
+    StimulusUniforms built = stimulusParams;
+    double builtInputTime = record.inputTime;
+    applyPlacement(latest, record);
+    float bounds[4];
+    currentBoundsNdc(bounds);
+    if (!fullRedraw && !damageTracker.containsNdc(bounds[0], bounds[1], bounds[2], bounds[3])) {
+        stimulusParams = built;
+        record.inputTime = builtInputTime;
+        deferredLatch = latest;
+        latchDeferred = true;
+        return false;
+    }
+    *latchSlot = stimulusParams;
+
+    lastDrawn.params = stimulusParams;
+    lastDrawn.params.frameIndex = 0;
+    std::memcpy(lastDrawn.bounds, bounds, sizeof(bounds));
+    return true;
+}
+
+// Newest gaze sample into this frame's gaze block. True when the window
+// moved or appeared or disappeared since the last latch.
+bool latchGaze(FrameRecord& record) {
+    GazeUniforms uniforms = currentGazeUniforms(&record.inputTime);
+    *gazeSlot = uniforms;
+    bool moved = uniforms.valid != latchedGaze.valid || uniforms.centerX != latchedGaze.centerX ||
+                 uniforms.centerY != latchedGaze.centerY;
+    latchedGaze = uniforms;
+    return moved;
+}
+
+// Log a stimulus onset of this frame for the reaction times. The present
+// time is an estimate: with FIFO presentation a frame normally reaches the
+// screen at the vsync after the one it was started on, but a missed vsync
+// or compositor delay shows it later, which only a photodiode would catch.
+void markOnset(double vsyncClock) {
+    double presentTime = vsyncClock + 1000.0 / frameTimeline.estimateRefreshHz(60.0);
+    responseLog.onset(frameIndex, presentTime);
+    mockResponder.onset(presentTime);
+}
+
+void pushInput(const InputEvent& event) {
+    if (!inputQueue.tryPush(event)) {
+        droppedInputs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// An html5 event's timestamp on the shared clock, from the thread it is delivered on
+double inputEventTime(double domTimestamp) {
+    return emscripten_get_now() - (emscripten_performance_now() - domTimestamp);
+}
+
+EM_BOOL onKeyEvent(int eventType, const EmscriptenKeyboardEvent* event, void* userData) {
+    if (event->repeat) {
+        return EM_FALSE;
+    }
+    InputEvent input = {};
+    input.time = inputEventTime(event->timestamp);
+    input.type = static_cast<uint32_t>(eventType == EMSCRIPTEN_EVENT_KEYDOWN ? InputType::KeyDown : InputType::KeyUp);
+    input.code = static_cast<uint32_t>(event->keyCode);
+    input.source = static_cast<uint32_t>(InputSource::Browser);
+    pushInput(input);
+    return EM_FALSE;
+}
+
+EM_BOOL onMouseEvent(int eventType, const EmscriptenMouseEvent* event, void* userData) {
+    InputEvent input = {};
+    input.time = inputEventTime(event->timestamp);
+    input.type = static_cast<uint32_t>(eventType == EMSCRIPTEN_EVENT_MOUSEDOWN ? InputType::MouseDown : InputType::MouseUp);
+    input.code = event->button;
+    input.source = static_cast<uint32_t>(InputSource::Browser);
+    pushInput(input);
+    return EM_FALSE;
+}
+
 // Main rendering loop
 EM_BOOL frame(double time, void* userData) {
     // Ensure swap chain is valid
@@ -175,39 +1725,538 @@ EM_BOOL frame(double time, void* userData) {
         return EM_FALSE;
     }
 
+    FrameRecord record = {};
+    record.frameIndex = frameIndex;
+    record.vsyncTime = time;
+    record.cpuStart = emscripten_get_now();
+    // rAF timestamps count from this thread's time origin; move the vsync
+    // onto the clock shared with the input events
+    double vsyncClock = record.cpuStart - (emscripten_performance_now() - time);
+
+    // Everything queued before this point takes effect on this frame; the
+    // damage check below sees the new state like any other change
+    bool onset = false;
+    record.commands = static_cast<uint32_t>(commandQueue.drain([&onset](const Command& command) {
+        onset = onset || changesStimulus(command.type);
+        applyCommand(command);
+    }));
+
+    mockResponder.release(record.cpuStart, pushInput);
+    inputQueue.drain([](const InputEvent& event) { responseLog.add(event); });
+
+    if (noiseAnimated) {
+        noiseParams.frame = frameIndex;
+    }
+
+    if (lateLatching && placeStimulus(record)) {
+        onset = true;
+    }
+
+    // Nothing changed: the canvas keeps showing the last presented image as
+    // long as we do not acquire a new swap chain texture this frame. Temporal
+    // dithering still needs a fresh output pass, just not a scene redraw.
+    updateDamage();
+    if (lateLatching && damageTracker.dirty()) {
+        // Room for a placement published while this frame is being built
+        float bounds[4];
+        currentBoundsNdc(bounds);
+        damageTracker.invalidateNdc(bounds[0], bounds[1], bounds[2], bounds[3], kLatchMarginPixels);
+    }
+    bool sceneDirty = damageTracker.dirty();
+    if (!sceneDirty && !temporalDither && !outputChanged && gazeMode == GazeMode::Off && !recordingFrames) {
+        // A command that left the image as it was still marks an onset
+        if (onset) {
+            markOnset(vsyncClock);
+        }
+        record.cpuEnd = emscripten_get_now();
+        frameTimeline.record(record);
+        frameIndex++;
+        return EM_TRUE;
+    }
+
     wgpu::TextureView backbuffer = swapChain.GetCurrentTextureView();
     if (!backbuffer) {
         std::cerr << "Failed to get current texture view." << std::endl;
         return EM_FALSE;
     }
 
-    wgpu::CommandEncoder encoder = device.CreateCommandEncoder();
-
-    wgpu::RenderPassColorAttachment colorAttachment = {};
-    colorAttachment.view = backbuffer;
-    colorAttachment.loadOp = wgpu::LoadOp::Clear;
-    colorAttachment.storeOp = wgpu::StoreOp::Store;
-    colorAttachment.clearValue = { 0.3f, 0.3f, 0.3f, 1.0f }; // Gray background
-
-    wgpu::RenderPassDescriptor renderPassDesc = {};
-    renderPassDesc.colorAttachmentCount = 1;
-    renderPassDesc.colorAttachments = &colorAttachment;
+    const PixelRect& damage = damageTracker.bounds();
+    bool fullRedraw = damageTracker.full();
 
-    wgpu::RenderPassEncoder pass = encoder.BeginRenderPass(&renderPassDesc);
+    latchSlot = nullptr;
+    gazeSlot = nullptr;
+    frameGraph.reset();
+    RenderGraph::Resource backbufferResource = frameGraph.importTexture("backbuffer", backbuffer);
+    RenderGraph::Resource sceneResource = frameGraph.importTexture("scene", sceneView);
+    frameGraph.markOutput(backbufferResource);
+    if (sceneDirty) {
+        addScenePasses(frameGraph, sceneResource, fullRedraw, damage);
+    }
+    RenderGraph::Resource presented = sceneResource;
+    if (gazeMode != GazeMode::Off) {
+        presented = addGazePass(frameGraph, sceneResource);
+    }
+    uint32_t outputOffset = addOutputPass(frameGraph, presented, backbufferResource);
+    bool capturing = frameCapture.begin(frameIndex, time, sceneTexture.GetWidth(), sceneTexture.GetHeight());
+    bool hashing = frameHashing && frameHasher.begin(frameIndex, time);
+    if (capturing || hashing) {
+        addCapturePasses(frameGraph, presented, outputOffset, capturing, hashing);
+    }
 
-    pass.SetPipeline(pipeline);
-    pass.Draw(6, 1, 0, 0);
-    pass.End();
+    wgpu::CommandEncoder encoder = device.CreateCommandEncoder();
+    frameGraph.execute(encoder, texturePool);
 
     wgpu::CommandBuffer cmdBuffer = encoder.Finish();
+    if (latchSlot || gazeSlot) {
+        record.latchTime = emscripten_get_now();
+        if (latchSlot && latchStimulus(record, fullRedraw)) {
+            onset = true;
+        }
+        if (gazeSlot && latchGaze(record)) {
+            onset = true;
+        }
+    }
+    uniformRing.flush(queue);
     queue.Submit(1, &cmdBuffer);
+    record.submitTime = emscripten_get_now();
+    uniformRing.submitted(queue);
+    frameCapture.submitted();
+    frameHasher.submitted();
+    texturePool.endFrame();
+
+    if (onset) {
+        markOnset(vsyncClock);
+    }
+
+    record.submitted = true;
+    outputChanged = false;
+    if (sceneDirty) {
+        record.redrawnPixels = fullRedraw ? damageTracker.targetArea() : damage.area();
+    }
+    damageTracker.clear();
+
+    record.cpuEnd = emscripten_get_now();
+    frameTimeline.record(record);
+    frameIndex++;
 
     // Return EM_TRUE to keep the loop running
     return EM_TRUE;
 }
 
-// Entry point
-int main() {
+// Decoded RGBA8 image from JavaScript, `width * height * 4` bytes in the wasm heap
+extern "C" EMSCRIPTEN_KEEPALIVE void loadStimulusImage(const uint8_t* rgba, uint32_t width, uint32_t height) {
+    if (!device) {
+        std::cerr << "Cannot load an image before the device is ready." << std::endl;
+        return;
+    }
+    if (!rgba || width == 0 || height == 0) {
+        std::cerr << "Invalid stimulus image." << std::endl;
+        return;
+    }
+    // Statistics use the output stage's luminance weights, i.e. the
+    // calibrated ones if set, and are computed on this thread and the worker
+    // pool before the image is handed to the render thread
+    float weights[3];
+    onRenderThread([&] { std::copy(outputParams.weights, outputParams.weights + 3, weights); });
+    ImageStats stats = computeImageStats(rgba, width, height, weights[0], weights[1], weights[2]);
+    onRenderThread([=] { setStimulusImage(rgba, width, height, stats); });
+}
+
+// Flicker `count` targets described by FlickerSpecs in the wasm heap,
+// replacing the current stimulus; refreshHz = 0 uses the measured rate
+extern "C" EMSCRIPTEN_KEEPALIVE void startFlicker(const FlickerSpec* specs, uint32_t count, double refreshHz) {
+    if (!device) {
+        std::cerr << "Cannot start flicker before the device is ready." << std::endl;
+        return;
+    }
+    if (!specs || count == 0) {
+        std::cerr << "No flicker targets." << std::endl;
+        return;
+    }
+    onRenderThread([=] { setFlickerTargets(specs, count, refreshHz); });
+}
+
+// Queue `count` commands for the next frame, all or none; false when the
+// queue is full. Safe to call from any thread.
+extern "C" EMSCRIPTEN_KEEPALIVE bool pushCommands(const Command* commands, uint32_t count) {
+    return commandQueue.tryPush(commands, count);
+}
+
+// Where JavaScript writes its control records
+extern "C" EMSCRIPTEN_KEEPALIVE ControlBlock* controlBlockAddress() {
+    return &controlBlock;
+}
+
+// Queue the records in the control block as one batch for the next frame.
+// Returns false and keeps them when the queue is full, so the caller can
+// submit again on the following frame.
+extern "C" EMSCRIPTEN_KEEPALIVE bool submitControlBlock() {
+    uint32_t count = std::min(controlBlock.count, kControlCapacity);
+    size_t decoded = decodeControlRecords(controlBlock.records, count, controlCommands, &controlBlock.rejected);
+    if (!commandQueue.tryPush(controlCommands, decoded)) {
+        return false;
+    }
+    controlBlock.count = 0;
+    return true;
+}
+
+// Calibration LUT of `size` RGBA float texels per channel curve, see setOutputLut1d()
+extern "C" EMSCRIPTEN_KEEPALIVE void loadCalibrationLut1d(const float* rgba, uint32_t size) {
+    onRenderThread([=] { setOutputLut1d(rgba, size); });
+}
+
+// Full color calibration LUT of size^3 RGBA float texels, red fastest
+extern "C" EMSCRIPTEN_KEEPALIVE void loadCalibrationLut3d(const float* rgba, uint32_t size) {
+    onRenderThread([=] { setOutputLut3d(rgba, size); });
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE void clearCalibrationLut() {
+    onRenderThread([] { clearOutputLut(); });
+}
+
+// Result of calibrateDisplay(), read by JavaScript through the heap
+struct CalibrationResult {
+    GammaFit fits[3]; // red, green, blue
+    uint32_t applied; // 1 when the LUT was installed
+    uint32_t padding;
+};
+
+// Linearize the display from photometer readings: `samples` holds `count`
+// PhotometerSamples of red, then of green, then of blue; model is a
+// CalibrationModel. The fits run on the calling thread and the resulting
+// 1D LUT of `size` entries is installed.
+extern "C" EMSCRIPTEN_KEEPALIVE const CalibrationResult* calibrateDisplay(const PhotometerSample* samples,
+                                                                          uint32_t count, uint32_t model,
+                                                                          uint32_t size) {
+    static CalibrationResult result;
+    result = {};
+    if (model > static_cast<uint32_t>(CalibrationModel::Spline)) {
+        std::cerr << "Unknown calibration model " << model << "." << std::endl;
+        return &result;
+    }
+
+    const PhotometerSample* channels[3] = { samples, samples + count, samples + 2 * size_t(count) };
+    std::vector<float> lut = calibrateChannels(channels, count, static_cast<CalibrationModel>(model), size, result.fits);
+    if (lut.empty()) {
+        std::cerr << "Calibration needs at least two readings per channel and two LUT entries." << std::endl;
+        return &result;
+    }
+    onRenderThread([&] { setOutputLut1d(lut.data(), size); });
+    result.applied = 1;
+    return &result;
+}
+
+// Statistics of the image last loaded, read by JavaScript through the heap
+extern "C" EMSCRIPTEN_KEEPALIVE const ImageStats* stimulusImageStats() {
+    return &stimulusStats;
+}
+
+// Equalize decoded images in place before they are loaded: `images` holds
+// `count` MatchImage records; mode 0 matches mean and RMS contrast, mode 1
+// the full histogram. Returns the number of pixels clipped by mode 0.
+extern "C" EMSCRIPTEN_KEEPALIVE uint32_t matchImageSet(MatchImage* images, uint32_t count, uint32_t mode) {
+    // The output stage's weights belong to the render thread; only the copy
+    // is read while matching runs here
+    float weights[3];
+    onRenderThread([&] { std::copy(outputParams.weights, outputParams.weights + 3, weights); });
+    MatchResult result = mode == 1 ? matchHistograms(images, count, nullptr, weights[0], weights[1], weights[2])
+                                   : matchMeanContrast(images, count, -1.0, -1.0, weights[0], weights[1], weights[2]);
+    return static_cast<uint32_t>(result.clippedPixels);
+}
+
+// Phase-scramble one decoded image in place; the same seed gives the same image
+extern "C" EMSCRIPTEN_KEEPALIVE uint32_t phaseScrambleImage(MatchImage* image, uint32_t seed, float amount) {
+    return static_cast<uint32_t>(phaseScramble(*image, seed, amount));
+}
+
+// Give a set of same-sized images the set's average amplitude spectrum.
+// Returns the number of clipped pixels, or UINT32_MAX if the sizes differ.
+extern "C" EMSCRIPTEN_KEEPALIVE uint32_t matchImageSpectra(MatchImage* images, uint32_t count) {
+    float weights[3];
+    onRenderThread([&] { std::copy(outputParams.weights, outputParams.weights + 3, weights); });
+    size_t clipped = 0;
+    if (!matchSpectra(images, count, &clipped, weights[0], weights[1], weights[2])) {
+        return UINT32_MAX;
+    }
+    return static_cast<uint32_t>(clipped);
+}
+
+// Capture every `every` rendered frames for the audit trail; 0 stops capturing
+extern "C" EMSCRIPTEN_KEEPALIVE void setFrameCapture(uint32_t every) {
+    onRenderThread([=] { frameCapture.setInterval(every); });
+}
+
+// Capture counters, read by JavaScript through the heap
+extern "C" EMSCRIPTEN_KEEPALIVE const FrameCapture::Stats* frameCaptureStats() {
+    static FrameCapture::Stats stats;
+    stats = frameCapture.stats();
+    return &stats;
+}
+
+// Encode captured frames as ImageFormat (0 stored PNG, 1 fast PNG, 2 QOI)
+// on the capture worker; any other value stops encoding
+extern "C" EMSCRIPTEN_KEEPALIVE void setCaptureEncoding(uint32_t format) {
+    captureEncoding = format <= static_cast<uint32_t>(ImageFormat::Qoi) ? format : kNoEncoding;
+}
+
+// Oldest encoded capture, or null if none is waiting. The bytes stay valid
+// until the next call.
+extern "C" EMSCRIPTEN_KEEPALIVE const uint8_t* takeEncodedFrame(uint32_t* size, uint32_t* frameIndex,
+                                                                double* vsyncTime) {
+    static EncodedFrame taken;
+    {
+        std::lock_guard<std::mutex> lock(encodedMutex);
+        if (encodedFrames.empty()) {
+            return nullptr;
+        }
+        taken = std::move(encodedFrames.front());
+        encodedFrames.pop_front();
+    }
+    *size = static_cast<uint32_t>(taken.bytes.size());
+    *frameIndex = static_cast<uint32_t>(taken.frameIndex);
+    *vsyncTime = taken.vsyncTime;
+    return taken.bytes.data();
+}
+
+// Record every vsync's frame to `path` in the Emscripten file system,
+// as Y4M (container 0) or raw I420 (1), with a `path`.timestamps sidecar.
+// For the duration, unchanged frames are rendered and captured too instead
+// of being skipped.
+extern "C" EMSCRIPTEN_KEEPALIVE bool startRecording(const char* path, uint32_t container) {
+    bool started = false;
+    onRenderThread([&] {
+        double refreshHz = frameTimeline.estimateRefreshHz(60.0);
+        started = videoRecorder.start(path, static_cast<VideoRecorder::Container>(container), sceneTexture.GetWidth(),
+                                      sceneTexture.GetHeight(), refreshHz);
+        if (started) {
+            frameCapture.setInterval(1);
+            recordingFrames = true;
+        }
+    });
+    return started;
+}
+
+// Stop recording; the file is complete once recordingActive() is false
+extern "C" EMSCRIPTEN_KEEPALIVE void stopRecording() {
+    videoRecorder.stop();
+    onRenderThread([] {
+        frameCapture.setInterval(0);
+        recordingFrames = false;
+    });
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE bool recordingActive() {
+    return videoRecorder.active();
+}
+
+// Recording counters, read by JavaScript through the heap
+extern "C" EMSCRIPTEN_KEEPALIVE const VideoRecorder::Stats* recordingStats() {
+    static VideoRecorder::Stats stats;
+    stats = videoRecorder.stats();
+    return &stats;
+}
+
+// Sample stimulus placement for late latching: from now on each frame uses
+// the newest placement published before its submission, unless it moved
+// further than the damage the frame was built with allows, in which case
+// the next frame shows it
+extern "C" EMSCRIPTEN_KEEPALIVE void setLateLatch(bool enabled) {
+    onRenderThread([=] {
+        lateLatching = enabled;
+        latchDeferred = false;
+    });
+}
+
+// Publish the placement derived from an input sampled at `inputTime`
+// (emscripten_get_now() ms). Safe to call from any thread at any rate.
+extern "C" EMSCRIPTEN_KEEPALIVE void publishStimulus(const StimulusCommand* stimulus, double inputTime) {
+    stimulusLatch.store({ *stimulus, inputTime });
+}
+
+// Per-frame latch timing for the retained frames that were late-latched,
+// oldest first; `count` receives how many
+extern "C" EMSCRIPTEN_KEEPALIVE const LatchTiming* latchTimingLog(uint32_t* count) {
+    static std::vector<LatchTiming> timings;
+    onRenderThread([] { timings = frameTimeline.latchTimings(); });
+    *count = static_cast<uint32_t>(timings.size());
+    return timings.data();
+}
+
+// Gaze-contingent display: mode is a GazeMode; radius, feather and maxBlur
+// in pixels, blurPerPixel in pixels of blur per pixel of eccentricity
+extern "C" EMSCRIPTEN_KEEPALIVE void setGazeMode(uint32_t mode, float radius, float feather, float blurPerPixel,
+                                                 float maxBlur) {
+    onRenderThread([=] {
+        gazeMode = mode <= static_cast<uint32_t>(GazeMode::FoveatedBlur) ? static_cast<GazeMode>(mode) : GazeMode::Off;
+        gazeParams.radius = radius;
+        gazeParams.feather = feather;
+        gazeParams.blurPerPixel = blurPerPixel;
+        gazeParams.maxBlur = maxBlur;
+        outputChanged = true;
+    });
+}
+
+void storeGazeSample(const GazeSample& sample) {
+    gazeLatest.store(sample);
+    latestGazeTime.store(sample.time, std::memory_order_relaxed);
+}
+
+EM_BOOL onGazeMessage(int eventType, const EmscriptenWebSocketMessageEvent* event, void* userData) {
+    if (!event->isText) {
+        socketGazeDecoder.feed(event->data, event->numBytes, storeGazeSample);
+    }
+    return EM_TRUE;
+}
+
+// Receive binary gaze records (see Gaze.h) from a local bridge at `url`,
+// e.g. ws://localhost:8765 in front of the tracker's socket
+extern "C" EMSCRIPTEN_KEEPALIVE bool connectGazeSocket(const char* url) {
+    if (gazeSocket > 0) {
+        emscripten_websocket_close(gazeSocket, 1000, "reconnect");
+        emscripten_websocket_delete(gazeSocket);
+    }
+    EmscriptenWebSocketCreateAttributes attributes;
+    emscripten_websocket_init_create_attributes(&attributes);
+    attributes.url = url;
+    gazeSocket = emscripten_websocket_new(&attributes);
+    if (gazeSocket <= 0) {
+        std::cerr << "Cannot open gaze socket " << url << std::endl;
+        gazeSocket = 0;
+        return false;
+    }
+    socketGazeDecoder.reset();
+    emscripten_websocket_set_onmessage_callback(gazeSocket, nullptr, onGazeMessage);
+    return true;
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE void disconnectGazeSocket() {
+    if (gazeSocket > 0) {
+        emscripten_websocket_close(gazeSocket, 1000, "done");
+        emscripten_websocket_delete(gazeSocket);
+        gazeSocket = 0;
+    }
+}
+
+// Drive the gaze path with synthetic samples at `rateHz`, `batch` records
+// per message, without a tracker
+extern "C" EMSCRIPTEN_KEEPALIVE bool startSyntheticGaze(double rateHz, uint32_t seed, uint32_t batch) {
+    syntheticGazeDecoder.reset();
+    return syntheticGaze.start(rateHz, seed, batch, emscripten_get_now, [](const uint8_t* data, size_t size) {
+        syntheticGazeDecoder.feed(data, size, storeGazeSample);
+    });
+}
+
+extern "C" EMSCRIPTEN_KEEPALIVE void stopSyntheticGaze() {
+    syntheticGaze.stop();
+}
+
+struct GazeStats {
+    uint64_t socketSamples;
+    uint64_t syntheticEmitted;
+    uint64_t syntheticDecoded;
+    uint64_t skippedBytes;
+    double latestSampleTime; // 0 before the first sample
+    double latestSampleAge;  // ms before this call
+};
+
+// Gaze throughput counters, read by JavaScript through the heap; the
+// per-frame sample age at the latch is in latchTimingLog()
+extern "C" EMSCRIPTEN_KEEPALIVE const GazeStats* gazeStats() {
+    static GazeStats stats;
+    stats.socketSamples = socketGazeDecoder.sampleCount();
+    stats.syntheticEmitted = syntheticGaze.emitted();
+    stats.syntheticDecoded = syntheticGazeDecoder.sampleCount();
+    stats.skippedBytes = socketGazeDecoder.skippedBytes() + syntheticGazeDecoder.skippedBytes();
+    double latest = latestGazeTime.load(std::memory_order_relaxed);
+    stats.latestSampleTime = latest;
+    stats.latestSampleAge = latest > 0.0 ? emscripten_get_now() - latest : 0.0;
+    return &stats;
+}
+
+// A response with an explicit emscripten_get_now() timestamp, for scripted
+// input; InputType for `type`. False when the input queue is full.
+extern "C" EMSCRIPTEN_KEEPALIVE bool injectResponse(uint32_t type, uint32_t code, double time) {
+    InputEvent input = {};
+    input.time = time;
+    input.type = type;
+    input.code = code;
+    input.source = static_cast<uint32_t>(InputSource::Injected);
+    return inputQueue.tryPush(input);
+}
+
+// Answer every onset with a key press after meanReactionTime +- jitter ms,
+// for running experiments headless
+extern "C" EMSCRIPTEN_KEEPALIVE void setMockResponder(bool enabled, double meanReactionTime, double jitter,
+                                                      uint32_t seed, uint32_t keyCode) {
+    onRenderThread([=] { mockResponder.configure(enabled, meanReactionTime, jitter, seed, keyCode); });
+}
+
+// Retained responses with their reaction times, oldest first; `count`
+// receives how many and `dropped` how many were lost to a full queue
+extern "C" EMSCRIPTEN_KEEPALIVE const Response* responseLogEntries(uint32_t* count, uint32_t* dropped) {
+    static std::vector<Response> responses;
+    onRenderThread([] {
+        responses.resize(responseLog.size());
+        for (size_t i = 0; i < responses.size(); ++i) {
+            responses[i] = responseLog.at(i);
+        }
+    });
+    *count = static_cast<uint32_t>(responses.size());
+    *dropped = static_cast<uint32_t>(droppedInputs.load(std::memory_order_relaxed));
+    return responses.data();
+}
+
+// Frame-interval jitter over the retained timeline, read by JavaScript
+// through the heap; compare builds with and without RENDER_ON_WORKER
+extern "C" EMSCRIPTEN_KEEPALIVE const JitterStats* frameJitterStats() {
+    static JitterStats stats;
+    onRenderThread([] { stats = frameTimeline.jitterStats(); });
+    return &stats;
+}
+
+// Hash every rendered frame on the GPU and log it with its vsync time
+extern "C" EMSCRIPTEN_KEEPALIVE void setFrameHashing(bool enabled) {
+    onRenderThread([=] { frameHashing = enabled; });
+}
+
+// Logged hashes, oldest first, as FrameHasher::Record structs; `count`
+// receives how many. Frames skipped because nothing changed have no entry.
+extern "C" EMSCRIPTEN_KEEPALIVE const FrameHasher::Record* frameHashLog(uint32_t* count) {
+    static std::vector<FrameHasher::Record> records;
+    onRenderThread([] {
+        records.resize(frameHasher.size());
+        for (size_t i = 0; i < records.size(); ++i) {
+            records[i] = frameHasher.at(i);
+        }
+    });
+    *count = static_cast<uint32_t>(records.size());
+    return records.data();
+}
+
+// Hash an expected 8-bit frame the same way the GPU does, into `hash`
+extern "C" EMSCRIPTEN_KEEPALIVE void contentHashImage(const uint8_t* rgba, uint32_t width, uint32_t height,
+                                                      uint64_t* hash) {
+    *hash = contentHash(rgba, width, height);
+}
+
+// Compare a rendered frame with its golden image using the default
+// tolerances. `diff` receives the metrics; on failure a heatmap is written
+// to `heatmap` if it is not null. Returns whether the frame passed. The
+// native harness in tests/GoldenTest.cpp applies the same check to the CPU
+// references of the shaders.
+extern "C" EMSCRIPTEN_KEEPALIVE bool compareGoldenImage(const uint8_t* actual, const uint8_t* expected, uint32_t width,
+                                                        uint32_t height, ImageDiff* diff, uint8_t* heatmap) {
+    *diff = compareImages(actual, expected, width, height);
+    bool passed = diffPasses(*diff, DiffTolerance());
+    if (!passed && heatmap) {
+        diffHeatmap(actual, expected, width, height, 16, heatmap);
+    }
+    return passed;
+}
+
+// Create the surface and request the device. The renderer, its GPU objects
+// and the animation frame loop all live on the calling thread.
+bool startRenderer() {
     // Create a WGPUInstance
     WGPUInstanceDescriptor instanceDesc = {};
     WGPUInstance instance = wgpuCreateInstance(&instanceDesc);
@@ -219,7 +2268,7 @@ int main() {
     // Create surface from canvas
     WGPUSurfaceDescriptorFromCanvasHTMLSelector canvDesc = {};
     canvDesc.chain.sType = WGPUSType_SurfaceDescriptorFromCanvasHTMLSelector;
-    canvDesc.selector = "canvas"; // Removed '#' prefix
+    canvDesc.selector = canvasSelector;
 
     WGPUSurfaceDescriptor surfDesc = {};
     surfDesc.nextInChain = reinterpret_cast<const WGPUChainedStruct*>(&canvDesc);
@@ -227,7 +2276,7 @@ int main() {
     WGPUSurface surface = wgpuInstanceCreateSurface(instance, &surfDesc);
     if (!surface) {
         std::cerr << "Failed to create WebGPU surface." << std::endl;
-        return -1;
+        return false;
     }
 
     // Request adapter
@@ -237,6 +2286,47 @@ int main() {
             onAdapterRequestEnded,
             surface // Pass the surface as userdata
     );
+    return true;
+}
+
+#ifdef RENDER_ON_WORKER
+void* renderThreadMain(void*) {
+    if (startRenderer()) {
+        emscripten_exit_with_live_runtime();
+    }
+    return nullptr;
+}
+#endif
+
+// Entry point
+int main() {
+    // Responses are DOM events, so listen on this thread whichever thread renders
+    emscripten_set_keydown_callback(EMSCRIPTEN_EVENT_TARGET_WINDOW, nullptr, EM_TRUE, onKeyEvent);
+    emscripten_set_keyup_callback(EMSCRIPTEN_EVENT_TARGET_WINDOW, nullptr, EM_TRUE, onKeyEvent);
+    emscripten_set_mousedown_callback(canvasSelector, nullptr, EM_TRUE, onMouseEvent);
+    emscripten_set_mouseup_callback(canvasSelector, nullptr, EM_TRUE, onMouseEvent);
+
+#ifdef RENDER_ON_WORKER
+    // Hand the canvas to a dedicated thread so DOM work, GC and page scripts
+    // on the main thread cannot delay frames
+    double canvasWidth, canvasHeight;
+    emscripten_get_element_css_size(canvasSelector, &canvasWidth, &canvasHeight);
+    emscripten_set_canvas_element_size(canvasSelector, static_cast<int>(canvasWidth), static_cast<int>(canvasHeight));
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    emscripten_pthread_attr_settransferredcanvases(&attr, canvasSelector);
+    int error = pthread_create(&renderThread, &attr, renderThreadMain, nullptr);
+    pthread_attr_destroy(&attr);
+    if (error != 0) {
+        std::cerr << "Failed to start the render thread." << std::endl;
+        return -1;
+    }
+#else
+    if (!startRenderer()) {
+        return -1;
+    }
+#endif
 
     // Run the Emscripten main loop
     emscripten_set_main_loop([](){}, 0, 0);
@@ -0,0 +1,93 @@
+#include "Check.h"
+
+#include <cmath>
+#include <vector>
+
+#include "Calibration.h"
+
+namespace {
+
+// Readings of a display following `model`, at `count` evenly spaced levels
+std::vector<PhotometerSample> measure(double (*model)(double), size_t count) {
+    std::vector<PhotometerSample> samples(count);
+    for (size_t i = 0; i < count; ++i) {
+        double level = double(i) / double(count - 1);
+        samples[i] = { level, model(level) };
+    }
+    return samples;
+}
+
+// Largest deviation of model(LUT(t)) from a straight line between the
+// model's end luminances, relative to the luminance range
+double linearityError(const std::vector<float>& lut, uint32_t size, int channel, double (*model)(double)) {
+    double low = model(0.0);
+    double high = model(1.0);
+    double worst = 0.0;
+    for (uint32_t i = 0; i <= 64; ++i) {
+        float t = float(i) / 64.0f;
+        const float in[3] = { t, t, t };
+        float out[3];
+        applyLut1d(lut.data(), size, in, out);
+        double expected = low + (high - low) * t;
+        worst = std::max(worst, std::abs(model(out[channel]) - expected) / (high - low));
+    }
+    return worst;
+}
+
+double redDisplay(double v) { return 0.3 + 24.0 * std::pow(v, 2.4); }
+double greenDisplay(double v) { return 0.5 + 80.0 * std::pow(v, 2.1); }
+double blueDisplay(double v) { return 0.2 + 9.0 * std::pow(v, 2.6); }
+
+// Not a power law: a soft S-curve, as on displays with a contrast enhancement
+double sCurveDisplay(double v) { return 1.0 + 99.0 * (3.0 * v * v - 2.0 * v * v * v); }
+
+} // namespace
+
+// Readings from known gamma displays: the fit recovers the parameters and
+// the LUT built from it linearizes the display
+TEST(calibrationGammaRoundTrip) {
+    double (*models[3])(double) = { redDisplay, greenDisplay, blueDisplay };
+    const double gammas[3] = { 2.4, 2.1, 2.6 };
+    std::vector<PhotometerSample> readings[3];
+    const PhotometerSample* channels[3];
+    for (int c = 0; c < 3; ++c) {
+        readings[c] = measure(models[c], 17);
+        channels[c] = readings[c].data();
+    }
+
+    GammaFit fits[3];
+    std::vector<float> lut = calibrateChannels(channels, 17, CalibrationModel::Gamma, 1024, fits);
+    CHECK(lut.size() == 1024 * 4);
+    for (int c = 0; c < 3; ++c) {
+        CHECK(std::abs(fits[c].gamma - gammas[c]) < 1e-3);
+        CHECK(std::abs(fits[c].minLuminance - models[c](0.0)) < 1e-3);
+        CHECK(std::abs(fits[c].maxLuminance - models[c](1.0)) < 1e-3);
+        CHECK(fits[c].rmsError < 1e-3);
+        CHECK(linearityError(lut, 1024, c, models[c]) < 2e-3);
+    }
+}
+
+// The spline path linearizes a display a gamma curve cannot describe
+TEST(calibrationSplineRoundTrip) {
+    std::vector<PhotometerSample> readings = measure(sCurveDisplay, 33);
+    const PhotometerSample* channels[3] = { readings.data(), readings.data(), readings.data() };
+
+    GammaFit fits[3];
+    std::vector<float> lut = calibrateChannels(channels, readings.size(), CalibrationModel::Spline, 1024, fits);
+    CHECK(lut.size() == 1024 * 4);
+    CHECK(std::abs(fits[0].minLuminance - 1.0) < 1e-9);
+    CHECK(std::abs(fits[0].maxLuminance - 100.0) < 1e-9);
+    CHECK(linearityError(lut, 1024, 0, sCurveDisplay) < 5e-3);
+
+    GammaFit gammaFits[3];
+    std::vector<float> gammaLut = calibrateChannels(channels, readings.size(), CalibrationModel::Gamma, 1024, gammaFits);
+    CHECK(linearityError(gammaLut, 1024, 0, sCurveDisplay) > 0.02);
+}
+
+TEST(calibrationRejectsTooFewReadings) {
+    PhotometerSample one = { 0.5, 10.0 };
+    const PhotometerSample* channels[3] = { &one, &one, &one };
+    GammaFit fits[3];
+    CHECK(calibrateChannels(channels, 1, CalibrationModel::Gamma, 256, fits).empty());
+    CHECK(calibrateChannels(channels, 1, CalibrationModel::Spline, 256, fits).empty());
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+// Minimal registry for the native tests and benchmarks. TEST bodies fail
+// through CHECK; BENCH bodies print their figures and may CHECK a floor.
+struct TestCase {
+    const char* name;
+    bool bench;
+    void (*run)();
+};
+
+std::vector<TestCase>& testCases();
+void checkFailed(const char* file, int line, const char* expression);
+
+struct TestRegistration {
+    TestRegistration(const char* name, bool bench, void (*run)()) { testCases().push_back({ name, bench, run }); }
+};
+
+#define TEST_CASE_IMPL(name, bench)                                          \
+    static void name##Body();                                                \
+    static TestRegistration name##Registration(#name, bench, name##Body);    \
+    static void name##Body()
+
+#define TEST(name) TEST_CASE_IMPL(name, false)
+#define BENCH(name) TEST_CASE_IMPL(name, true)
+
+#define CHECK(expression)                                                    \
+    do {                                                                     \
+        if (!(expression)) {                                                 \
+            checkFailed(__FILE__, __LINE__, #expression);                    \
+        }                                                                    \
+    } while (0)
+
+// Wall-clock milliseconds spent in body()
+inline double elapsedMs(const std::function<void()>& body) {
+    auto start = std::chrono::steady_clock::now();
+    body();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
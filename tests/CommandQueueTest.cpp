@@ -0,0 +1,134 @@
+#include "Check.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "CommandQueue.h"
+#include "Commands.h"
+
+namespace {
+
+// Producer, batch and position within the batch travel in the command itself
+Command tagged(uint32_t producer, uint32_t batch, uint32_t index, uint32_t size) {
+    Command command = {};
+    command.type = CommandType::SetStimulus;
+    command.flag = producer << 16 | index << 8 | size;
+    command.stimulus.opacity = float(batch);
+    return command;
+}
+
+} // namespace
+
+// Producers push batches of 1 to 8 commands as fast as the ring allows
+// while the consumer drains slices of varying length. Every command
+// arrives exactly once, batches are never interleaved, and each
+// producer's batches arrive in the order pushed.
+TEST(commandQueueMpscStress) {
+    const uint32_t producers = 4;
+    const uint32_t batches = 20000;
+    static MpscQueue<Command, 64> queue;
+
+    std::vector<std::thread> threads;
+    for (uint32_t p = 0; p < producers; ++p) {
+        threads.emplace_back([p] {
+            Command batch[8];
+            for (uint32_t b = 0; b < batches;) {
+                uint32_t size = 1 + (b + p) % 8;
+                for (uint32_t i = 0; i < size; ++i) {
+                    batch[i] = tagged(p, b, i, size);
+                }
+                if (queue.tryPush(batch, size)) {
+                    ++b;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    uint64_t expected = 0;
+    for (uint32_t p = 0; p < producers; ++p) {
+        for (uint32_t b = 0; b < batches; ++b) {
+            expected += 1 + (b + p) % 8;
+        }
+    }
+
+    // Drain until everything arrived, giving up after a generous deadline
+    // if commands were lost
+    std::vector<uint32_t> nextBatch(producers, 0);
+    uint64_t received = 0;
+    uint32_t errors = 0;
+    bool inBatch = false;
+    uint32_t currentProducer = 0, currentBatch = 0, currentIndex = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (received < expected && std::chrono::steady_clock::now() < deadline) {
+        size_t drained = queue.drain([&](const Command& command) {
+            uint32_t producer = command.flag >> 16, index = command.flag >> 8 & 0xFF, size = command.flag & 0xFF;
+            uint32_t batch = uint32_t(command.stimulus.opacity);
+            received++;
+            if (producer >= producers) {
+                errors++;
+                return;
+            }
+            if (!inBatch) {
+                errors += index != 0 || batch != nextBatch[producer];
+                inBatch = true;
+            } else {
+                errors += producer != currentProducer || batch != currentBatch || index != currentIndex + 1;
+            }
+            currentProducer = producer;
+            currentBatch = batch;
+            currentIndex = index;
+            if (index + 1 == size) {
+                inBatch = false;
+                nextBatch[producer] = batch + 1;
+            }
+        }, 1 + received % 13);
+        if (drained == 0) {
+            std::this_thread::yield();
+        }
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    CHECK(errors == 0);
+    CHECK(received == expected);
+    CHECK(queue.drain([](const Command&) {}) == 0);
+}
+
+TEST(commandQueueRejectsWhole) {
+    static MpscQueue<Command, 8> queue;
+    Command batch[8] = {};
+    CHECK(queue.tryPush(batch, 5));
+    CHECK(!queue.tryPush(batch, 4)); // only three cells left: nothing is queued
+    CHECK(queue.tryPush(batch, 3));
+    CHECK(!queue.tryPush(batch[0]));
+    CHECK(queue.drain([](const Command&) {}) == 8);
+    CHECK(!queue.tryPush(batch, 9));
+    CHECK(queue.tryPush(batch, 8));
+}
+
+TEST(commandQueueSpsc) {
+    static SpscQueue<uint32_t, 256> queue;
+    const uint32_t count = 1000000;
+    std::thread producer([] {
+        for (uint32_t i = 0; i < count;) {
+            uint32_t batch[3] = { i, i + 1, i + 2 };
+            uint32_t size = std::min(3u, count - i);
+            if (queue.tryPush(batch, size)) {
+                i += size;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    uint32_t next = 0, errors = 0;
+    while (next < count) {
+        if (queue.drain([&](uint32_t value) { errors += value != next++; }) == 0) {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    CHECK(errors == 0);
+}
@@ -0,0 +1,147 @@
+#include "Check.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "ContentHash.h"
+
+namespace {
+
+// mix32 as the shader source spells it: the statements of its body, each
+// `h ^= h >> N;` or `h *= K;`, run in order
+struct ShaderMix {
+    struct Step {
+        bool multiply;
+        uint32_t operand;
+    };
+    std::vector<Step> steps;
+
+    ShaderMix() {
+        std::string code = contentHashShaderCode;
+        size_t begin = code.find("fn mix32(");
+        size_t end = code.find("return h;", begin);
+        if (begin == std::string::npos || end == std::string::npos) {
+            return;
+        }
+        for (size_t line = code.find('\n', begin) + 1; line < end; line = code.find('\n', line) + 1) {
+            std::string statement = code.substr(line, code.find('\n', line) - line);
+            size_t xorShift = statement.find("h ^= h >> ");
+            size_t multiply = statement.find("h *= ");
+            if (xorShift != std::string::npos) {
+                steps.push_back({ false, uint32_t(std::strtoul(statement.c_str() + xorShift + 10, nullptr, 0)) });
+            } else if (multiply != std::string::npos) {
+                steps.push_back({ true, uint32_t(std::strtoul(statement.c_str() + multiply + 5, nullptr, 0)) });
+            }
+        }
+    }
+
+    uint32_t operator()(uint32_t h) const {
+        for (const Step& step : steps) {
+            h = step.multiply ? h * step.operand : h ^ (h >> step.operand);
+        }
+        return h;
+    }
+};
+
+// One pixel after another on this thread, with the packing and mixing
+// the shader's main() spells out
+uint64_t referenceHash(const ShaderMix& mix, const uint8_t* rgba, uint32_t width, uint32_t height) {
+    uint32_t low = 0;
+    uint32_t high = 0;
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            const uint8_t* c = rgba + (size_t(y) * width + x) * 4;
+            uint32_t word = c[0] | (c[1] << 8u) | (c[2] << 16u) | (uint32_t(c[3]) << 24u);
+            uint32_t index = y * width + x;
+            low += mix(word ^ mix(index));
+            high += mix(word + mix(index ^ 0x9e3779b9u));
+        }
+    }
+    return uint64_t(high) << 32 | low;
+}
+
+std::vector<uint8_t> randomImage(uint32_t width, uint32_t height, uint32_t seed) {
+    std::mt19937 random(seed);
+    std::vector<uint8_t> rgba(size_t(width) * height * 4);
+    for (uint8_t& byte : rgba) {
+        byte = uint8_t(random());
+    }
+    return rgba;
+}
+
+} // namespace
+
+// The reference above is what the shader computes: its mix32 parses into
+// the five expected steps and main() packs and combines as the reference
+// does. referenceHash() stands in for the shader in the tests below.
+TEST(contentHashShaderMatchesReference) {
+    ShaderMix mix;
+    CHECK(mix.steps.size() == 5);
+    std::string code = contentHashShaderCode;
+    for (const char* line : { "let word = c.r | (c.g << 8u) | (c.b << 16u) | (c.a << 24u);",
+                              "let index = id.y * size.x + id.x;",
+                              "atomicAdd(&partial[0], mix32(word ^ mix32(index)));",
+                              "atomicAdd(&partial[1], mix32(word + mix32(index ^ 0x9e3779b9u)));" }) {
+        CHECK(code.find(line) != std::string::npos);
+    }
+
+    CHECK(mix(0) == 0 && mix(1) != 1);
+    std::vector<uint8_t> pixel = { 1, 2, 3, 4 };
+    CHECK(contentHash(pixel.data(), 1, 1) == referenceHash(mix, pixel.data(), 1, 1));
+}
+
+// Every stripe count gives the single-threaded result, including more
+// stripes than pixels and sizes that do not split evenly
+TEST(contentHashStripesMatchReference) {
+    ShaderMix mix;
+    const uint32_t sizes[5][2] = { { 1, 1 }, { 7, 3 }, { 255, 257 }, { 256, 256 }, { 1920, 1080 } };
+    for (const auto& size : sizes) {
+        std::vector<uint8_t> rgba = randomImage(size[0], size[1], size[0] + size[1]);
+        uint64_t expected = referenceHash(mix, rgba.data(), size[0], size[1]);
+        CHECK(contentHash(rgba.data(), size[0], size[1]) == expected);
+        for (size_t stripes : { 1, 2, 3, 7, 16, 64 }) {
+            CHECK(contentHash(rgba.data(), size[0], size[1], stripes) == expected);
+        }
+    }
+}
+
+// Every single-bit change of any pixel gives a hash of its own, and
+// swapping two different pixels changes the hash
+TEST(contentHashSeesChanges) {
+    const uint32_t width = 64, height = 48;
+    std::vector<uint8_t> rgba = randomImage(width, height, 41);
+    uint64_t original = contentHash(rgba.data(), width, height);
+    std::set<uint64_t> hashes = { original };
+    std::mt19937 random(7);
+
+    for (size_t i = 0; i < rgba.size(); ++i) {
+        for (uint32_t bit = 0; bit < 8; ++bit) {
+            rgba[i] ^= uint8_t(1u << bit);
+            hashes.insert(contentHash(rgba.data(), width, height));
+            rgba[i] ^= uint8_t(1u << bit);
+        }
+    }
+    CHECK(hashes.size() == rgba.size() * 8 + 1);
+
+    for (uint32_t i = 0; i < 500; ++i) {
+        size_t a = random() % (width * height), b = random() % (width * height);
+        if (std::memcmp(&rgba[a * 4], &rgba[b * 4], 4) == 0) {
+            continue;
+        }
+        std::vector<uint8_t> moved = rgba;
+        std::swap_ranges(&moved[a * 4], &moved[a * 4 + 4], &moved[b * 4]);
+        CHECK(contentHash(moved.data(), width, height) != original);
+    }
+
+    // A lone dot moved by one pixel on a blank frame
+    std::vector<uint8_t> dot(width * height * 4, 0);
+    dot[(5 * width + 5) * 4] = 255;
+    uint64_t before = contentHash(dot.data(), width, height);
+    std::swap(dot[(5 * width + 5) * 4], dot[(5 * width + 6) * 4]);
+    CHECK(contentHash(dot.data(), width, height) != before);
+}
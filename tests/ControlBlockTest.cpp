@@ -0,0 +1,94 @@
+#include "Check.h"
+
+#include <cstring>
+#include <vector>
+
+#include "CommandQueue.h"
+#include "ControlBlock.h"
+
+namespace {
+
+// A SetStimulus record as FlasherControl.setStimulus() writes it
+ControlRecord stimulusRecord(float x, float opacity) {
+    ControlRecord record = {};
+    record.type = static_cast<uint32_t>(CommandType::SetStimulus);
+    StimulusCommand stimulus = {};
+    stimulus.transform[0] = stimulus.transform[5] = stimulus.transform[10] = stimulus.transform[15] = 1.0f;
+    stimulus.transform[12] = x;
+    stimulus.opacity = opacity;
+    stimulus.luminance = 0.5f;
+    std::memcpy(record.payload, &stimulus, sizeof(stimulus));
+    return record;
+}
+
+} // namespace
+
+TEST(controlBlockDecodes) {
+    ControlRecord records[4] = { stimulusRecord(0.25f, 0.75f) };
+    records[1].type = static_cast<uint32_t>(CommandType::SetOutputMode);
+    records[1].flag = 1;
+    records[1].payload[0] = static_cast<uint32_t>(OutputMode::Dither);
+    records[2].type = static_cast<uint32_t>(CommandType::Callback); // JS has no function pointers
+    records[3].type = static_cast<uint32_t>(CommandType::SetOutputMode);
+    records[3].payload[0] = 9;
+
+    Command commands[4];
+    uint32_t rejected = 0;
+    CHECK(decodeControlRecords(records, 4, commands, &rejected) == 2);
+    CHECK(rejected == 2);
+    CHECK(commands[0].type == CommandType::SetStimulus);
+    CHECK(commands[0].stimulus.transform[12] == 0.25f && commands[0].stimulus.opacity == 0.75f);
+    CHECK(commands[1].type == CommandType::SetOutputMode && commands[1].flag == 1);
+    CHECK(commands[1].output.mode == OutputMode::Dither);
+}
+
+// 10k parameter updates per second at 60 Hz, as one exported call per
+// update against records written into the block and submitted once per
+// frame. This cannot show what the batch is for: natively there is no
+// wasm/JS boundary, so only the C++ side is timed, and there the batch
+// pays for decoding the records and comes out slower. The crossings it
+// saves are printed as the counts each scheme implies, not measured.
+BENCH(controlBlockPerCallVsBatch) {
+    const uint32_t updatesPerSecond = 10000;
+    const uint32_t frames = 60 * 20;
+    const uint32_t perFrame = updatesPerSecond / 60 + 1;
+    static MpscQueue<Command, 1024> queue;
+    static ControlBlock block;
+    static Command decoded[kControlCapacity];
+    uint64_t applied = 0;
+    auto apply = [&](const Command& command) { applied += command.stimulus.opacity > 0.0f; };
+
+    double perCallMs = elapsedMs([&] {
+        for (uint32_t frame = 0; frame < frames; ++frame) {
+            for (uint32_t i = 0; i < perFrame; ++i) {
+                // What pushCommands() receives from a per-update export
+                Command command = {};
+                command.type = CommandType::SetStimulus;
+                command.stimulus.transform[12] = float(i);
+                command.stimulus.opacity = 1.0f;
+                CHECK(queue.tryPush(command));
+            }
+            queue.drain(apply);
+        }
+    });
+
+    double batchMs = elapsedMs([&] {
+        for (uint32_t frame = 0; frame < frames; ++frame) {
+            for (uint32_t i = 0; i < perFrame; ++i) {
+                block.records[block.count++] = stimulusRecord(float(i), 1.0f);
+            }
+            // What submitControlBlock() does
+            size_t count = decodeControlRecords(block.records, block.count, decoded, &block.rejected);
+            CHECK(queue.tryPush(decoded, count));
+            block.count = 0;
+            queue.drain(apply);
+        }
+    });
+
+    double seconds = frames / 60.0;
+    std::printf("  per call: %7.1f us/s of C++ work; would cross into wasm %u times/s (not timed)\n",
+                perCallMs * 1000.0 / seconds, perFrame * 60);
+    std::printf("  batch:    %7.1f us/s of C++ work; would cross into wasm 60 times/s (not timed)\n",
+                batchMs * 1000.0 / seconds);
+    CHECK(applied == 2ull * frames * perFrame);
+}
@@ -0,0 +1,55 @@
+#include "Check.h"
+
+#include "DamageTracker.h"
+
+// NDC boxes land on the pixels they cover plus the padding, clamped to the
+// target, and the damage grows to the union of everything invalidated
+TEST(damageTrackerNdcToPixels) {
+    DamageTracker damage;
+    damage.resize(200, 100);
+    CHECK(damage.dirty() && damage.bounds().area() == 200 * 100);
+    damage.clear();
+    CHECK(!damage.dirty());
+
+    // x -0.5..0 is pixels 50..100, y 0..0.5 is rows 25..50
+    damage.invalidateNdc(-0.5f, 0.0f, 0.0f, 0.5f);
+    PixelRect rect = damage.bounds();
+    CHECK(rect.x == 49 && rect.y == 24 && rect.width == 52 && rect.height == 27);
+
+    damage.clear();
+    damage.invalidateNdc(-0.5f, 0.0f, 0.0f, 0.5f, 10.0f);
+    rect = damage.bounds();
+    CHECK(rect.x == 40 && rect.y == 15 && rect.width == 70 && rect.height == 45);
+
+    damage.invalidateNdc(0.9f, -1.5f, 1.5f, -0.9f);
+    rect = damage.bounds();
+    CHECK(rect.x == 40 && rect.y == 15 && rect.x + rect.width == 200 && rect.y + rect.height == 100);
+    CHECK(damage.full()); // more than half the target
+
+    // Off the target entirely leaves the damage as it was
+    damage.clear();
+    damage.invalidateNdc(1.5f, 1.5f, 2.0f, 2.0f);
+    CHECK(!damage.dirty());
+}
+
+// What a late-latched placement needs: a footprint that moved less than
+// the padding of the damage it was built with still fits, one that moved
+// further does not
+TEST(damageTrackerContainsNdc) {
+    DamageTracker damage;
+    damage.resize(1920, 1080);
+    damage.clear();
+    CHECK(!damage.containsNdc(-0.1f, -0.1f, 0.1f, 0.1f));
+    CHECK(damage.containsNdc(1.5f, 1.5f, 2.0f, 2.0f)); // nothing on the target to draw
+
+    damage.invalidateNdc(-0.1f, -0.1f, 0.1f, 0.1f, 32.0f);
+    CHECK(damage.containsNdc(-0.1f, -0.1f, 0.1f, 0.1f));
+    float step = 30.0f * 2.0f / 1920.0f; // 30 pixels to the right
+    CHECK(damage.containsNdc(-0.1f + step, -0.1f, 0.1f + step, 0.1f));
+    step = 40.0f * 2.0f / 1920.0f;
+    CHECK(!damage.containsNdc(-0.1f + step, -0.1f, 0.1f + step, 0.1f));
+    CHECK(!damage.containsNdc(-0.1f, -0.5f, 0.1f, 0.1f));
+
+    damage.invalidateAll();
+    CHECK(damage.containsNdc(-1.0f, -1.0f, 1.0f, 1.0f) && damage.full());
+}
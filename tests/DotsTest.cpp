@@ -0,0 +1,151 @@
+#include "Check.h"
+
+#include <cmath>
+#include <vector>
+
+#include "Dots.h"
+#include "Noise.h"
+
+namespace {
+
+DotUniforms dotParams(uint32_t count, float coherence, uint32_t lifetime) {
+    DotUniforms p = {};
+    p.count = count;
+    p.seed = 17;
+    p.lifetime = lifetime;
+    p.coherence = coherence;
+    p.direction = 0.7f;
+    p.speed = 0.01f;
+    return p;
+}
+
+// Run `frames` steps after the reset frame
+void run(DotFieldCpu& field, DotUniforms p, uint32_t frames) {
+    p.reset = 1;
+    field.step(p);
+    p.reset = 0;
+    for (uint32_t frame = 1; frame <= frames; ++frame) {
+        p.frame = frame;
+        field.step(p);
+    }
+}
+
+// One dot at a time, as the compute shader states the update; the hash
+// stream and constant match Dots.cpp
+void referenceStep(std::vector<Dot>& dots, const DotUniforms& p) {
+    const uint32_t stream = 0xD07D07u;
+    const float tau = 6.28318530717958647692f;
+    auto unorm = [](uint32_t h) { return float(h >> 8) * (1.0f / 16777216.0f); };
+    auto wrap = [](float v) { return v - 2.0f * std::floor((v + 1.0f) * 0.5f); };
+    for (uint32_t i = 0; i < dots.size(); ++i) {
+        Dot& d = dots[i];
+        NoiseHash h = noiseHash(i, p.frame, p.seed, stream);
+        if (p.reset) {
+            d = { unorm(h.x) * 2.0f - 1.0f, unorm(h.y) * 2.0f - 1.0f, p.lifetime > 0 ? h.z % p.lifetime : 0, 0 };
+        } else if (p.lifetime > 0 && d.age + 1 >= p.lifetime) {
+            d = { unorm(h.x) * 2.0f - 1.0f, unorm(h.y) * 2.0f - 1.0f, 0, 0 };
+        } else {
+            bool isCoherent = unorm(h.z) < p.coherence;
+            float angle = isCoherent ? p.direction : unorm(h.w) * tau;
+            d = { wrap(d.x + std::cos(angle) * p.speed), wrap(d.y + std::sin(angle) * p.speed), d.age + 1,
+                  isCoherent ? 1u : 0u };
+        }
+    }
+}
+
+} // namespace
+
+// DotFieldCpu runs four dots at a time where wasm SIMD is enabled and the
+// rest one at a time; nativeSimdTests builds that path. Either way every
+// dot matches the one-at-a-time reference exactly, frame after frame,
+// including the tail that does not fill a vector.
+TEST(dotsStepMatchesReference) {
+    for (uint32_t count : { 1u, 4u, 1023u }) {
+        for (uint32_t lifetime : { 0u, 7u }) {
+            DotFieldCpu field(count);
+            std::vector<Dot> expected(count);
+            DotUniforms p = dotParams(count, 0.4f, lifetime);
+            bool same = true;
+            for (uint32_t frame = 0; frame <= 20; ++frame) {
+                p.frame = frame;
+                p.reset = frame == 0;
+                field.step(p);
+                referenceStep(expected, p);
+                for (uint32_t i = 0; i < count; ++i) {
+                    Dot dot = field.dot(i);
+                    same = same && dot.x == expected[i].x && dot.y == expected[i].y && dot.age == expected[i].age &&
+                           dot.coherent == expected[i].coherent;
+                }
+            }
+            CHECK(same);
+        }
+    }
+}
+
+// Every surviving dot joins the signal with probability `coherence`;
+// the 1 / lifetime of dots replotted each frame count as incoherent
+TEST(dotsCoherenceFraction) {
+    const uint32_t count = 100000;
+    for (float coherence : { 0.0f, 0.1f, 0.5f, 1.0f }) {
+        DotFieldCpu field(count);
+        run(field, dotParams(count, coherence, 20), 30);
+        double expected = coherence * (1.0 - 1.0 / 20.0);
+        CHECK(std::abs(field.coherentFraction() - expected) < 0.01);
+    }
+}
+
+// Staggered ages at onset stay uniform over [0, lifetime), so a fixed
+// share of dots is replotted every frame instead of all at once
+TEST(dotsLifetimeDistribution) {
+    const uint32_t count = 100000;
+    const uint32_t lifetime = 10;
+    DotFieldCpu field(count);
+    DotUniforms p = dotParams(count, 0.5f, lifetime);
+    for (uint32_t frames : { 0u, 1u, 7u, 45u }) {
+        run(field, p, frames);
+        std::vector<uint32_t> histogram = field.ageHistogram(lifetime + 1);
+        CHECK(histogram[lifetime] == 0);
+        for (uint32_t age = 0; age < lifetime; ++age) {
+            CHECK(std::abs(double(histogram[age]) - count / double(lifetime)) < 0.05 * count / lifetime);
+        }
+    }
+}
+
+// Coherent dots step exactly along the signal direction, noise dots in
+// directions that average out, and everything stays in the wrapped field
+TEST(dotsMotion) {
+    const uint32_t count = 50000;
+    DotFieldCpu field(count);
+    DotUniforms p = dotParams(count, 0.3f, 0);
+    run(field, p, 5);
+
+    std::vector<Dot> before(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        before[i] = field.dot(i);
+    }
+    p.frame = 6;
+    field.step(p);
+
+    double noiseX = 0.0, noiseY = 0.0;
+    uint32_t noiseDots = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        Dot dot = field.dot(i);
+        CHECK(dot.x >= -1.0f && dot.x < 1.0f && dot.y >= -1.0f && dot.y < 1.0f);
+        float dx = dot.x - before[i].x;
+        float dy = dot.y - before[i].y;
+        if (std::abs(dx) > 1.0f || std::abs(dy) > 1.0f) {
+            continue; // wrapped at the field edge
+        }
+        if (dot.coherent) {
+            CHECK(std::abs(dx - std::cos(p.direction) * p.speed) < 1e-5f);
+            CHECK(std::abs(dy - std::sin(p.direction) * p.speed) < 1e-5f);
+        } else {
+            CHECK(std::abs(std::hypot(dx, dy) - p.speed) < 1e-5f);
+            noiseX += dx;
+            noiseY += dy;
+            noiseDots++;
+        }
+    }
+    CHECK(std::abs(noiseX / noiseDots) < 0.05 * p.speed);
+    CHECK(std::abs(noiseY / noiseDots) < 0.05 * p.speed);
+}
@@ -0,0 +1,67 @@
+#include "Check.h"
+
+#include <cmath>
+#include <vector>
+
+#include "Filter.h"
+
+TEST(filterKernelNormalized) {
+    for (float sigma : { 0.5f, 1.0f, 3.3f, 10.0f, 40.0f }) {
+        FilterUniforms params = {};
+        setGaussianKernel(params, sigma);
+        CHECK(params.radius <= kFilterMaxRadius);
+        double sum = params.weights[0];
+        for (uint32_t i = 1; i <= params.radius; ++i) {
+            sum += 2.0 * params.weights[i];
+            CHECK(params.weights[i] <= params.weights[i - 1]);
+        }
+        CHECK(std::abs(sum - 1.0) < 1e-5);
+    }
+}
+
+// Flat fields pass the low-pass unchanged and come out of the high-pass
+// at the offset; an impulse spreads into the outer product of the kernel
+TEST(filterReference) {
+    const uint32_t size = 33;
+    std::vector<float> flat(size * size * 4, 0.6f);
+    std::vector<float> low = filterImage(flat.data(), size, size, FilterType::LowPass, 2.0f, 0.0f);
+    std::vector<float> high = filterImage(flat.data(), size, size, FilterType::HighPass, 2.0f, 0.5f);
+    for (size_t i = 0; i < low.size(); i += 4) {
+        CHECK(std::abs(low[i] - 0.6f) < 1e-5f);
+        CHECK(std::abs(high[i] - 0.5f) < 1e-5f);
+        CHECK(high[i + 3] == 0.6f);
+    }
+
+    std::vector<float> impulse(size * size * 4, 0.0f);
+    impulse[(16 * size + 16) * 4] = 1.0f;
+    std::vector<float> spread = filterImage(impulse.data(), size, size, FilterType::LowPass, 2.0f, 0.0f);
+    FilterUniforms params = {};
+    setGaussianKernel(params, 2.0f);
+    for (int dy = -3; dy <= 3; ++dy) {
+        for (int dx = -3; dx <= 3; ++dx) {
+            float expected = params.weights[std::abs(dx)] * params.weights[std::abs(dy)];
+            CHECK(std::abs(spread[((16 + dy) * size + 16 + dx) * 4] - expected) < 1e-6f);
+        }
+    }
+}
+
+// Throughput of the CPU reference by kernel radius, next to the texel
+// fetches per output texel and pass that the GPU's tiled passes make from
+// memory (one tile plus its apron) against a direct convolution
+BENCH(filterThroughputByRadius) {
+    const uint32_t size = 512;
+    std::vector<float> image(size * size * 4);
+    for (size_t i = 0; i < image.size(); ++i) {
+        image[i] = float(i * 2654435761u >> 24) / 255.0f;
+    }
+
+    for (uint32_t radius : { 2u, 4u, 8u, 16u, 32u, 64u }) {
+        float sigma = float(radius) / 3.0f;
+        std::vector<float> out;
+        double ms = elapsedMs([&] { out = filterImage(image.data(), size, size, FilterType::LowPass, sigma, 0.0f); });
+        double tiled = double(kFilterTileSize + 2 * radius) / kFilterTileSize;
+        std::printf("  radius %2u: %7.2f MP/s (CPU reference), fetches per texel and pass %.2f tiled vs %u direct\n",
+                    radius, double(size) * size / (ms * 1000.0), tiled, 2 * radius + 1);
+        CHECK(!out.empty());
+    }
+}
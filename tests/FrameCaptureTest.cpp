@@ -0,0 +1,148 @@
+#include "Check.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "FrameCapture.h"
+
+namespace {
+
+// A BGRA texture whose texels encode their position and the frame
+wgpu::Texture frameTexture(uint32_t width, uint32_t height, uint32_t frame) {
+    wgpu::Texture texture;
+    texture.width = width;
+    texture.height = height;
+    texture.texels = std::make_shared<std::vector<uint8_t>>(size_t(width) * height * 4);
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            uint8_t* texel = texture.texels->data() + (size_t(y) * width + x) * 4;
+            texel[0] = uint8_t(frame); // blue
+            texel[1] = uint8_t(x);
+            texel[2] = uint8_t(y); // red
+            texel[3] = 255;
+        }
+    }
+    return texture;
+}
+
+// What the render loop does for one frame
+bool captureFrame(FrameCapture& capture, uint64_t frameIndex, const wgpu::Texture& texture) {
+    if (!capture.begin(frameIndex, frameIndex * 10.0, texture.width, texture.height)) {
+        return false;
+    }
+    wgpu::CommandEncoder encoder;
+    capture.encodeCopy(encoder, texture);
+    capture.submitted();
+    return true;
+}
+
+bool waitForDelivered(const FrameCapture& capture, uint64_t delivered) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (capture.stats().delivered < delivered) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+} // namespace
+
+// Frames go through copy, map and the worker, and reach the consumer in
+// order as RGBA without the row padding (70 texels is 280 of 512 bytes)
+TEST(frameCaptureDeliversFrames) {
+    wgpu::Device device;
+    FrameCapture capture;
+    capture.init(device, 3, 32); // room for every frame however slow the worker starts
+    capture.setInterval(2);
+
+    std::mutex mutex;
+    std::vector<FrameCapture::Frame> frames;
+    capture.setConsumer([&](const FrameCapture::Frame& frame) {
+        std::lock_guard<std::mutex> lock(mutex);
+        frames.push_back(frame);
+    });
+
+    const uint32_t width = 70, height = 5;
+    uint32_t captured = 0;
+    for (uint32_t i = 0; i < 40; ++i) {
+        captured += captureFrame(capture, i, frameTexture(width, height, i));
+        // The GPU finishes one frame later
+        if (device.gpu->maps.size() > 1) {
+            device.gpu->completeOldestMap();
+        }
+    }
+    while (device.gpu->completeOldestMap()) {
+    }
+    CHECK(captured == 20);
+    CHECK(waitForDelivered(capture, 20));
+    capture.shutdown();
+
+    FrameCapture::Stats stats = capture.stats();
+    CHECK(stats.captured == 20 && stats.droppedBusy == 0 && stats.droppedQueue == 0 && stats.failed == 0);
+    CHECK(frames.size() == 20);
+    for (size_t f = 0; f < frames.size(); ++f) {
+        const FrameCapture::Frame& frame = frames[f];
+        CHECK(frame.frameIndex == f * 2 && frame.vsyncTime == f * 20.0);
+        CHECK(frame.width == width && frame.height == height && frame.rgba.size() == size_t(width) * height * 4);
+        bool pixels = true;
+        for (uint32_t y = 0; y < height; ++y) {
+            for (uint32_t x = 0; x < width; ++x) {
+                const uint8_t* p = frame.rgba.data() + (size_t(y) * width + x) * 4;
+                pixels = pixels && p[0] == y && p[1] == x && p[2] == f * 2 && p[3] == 255;
+            }
+        }
+        CHECK(pixels);
+    }
+}
+
+// With every readback buffer still being mapped, begin() returns false at
+// once and counts the drop, while another thread reads the stats as
+// frameCaptureStats() does. Once the GPU catches up capture resumes.
+TEST(frameCaptureFullRingDrops) {
+    wgpu::Device device;
+    FrameCapture capture;
+    capture.init(device, 2);
+    capture.setInterval(1);
+    wgpu::Texture texture = frameTexture(16, 4, 0);
+
+    std::atomic<bool> stop{ false };
+    std::atomic<bool> backwards{ false };
+    std::thread reader([&] {
+        uint64_t last = 0;
+        while (!stop.load()) {
+            FrameCapture::Stats stats = capture.stats();
+            backwards = backwards || stats.droppedBusy < last;
+            last = stats.droppedBusy;
+            std::this_thread::yield();
+        }
+    });
+
+    uint32_t captured = 0;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        captured += captureFrame(capture, i, texture);
+    }
+    stop = true;
+    reader.join();
+    CHECK(!backwards);
+    CHECK(captured == 2);
+    CHECK(device.gpu->maps.size() == 2);
+    FrameCapture::Stats stats = capture.stats();
+    CHECK(stats.captured == 2 && stats.droppedBusy == 998);
+
+    // A failed map frees its buffer too
+    CHECK(device.gpu->completeOldestMap(WGPUBufferMapAsyncStatus_Error));
+    CHECK(device.gpu->completeOldestMap());
+    CHECK(captureFrame(capture, 1000, texture));
+    CHECK(captureFrame(capture, 1001, texture));
+    CHECK(!captureFrame(capture, 1002, texture));
+    while (device.gpu->completeOldestMap()) {
+    }
+    CHECK(waitForDelivered(capture, 3));
+    stats = capture.stats();
+    CHECK(stats.captured == 4 && stats.failed == 1 && stats.droppedBusy == 999);
+}
@@ -0,0 +1,351 @@
+#include "Check.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "FrameEncoder.h"
+#include "Noise.h"
+#include "Procedural.h"
+#include "QoiDecoder.h"
+
+namespace {
+
+// A frame like the ones captured: a grating with a noise patch and flat
+// surround, so runs, small deltas and literal pixels all occur
+std::vector<uint8_t> testFrame(uint32_t width, uint32_t height) {
+    PatternUniforms grating = {};
+    grating.frequency = 12.0f;
+    grating.orientation = 0.6f;
+    grating.contrast = 0.8f;
+    grating.meanLuminance = 0.5f;
+
+    std::vector<uint8_t> rgba(size_t(width) * height * 4);
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            uint8_t* px = &rgba[(size_t(y) * width + x) * 4];
+            uint8_t code = 128;
+            if (x > width / 4 && x < width / 2) {
+                code = uint8_t(std::lround(255.0f * evaluatePattern(grating, float(x) / width, float(y) / height)));
+            } else if (x >= width / 2 && x < 3 * width / 4 && y > height / 4 && y < 3 * height / 4) {
+                code = uint8_t(noiseHash(x / 4, y / 4, 0, 9).x >> 24);
+            }
+            px[0] = code;
+            px[1] = uint8_t(code / 2 + 40);
+            px[2] = uint8_t(255 - code);
+            px[3] = 255;
+        }
+    }
+    return rgba;
+}
+
+uint32_t be32(const std::vector<uint8_t>& data, size_t at) {
+    return uint32_t(data[at]) << 24 | uint32_t(data[at + 1]) << 16 | uint32_t(data[at + 2]) << 8 | data[at + 3];
+}
+
+uint32_t crc32(const uint8_t* data, size_t size) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+// What inflate() saw, so a test can tell how a stream was built
+struct InflateStats {
+    uint32_t storedBlocks = 0;
+    uint32_t emptyStoredBlocks = 0;
+    uint32_t fixedBlocks = 0;
+    uint64_t literals = 0;
+    uint64_t matches = 0;
+};
+
+// LSB-first bit reader over a deflate stream; reading past the end fails
+struct BitReader {
+    const std::vector<uint8_t>& data;
+    size_t at;
+    uint32_t bit = 0;
+    bool overrun = false;
+
+    uint32_t get(uint32_t count) {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            if (at >= data.size()) {
+                overrun = true;
+                return 0;
+            }
+            value |= uint32_t(data[at] >> bit & 1) << i;
+            if (++bit == 8) {
+                bit = 0;
+                ++at;
+            }
+        }
+        return value;
+    }
+
+    // Huffman codes are packed starting from their most significant bit
+    uint32_t getCode(uint32_t count) {
+        uint32_t code = 0;
+        for (uint32_t i = 0; i < count; ++i) {
+            code = code << 1 | get(1);
+        }
+        return code;
+    }
+
+    void align() {
+        if (bit != 0) {
+            bit = 0;
+            ++at;
+        }
+    }
+};
+
+// Literal/length symbol of the fixed code (RFC 1951, 3.2.6)
+uint32_t fixedLiteral(BitReader& bits) {
+    uint32_t code = bits.getCode(7);
+    if (code <= 0x17) {
+        return 256 + code;
+    }
+    code = code << 1 | bits.get(1);
+    if (code >= 0x30 && code <= 0xbf) {
+        return code - 0x30;
+    }
+    if (code >= 0xc0 && code <= 0xc7) {
+        return 280 + code - 0xc0;
+    }
+    code = code << 1 | bits.get(1);
+    return 144 + code - 0x190;
+}
+
+// Inflate for the blocks this encoder writes: stored and fixed Huffman.
+// Dynamic Huffman blocks are rejected. `at` starts after the zlib header
+// and ends on the byte after the last block.
+bool inflate(const std::vector<uint8_t>& zlib, size_t& at, std::vector<uint8_t>& out, InflateStats& stats) {
+    static const uint16_t lengthBase[29] = { 3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+                                             31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const uint8_t lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                             2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static const uint16_t distanceBase[30] = { 1,   2,   3,   4,   5,   7,    9,    13,   17,   25,
+                                               33,  49,  65,  97,  129, 193,  257,  385,  513,  769,
+                                               1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static const uint8_t distanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2,  3,  3,  4,  4,  5,  5,  6,
+                                               6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+    BitReader bits{ zlib, at };
+    bool last = false;
+    while (!last) {
+        last = bits.get(1);
+        uint32_t type = bits.get(2);
+        if (type == 0) {
+            bits.align();
+            if (bits.at + 4 > zlib.size()) {
+                return false;
+            }
+            uint32_t length = zlib[bits.at] | uint32_t(zlib[bits.at + 1]) << 8;
+            uint32_t complement = zlib[bits.at + 2] | uint32_t(zlib[bits.at + 3]) << 8;
+            bits.at += 4;
+            if ((length ^ 0xffff) != complement || bits.at + length > zlib.size()) {
+                return false;
+            }
+            out.insert(out.end(), zlib.begin() + bits.at, zlib.begin() + bits.at + length);
+            bits.at += length;
+            stats.storedBlocks++;
+            stats.emptyStoredBlocks += length == 0;
+        } else if (type == 1) {
+            stats.fixedBlocks++;
+            for (;;) {
+                uint32_t symbol = fixedLiteral(bits);
+                if (bits.overrun || symbol > 285) {
+                    return false;
+                }
+                if (symbol < 256) {
+                    out.push_back(uint8_t(symbol));
+                    stats.literals++;
+                    continue;
+                }
+                if (symbol == 256) {
+                    break;
+                }
+                uint32_t li = symbol - 257;
+                uint32_t length = lengthBase[li] + bits.get(lengthExtra[li]);
+                uint32_t di = bits.getCode(5);
+                if (di >= 30) {
+                    return false;
+                }
+                uint32_t distance = distanceBase[di] + bits.get(distanceExtra[di]);
+                if (bits.overrun || distance > out.size()) {
+                    return false;
+                }
+                // Byte by byte, since a match may overlap what it copies
+                for (size_t from = out.size() - distance, end = from + length; from < end; ++from) {
+                    out.push_back(out[from]);
+                }
+                stats.matches++;
+            }
+        } else {
+            return false;
+        }
+        if (bits.overrun) {
+            return false;
+        }
+    }
+    bits.align();
+    at = bits.at;
+    return true;
+}
+
+// PNG decoder for what encodePng() writes, checking every chunk CRC, the
+// zlib header and trailer and the row filters
+bool decodePng(const std::vector<uint8_t>& png, uint32_t& width, uint32_t& height, std::vector<uint8_t>& rgba,
+               InflateStats& stats) {
+    std::vector<uint8_t> zlib;
+    for (size_t at = 8; at + 12 <= png.size();) {
+        uint32_t length = be32(png, at);
+        std::string type(png.begin() + at + 4, png.begin() + at + 8);
+        if (crc32(&png[at + 4], length + 4) != be32(png, at + 8 + length)) {
+            return false;
+        }
+        if (type == "IHDR") {
+            width = be32(png, at + 8);
+            height = be32(png, at + 12);
+        } else if (type == "IDAT") {
+            zlib.insert(zlib.end(), png.begin() + at + 8, png.begin() + at + 8 + length);
+        }
+        at += 12 + length;
+    }
+
+    if (zlib.size() < 2 || (zlib[0] & 0x0f) != 8 || (zlib[0] << 8 | zlib[1]) % 31 != 0) {
+        return false;
+    }
+    std::vector<uint8_t> filtered;
+    size_t at = 2;
+    if (!inflate(zlib, at, filtered, stats)) {
+        return false;
+    }
+
+    uint32_t a = 1, b = 0;
+    for (uint8_t byte : filtered) {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+    if (zlib.size() != at + 4 || be32(zlib, at) != (b << 16 | a)) {
+        return false;
+    }
+
+    size_t rowBytes = size_t(width) * 4;
+    if (filtered.size() != height * (rowBytes + 1)) {
+        return false;
+    }
+    rgba.assign(height * rowBytes, 0);
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint8_t* in = &filtered[y * (rowBytes + 1)];
+        uint8_t* out = &rgba[y * rowBytes];
+        for (size_t i = 0; i < rowBytes; ++i) {
+            uint8_t predictor = 0;
+            if (in[0] == 1) {
+                predictor = i >= 4 ? out[i - 4] : 0;
+            } else if (in[0] == 2) {
+                predictor = y > 0 ? out[i - rowBytes] : 0;
+            } else if (in[0] != 0) {
+                return false;
+            }
+            out[i] = uint8_t(in[1 + i] + predictor);
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+// Sizes that split into several stripes, and one of a single row
+TEST(encoderQoiRoundTrip) {
+    const uint32_t sizes[3][2] = { { 640, 480 }, { 1920, 1080 }, { 333, 1 } };
+    for (const auto& size : sizes) {
+        std::vector<uint8_t> frame = testFrame(size[0], size[1]);
+        std::vector<uint8_t> encoded;
+        encodeQoi(frame.data(), size[0], size[1], encoded);
+        Image decoded;
+        CHECK(decodeQoi(encoded, decoded));
+        CHECK(decoded.width == size[0] && decoded.height == size[1]);
+        CHECK(decoded.rgba == frame);
+    }
+}
+
+TEST(encoderPngRoundTrip) {
+    std::vector<uint8_t> frame = testFrame(1920, 1080);
+    std::vector<uint8_t> stored;
+    encodePng(frame.data(), 1920, 1080, false, stored);
+    uint32_t width = 0, height = 0;
+    std::vector<uint8_t> decoded;
+    InflateStats stats;
+    CHECK(decodePng(stored, width, height, decoded, stats));
+    CHECK(width == 1920 && height == 1080);
+    CHECK(decoded == frame);
+    CHECK(stats.fixedBlocks == 0 && stats.storedBlocks > 1);
+}
+
+// The compressed variant decodes to the frame: each stripe is one fixed
+// Huffman block of literals and LZ matches, joined to the next by an empty
+// stored block, and the combined Adler-32 covers them all. Stripe counts
+// are given so the joins are covered however many workers there are.
+TEST(encoderPngFastRoundTrip) {
+    const uint32_t sizes[3][2] = { { 1920, 1080 }, { 640, 480 }, { 333, 1 } };
+    for (const auto& size : sizes) {
+        std::vector<uint8_t> frame = testFrame(size[0], size[1]);
+        std::vector<uint8_t> stored;
+        encodePng(frame.data(), size[0], size[1], false, stored);
+        for (size_t stripes : { 1, 2, 7, 16 }) {
+            std::vector<uint8_t> compressed;
+            encodePng(frame.data(), size[0], size[1], true, stripes, compressed);
+            CHECK(std::equal(stored.begin(), stored.begin() + 33, compressed.begin()));
+
+            uint32_t width = 0, height = 0;
+            std::vector<uint8_t> decoded;
+            InflateStats stats;
+            CHECK(decodePng(compressed, width, height, decoded, stats));
+            CHECK(width == size[0] && height == size[1]);
+            CHECK(decoded == frame);
+            CHECK(stats.fixedBlocks == std::min<size_t>(stripes, size[1]));
+            CHECK(stats.storedBlocks == stats.fixedBlocks - 1 && stats.emptyStoredBlocks == stats.storedBlocks);
+            CHECK(stats.matches > 0 && stats.literals > 0);
+            if (size[1] > 1) {
+                CHECK(compressed.size() < stored.size() / 2);
+            }
+        }
+    }
+
+    // Stored stripes join the same way
+    std::vector<uint8_t> frame = testFrame(640, 480);
+    std::vector<uint8_t> stored;
+    encodePng(frame.data(), 640, 480, false, 5, stored);
+    uint32_t width = 0, height = 0;
+    std::vector<uint8_t> decoded;
+    InflateStats stats;
+    CHECK(decodePng(stored, width, height, decoded, stats) && decoded == frame);
+    CHECK(stats.fixedBlocks == 0 && stats.emptyStoredBlocks == 0);
+}
+
+// Frames per second of each format at 1080p and 4K
+BENCH(encoderFramesPerSecond) {
+    const uint32_t sizes[2][2] = { { 1920, 1080 }, { 3840, 2160 } };
+    const char* names[3] = { "PNG stored", "PNG fast", "QOI" };
+    for (const auto& size : sizes) {
+        std::vector<uint8_t> frame = testFrame(size[0], size[1]);
+        std::vector<uint8_t> out;
+        for (uint32_t format = 0; format < 3; ++format) {
+            encodeImage(frame.data(), size[0], size[1], static_cast<ImageFormat>(format), out);
+            const int repeats = 5;
+            double ms = elapsedMs([&] {
+                for (int i = 0; i < repeats; ++i) {
+                    encodeImage(frame.data(), size[0], size[1], static_cast<ImageFormat>(format), out);
+                }
+            });
+            std::printf("  %4u x %4u %-10s %6.1f fps, %6.1f MB/s in, ratio %.2f\n", size[0], size[1], names[format],
+                        1000.0 * repeats / ms, frame.size() * repeats / (ms * 1000.0),
+                        double(out.size()) / frame.size());
+        }
+    }
+}
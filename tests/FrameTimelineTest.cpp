@@ -0,0 +1,117 @@
+#include "Check.h"
+
+#include <cmath>
+#include <random>
+#include <thread>
+
+#include "FrameTimeline.h"
+
+namespace {
+
+// Frames at `hz` with the vsync at `missed` skipped
+FrameTimeline steadyTimeline(double hz, uint32_t frames, uint32_t missed) {
+    FrameTimeline timeline(256);
+    double period = 1000.0 / hz;
+    for (uint32_t i = 0, vsync = 0; i < frames; ++i, ++vsync) {
+        if (i == missed) {
+            vsync++;
+        }
+        FrameRecord record;
+        record.frameIndex = i;
+        record.vsyncTime = vsync * period;
+        record.cpuStart = record.vsyncTime + 0.1;
+        timeline.record(record);
+    }
+    return timeline;
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void spinUntil(std::chrono::steady_clock::time_point start, double ms) {
+    while (millisecondsSince(start) < ms) {
+    }
+}
+
+// A 60 Hz frame loop on a thread of its own. With `pageWork`, the thread
+// is shared the way the browser main thread is: now and then a task (DOM
+// updates, GC, page scripts) of 2 to 20 ms runs ahead of the frame
+// callback. rAF timestamps are the vsync the callback ran in.
+JitterStats runFrameLoop(bool pageWork, uint32_t frames) {
+    const double period = 1000.0 / 60.0;
+    FrameTimeline timeline(frames);
+    std::mt19937 random(47);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < frames; ++i) {
+        double vsync = std::ceil(millisecondsSince(start) / period) * period;
+        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(vsync - millisecondsSince(start)));
+        spinUntil(start, vsync);
+        if (pageWork && uniform(random) < 0.15) {
+            spinUntil(start, vsync + 2.0 + 18.0 * uniform(random));
+        }
+
+        FrameRecord record;
+        record.frameIndex = i;
+        record.cpuStart = millisecondsSince(start);
+        record.vsyncTime = std::floor(record.cpuStart / period) * period;
+        spinUntil(start, record.cpuStart + 2.0); // frame() itself
+        record.cpuEnd = millisecondsSince(start);
+        timeline.record(record);
+    }
+    return timeline.jitterStats();
+}
+
+} // namespace
+
+TEST(frameTimelineRefreshRate) {
+    CHECK(std::abs(steadyTimeline(144.0, 100, 50).estimateRefreshHz(60.0) - 144.0) < 1e-6);
+    CHECK(std::abs(steadyTimeline(59.94, 300, 1000).estimateRefreshHz(60.0) - 59.94) < 1e-6);
+    CHECK(steadyTimeline(144.0, 5, 1000).estimateRefreshHz(60.0) == 60.0);
+}
+
+// The cached estimate follows a change of refresh rate once the new rate
+// fills most of the window
+TEST(frameTimelineRefreshRateFollowsChange) {
+    FrameTimeline timeline(1024);
+    double time = 0.0;
+    for (uint32_t i = 0; i < 600; ++i) {
+        time += i < 300 ? 1000.0 / 60.0 : 1000.0 / 120.0;
+        FrameRecord record;
+        record.frameIndex = i;
+        record.vsyncTime = time;
+        timeline.record(record);
+        double hz = timeline.estimateRefreshHz(0.0);
+        if (i == 299) {
+            CHECK(std::abs(hz - 60.0) < 1e-6);
+        }
+    }
+    CHECK(std::abs(timeline.estimateRefreshHz(0.0) - 120.0) < 1e-6);
+}
+
+TEST(frameTimelineJitterStats) {
+    JitterStats stats = steadyTimeline(120.0, 200, 80).jitterStats();
+    CHECK(stats.intervals == 199);
+    CHECK(std::abs(stats.medianInterval - 1000.0 / 120.0) < 1e-6);
+    CHECK(stats.longIntervals == 1);
+    CHECK(std::abs(stats.callbackMaxDeviation - 1000.0 / 120.0) < 1e-6);
+}
+
+// A model of frame-interval jitter for the render loop on a shared "main
+// thread" against a dedicated worker, reported with the same statistics as
+// frameJitterStats(). It only shows what its own assumptions about page work
+// imply and measures neither browser build, so nothing is checked; the
+// builds themselves are compared in the browser with control.jitterStats()
+// in index.html.
+BENCH(frameLoopJitterMainVsWorker) {
+    const uint32_t frames = 360;
+    JitterStats shared = runFrameLoop(true, frames);
+    JitterStats worker = runFrameLoop(false, frames);
+    for (auto [name, stats] : { std::pair{ "main thread", shared }, std::pair{ "worker", worker } }) {
+        std::printf("  %-11s median %6.2f ms, vsync stddev %5.2f ms, callback stddev %5.2f ms, "
+                    "max deviation %5.2f ms, %u missed\n",
+                    name, stats.medianInterval, stats.vsyncStddev, stats.callbackStddev, stats.callbackMaxDeviation,
+                    stats.longIntervals);
+    }
+}
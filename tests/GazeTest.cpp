@@ -0,0 +1,161 @@
+#include "Check.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "Gaze.h"
+#include "LatestValue.h"
+
+namespace {
+
+double nowMs() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+GazeSample testSample(uint32_t i) {
+    GazeSample sample = {};
+    sample.time = 1000.0 + i * 0.5;
+    sample.x = float(i % 97) / 97.0f;
+    sample.y = float(i % 89) / 89.0f;
+    sample.pupil = 3.0f + float(i % 7) * 0.125f;
+    sample.sequence = i;
+    sample.flags = kGazeValid | (i % 5 == 0 ? kGazeSaccade : 0);
+    return sample;
+}
+
+bool sameSample(const GazeSample& a, const GazeSample& b) {
+    return a.time == b.time && a.x == b.x && a.y == b.y && a.pupil == b.pupil && a.sequence == b.sequence &&
+           a.flags == b.flags;
+}
+
+} // namespace
+
+// Records with runs of garbage between them, cut into chunks at random
+// points: every sample comes out once, intact and in order, and every
+// garbage byte is counted as skipped. Garbage leaves out 0x47, the first
+// byte of the magic, so it can never start a false record.
+TEST(gazeDecoderResynchronizes) {
+    std::mt19937 random(49);
+    const uint32_t count = 5000;
+    std::vector<uint8_t> stream;
+    uint64_t garbage = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t junk = random() % 3 == 0 ? random() % 80 : 0;
+        for (uint32_t j = 0; j < junk; ++j) {
+            uint8_t byte = uint8_t(random());
+            stream.push_back(byte == 0x47 ? 0x48 : byte);
+        }
+        garbage += junk;
+        uint8_t record[kGazeRecordSize];
+        encodeGazeSample(testSample(i), record);
+        stream.insert(stream.end(), record, record + kGazeRecordSize);
+    }
+
+    GazeDecoder decoder;
+    std::vector<GazeSample> decoded;
+    size_t delivered = 0;
+    for (size_t at = 0; at < stream.size();) {
+        size_t size = std::min<size_t>(1 + random() % 100, stream.size() - at);
+        delivered += decoder.feed(stream.data() + at, size, [&](const GazeSample& s) { decoded.push_back(s); });
+        at += size;
+    }
+
+    CHECK(delivered == count && decoded.size() == count);
+    CHECK(decoder.sampleCount() == count);
+    CHECK(decoder.skippedBytes() == garbage);
+    bool intact = true;
+    for (uint32_t i = 0; i < decoded.size(); ++i) {
+        intact = intact && sameSample(decoded[i], testSample(i));
+    }
+    CHECK(intact);
+}
+
+// The whole stream in one call and one byte at a time decode the same
+TEST(gazeDecoderChunkSizes) {
+    std::vector<uint8_t> stream(3 + 10 * kGazeRecordSize, 0xAB);
+    for (uint32_t i = 0; i < 10; ++i) {
+        encodeGazeSample(testSample(i), stream.data() + 3 + i * kGazeRecordSize);
+    }
+    for (size_t chunk : { stream.size(), size_t(1), kGazeRecordSize, kGazeRecordSize + 1 }) {
+        GazeDecoder decoder;
+        std::vector<GazeSample> decoded;
+        for (size_t at = 0; at < stream.size(); at += chunk) {
+            decoder.feed(stream.data() + at, std::min(chunk, stream.size() - at),
+                         [&](const GazeSample& s) { decoded.push_back(s); });
+        }
+        CHECK(decoded.size() == 10 && decoder.skippedBytes() == 3);
+        CHECK(!decoded.empty() && sameSample(decoded.front(), testSample(0)) &&
+              sameSample(decoded.back(), testSample(9)));
+    }
+}
+
+// The synthetic tracker at 2000 Hz through the decoder into a LatestValue,
+// read by a 144 Hz "render thread" as main.cpp wires it up: no sample is
+// lost or mangled on the way, the reader only ever moves forward and ends
+// on the last sample
+TEST(gazePipelineAt2000Hz) {
+    GazeDecoder decoder;
+    LatestValue<GazeSample> latest;
+    std::atomic<uint32_t> lastSequence{ 0 };
+    SyntheticGaze generator;
+    CHECK(generator.start(2000.0, 3, 1, nowMs, [&](const uint8_t* data, size_t size) {
+        decoder.feed(data, size, [&](const GazeSample& sample) {
+            latest.store(sample);
+            lastSequence.store(sample.sequence, std::memory_order_relaxed);
+        });
+    }));
+
+    uint32_t frames = 0, fresh = 0, backwards = 0;
+    uint32_t previous = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(500)) {
+        std::this_thread::sleep_for(std::chrono::microseconds(6944));
+        GazeSample sample = {};
+        bool arrived = false;
+        if (latest.load(sample, &arrived)) {
+            backwards += sample.sequence < previous;
+            previous = sample.sequence;
+            fresh += arrived;
+        }
+        frames++;
+    }
+    generator.stop();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    GazeSample sample = {};
+    CHECK(latest.load(sample));
+    CHECK(sample.sequence == lastSequence.load() && sample.sequence + 1 == generator.emitted());
+    CHECK(decoder.sampleCount() == generator.emitted() && decoder.skippedBytes() == 0);
+    // The generator catches up after late wakeups, so the count follows the rate
+    CHECK(generator.emitted() > 2000.0 * seconds * 0.9);
+    CHECK(backwards == 0);
+    CHECK(fresh + 5 >= frames);
+}
+
+// Decode and store rate without the generator's pacing, against the
+// 2000 Hz a fast tracker delivers
+BENCH(gazeDecodeThroughput) {
+    const uint32_t count = 1 << 20;
+    std::vector<uint8_t> stream(size_t(count) * kGazeRecordSize);
+    for (uint32_t i = 0; i < count; ++i) {
+        encodeGazeSample(testSample(i), stream.data() + size_t(i) * kGazeRecordSize);
+    }
+    for (size_t message : { kGazeRecordSize, 16 * kGazeRecordSize, size_t(1000) }) {
+        GazeDecoder decoder;
+        LatestValue<GazeSample> latest;
+        double ms = elapsedMs([&] {
+            for (size_t at = 0; at < stream.size(); at += message) {
+                decoder.feed(stream.data() + at, std::min(message, stream.size() - at),
+                             [&](const GazeSample& sample) { latest.store(sample); });
+            }
+        });
+        std::printf("  %4zu-byte messages: %6.1f M samples/s, %8.0fx 2000 Hz\n", message, count / ms / 1000.0,
+                    count / ms * 1000.0 / 2000.0);
+        CHECK(decoder.sampleCount() == count);
+    }
+}
@@ -0,0 +1,289 @@
+#include "Check.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ContentHash.h"
+#include "Dither.h"
+#include "Dots.h"
+#include "Filter.h"
+#include "Flicker.h"
+#include "FrameEncoder.h"
+#include "ImageDiff.h"
+#include "Noise.h"
+#include "Procedural.h"
+#include "QoiDecoder.h"
+
+// Headless golden-image harness. There is no native WebGPU here, so scenes
+// are rendered through the CPU references of the shaders (pattern, noise
+// and output stage), which the shaders match to within one code, and
+// compared with compareImages() against QOI goldens in tests/golden. On a
+// mismatch the actual image and a diff heatmap are written as PNGs to
+// golden-diffs/ in the build tree. UPDATE_GOLDENS=1 rewrites the goldens.
+//
+// The goldens come from the same CPU references they are checked against,
+// so they catch changes to the references and the harness, not a shader
+// that no longer matches its reference. For that, shaders.txt next to the
+// goldens holds a hash of every WGSL source with a CPU mirror; editing a
+// shader fails goldenShaderSources until the mirror has been brought in
+// line and the hashes rewritten with UPDATE_GOLDENS=1.
+
+namespace {
+
+constexpr uint32_t kSize = 256;
+
+std::vector<uint8_t> readFile(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), {});
+}
+
+void writeFile(const std::filesystem::path& path, const std::vector<uint8_t>& data) {
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size()));
+}
+
+// Luminance of every pixel through the output stage, as the present pass does
+template <typename Luminance>
+Image renderThroughOutput(OutputMode mode, Luminance&& luminance) {
+    static const std::vector<float> blueNoise = generateBlueNoise(64, 1);
+    OutputUniforms output = makeOutputUniforms(mode, 0.2126f, 0.7152f, 0.0722f, 64);
+
+    Image image{ kSize, kSize, std::vector<uint8_t>(kSize * kSize * 4) };
+    for (uint32_t y = 0; y < kSize; ++y) {
+        for (uint32_t x = 0; x < kSize; ++x) {
+            float rgb[3];
+            luminance(x, y, rgb);
+            uint8_t* px = &image.rgba[(y * kSize + x) * 4];
+            encodeOutputPixel(output, blueNoise.data(), rgb[0], rgb[1], rgb[2], x, y, px);
+            px[3] = 255;
+        }
+    }
+    return image;
+}
+
+Image renderPatternScene(PatternUniforms pattern, OutputMode mode) {
+    return renderThroughOutput(mode, [&](uint32_t x, uint32_t y, float rgb[3]) {
+        float u = (float(x) + 0.5f) / kSize - 0.5f;
+        float v = 0.5f - (float(y) + 0.5f) / kSize;
+        rgb[0] = rgb[1] = rgb[2] = evaluatePattern(pattern, u, v);
+    });
+}
+
+Image renderNoiseScene(NoiseUniforms noise) {
+    noise.width = noise.height = kSize;
+    std::vector<uint8_t> codes(kSize * kSize);
+    renderNoise(noise, codes.data());
+    Image image{ kSize, kSize, std::vector<uint8_t>(kSize * kSize * 4, 255) };
+    for (size_t i = 0; i < codes.size(); ++i) {
+        image.rgba[i * 4] = image.rgba[i * 4 + 1] = image.rgba[i * 4 + 2] = codes[i];
+    }
+    return image;
+}
+
+struct Scene {
+    const char* name;
+    Image (*render)();
+};
+
+const Scene kScenes[] = {
+    { "grating-bitsteal",
+      [] { return renderPatternScene({ 0, 4.0f, 0.5f, 0.0f, 0.02f, 0.5f, 0.0f, 0.0f, 0.0f, 0.0f, {} },
+                                     OutputMode::BitSteal); } },
+    { "gabor-dither",
+      [] { return renderPatternScene({ 1, 6.0f, 1.2f, 0.7f, 0.8f, 0.5f, 0.15f, 0.0f, 0.0f, 0.0f, {} },
+                                     OutputMode::Dither); } },
+    { "checkerboard-quantize",
+      [] { return renderPatternScene({ 2, 8.0f, 0.3f, 0.0f, 1.0f, 0.5f, 0.0f, 0.0f, 0.0f, 0.0f, {} },
+                                     OutputMode::Quantize); } },
+    { "radial-quantize",
+      [] { return renderPatternScene({ 3, 5.0f, 0.0f, 0.0f, 1.0f, 0.5f, 0.0f, 12.0f, 0.0f, 0.0f, {} },
+                                     OutputMode::Quantize); } },
+    { "plaid-bitstealdither",
+      [] { return renderPatternScene({ 4, 3.0f, 0.4f, 0.0f, 0.5f, 0.5f, 0.0f, 5.0f, 2.0f, 1.0f, {} },
+                                     OutputMode::BitStealDither); } },
+    { "color-ramp-bitsteal",
+      [] {
+          return renderThroughOutput(OutputMode::BitSteal, [](uint32_t x, uint32_t y, float rgb[3]) {
+              rgb[0] = 0.2f + 0.02f * x / kSize;
+              rgb[1] = 0.6f * y / kSize;
+              rgb[2] = 0.3f;
+          });
+      } },
+    { "noise-pink", [] { return renderNoiseScene({ 1, 7, 3, 0, 0, 0, 255, 6, 0, {} }); } },
+    { "noise-mondrian", [] { return renderNoiseScene({ 3, 11, 0, 0, 0, 20, 235, 0, 40, {} }); } },
+};
+
+// WGSL sources and the CPU functions that mirror them
+struct ShaderSource {
+    const char* name;
+    const char* mirror;
+    std::string code;
+};
+
+std::vector<ShaderSource> shaderSources() {
+    return {
+        { "proceduralFragmentShaderCode", "evaluatePattern", proceduralFragmentShaderCode },
+        { "outputShaderCode", "encodeOutputPixel", outputShaderCode },
+        { "pcg4dShaderCode", "noiseHash", pcg4dShaderCode },
+        { "noiseFragmentShaderCode", "evaluateNoise", noiseFragmentShaderCode },
+        { "flickerShaderCode", "flickerLuminance", flickerShaderCode },
+        { "filterShaderCode", "filterImage", filterShaderCode },
+        { "dotsComputeShaderCode", "DotFieldCpu::step", dotsComputeShaderCode },
+        { "contentHashShaderCode", "contentHash", contentHashShaderCode },
+    };
+}
+
+uint64_t fnv1a64(const std::string& text) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (char c : text) {
+        hash = (hash ^ uint8_t(c)) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+} // namespace
+
+// Fails when a shader changed without its CPU mirror being reviewed
+TEST(goldenShaderSources) {
+    const std::filesystem::path path = std::filesystem::path(GOLDEN_DIR) / "shaders.txt";
+    const char* update = std::getenv("UPDATE_GOLDENS");
+    if (update && update[0] == '1') {
+        std::ofstream file(path);
+        file << "# FNV-1a 64 of each WGSL source and the CPU function mirroring it. A\n"
+                "# mismatch means the shader changed: update the mirror to match, then\n"
+                "# rewrite this file with UPDATE_GOLDENS=1.\n";
+        for (const ShaderSource& shader : shaderSources()) {
+            char hex[17];
+            std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(fnv1a64(shader.code)));
+            file << shader.name << " " << shader.mirror << " " << hex << "\n";
+        }
+        std::printf("  wrote %s\n", path.c_str());
+        return;
+    }
+
+    std::ifstream file(path);
+    CHECK(file.good());
+    std::vector<ShaderSource> sources = shaderSources();
+    size_t checked = 0;
+    std::string name, mirror, hex;
+    while (file >> name) {
+        if (name[0] == '#') {
+            std::getline(file, name);
+            continue;
+        }
+        file >> mirror >> hex;
+        for (const ShaderSource& shader : sources) {
+            if (name != shader.name) {
+                continue;
+            }
+            bool same = std::strtoull(hex.c_str(), nullptr, 16) == fnv1a64(shader.code);
+            CHECK(same);
+            if (!same) {
+                std::fprintf(stderr, "  %s changed: bring %s in line, then UPDATE_GOLDENS=1\n", shader.name,
+                             shader.mirror);
+            }
+            checked++;
+        }
+    }
+    CHECK(checked == sources.size());
+}
+
+TEST(goldenImages) {
+    const std::filesystem::path goldens = GOLDEN_DIR;
+    const std::filesystem::path diffs = GOLDEN_DIFF_DIR;
+    const char* update = std::getenv("UPDATE_GOLDENS");
+    bool updating = update && update[0] == '1';
+
+    for (const Scene& scene : kScenes) {
+        Image actual = scene.render();
+        std::filesystem::path path = goldens / (std::string(scene.name) + ".qoi");
+        if (updating) {
+            std::vector<uint8_t> encoded;
+            encodeQoi(actual.rgba.data(), actual.width, actual.height, encoded);
+            writeFile(path, encoded);
+            std::printf("  wrote %s\n", path.c_str());
+            continue;
+        }
+
+        Image expected;
+        bool loaded = decodeQoi(readFile(path), expected);
+        CHECK(loaded);
+        if (!loaded || expected.width != actual.width || expected.height != actual.height) {
+            std::fprintf(stderr, "  %s: missing or unreadable golden %s\n", scene.name, path.c_str());
+            continue;
+        }
+
+        ImageDiff diff = compareImages(actual.rgba.data(), expected.rgba.data(), actual.width, actual.height);
+        bool passed = diffPasses(diff, DiffTolerance());
+        CHECK(passed);
+        if (!passed) {
+            std::vector<uint8_t> heatmap(actual.rgba.size());
+            diffHeatmap(actual.rgba.data(), expected.rgba.data(), actual.width, actual.height, 16, heatmap.data());
+            std::vector<uint8_t> png;
+            encodePng(heatmap.data(), actual.width, actual.height, true, png);
+            writeFile(diffs / (std::string(scene.name) + "-heatmap.png"), png);
+            encodePng(actual.rgba.data(), actual.width, actual.height, true, png);
+            writeFile(diffs / (std::string(scene.name) + "-actual.png"), png);
+            std::fprintf(stderr, "  %s: PSNR %.2f dB, SSIM %.4f, max diff %u; heatmap in %s\n", scene.name,
+                         diff.psnr, diff.ssim, diff.maxAbsDiff, diffs.c_str());
+        }
+    }
+}
+
+// A perturbed frame must fail the comparison and produce a heatmap that
+// marks exactly the perturbed pixels
+TEST(goldenDetectsRegression) {
+    Image expected = kScenes[0].render();
+    Image actual = expected;
+    for (uint32_t y = 100; y < 120; ++y) {
+        for (uint32_t x = 40; x < 60; ++x) {
+            actual.rgba[(y * kSize + x) * 4 + 1] += 40;
+        }
+    }
+    ImageDiff diff = compareImages(actual.rgba.data(), expected.rgba.data(), kSize, kSize);
+    CHECK(!diffPasses(diff, DiffTolerance()));
+    CHECK(diff.differingPixels == 400);
+    CHECK(diff.maxAbsDiff == 40);
+
+    std::vector<uint8_t> heatmap(actual.rgba.size());
+    diffHeatmap(actual.rgba.data(), expected.rgba.data(), kSize, kSize, 16, heatmap.data());
+    const uint8_t* hot = &heatmap[(110 * kSize + 50) * 4];
+    const uint8_t* cold = &heatmap[(10 * kSize + 10) * 4];
+    CHECK(hot[0] > cold[0]);
+}
+
+// Comparison throughput at 1080p and 4K. The floor is for the native
+// scalar path on a single core; it catches losing the band split or an
+// allocation per pixel, not the speed of the wasm SIMD build.
+BENCH(goldenCompareThroughput) {
+    const uint32_t sizes[2][2] = { { 1920, 1080 }, { 3840, 2160 } };
+    for (const auto& size : sizes) {
+        uint32_t width = size[0];
+        uint32_t height = size[1];
+        std::vector<uint8_t> expected(size_t(width) * height * 4);
+        for (size_t i = 0; i < expected.size(); ++i) {
+            expected[i] = uint8_t(noiseHash(uint32_t(i), 0, 0, 5).x);
+        }
+        std::vector<uint8_t> actual = expected;
+        for (size_t i = 0; i < actual.size(); i += 97) {
+            actual[i] ^= 1;
+        }
+
+        const int repeats = 10;
+        ImageDiff diff = {};
+        double ms = elapsedMs([&] {
+            for (int i = 0; i < repeats; ++i) {
+                diff = compareImages(actual.data(), expected.data(), width, height);
+            }
+        });
+        double mps = double(width) * height * repeats / (ms * 1000.0);
+        std::printf("  compareImages %ux%u: %.2f ms/frame, %.0f MP/s (PSNR %.1f dB)\n", width, height, ms / repeats,
+                    mps, diff.psnr);
+        CHECK(mps > 30.0);
+    }
+}
@@ -0,0 +1,101 @@
+#include "Check.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "ImageStats.h"
+
+namespace {
+
+// Statistics in double throughout, two passes for the variance
+struct Reference {
+    double mean = 0.0;
+    double rms = 0.0;
+    double min = 1.0;
+    double max = 0.0;
+};
+
+Reference referenceStats(const std::vector<uint8_t>& rgba, double lumR, double lumG, double lumB) {
+    double total = lumR + lumG + lumB;
+    size_t count = rgba.size() / 4;
+    std::vector<double> luminance(count);
+    Reference reference;
+    for (size_t i = 0; i < count; ++i) {
+        const uint8_t* p = &rgba[i * 4];
+        luminance[i] = (p[0] * lumR + p[1] * lumG + p[2] * lumB) / total / 255.0;
+        reference.mean += luminance[i] / count;
+        reference.min = std::min(reference.min, luminance[i]);
+        reference.max = std::max(reference.max, luminance[i]);
+    }
+    double variance = 0.0;
+    for (double y : luminance) {
+        variance += (y - reference.mean) * (y - reference.mean) / count;
+    }
+    reference.rms = std::sqrt(variance);
+    return reference;
+}
+
+// Codes drawn around `base` with up to `spread` either way, per channel
+std::vector<uint8_t> randomImage(uint32_t width, uint32_t height, uint32_t seed, int base, int spread) {
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> offset(-spread, spread);
+    std::vector<uint8_t> rgba(size_t(width) * height * 4);
+    for (size_t i = 0; i < rgba.size(); ++i) {
+        rgba[i] = i % 4 == 3 ? 255 : uint8_t(std::clamp(base + offset(random), 0, 255));
+    }
+    return rgba;
+}
+
+bool matches(const ImageStats& stats, const Reference& reference, double rmsTolerance) {
+    return std::abs(stats.meanLuminance - reference.mean) < 1e-7 &&
+           std::abs(stats.rmsContrast - reference.rms) <= rmsTolerance * reference.rms + 1e-9 &&
+           std::abs(stats.minLuminance - reference.min) < 1e-6 && std::abs(stats.maxLuminance - reference.max) < 1e-6;
+}
+
+} // namespace
+
+// Full-range and low-contrast images against the double reference, at
+// widths that do and do not fill whole SIMD vectors, with the default and
+// calibrated weights. A contrast of a fraction of a code on a bright
+// background is where E[y^2] - mean^2 in float falls apart.
+TEST(imageStatsMatchReference) {
+    const uint32_t sizes[4][2] = { { 1, 1 }, { 7, 5 }, { 640, 480 }, { 1921, 1080 } };
+    const float weights[2][3] = { { 0.2126f, 0.7152f, 0.0722f }, { 31.0f, 92.5f, 8.25f } };
+    for (const auto& size : sizes) {
+        for (const auto& w : weights) {
+            std::vector<uint8_t> full = randomImage(size[0], size[1], size[0], 128, 128);
+            ImageStats stats = computeImageStats(full.data(), size[0], size[1], w[0], w[1], w[2]);
+            CHECK(stats.width == size[0] && stats.height == size[1]);
+            CHECK(matches(stats, referenceStats(full, w[0], w[1], w[2]), 1e-6));
+
+            std::vector<uint8_t> faint = randomImage(size[0], size[1], size[1], 230, 1);
+            stats = computeImageStats(faint.data(), size[0], size[1], w[0], w[1], w[2]);
+            CHECK(matches(stats, referenceStats(faint, w[0], w[1], w[2]), 1e-4));
+        }
+    }
+}
+
+// A flat image has no contrast at all, and gray pixels land in the
+// histogram bin of their code
+TEST(imageStatsFlatAndHistogram) {
+    const uint32_t width = 1920, height = 1080;
+    std::vector<uint8_t> flat(size_t(width) * height * 4, 249);
+    ImageStats stats = computeImageStats(flat.data(), width, height);
+    CHECK(std::abs(stats.meanLuminance - 249.0 / 255.0) < 1e-6);
+    CHECK(stats.rmsContrast < 1e-6);
+    CHECK(stats.histogram[249] == width * height);
+
+    std::vector<uint8_t> gray = randomImage(width, height, 3, 128, 128);
+    std::vector<uint32_t> expected(256, 0);
+    for (size_t i = 0; i < gray.size(); i += 4) {
+        gray[i + 1] = gray[i + 2] = gray[i];
+        expected[gray[i]]++;
+    }
+    stats = computeImageStats(gray.data(), width, height);
+    CHECK(std::equal(expected.begin(), expected.end(), stats.histogram));
+
+    ImageStats empty = computeImageStats(nullptr, 0, 0);
+    CHECK(empty.meanLuminance == 0.0 && empty.histogram[0] == 0);
+}
@@ -0,0 +1,97 @@
+#include "Check.h"
+
+#include <cmath>
+#include <vector>
+
+#include "CommandQueue.h"
+#include "Input.h"
+
+namespace {
+
+// The render loop's input path: due mock presses go through the same
+// queue as browser events and are matched when it is drained
+struct HeadlessSession {
+    MockResponder responder;
+    MpscQueue<InputEvent, 1024> queue;
+    ResponseLog log;
+    std::vector<uint32_t> onsetFrames;
+    std::vector<double> onsetTimes;
+
+    // 60 Hz frames with a stimulus change every `onsetEvery` frames,
+    // presented one refresh after its vsync
+    void run(uint32_t frames, uint32_t onsetEvery) {
+        const double period = 1000.0 / 60.0;
+        for (uint32_t frame = 0; frame < frames; ++frame) {
+            double vsync = frame * period;
+            responder.release(vsync, [&](const InputEvent& event) { CHECK(queue.tryPush(event)); });
+            queue.drain([&](const InputEvent& event) { log.add(event); });
+            if (frame % onsetEvery == 0) {
+                double presentTime = vsync + period;
+                log.onset(frame, presentTime);
+                responder.onset(presentTime);
+                onsetFrames.push_back(frame);
+                onsetTimes.push_back(presentTime);
+            }
+        }
+    }
+};
+
+} // namespace
+
+// Every onset gets one press, measured from that onset, within the
+// configured reaction time window
+TEST(inputMockReactionTimes) {
+    static HeadlessSession session;
+    session.responder.configure(true, 350.0, 50.0, 5, 32);
+    session.run(600, 40);
+
+    CHECK(session.log.total() == session.onsetFrames.size());
+    double mean = 0.0;
+    for (size_t i = 0; i < session.log.size(); ++i) {
+        const Response& response = session.log.at(i);
+        CHECK(response.event.source == static_cast<uint32_t>(InputSource::Mock));
+        CHECK(response.event.code == 32);
+        CHECK(response.onsetFrame == session.onsetFrames[i]);
+        CHECK(std::abs(response.reactionTime - (response.event.time - session.onsetTimes[i])) < 1e-9);
+        CHECK(response.reactionTime >= 300.0 && response.reactionTime <= 400.0);
+        mean += response.reactionTime;
+    }
+    mean /= session.log.size();
+    CHECK(std::abs(mean - 350.0) < 20.0);
+}
+
+// Presses are released only once their timestamp has passed
+TEST(inputMockReleaseWaits) {
+    MockResponder responder;
+    responder.configure(true, 300.0, 0.0, 1, 13);
+    responder.onset(1000.0);
+    uint32_t released = 0;
+    responder.release(1299.0, [&](const InputEvent&) { released++; });
+    CHECK(released == 0);
+    responder.release(1300.0, [&](const InputEvent& event) {
+        released++;
+        CHECK(event.time == 1300.0);
+    });
+    CHECK(released == 1);
+    responder.release(5000.0, [&](const InputEvent&) { released++; });
+    CHECK(released == 1);
+}
+
+// A response handled after later onsets were recorded is still measured
+// from the onset that was on screen when it happened; one before any
+// onset has no reaction time
+TEST(inputResponseMatchesEarlierOnset) {
+    ResponseLog log(8);
+    InputEvent early = {};
+    early.time = 50.0;
+    log.add(early);
+    log.onset(6, 100.0);
+    log.onset(36, 600.0);
+    log.onset(66, 1100.0);
+    InputEvent late = {};
+    late.time = 750.0;
+    log.add(late);
+    CHECK(log.at(0).reactionTime < 0.0);
+    CHECK(log.at(1).onsetFrame == 36);
+    CHECK(std::abs(log.at(1).reactionTime - 150.0) < 1e-9);
+}
@@ -0,0 +1,93 @@
+#include "Check.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "LatestValue.h"
+
+namespace {
+
+// Torn reads show up as fields that disagree
+struct Sample {
+    uint32_t writer;
+    uint32_t sequence[15];
+};
+
+} // namespace
+
+TEST(latestValueFreshness) {
+    LatestValue<Sample> latest;
+    Sample sample = {};
+    bool fresh = true;
+    CHECK(!latest.load(sample, &fresh));
+    CHECK(!fresh);
+
+    Sample first = { 1, { 7 } };
+    latest.store(first);
+    CHECK(latest.load(sample, &fresh));
+    CHECK(fresh && sample.sequence[0] == 7);
+    CHECK(latest.load(sample, &fresh));
+    CHECK(!fresh && sample.sequence[0] == 7);
+
+    // Only the newest of several stores is seen
+    for (uint32_t i = 8; i < 12; ++i) {
+        latest.store({ 1, { i } });
+    }
+    CHECK(latest.load(sample, &fresh));
+    CHECK(fresh && sample.sequence[0] == 11);
+}
+
+// Two writers store as fast as they can while the reader loads: every
+// load is one complete value, and each writer's values only move forward
+TEST(latestValueConcurrent) {
+    static LatestValue<Sample> latest;
+    std::atomic<bool> stop{ false };
+    std::vector<std::thread> writers;
+    for (uint32_t w = 0; w < 2; ++w) {
+        writers.emplace_back([w, &stop] {
+            for (uint32_t i = 1; !stop.load(std::memory_order_relaxed); ++i) {
+                Sample sample;
+                sample.writer = w;
+                for (uint32_t& s : sample.sequence) {
+                    s = i;
+                }
+                latest.store(sample);
+                if (i % 64 == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    uint32_t torn = 0, backwards = 0, loads = 0;
+    uint32_t last[2] = {};
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+    while (std::chrono::steady_clock::now() < deadline) {
+        Sample sample;
+        if (!latest.load(sample)) {
+            std::this_thread::yield();
+            continue;
+        }
+        loads++;
+        for (uint32_t s : sample.sequence) {
+            torn += s != sample.sequence[0];
+        }
+        if (sample.writer < 2) {
+            backwards += sample.sequence[0] < last[sample.writer];
+            last[sample.writer] = sample.sequence[0];
+        } else {
+            torn++;
+        }
+        if (loads % 64 == 0) {
+            std::this_thread::yield();
+        }
+    }
+    stop = true;
+    for (std::thread& writer : writers) {
+        writer.join();
+    }
+    CHECK(loads > 0);
+    CHECK(torn == 0);
+    CHECK(backwards == 0);
+}
@@ -0,0 +1,81 @@
+#include "Check.h"
+
+#include <cmath>
+#include <vector>
+
+#include "LuminanceMatch.h"
+#include "Noise.h"
+
+namespace {
+
+// `count` gray images of size x size with their own mean and contrast
+struct ImageSet {
+    std::vector<uint8_t> pixels;
+    std::vector<MatchImage> images;
+
+    ImageSet(size_t count, uint32_t size) : pixels(count * size * size * 4), images(count) {
+        for (size_t i = 0; i < count; ++i) {
+            uint8_t* rgba = &pixels[i * size * size * 4];
+            images[i] = { rgba, size, size };
+            float mean = 60.0f + float(i % 7) * 20.0f;
+            float spread = 20.0f + float(i % 5) * 10.0f;
+            for (uint32_t p = 0; p < size * size; ++p) {
+                NoiseHash h = noiseHash(p, uint32_t(i), 0, 3);
+                float v = mean + spread * (float(h.x >> 8) * (2.0f / 16777216.0f) - 1.0f);
+                rgba[p * 4] = rgba[p * 4 + 1] = rgba[p * 4 + 2] = uint8_t(std::clamp(v, 0.0f, 255.0f));
+                rgba[p * 4 + 3] = 255;
+            }
+        }
+    }
+};
+
+double meanCode(const MatchImage& image) {
+    double sum = 0.0;
+    size_t n = size_t(image.width) * image.height;
+    for (size_t p = 0; p < n; ++p) {
+        sum += image.rgba[p * 4];
+    }
+    return sum / n;
+}
+
+std::vector<uint32_t> histogram(const MatchImage& image) {
+    std::vector<uint32_t> bins(256, 0);
+    size_t n = size_t(image.width) * image.height;
+    for (size_t p = 0; p < n; ++p) {
+        bins[image.rgba[p * 4]]++;
+    }
+    return bins;
+}
+
+} // namespace
+
+TEST(luminanceMatchMeans) {
+    ImageSet set(40, 64);
+    MatchResult result = matchMeanContrast(set.images.data(), set.images.size(), 0.5, 0.1);
+    CHECK(result.clippedPixels == 0);
+    for (const MatchImage& image : set.images) {
+        CHECK(std::abs(meanCode(image) - 127.5) < 0.6);
+    }
+}
+
+// Exact specification: every image ends up with the same histogram
+TEST(luminanceMatchHistograms) {
+    ImageSet set(40, 64);
+    matchHistograms(set.images.data(), set.images.size());
+    std::vector<uint32_t> first = histogram(set.images[0]);
+    for (const MatchImage& image : set.images) {
+        CHECK(histogram(image) == first);
+    }
+}
+
+// SHINE-style equalization of 1k and 10k images of 128 x 128
+BENCH(luminanceMatchImageSets) {
+    for (size_t count : { size_t(1000), size_t(10000) }) {
+        ImageSet set(count, 128);
+        double meanMs = elapsedMs([&] { matchMeanContrast(set.images.data(), count); });
+        double histogramMs = elapsedMs([&] { matchHistograms(set.images.data(), count); });
+        std::printf("  %5zu images: mean/contrast %8.1f ms (%.3f ms/image), histograms %8.1f ms (%.3f ms/image)\n",
+                    count, meanMs, meanMs / count, histogramMs, histogramMs / count);
+        CHECK(histogram(set.images.front()) == histogram(set.images.back()));
+    }
+}
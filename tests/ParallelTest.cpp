@@ -0,0 +1,72 @@
+#include "Check.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "Parallel.h"
+
+namespace {
+
+struct Counts {
+    std::vector<std::atomic<uint32_t>> chunks;
+    std::vector<std::thread::id> threads;
+    WorkerPool* pool = nullptr;
+    uint32_t nested = 0;
+
+    explicit Counts(size_t n) : chunks(n), threads(n) {}
+};
+
+void countChunk(void* context, size_t chunk) {
+    Counts& counts = *static_cast<Counts*>(context);
+    counts.chunks[chunk]++;
+    counts.threads[chunk] = std::this_thread::get_id();
+}
+
+} // namespace
+
+// Every chunk runs exactly once per job, over many jobs on the same threads
+TEST(parallelPoolRunsEveryChunk) {
+    WorkerPool pool(3);
+    CHECK(pool.workers() == 3);
+    for (uint32_t job = 0; job < 2000; ++job) {
+        Counts counts(1 + job % 9);
+        pool.run(counts.chunks.size(), countChunk, &counts);
+        for (auto& count : counts.chunks) {
+            CHECK(count == 1);
+        }
+    }
+}
+
+// A job submitted from inside a job runs on the submitting worker
+TEST(parallelPoolNestedRunsInline) {
+    WorkerPool pool(2);
+    Counts outer(4);
+    outer.pool = &pool;
+    pool.run(4, [](void* context, size_t chunk) {
+        Counts& outer = *static_cast<Counts*>(context);
+        Counts inner(3);
+        outer.pool->run(3, countChunk, &inner);
+        bool sameThread = true;
+        for (size_t i = 0; i < 3; ++i) {
+            sameThread = sameThread && inner.chunks[i] == 1 && inner.threads[i] == std::this_thread::get_id();
+        }
+        outer.chunks[chunk] += sameThread ? 1 : 100;
+    }, &outer);
+    for (auto& count : outer.chunks) {
+        CHECK(count == 1);
+    }
+}
+
+TEST(parallelForCoversRange) {
+    std::vector<uint32_t> hits(100003, 0);
+    parallelFor(hits.size(), 1000, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            hits[i]++;
+        }
+    });
+    for (uint32_t hit : hits) {
+        CHECK(hit == 1);
+    }
+    CHECK(parallelWorkers() <= kWorkerPoolBudget + 1);
+}
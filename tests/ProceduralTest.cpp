@@ -0,0 +1,106 @@
+#include "Check.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Procedural.h"
+
+namespace {
+
+PatternUniforms pattern(PatternType type, float frequency, float contrast) {
+    PatternUniforms p = {};
+    p.type = static_cast<uint32_t>(type);
+    p.frequency = frequency;
+    p.contrast = contrast;
+    p.meanLuminance = 0.5f;
+    p.sigma = 0.1f;
+    return p;
+}
+
+} // namespace
+
+// A full-field grating reaches mean * (1 +- contrast) and averages to the mean
+TEST(proceduralGratingStatistics) {
+    PatternUniforms p = pattern(PatternType::Grating, 8.0f, 0.6f);
+    p.orientation = 0.4f;
+    const uint32_t size = 512;
+    std::vector<uint8_t> codes(size * size);
+    renderPattern(p, size, size, codes.data());
+
+    double sum = 0.0;
+    for (uint8_t code : codes) {
+        sum += code;
+    }
+    auto [low, high] = std::minmax_element(codes.begin(), codes.end());
+    CHECK(std::abs(sum / codes.size() - 127.5) < 1.5);
+    CHECK(std::abs(*low - 0.2 * 255.0) <= 1.0);
+    CHECK(std::abs(*high - 0.8 * 255.0) <= 1.0);
+}
+
+// The Gabor envelope: grating contrast at the centre, mean luminance far out
+TEST(proceduralGaborEnvelope) {
+    PatternUniforms p = pattern(PatternType::Gabor, 4.0f, 1.0f);
+    p.phase = 1.5707963f;
+    CHECK(std::abs(evaluatePattern(p, 0.0f, 0.0f) - 1.0f) < 1e-6f);
+    CHECK(std::abs(evaluatePattern(p, 0.5f, 0.5f) - 0.5f) < 1e-3f);
+}
+
+// Checkerboards and polar checkerboards only ever take two values
+TEST(proceduralChecksAreBinary) {
+    PatternUniforms checks = pattern(PatternType::Checkerboard, 6.0f, 0.5f);
+    PatternUniforms polar = pattern(PatternType::Radial, 4.0f, 0.5f);
+    polar.frequency2 = 10.0f;
+    for (const PatternUniforms& p : { checks, polar }) {
+        std::vector<uint8_t> codes(128 * 128);
+        renderPattern(p, 128, 128, codes.data());
+        for (uint8_t code : codes) {
+            CHECK(code == 64 || code == 191);
+        }
+    }
+}
+
+// Fill cost of the procedural path against the texture path it replaces.
+// CPU stand-ins for the two fragment shaders: evaluating the pattern per
+// pixel, and a bilinear fetch from a pre-rendered RGBA8 texture, which
+// also has to be uploaded once per stimulus.
+BENCH(proceduralFillCost) {
+    const uint32_t size = 1024;
+    std::vector<uint8_t> texture(size * size * 4);
+    for (size_t i = 0; i < texture.size(); ++i) {
+        texture[i] = uint8_t(i * 2654435761u >> 24);
+    }
+
+    std::vector<uint8_t> out(size * size);
+    uint32_t checksum = 0;
+    double textureMs = elapsedMs([&] {
+        for (uint32_t y = 0; y < size; ++y) {
+            for (uint32_t x = 0; x < size; ++x) {
+                // Sample halfway between texels, as a scaled draw does
+                float u = std::min(float(x) + 0.5f, float(size - 2));
+                float v = std::min(float(y) + 0.5f, float(size - 2));
+                uint32_t x0 = uint32_t(u), y0 = uint32_t(v);
+                float fx = u - x0, fy = v - y0;
+                auto at = [&](uint32_t xx, uint32_t yy) { return float(texture[(yy * size + xx) * 4 + 1]); };
+                float top = at(x0, y0) + (at(x0 + 1, y0) - at(x0, y0)) * fx;
+                float bottom = at(x0, y0 + 1) + (at(x0 + 1, y0 + 1) - at(x0, y0 + 1)) * fx;
+                out[y * size + x] = uint8_t(top + (bottom - top) * fy);
+            }
+        }
+    });
+    checksum += out[size * size / 2];
+    std::printf("  %-12s %5.2f ns/px, %.1f MB upload per stimulus\n", "texture", textureMs * 1e6 / (size * size),
+                texture.size() / 1e6);
+
+    const char* names[] = { "grating", "gabor", "checkerboard", "radial", "plaid" };
+    for (uint32_t type = 0; type < 5; ++type) {
+        PatternUniforms p = pattern(static_cast<PatternType>(type), 8.0f, 0.8f);
+        p.frequency2 = 5.0f;
+        p.orientation2 = 1.0f;
+        double ms = elapsedMs([&] { renderPattern(p, size, size, out.data()); });
+        checksum += out[size * size / 2];
+        std::printf("  %-12s %5.2f ns/px, 0 MB upload, %.2fx the texture fetch\n", names[type],
+                    ms * 1e6 / (size * size), ms / textureMs);
+    }
+    CHECK(checksum != 0xFFFFFFFFu);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// QOI decoder written from the format specification, independent of
+// encodeQoi(), so encoded frames and goldens are not only read back by the
+// code that wrote them.
+
+struct Image {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> rgba;
+};
+
+inline bool decodeQoi(const std::vector<uint8_t>& data, Image& image) {
+    if (data.size() < 22 || std::string(data.begin(), data.begin() + 4) != "qoif") {
+        return false;
+    }
+    auto be32 = [&](size_t at) {
+        return uint32_t(data[at]) << 24 | uint32_t(data[at + 1]) << 16 | uint32_t(data[at + 2]) << 8 | data[at + 3];
+    };
+    image.width = be32(4);
+    image.height = be32(8);
+    size_t pixels = size_t(image.width) * image.height;
+    image.rgba.assign(pixels * 4, 0);
+
+    uint8_t index[64][4] = {};
+    uint8_t px[4] = { 0, 0, 0, 255 };
+    size_t at = 14;
+    size_t end = data.size() - 8;
+    size_t i = 0;
+    while (i < pixels) {
+        if (at >= end) {
+            return false;
+        }
+        uint8_t op = data[at++];
+        uint32_t run = 1;
+        if (op == 0xFE) {
+            std::copy(data.begin() + at, data.begin() + at + 3, px);
+            at += 3;
+        } else if (op == 0xFF) {
+            std::copy(data.begin() + at, data.begin() + at + 4, px);
+            at += 4;
+        } else if ((op >> 6) == 0) {
+            std::copy(index[op], index[op] + 4, px);
+        } else if ((op >> 6) == 1) {
+            px[0] += ((op >> 4) & 3) - 2;
+            px[1] += ((op >> 2) & 3) - 2;
+            px[2] += (op & 3) - 2;
+        } else if ((op >> 6) == 2) {
+            int dg = (op & 63) - 32;
+            uint8_t next = data[at++];
+            px[0] += dg - 8 + (next >> 4);
+            px[1] += dg;
+            px[2] += dg - 8 + (next & 15);
+        } else {
+            run = (op & 63) + 1;
+        }
+        std::copy(px, px + 4, index[(px[0] * 3 + px[1] * 5 + px[2] * 7 + px[3] * 11) % 64]);
+        for (uint32_t r = 0; r < run && i < pixels; ++r, ++i) {
+            std::copy(px, px + 4, &image.rgba[i * 4]);
+        }
+    }
+    return true;
+}
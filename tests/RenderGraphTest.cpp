@@ -0,0 +1,170 @@
+#include "Check.h"
+
+#include <string>
+#include <vector>
+
+#include "RenderGraph.h"
+
+namespace {
+
+TexturePool::Desc halfFloat(uint32_t width, uint32_t height) {
+    TexturePool::Desc desc;
+    desc.width = width;
+    desc.height = height;
+    desc.format = wgpu::TextureFormat::RGBA16Float;
+    desc.usage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::TextureBinding |
+                 wgpu::TextureUsage::StorageBinding;
+    return desc;
+}
+
+struct Fixture {
+    wgpu::Device device;
+    TexturePool pool;
+    RenderGraph graph;
+    wgpu::TextureView backbufferView = wgpu::Texture().CreateView();
+    RenderGraph::Resource backbuffer;
+    std::vector<std::string> ran;
+
+    Fixture() {
+        pool.init(device, nullptr);
+        backbuffer = graph.importTexture("backbuffer", backbufferView);
+        graph.markOutput(backbuffer);
+    }
+
+    // A pass that records that it ran
+    RenderGraph::Execute record(const char* name) {
+        return [this, name](wgpu::CommandEncoder&) { ran.push_back(name); };
+    }
+
+    void execute() {
+        wgpu::CommandEncoder encoder;
+        graph.execute(encoder, pool);
+    }
+};
+
+} // namespace
+
+// Passes whose writes never reach an output are culled along with the
+// passes that only feed them; the rest run in declaration order
+TEST(renderGraphCullsUnusedPasses) {
+    Fixture f;
+    RenderGraph::Resource unused = f.graph.createTexture("unused", halfFloat(64, 64));
+    RenderGraph::Resource feeds = f.graph.createTexture("feeds unused", halfFloat(64, 64));
+    RenderGraph::Resource scene = f.graph.createTexture("scene", halfFloat(64, 64));
+    f.graph.addPass("draw", {}, { scene }, f.record("draw"));
+    f.graph.addPass("producer", {}, { feeds }, f.record("producer"));
+    f.graph.addPass("consumer", { feeds, scene }, { unused }, f.record("consumer"));
+    f.graph.addPass("output", { scene }, { f.backbuffer }, f.record("output"));
+    f.execute();
+
+    CHECK((f.ran == std::vector<std::string>{ "draw", "output" }));
+    CHECK(f.graph.stats().passes == 4 && f.graph.stats().culled == 2);
+    CHECK(f.graph.describe() == "draw\n(culled) producer\n(culled) consumer\noutput\n");
+    // Only the transient that is used gets memory
+    CHECK(f.graph.stats().transients == 1 && f.graph.stats().physical == 1);
+    CHECK(f.pool.stats().created == 1);
+}
+
+// A ping-pong chain: a is dead once b has been written, so c reuses a's
+// texture, but b overlaps both and gets its own
+TEST(renderGraphAliasesDisjointLifetimes) {
+    Fixture f;
+    RenderGraph::Resource a = f.graph.createTexture("a", halfFloat(64, 64));
+    RenderGraph::Resource b = f.graph.createTexture("b", halfFloat(64, 64));
+    RenderGraph::Resource c = f.graph.createTexture("c", halfFloat(64, 64));
+    const void* textures[3] = {};
+    f.graph.addPass("one", {}, { a }, [&](wgpu::CommandEncoder&) { textures[0] = f.graph.texture(a).Get(); });
+    f.graph.addPass("two", { a }, { b }, [&](wgpu::CommandEncoder&) { textures[1] = f.graph.texture(b).Get(); });
+    f.graph.addPass("three", { b }, { c }, [&](wgpu::CommandEncoder&) { textures[2] = f.graph.texture(c).Get(); });
+    f.graph.addPass("output", { c }, { f.backbuffer }, f.record("output"));
+    f.execute();
+
+    const RenderGraph::Stats& stats = f.graph.stats();
+    CHECK(stats.transients == 3 && stats.physical == 2);
+    CHECK(stats.physicalBytes == stats.transientBytes * 2 / 3);
+    CHECK(textures[0] && textures[0] == textures[2] && textures[0] != textures[1]);
+    CHECK(f.pool.stats().created == 2);
+}
+
+// Textures alive at the same time never share, and neither do ones whose
+// descriptors differ in size, format or usage
+TEST(renderGraphKeepsOverlappingApart) {
+    Fixture f;
+    TexturePool::Desc small = halfFloat(32, 32);
+    TexturePool::Desc eightBit = halfFloat(64, 64);
+    eightBit.format = wgpu::TextureFormat::RGBA8Unorm;
+    TexturePool::Desc sampledOnly = halfFloat(64, 64);
+    sampledOnly.usage = wgpu::TextureUsage::TextureBinding;
+
+    RenderGraph::Resource a = f.graph.createTexture("a", halfFloat(64, 64));
+    RenderGraph::Resource b = f.graph.createTexture("b", halfFloat(64, 64));
+    RenderGraph::Resource c = f.graph.createTexture("c", small);
+    RenderGraph::Resource d = f.graph.createTexture("d", eightBit);
+    RenderGraph::Resource e = f.graph.createTexture("e", sampledOnly);
+    RenderGraph::Resource last = f.graph.createTexture("last", halfFloat(64, 64));
+    f.graph.addPass("both", {}, { a, b }, f.record("both"));
+    f.graph.addPass("read both", { a, b }, { c }, f.record("read both"));
+    f.graph.addPass("others", { c }, { d }, f.record("others"));
+    f.graph.addPass("more", { d }, { e }, f.record("more"));
+    f.graph.addPass("last", { e }, { last }, f.record("last"));
+    f.graph.addPass("output", { last }, { f.backbuffer }, f.record("output"));
+    f.execute();
+
+    // Only `last` can take the slot a or b left
+    const RenderGraph::Stats& stats = f.graph.stats();
+    CHECK(stats.culled == 0);
+    CHECK(stats.transients == 6 && stats.physical == 5);
+}
+
+// The frame graph main.cpp builds with a filtered image the size of the
+// canvas and the gaze overlay on, while a frame is captured: the filter
+// intermediate is done before the gaze target is written, and both use the
+// same half-float descriptor, so they share a texture
+TEST(renderGraphFilterGazeCaptureChain) {
+    Fixture f;
+    const uint32_t width = 1920, height = 1080;
+    wgpu::TextureView stimulusView = wgpu::Texture().CreateView();
+    wgpu::TextureView filteredView = wgpu::Texture().CreateView();
+    wgpu::TextureView sceneView = wgpu::Texture().CreateView();
+    RenderGraph::Resource scene = f.graph.importTexture("scene", sceneView);
+    RenderGraph::Resource filtered = f.graph.importTexture("filtered stimulus", filteredView);
+    RenderGraph::Resource image = f.graph.importTexture("stimulus", stimulusView);
+    RenderGraph::Resource rows = f.graph.createTexture("filter rows", halfFloat(width, height));
+    f.graph.addPass("filter rows", { image }, { rows }, f.record("filter rows"));
+    f.graph.addPass("filter columns", { rows, image }, { filtered }, f.record("filter columns"));
+    f.graph.addPass("scene", { filtered, scene }, { scene }, f.record("scene"));
+
+    RenderGraph::Resource gaze = f.graph.createTexture("gaze", halfFloat(width, height));
+    f.graph.addPass("gaze", { scene }, { gaze }, f.record("gaze"));
+    f.graph.addPass("output", { gaze }, { f.backbuffer }, f.record("output"));
+
+    TexturePool::Desc captureDesc;
+    captureDesc.width = width;
+    captureDesc.height = height;
+    captureDesc.format = wgpu::TextureFormat::BGRA8Unorm;
+    captureDesc.usage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::CopySrc |
+                        wgpu::TextureUsage::TextureBinding;
+    RenderGraph::Resource capture = f.graph.createTexture("capture target", captureDesc);
+    RenderGraph::Resource readback = f.graph.importBuffer("capture readback");
+    f.graph.markOutput(readback);
+    f.graph.addPass("capture", { gaze }, { capture }, f.record("capture"));
+    f.graph.addPass("capture copy", { capture }, { readback }, f.record("capture copy"));
+    f.execute();
+
+    const RenderGraph::Stats& stats = f.graph.stats();
+    CHECK(f.ran.size() == 7 && stats.culled == 0);
+    CHECK(stats.transients == 3 && stats.physical == 2);
+    CHECK(stats.physicalBytes < stats.transientBytes);
+    CHECK(stats.transientBytes - stats.physicalBytes == uint64_t(width) * height * 8);
+
+    // The next frame reuses the pooled textures instead of creating more
+    f.graph.reset();
+    f.pool.endFrame();
+    RenderGraph::Resource backbuffer = f.graph.importTexture("backbuffer", f.backbufferView);
+    f.graph.markOutput(backbuffer);
+    RenderGraph::Resource again = f.graph.createTexture("gaze", halfFloat(width, height));
+    f.graph.addPass("gaze", {}, { again }, f.record("gaze"));
+    f.graph.addPass("output", { again }, { backbuffer }, f.record("output"));
+    f.execute();
+    CHECK(f.pool.stats().created == 2 && f.pool.stats().reused == 1);
+}
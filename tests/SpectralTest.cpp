@@ -0,0 +1,269 @@
+#include "Check.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "Fft.h"
+#include "Spectral.h"
+
+// FftPlan runs its radix-4 butterflies four at a time with wasm SIMD;
+// nativeTests covers the scalar butterflies and nativeSimdTests the SIMD
+// ones against the same direct DFT.
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+
+std::vector<float> randomValues(size_t count, uint32_t seed, float low = -1.0f, float high = 1.0f) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> uniform(low, high);
+    std::vector<float> values(count);
+    for (float& v : values) {
+        v = uniform(random);
+    }
+    return values;
+}
+
+// Direct 2D DFT in double precision; a 1D transform is height 1
+void naiveDft(const float* re, const float* im, uint32_t width, uint32_t height, std::vector<double>& outRe,
+              std::vector<double>& outIm) {
+    outRe.assign(size_t(width) * height, 0.0);
+    outIm.assign(outRe.size(), 0.0);
+    for (uint32_t v = 0; v < height; ++v) {
+        for (uint32_t u = 0; u < width; ++u) {
+            double sumRe = 0.0, sumIm = 0.0;
+            for (uint32_t y = 0; y < height; ++y) {
+                for (uint32_t x = 0; x < width; ++x) {
+                    double angle = -2.0 * kPi * (double(u) * x / width + double(v) * y / height);
+                    size_t i = size_t(y) * width + x;
+                    double a = re[i], b = im ? im[i] : 0.0;
+                    sumRe += a * std::cos(angle) - b * std::sin(angle);
+                    sumIm += a * std::sin(angle) + b * std::cos(angle);
+                }
+            }
+            outRe[size_t(v) * width + u] = sumRe;
+            outIm[size_t(v) * width + u] = sumIm;
+        }
+    }
+}
+
+// Largest difference against the reference, relative to its largest magnitude
+double relativeError(const float* re, const float* im, const std::vector<double>& refRe,
+                     const std::vector<double>& refIm) {
+    double worst = 0.0, scale = 1e-30;
+    for (size_t i = 0; i < refRe.size(); ++i) {
+        worst = std::max(worst, std::hypot(re[i] - refRe[i], im[i] - refIm[i]));
+        scale = std::max(scale, std::hypot(refRe[i], refIm[i]));
+    }
+    return worst / scale;
+}
+
+std::vector<uint8_t> randomImage(uint32_t width, uint32_t height, uint32_t seed, int low = 0, int high = 255) {
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> uniform(low, high);
+    std::vector<uint8_t> rgba(size_t(width) * height * 4);
+    for (size_t i = 0; i < rgba.size(); ++i) {
+        rgba[i] = i % 4 == 3 ? 255 : uint8_t(uniform(random));
+    }
+    return rgba;
+}
+
+// Smooth image with structure at a few frequencies, well inside [0, 255]
+std::vector<uint8_t> smoothImage(uint32_t width, uint32_t height, double phase) {
+    std::vector<uint8_t> rgba(size_t(width) * height * 4);
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            double v = 128.0 + 40.0 * std::sin(2.0 * kPi * (3.0 * x / width + phase)) +
+                       25.0 * std::cos(2.0 * kPi * (5.0 * y / height - phase));
+            uint8_t* p = &rgba[(size_t(y) * width + x) * 4];
+            p[0] = uint8_t(std::lround(v));
+            p[1] = uint8_t(std::lround(v * 0.9 + 10.0));
+            p[2] = uint8_t(std::lround(255.0 - v));
+            p[3] = 255;
+        }
+    }
+    return rgba;
+}
+
+// Luminance amplitude spectrum of an RGBA image with power-of-two sides
+std::vector<double> amplitudeSpectrum(const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height, int channel) {
+    std::vector<float> plane(size_t(width) * height), re(plane.size()), im(plane.size());
+    for (size_t i = 0; i < plane.size(); ++i) {
+        const uint8_t* p = &rgba[i * 4];
+        plane[i] = channel < 3 ? p[channel] : 0.2126f * p[0] + 0.7152f * p[1] + 0.0722f * p[2];
+    }
+    forwardReal2d(plane.data(), width, height, re.data(), im.data(), false);
+    std::vector<double> amplitude(plane.size());
+    for (size_t i = 0; i < plane.size(); ++i) {
+        amplitude[i] = std::hypot(re[i], im[i]);
+    }
+    return amplitude;
+}
+
+// Difference between two amplitude spectra relative to the second,
+// leaving out the mean (DC)
+double spectrumDistance(const std::vector<double>& a, const std::vector<double>& b) {
+    double difference = 0.0, total = 1e-30;
+    for (size_t i = 1; i < a.size(); ++i) {
+        difference += std::abs(a[i] - b[i]);
+        total += b[i];
+    }
+    return difference / total;
+}
+
+} // namespace
+
+// Forward against a direct DFT at every size up to 256, covering the even
+// and odd powers that do and do not start with a radix-2 stage; inverse
+// brings back the input
+TEST(fftMatchesDftAndRoundTrips) {
+    for (uint32_t n = 1; n <= 1024; n *= 2) {
+        FftPlan plan(n);
+        CHECK(plan.size() == n);
+        std::vector<float> re = randomValues(n, n), im = randomValues(n, n + 1);
+        std::vector<float> originalRe = re, originalIm = im;
+        plan.forward(re.data(), im.data());
+        if (n <= 256) {
+            std::vector<double> refRe, refIm;
+            naiveDft(originalRe.data(), originalIm.data(), n, 1, refRe, refIm);
+            CHECK(relativeError(re.data(), im.data(), refRe, refIm) < 1e-5);
+        }
+        plan.inverse(re.data(), im.data());
+        double worst = 0.0;
+        for (uint32_t i = 0; i < n; ++i) {
+            worst = std::max(worst, double(std::hypot(re[i] - originalRe[i], im[i] - originalIm[i])));
+        }
+        CHECK(worst < 1e-5);
+    }
+    CHECK(fftSize(1) == 1 && fftSize(3) == 4 && fftSize(64) == 64 && fftSize(65) == 128);
+}
+
+// The real-input 2D transform gives the full spectrum of the plane, on one
+// thread or several, and inverseReal2d undoes it
+TEST(fftReal2dMatchesDft) {
+    const uint32_t sizes[5][2] = { { 2, 2 }, { 8, 4 }, { 4, 16 }, { 32, 32 }, { 64, 8 } };
+    for (const auto& size : sizes) {
+        uint32_t width = size[0], height = size[1];
+        std::vector<float> plane = randomValues(size_t(width) * height, width * 7 + height, 0.0f, 255.0f);
+        std::vector<float> re(plane.size()), im(plane.size());
+        forwardReal2d(plane.data(), width, height, re.data(), im.data(), false);
+
+        std::vector<double> refRe, refIm;
+        naiveDft(plane.data(), nullptr, width, height, refRe, refIm);
+        CHECK(relativeError(re.data(), im.data(), refRe, refIm) < 1e-5);
+
+        std::vector<float> parallelRe(plane.size()), parallelIm(plane.size());
+        forwardReal2d(plane.data(), width, height, parallelRe.data(), parallelIm.data(), true);
+        CHECK(parallelRe == re && parallelIm == im);
+
+        std::vector<float> back(plane.size());
+        inverseReal2d(re.data(), im.data(), width, height, back.data(), false);
+        double worst = 0.0;
+        for (size_t i = 0; i < plane.size(); ++i) {
+            worst = std::max(worst, double(std::abs(back[i] - plane[i])));
+        }
+        CHECK(worst < 1e-3);
+    }
+}
+
+// Amount 0 leaves every pixel as it was, including images padded to a
+// power of two
+TEST(phaseScrambleZeroIsIdentity) {
+    const uint32_t sizes[3][2] = { { 64, 64 }, { 50, 30 }, { 1, 17 } };
+    for (const auto& size : sizes) {
+        std::vector<uint8_t> rgba = randomImage(size[0], size[1], size[0] + size[1]);
+        std::vector<uint8_t> original = rgba;
+        MatchImage image = { rgba.data(), size[0], size[1] };
+        CHECK(phaseScramble(image, 9, 0.0f) == 0);
+        CHECK(rgba == original);
+    }
+}
+
+// A seed always gives the same image, on one thread or several; another
+// seed gives another image. Each channel keeps its amplitude spectrum.
+TEST(phaseScrambleDeterministicPerSeed) {
+    const uint32_t width = 64, height = 32;
+    std::vector<uint8_t> original = smoothImage(width, height, 0.1);
+
+    std::vector<uint8_t> first = original, second = original, single = original, other = original;
+    MatchImage a = { first.data(), width, height }, b = { second.data(), width, height };
+    MatchImage c = { single.data(), width, height }, d = { other.data(), width, height };
+    size_t clipped = phaseScramble(a, 5, 1.0f);
+    CHECK(phaseScramble(b, 5, 1.0f) == clipped);
+    phaseScramble(c, 5, 1.0f, false);
+    phaseScramble(d, 6, 1.0f);
+    CHECK(first == second);
+    CHECK(first == single);
+    CHECK(first != other);
+    CHECK(first != original);
+
+    // Scrambled structure stays within [0, 255] here, so only rounding to
+    // codes, spread over every bin, separates the spectra
+    CHECK(clipped == 0);
+    for (int channel = 0; channel < 3; ++channel) {
+        double distance = spectrumDistance(amplitudeSpectrum(original, width, height, channel),
+                                           amplitudeSpectrum(first, width, height, channel));
+        CHECK(distance < 0.15);
+    }
+
+    // Half the amount lands in between
+    std::vector<uint8_t> half = original;
+    MatchImage h = { half.data(), width, height };
+    phaseScramble(h, 5, 0.5f);
+    CHECK(half != original && half != first);
+}
+
+// Every image leaves with the average luminance amplitude spectrum of the
+// set, its own phase and no color
+TEST(matchSpectraEqualizesAmplitude) {
+    const uint32_t width = 32, height = 32;
+    std::vector<std::vector<uint8_t>> pixels = { smoothImage(width, height, 0.0), smoothImage(width, height, 0.3),
+                                                 randomImage(width, height, 3, 96, 160) };
+    std::vector<MatchImage> images;
+    for (std::vector<uint8_t>& rgba : pixels) {
+        images.push_back({ rgba.data(), width, height });
+    }
+
+    std::vector<std::vector<double>> before;
+    for (const std::vector<uint8_t>& rgba : pixels) {
+        before.push_back(amplitudeSpectrum(rgba, width, height, 3));
+    }
+    std::vector<double> average(before[0].size(), 0.0);
+    for (const std::vector<double>& spectrum : before) {
+        for (size_t k = 0; k < average.size(); ++k) {
+            average[k] += spectrum[k] / before.size();
+        }
+    }
+
+    size_t clipped = 1;
+    CHECK(matchSpectra(images.data(), images.size(), &clipped));
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        std::vector<double> after = amplitudeSpectrum(pixels[i], width, height, 3);
+        CHECK(spectrumDistance(after, average) < 0.1);
+        CHECK(spectrumDistance(before[i], average) > 0.5);
+        bool gray = true;
+        for (size_t p = 0; p < size_t(width) * height; ++p) {
+            gray = gray && pixels[i][p * 4] == pixels[i][p * 4 + 1] && pixels[i][p * 4] == pixels[i][p * 4 + 2];
+        }
+        CHECK(gray);
+    }
+
+    // A single gray image already has the average spectrum
+    std::vector<uint8_t> gray(size_t(width) * height * 4);
+    std::vector<uint8_t> source = randomImage(width, height, 8);
+    for (size_t p = 0; p < size_t(width) * height; ++p) {
+        std::fill(&gray[p * 4], &gray[p * 4 + 3], source[p * 4]);
+        gray[p * 4 + 3] = 255;
+    }
+    std::vector<uint8_t> grayOriginal = gray;
+    MatchImage alone = { gray.data(), width, height };
+    CHECK(matchSpectra(&alone, 1, &clipped));
+    CHECK(gray == grayOriginal && clipped == 0);
+
+    // Sizes must agree
+    std::vector<uint8_t> smaller = randomImage(16, 32, 4);
+    MatchImage mismatched[2] = { images[0], { smaller.data(), 16, 32 } };
+    CHECK(!matchSpectra(mismatched, 2));
+}
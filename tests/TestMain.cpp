@@ -0,0 +1,47 @@
+#include "Check.h"
+
+#include <cstring>
+
+// Usage: nativeTests [--bench] [filter]
+// Runs every TEST (or with --bench every BENCH) whose name contains filter.
+
+std::vector<TestCase>& testCases() {
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+static int failures = 0;
+
+void checkFailed(const char* file, int line, const char* expression) {
+    std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, expression);
+    failures++;
+}
+
+int main(int argc, char** argv) {
+    bool bench = false;
+    const char* filter = "";
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--bench") == 0) {
+            bench = true;
+        } else {
+            filter = argv[i];
+        }
+    }
+
+    int ran = 0;
+    for (const TestCase& test : testCases()) {
+        if (test.bench != bench || !std::strstr(test.name, filter)) {
+            continue;
+        }
+        int before = failures;
+        std::printf("[ RUN  ] %s\n", test.name);
+        test.run();
+        std::printf("[ %s ] %s\n", failures == before ? " OK " : "FAIL", test.name);
+        ran++;
+    }
+    if (ran == 0) {
+        std::fprintf(stderr, "No %s matches '%s'\n", bench ? "benchmark" : "test", filter);
+        return 1;
+    }
+    return failures == 0 ? 0 : 1;
+}
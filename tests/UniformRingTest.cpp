@@ -0,0 +1,132 @@
+#include "Check.h"
+
+#include <cstring>
+
+#include "UniformRing.h"
+
+// Frames of one 256- or 512-byte block in a 1.5 KiB ring, with the GPU one
+// frame behind: the ring wraps every few frames, sometimes with head
+// exactly at the end of the buffer and nothing to skip.
+TEST(uniformRingWraps) {
+    wgpu::Device device;
+    wgpu::Queue queue;
+    UniformRing ring;
+    ring.init(device, 1536);
+
+    uint32_t wraps = 0;
+    uint32_t previous = 0;
+    for (uint32_t frame = 0; frame < 64; ++frame) {
+        uint32_t size = frame % 2 ? 300 : 16;
+        UniformRing::Allocation alloc = ring.allocate(size);
+        CHECK(alloc.data != nullptr);
+        if (!alloc.data) {
+            return;
+        }
+        CHECK(alloc.offset % UniformRing::kAlignment == 0);
+        CHECK(alloc.offset + size <= ring.capacity());
+        if (frame > 0 && alloc.offset < previous) {
+            wraps++;
+        }
+        previous = alloc.offset;
+        std::memcpy(alloc.data, &frame, sizeof(frame));
+        ring.flush(queue);
+        ring.submitted(queue);
+        CHECK(ring.used() <= ring.capacity());
+
+        // The GPU finishes a frame one frame late
+        if (queue.gpu->pending.size() > 1) {
+            queue.gpu->completeOldest();
+        }
+    }
+    while (queue.gpu->completeOldest()) {
+    }
+    CHECK(wraps >= 10);
+    CHECK(ring.used() == 0);
+}
+
+// Frames of 3 to 5 blocks in the 64 KiB ring main() sets up, with the GPU
+// two frames behind: frames regularly span the end of the buffer, every
+// block is still granted, and each lands in the GPU buffer at its offset
+TEST(uniformRingMultiBlockFrames) {
+    wgpu::Device device;
+    wgpu::Queue queue;
+    UniformRing ring;
+    ring.init(device, 64 * 1024);
+
+    const uint32_t sizes[5] = { 80, 64, 48, 300, 16 };
+    uint32_t failures = 0, splitFrames = 0;
+    for (uint32_t frame = 0; frame < 1000; ++frame) {
+        uint32_t blocks = 3 + frame % 3;
+        uint32_t offsets[5];
+        for (uint32_t b = 0; b < blocks; ++b) {
+            UniformRing::Allocation alloc = ring.allocate(sizes[b]);
+            if (!alloc.data) {
+                failures++;
+                offsets[b] = UniformRing::kInvalidOffset;
+                continue;
+            }
+            CHECK(alloc.offset + sizes[b] <= ring.capacity());
+            uint32_t tag = frame * 8 + b;
+            std::memcpy(alloc.data, &tag, sizeof(tag));
+            offsets[b] = alloc.offset;
+        }
+        for (uint32_t b = 1; b < blocks; ++b) {
+            splitFrames += offsets[b] < offsets[b - 1];
+        }
+        uint64_t writesBefore = queue.gpu->writes;
+        ring.flush(queue);
+        CHECK(queue.gpu->writes - writesBefore <= 2);
+        ring.submitted(queue);
+        for (uint32_t b = 0; b < blocks; ++b) {
+            if (offsets[b] == UniformRing::kInvalidOffset) {
+                continue;
+            }
+            uint32_t uploaded = 0;
+            std::memcpy(&uploaded, ring.buffer().memory->data() + offsets[b], sizeof(uploaded));
+            CHECK(uploaded == frame * 8 + b);
+        }
+        if (queue.gpu->pending.size() > 2) {
+            queue.gpu->completeOldest();
+        }
+    }
+    CHECK(failures == 0);
+    CHECK(splitFrames >= 5);
+}
+
+// Blocks written before a wrap land in the GPU buffer at their offsets
+TEST(uniformRingUploadsAtOffsets) {
+    wgpu::Device device;
+    wgpu::Queue queue;
+    UniformRing ring;
+    ring.init(device, 768);
+
+    for (uint32_t frame = 0; frame < 12; ++frame) {
+        uint32_t offset = ring.push(frame);
+        CHECK(offset != UniformRing::kInvalidOffset);
+        ring.flush(queue);
+        ring.submitted(queue);
+        uint32_t uploaded = 0;
+        std::memcpy(&uploaded, ring.buffer().memory->data() + offset, sizeof(uploaded));
+        CHECK(uploaded == frame);
+        queue.gpu->completeOldest();
+    }
+}
+
+// A ring whose frames are never completed fills up and refuses blocks
+// instead of handing out memory past its end
+TEST(uniformRingFull) {
+    wgpu::Device device;
+    wgpu::Queue queue;
+    UniformRing ring;
+    ring.init(device, 1024);
+
+    uint32_t granted = 0;
+    for (uint32_t frame = 0; frame < 8; ++frame) {
+        if (ring.allocate(16).data) {
+            granted++;
+        }
+        ring.submitted(queue);
+    }
+    CHECK(granted == 4);
+    CHECK(ring.used() == ring.capacity());
+}
@@ -0,0 +1,173 @@
+#include "Check.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Noise.h"
+#include "VideoRecorder.h"
+
+// nativeTests covers the scalar conversion, nativeSimdTests the wasm SIMD
+// one, against the same reference.
+
+namespace {
+
+struct Planes {
+    std::vector<uint8_t> y, u, v;
+
+    Planes(uint32_t width, uint32_t height)
+        : y(size_t(width) * height), u(size_t((width + 1) / 2) * ((height + 1) / 2)), v(u.size()) {}
+};
+
+std::vector<uint8_t> noiseImage(uint32_t width, uint32_t height, uint32_t seed) {
+    std::vector<uint8_t> rgba(size_t(width) * height * 4);
+    for (size_t p = 0; p < size_t(width) * height; ++p) {
+        NoiseHash h = noiseHash(uint32_t(p), seed, 0, 44);
+        rgba[p * 4] = uint8_t(h.x >> 24);
+        rgba[p * 4 + 1] = uint8_t(h.y >> 24);
+        rgba[p * 4 + 2] = uint8_t(h.z >> 24);
+        rgba[p * 4 + 3] = 255;
+    }
+    return rgba;
+}
+
+// BT.709 limited range in double precision
+double refLuma(double r, double g, double b) {
+    return 16.0 + 219.0 / 255.0 * (0.2126 * r + 0.7152 * g + 0.0722 * b);
+}
+
+double refU(double r, double g, double b) {
+    return 128.0 + 224.0 / 255.0 * (b - (0.2126 * r + 0.7152 * g + 0.0722 * b)) / 1.8556;
+}
+
+double refV(double r, double g, double b) {
+    return 128.0 + 224.0 / 255.0 * (r - (0.2126 * r + 0.7152 * g + 0.0722 * b)) / 1.5748;
+}
+
+// Largest difference from the reference, with chroma from the mean of each
+// 2x2 block (centre siting, as C420jpeg declares) and edges repeated
+int maxError(const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height, const Planes& planes) {
+    int worst = 0;
+    auto at = [&](uint32_t x, uint32_t y, int c) { return double(rgba[(size_t(y) * width + x) * 4 + c]); };
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            double expected = refLuma(at(x, y, 0), at(x, y, 1), at(x, y, 2));
+            worst = std::max(worst, int(std::abs(planes.y[size_t(y) * width + x] - expected) + 0.5));
+        }
+    }
+    uint32_t chromaWidth = (width + 1) / 2;
+    for (uint32_t cy = 0; cy < (height + 1) / 2; ++cy) {
+        for (uint32_t cx = 0; cx < chromaWidth; ++cx) {
+            uint32_t x0 = cx * 2, x1 = std::min(x0 + 1, width - 1);
+            uint32_t y0 = cy * 2, y1 = std::min(y0 + 1, height - 1);
+            double mean[3];
+            for (int c = 0; c < 3; ++c) {
+                mean[c] = (at(x0, y0, c) + at(x1, y0, c) + at(x0, y1, c) + at(x1, y1, c)) / 4.0;
+            }
+            size_t i = size_t(cy) * chromaWidth + cx;
+            worst = std::max(worst, int(std::abs(planes.u[i] - refU(mean[0], mean[1], mean[2])) + 0.5));
+            worst = std::max(worst, int(std::abs(planes.v[i] - refV(mean[0], mean[1], mean[2])) + 0.5));
+        }
+    }
+    return worst;
+}
+
+} // namespace
+
+TEST(videoYuvColours) {
+    const uint8_t colours[5][3] = { { 0, 0, 0 }, { 255, 255, 255 }, { 255, 0, 0 }, { 0, 255, 0 }, { 0, 0, 255 } };
+    for (const auto& colour : colours) {
+        std::vector<uint8_t> rgba(4 * 4 * 4);
+        for (size_t p = 0; p < 16; ++p) {
+            std::copy(colour, colour + 3, &rgba[p * 4]);
+            rgba[p * 4 + 3] = 255;
+        }
+        Planes planes(4, 4);
+        rgbaToYuv420(rgba.data(), 4, 4, planes.y.data(), planes.u.data(), planes.v.data());
+        CHECK(std::abs(planes.y[0] - refLuma(colour[0], colour[1], colour[2])) <= 1.0);
+        CHECK(std::abs(planes.u[0] - refU(colour[0], colour[1], colour[2])) <= 1.0);
+        CHECK(std::abs(planes.v[0] - refV(colour[0], colour[1], colour[2])) <= 1.0);
+    }
+    // Limited range end points
+    std::vector<uint8_t> white(4, 255);
+    Planes planes(1, 1);
+    rgbaToYuv420(white.data(), 1, 1, planes.y.data(), planes.u.data(), planes.v.data());
+    CHECK(planes.y[0] == 235 && planes.u[0] == 128 && planes.v[0] == 128);
+}
+
+// Noise at even and odd sizes, including single rows and columns and a
+// 1080p frame that is split over row pairs
+TEST(videoYuvMatchesReference) {
+    const uint32_t sizes[6][2] = { { 16, 16 }, { 17, 9 }, { 1, 1 }, { 1, 7 }, { 33, 1 }, { 1920, 1080 } };
+    for (const auto& size : sizes) {
+        std::vector<uint8_t> rgba = noiseImage(size[0], size[1], size[0] * 31 + size[1]);
+        Planes planes(size[0], size[1]);
+        rgbaToYuv420(rgba.data(), size[0], size[1], planes.y.data(), planes.u.data(), planes.v.data());
+        CHECK(maxError(rgba, size[0], size[1], planes) <= 1);
+    }
+}
+
+// Convert, queue and write 1080p frames paced at 144 Hz, as the capture
+// worker hands them over. addFrame() converts on the calling thread, so a
+// frame that returns after the next vsync would back up the capture ring in
+// the browser; those are counted as late alongside the recorder's own drops.
+// The unpaced run gives the throughput ceiling, and convert alone shows how
+// much of it the conversion takes.
+BENCH(videoRecord1080pAt144Hz) {
+    std::string path = (std::filesystem::temp_directory_path() / "flasher-bench.y4m").string();
+    FrameCapture::Frame frame;
+    frame.width = 1920;
+    frame.height = 1080;
+    frame.rgba = noiseImage(frame.width, frame.height, 1);
+    const uint32_t frames = 288;
+    const double period = 1000.0 / 144.0;
+
+    Planes planes(frame.width, frame.height);
+    double convertMs = elapsedMs([&] {
+        for (uint32_t i = 0; i < frames / 4; ++i) {
+            rgbaToYuv420(frame.rgba.data(), frame.width, frame.height, planes.y.data(), planes.u.data(),
+                         planes.v.data());
+        }
+    }) / (frames / 4);
+    std::printf("  convert  %6.2f ms per frame (%6.1f fps)\n", convertMs, 1000.0 / convertMs);
+
+    for (bool paced : { true, false }) {
+        VideoRecorder recorder;
+        CHECK(recorder.start(path.c_str(), VideoRecorder::Container::Y4m, frame.width, frame.height, 144.0));
+        uint32_t late = 0;
+        auto start = std::chrono::steady_clock::now();
+        auto vsync = [&](uint32_t i) { return start + std::chrono::microseconds(uint64_t(i * period * 1000.0)); };
+        double ms = elapsedMs([&] {
+            for (uint32_t i = 0; i < frames; ++i) {
+                if (paced) {
+                    std::this_thread::sleep_until(vsync(i));
+                }
+                frame.frameIndex = i;
+                frame.vsyncTime = i * period;
+                recorder.addFrame(frame);
+                late += paced && std::chrono::steady_clock::now() > vsync(i + 1);
+            }
+            recorder.stop();
+            while (recorder.active()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+        VideoRecorder::Stats stats = recorder.stats();
+        std::printf("  %-8s %u frames in %7.1f ms (%6.1f fps), %llu recorded, %llu dropped, %u late, "
+                    "%.1f MB written\n",
+                    paced ? "144 Hz" : "unpaced", frames, ms, 1000.0 * frames / ms,
+                    static_cast<unsigned long long>(stats.recorded), static_cast<unsigned long long>(stats.dropped),
+                    late, stats.bytesWritten / 1e6);
+        if (paced) {
+            std::printf("  1080p at 144 Hz without drops: %s (%u threads)\n",
+                        stats.dropped == 0 && late == 0 ? "yes" : "no", std::thread::hardware_concurrency());
+        }
+        CHECK(stats.recorded + stats.dropped == frames);
+    }
+    std::filesystem::remove(path);
+    std::filesystem::remove(path + ".timestamps");
+}
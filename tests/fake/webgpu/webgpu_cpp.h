@@ -0,0 +1,323 @@
+#pragma once
+
+// Just enough of webgpu_cpp.h for the native tests to build the CPU-side
+// bookkeeping of GPU helpers (UniformRing, FrameCapture, FrameHasher,
+// RenderGraph with its TexturePool and GpuCache). Buffers and textures are
+// host memory, writes and copies land in them immediately, and work-done
+// and map callbacks wait until the test completes them with
+// FakeGpu::completeOldest() and FakeGpu::completeOldestMap().
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <vector>
+
+enum WGPUQueueWorkDoneStatus : uint32_t {
+    WGPUQueueWorkDoneStatus_Success = 0,
+    WGPUQueueWorkDoneStatus_Error = 1,
+};
+typedef void (*WGPUQueueWorkDoneCallback)(WGPUQueueWorkDoneStatus status, void* userdata);
+
+enum WGPUBufferMapAsyncStatus : uint32_t {
+    WGPUBufferMapAsyncStatus_Success = 0,
+    WGPUBufferMapAsyncStatus_Error = 1,
+};
+typedef void (*WGPUBufferMapCallback)(WGPUBufferMapAsyncStatus status, void* userdata);
+
+namespace wgpu {
+
+enum class TextureFormat : uint32_t {
+    Undefined = 0,
+    R8Unorm = 1,
+    R16Float = 7,
+    RGBA8Unorm = 18,
+    BGRA8Unorm = 23,
+    RGBA16Float = 34,
+    RGBA32Float = 35,
+};
+
+enum class TextureUsage : uint32_t {
+    None = 0,
+    CopySrc = 1,
+    CopyDst = 2,
+    TextureBinding = 4,
+    StorageBinding = 8,
+    RenderAttachment = 16,
+};
+inline TextureUsage operator|(TextureUsage a, TextureUsage b) { return TextureUsage(uint32_t(a) | uint32_t(b)); }
+
+// Objects the helpers only pass around and compare by handle
+class Handle {
+public:
+    std::shared_ptr<int> object;
+
+    const void* Get() const { return object.get(); }
+    explicit operator bool() const { return object != nullptr; }
+};
+
+class TextureView : public Handle {};
+class Sampler : public Handle {};
+class BindGroupLayout : public Handle {};
+class BindGroup : public Handle {};
+
+// Tightly packed texels, 4 bytes each, filled in by the test
+class Texture {
+public:
+    std::shared_ptr<std::vector<uint8_t>> texels;
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    const void* Get() const { return texels.get(); }
+    explicit operator bool() const { return texels != nullptr; }
+    uint32_t GetWidth() const { return width; }
+    uint32_t GetHeight() const { return height; }
+    TextureView CreateView() const { return { { std::make_shared<int>() } }; }
+    void Destroy() const {}
+};
+
+enum class BufferUsage : uint32_t {
+    None = 0,
+    MapRead = 1,
+    CopySrc = 4,
+    CopyDst = 8,
+    Uniform = 64,
+    Storage = 128,
+};
+inline BufferUsage operator|(BufferUsage a, BufferUsage b) { return BufferUsage(uint32_t(a) | uint32_t(b)); }
+
+struct BufferDescriptor {
+    const char* label = nullptr;
+    BufferUsage usage = BufferUsage::None;
+    uint64_t size = 0;
+    bool mappedAtCreation = false;
+};
+
+enum class MapMode : uint32_t {
+    None = 0,
+    Read = 1,
+    Write = 2,
+};
+
+struct FakeGpu;
+
+class Buffer {
+public:
+    std::shared_ptr<std::vector<uint8_t>> memory;
+    std::shared_ptr<FakeGpu> gpu;
+    std::shared_ptr<bool> mapped = std::make_shared<bool>(false);
+
+    const void* Get() const { return memory.get(); }
+    explicit operator bool() const { return memory != nullptr; }
+    uint64_t GetSize() const { return memory ? memory->size() : 0; }
+    inline void MapAsync(MapMode mode, size_t offset, size_t size, WGPUBufferMapCallback callback,
+                         void* userdata) const;
+    const void* GetConstMappedRange(size_t offset, size_t) const {
+        return *mapped ? memory->data() + offset : nullptr;
+    }
+    void Unmap() const { *mapped = false; }
+    void Destroy() const {}
+};
+
+struct FakeGpu {
+    struct Pending {
+        WGPUQueueWorkDoneCallback callback;
+        void* userdata;
+    };
+    struct PendingMap {
+        Buffer buffer;
+        WGPUBufferMapCallback callback;
+        void* userdata;
+    };
+    std::deque<Pending> pending;
+    std::deque<PendingMap> maps;
+    uint64_t writes = 0;
+
+    // Map the buffer of the oldest outstanding MapAsync and fire its
+    // callback; false if none
+    bool completeOldestMap(WGPUBufferMapAsyncStatus status = WGPUBufferMapAsyncStatus_Success) {
+        if (maps.empty()) {
+            return false;
+        }
+        PendingMap done = maps.front();
+        maps.pop_front();
+        *done.buffer.mapped = status == WGPUBufferMapAsyncStatus_Success;
+        done.callback(status, done.userdata);
+        return true;
+    }
+
+    // Fire the oldest outstanding work-done callback; false if none
+    bool completeOldest() {
+        if (pending.empty()) {
+            return false;
+        }
+        Pending done = pending.front();
+        pending.pop_front();
+        done.callback(WGPUQueueWorkDoneStatus_Success, done.userdata);
+        return true;
+    }
+};
+
+inline void Buffer::MapAsync(MapMode, size_t, size_t, WGPUBufferMapCallback callback, void* userdata) const {
+    gpu->maps.push_back({ *this, callback, userdata });
+}
+
+struct Extent3D {
+    uint32_t width = 0;
+    uint32_t height = 1;
+    uint32_t depthOrArrayLayers = 1;
+};
+
+struct TextureDescriptor {
+    const char* label = nullptr;
+    TextureUsage usage = TextureUsage::None;
+    Extent3D size;
+    TextureFormat format = TextureFormat::Undefined;
+    uint32_t mipLevelCount = 1;
+    uint32_t sampleCount = 1;
+};
+
+enum class AddressMode : uint32_t { ClampToEdge = 0 };
+enum class FilterMode : uint32_t { Nearest = 0, Linear = 1 };
+enum class MipmapFilterMode : uint32_t { Nearest = 0, Linear = 1 };
+enum class CompareFunction : uint32_t { Undefined = 0 };
+enum class ShaderStage : uint32_t { None = 0 };
+enum class BufferBindingType : uint32_t { Undefined = 0 };
+enum class SamplerBindingType : uint32_t { Undefined = 0 };
+enum class TextureSampleType : uint32_t { Undefined = 0 };
+enum class TextureViewDimension : uint32_t { Undefined = 0 };
+enum class StorageTextureAccess : uint32_t { Undefined = 0 };
+
+struct SamplerDescriptor {
+    const char* label = nullptr;
+    AddressMode addressModeU = AddressMode::ClampToEdge;
+    AddressMode addressModeV = AddressMode::ClampToEdge;
+    AddressMode addressModeW = AddressMode::ClampToEdge;
+    FilterMode magFilter = FilterMode::Nearest;
+    FilterMode minFilter = FilterMode::Nearest;
+    MipmapFilterMode mipmapFilter = MipmapFilterMode::Nearest;
+    float lodMinClamp = 0.0f;
+    float lodMaxClamp = 32.0f;
+    CompareFunction compare = CompareFunction::Undefined;
+    uint16_t maxAnisotropy = 1;
+};
+
+struct BindGroupLayoutEntry {
+    uint32_t binding = 0;
+    ShaderStage visibility = ShaderStage::None;
+    struct {
+        BufferBindingType type = BufferBindingType::Undefined;
+        bool hasDynamicOffset = false;
+        uint64_t minBindingSize = 0;
+    } buffer;
+    struct {
+        SamplerBindingType type = SamplerBindingType::Undefined;
+    } sampler;
+    struct {
+        TextureSampleType sampleType = TextureSampleType::Undefined;
+        TextureViewDimension viewDimension = TextureViewDimension::Undefined;
+        bool multisampled = false;
+    } texture;
+    struct {
+        StorageTextureAccess access = StorageTextureAccess::Undefined;
+        TextureFormat format = TextureFormat::Undefined;
+        TextureViewDimension viewDimension = TextureViewDimension::Undefined;
+    } storageTexture;
+};
+
+struct BindGroupLayoutDescriptor {
+    const char* label = nullptr;
+    size_t entryCount = 0;
+    const BindGroupLayoutEntry* entries = nullptr;
+};
+
+struct BindGroupEntry {
+    uint32_t binding = 0;
+    Buffer buffer;
+    uint64_t offset = 0;
+    uint64_t size = 0;
+    Sampler sampler;
+    TextureView textureView;
+};
+
+struct BindGroupDescriptor {
+    const char* label = nullptr;
+    BindGroupLayout layout;
+    size_t entryCount = 0;
+    const BindGroupEntry* entries = nullptr;
+};
+
+struct ImageCopyTexture {
+    Texture texture;
+};
+
+struct TextureDataLayout {
+    uint64_t offset = 0;
+    uint32_t bytesPerRow = 0;
+    uint32_t rowsPerImage = 0;
+};
+
+struct ImageCopyBuffer {
+    TextureDataLayout layout;
+    Buffer buffer;
+};
+
+class CommandEncoder {
+public:
+    void ClearBuffer(const Buffer& buffer, uint64_t offset, uint64_t size) const {
+        std::memset(buffer.memory->data() + offset, 0, size);
+    }
+    void CopyBufferToBuffer(const Buffer& source, uint64_t sourceOffset, const Buffer& destination,
+                            uint64_t destinationOffset, uint64_t size) const {
+        std::memcpy(destination.memory->data() + destinationOffset, source.memory->data() + sourceOffset, size);
+    }
+    void CopyTextureToBuffer(const ImageCopyTexture* source, const ImageCopyBuffer* destination,
+                             const Extent3D* size) const {
+        const Texture& texture = source->texture;
+        for (uint32_t y = 0; y < size->height; ++y) {
+            std::memcpy(destination->buffer.memory->data() + destination->layout.offset +
+                            size_t(y) * destination->layout.bytesPerRow,
+                        texture.texels->data() + size_t(y) * texture.width * 4, size_t(size->width) * 4);
+        }
+    }
+};
+
+class Queue {
+public:
+    std::shared_ptr<FakeGpu> gpu = std::make_shared<FakeGpu>();
+
+    void WriteBuffer(const Buffer& buffer, uint64_t offset, const void* data, size_t size) const {
+        std::memcpy(buffer.memory->data() + offset, data, size);
+        gpu->writes++;
+    }
+    void OnSubmittedWorkDone(WGPUQueueWorkDoneCallback callback, void* userdata) const {
+        gpu->pending.push_back({ callback, userdata });
+    }
+};
+
+class Device {
+public:
+    std::shared_ptr<FakeGpu> gpu = std::make_shared<FakeGpu>();
+
+    Buffer CreateBuffer(const BufferDescriptor* desc) const {
+        Buffer buffer;
+        buffer.memory = std::make_shared<std::vector<uint8_t>>(desc->size);
+        buffer.gpu = gpu;
+        return buffer;
+    }
+    Texture CreateTexture(const TextureDescriptor* desc) const {
+        Texture texture;
+        texture.width = desc->size.width;
+        texture.height = desc->size.height;
+        texture.texels = std::make_shared<std::vector<uint8_t>>(size_t(texture.width) * texture.height * 4);
+        return texture;
+    }
+    Sampler CreateSampler(const SamplerDescriptor*) const { return { { std::make_shared<int>() } }; }
+    BindGroupLayout CreateBindGroupLayout(const BindGroupLayoutDescriptor*) const {
+        return { { std::make_shared<int>() } };
+    }
+    BindGroup CreateBindGroup(const BindGroupDescriptor*) const { return { { std::make_shared<int>() } }; }
+};
+
+} // namespace wgpu
@@ -0,0 +1,341 @@
+#pragma once
+
+// Lane-by-lane stand-in for the wasm SIMD intrinsics the modules use, so the
+// native tests can build their SIMD paths too (nativeSimdTests). Only the
+// results follow the wasm spec, not the speed. Intrinsics are added here as
+// modules start using them.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+struct v128_t {
+    alignas(16) uint8_t bytes[16];
+};
+
+namespace wasm_simd_detail {
+
+template <typename T>
+struct Lanes {
+    static constexpr int count = 16 / sizeof(T);
+    T lane[count];
+
+    Lanes() = default;
+    explicit Lanes(const v128_t& v) { std::memcpy(lane, v.bytes, 16); }
+
+    v128_t get() const {
+        v128_t v;
+        std::memcpy(v.bytes, lane, 16);
+        return v;
+    }
+};
+
+template <typename T, typename Op>
+v128_t map(v128_t a, Op op) {
+    Lanes<T> x(a), r;
+    for (int i = 0; i < Lanes<T>::count; ++i) {
+        r.lane[i] = op(x.lane[i]);
+    }
+    return r.get();
+}
+
+template <typename T, typename Op>
+v128_t map(v128_t a, v128_t b, Op op) {
+    Lanes<T> x(a), y(b), r;
+    for (int i = 0; i < Lanes<T>::count; ++i) {
+        r.lane[i] = op(x.lane[i], y.lane[i]);
+    }
+    return r.get();
+}
+
+// All ones where the comparison holds, as the wasm comparisons return
+template <typename T, typename Mask, typename Op>
+v128_t compare(v128_t a, v128_t b, Op op) {
+    Lanes<T> x(a), y(b);
+    Lanes<Mask> r;
+    for (int i = 0; i < Lanes<T>::count; ++i) {
+        r.lane[i] = op(x.lane[i], y.lane[i]) ? Mask(~Mask(0)) : Mask(0);
+    }
+    return r.get();
+}
+
+template <typename To, typename From>
+To saturate(From v) {
+    return To(std::clamp<From>(v, From(std::numeric_limits<To>::min()), From(std::numeric_limits<To>::max())));
+}
+
+// f32x4.min/max: NaN if either lane is NaN, and -0 below +0
+inline float minLane(float a, float b) {
+    if (std::isnan(a) || std::isnan(b)) {
+        return std::numeric_limits<float>::quiet_NaN();
+    }
+    if (a == b) {
+        return std::signbit(a) ? a : b;
+    }
+    return a < b ? a : b;
+}
+
+inline float maxLane(float a, float b) {
+    if (std::isnan(a) || std::isnan(b)) {
+        return std::numeric_limits<float>::quiet_NaN();
+    }
+    if (a == b) {
+        return std::signbit(a) ? b : a;
+    }
+    return a > b ? a : b;
+}
+
+} // namespace wasm_simd_detail
+
+// Loads, stores and construction
+
+inline v128_t wasm_v128_load(const void* memory) {
+    v128_t v;
+    std::memcpy(v.bytes, memory, 16);
+    return v;
+}
+
+inline void wasm_v128_store(void* memory, v128_t v) {
+    std::memcpy(memory, v.bytes, 16);
+}
+
+inline void wasm_v128_store32_lane(void* memory, v128_t v, int lane) {
+    std::memcpy(memory, v.bytes + lane * 4, 4);
+}
+
+inline void wasm_v128_store64_lane(void* memory, v128_t v, int lane) {
+    std::memcpy(memory, v.bytes + lane * 8, 8);
+}
+
+inline v128_t wasm_i32x4_make(int32_t c0, int32_t c1, int32_t c2, int32_t c3) {
+    wasm_simd_detail::Lanes<int32_t> r;
+    r.lane[0] = c0;
+    r.lane[1] = c1;
+    r.lane[2] = c2;
+    r.lane[3] = c3;
+    return r.get();
+}
+
+inline v128_t wasm_i32x4_splat(int32_t a) {
+    return wasm_i32x4_make(a, a, a, a);
+}
+
+inline v128_t wasm_f32x4_splat(float a) {
+    wasm_simd_detail::Lanes<float> r;
+    std::fill(r.lane, r.lane + 4, a);
+    return r.get();
+}
+
+inline v128_t wasm_f64x2_splat(double a) {
+    wasm_simd_detail::Lanes<double> r;
+    r.lane[0] = r.lane[1] = a;
+    return r.get();
+}
+
+// Lanes 0-3 pick from a, 4-7 from b
+inline v128_t wasm_i32x4_shuffle(v128_t a, v128_t b, int c0, int c1, int c2, int c3) {
+    wasm_simd_detail::Lanes<uint32_t> x(a), y(b), r;
+    const int picks[4] = { c0, c1, c2, c3 };
+    for (int i = 0; i < 4; ++i) {
+        r.lane[i] = picks[i] < 4 ? x.lane[picks[i]] : y.lane[picks[i] - 4];
+    }
+    return r.get();
+}
+
+// Bitwise
+
+inline v128_t wasm_v128_and(v128_t a, v128_t b) {
+    return wasm_simd_detail::map<uint8_t>(a, b, [](uint8_t x, uint8_t y) { return uint8_t(x & y); });
+}
+
+inline v128_t wasm_v128_or(v128_t a, v128_t b) {
+    return wasm_simd_detail::map<uint8_t>(a, b, [](uint8_t x, uint8_t y) { return uint8_t(x | y); });
+}
+
+inline v128_t wasm_v128_xor(v128_t a, v128_t b) {
+    return wasm_simd_detail::map<uint8_t>(a, b, [](uint8_t x, uint8_t y) { return uint8_t(x ^ y); });
+}
+
+// a & ~b
+inline v128_t wasm_v128_andnot(v128_t a, v128_t b) {
+    return wasm_simd_detail::map<uint8_t>(a, b, [](uint8_t x, uint8_t y) { return uint8_t(x & ~y); });
+}
+
+// Bits of a where mask is set, of b elsewhere
+inline v128_t wasm_v128_bitselect(v128_t a, v128_t b, v128_t mask) {
+    return wasm_v128_or(wasm_v128_and(a, mask), wasm_v128_andnot(b, mask));
+}
+
+// Integer arithmetic; shifts take the count modulo the lane width
+
+inline v128_t wasm_i8x16_sub(v128_t a, v128_t b) {
+    return wasm_simd_detail::map<uint8_t>(a, b, [](uint8_t x, uint8_t y) { return uint8_t(x - y); });
+}
+
+inline v128_t wasm_u8x16_sub_sat(v128_t a, v128_t b) {
+    return wasm_simd_detail::map<uint8_t>(a, b, [](uint8_t x, uint8_t y) { return uint8_t(x > y ? x - y : 0); });
+}
+
+inline v128_t wasm_u8x16_max(v128_t a, v128_t b) {
+    return wasm_simd_detail::map<uint8_t>(a, b, [](uint8_t x, uint8_t y) { return std::max(x, y); });
+}
+
+inline v128_t wasm_i32x4_add(v128_t a, v128_t b) {
+    return wasm_simd_detail::map<uint32_t>(a, b, [](uint32_t x, uint32_t y) { return x + y; });
+}
+
+inline v128_t wasm_i32x4_sub(v128_t a, v128_t b) {
+    return wasm_simd_detail::map<uint32_t>(a, b, [](uint32_t x, uint32_t y) { return x - y; });
+}
+
+inline v128_t wasm_i32x4_mul(v128_t a, v128_t b) {
+    return wasm_simd_detail::map<uint32_t>(a, b, [](uint32_t x, uint32_t y) { return x * y; });
+}
+
+inline v128_t wasm_i32x4_shr(v128_t a, uint32_t count) {
+    return wasm_simd_detail::map<int32_t>(a, [count](int32_t x) { return int32_t(x >> (count & 31)); });
+}
+
+inline v128_t wasm_u32x4_shr(v128_t a, uint32_t count) {
+    return wasm_simd_detail::map<uint32_t>(a, [count](uint32_t x) { return x >> (count & 31); });
+}
+
+inline v128_t wasm_i32x4_ne(v128_t a, v128_t b) {
+    return wasm_simd_detail::compare<uint32_t, uint32_t>(a, b, [](uint32_t x, uint32_t y) { return x != y; });
+}
+
+inline v128_t wasm_u32x4_ge(v128_t a, v128_t b) {
+    return wasm_simd_detail::compare<uint32_t, uint32_t>(a, b, [](uint32_t x, uint32_t y) { return x >= y; });
+}
+
+// Widening and narrowing
+
+inline v128_t wasm_u16x8_extmul_low_u8x16(v128_t a, v128_t b) {
+    wasm_simd_detail::Lanes<uint8_t> x(a), y(b);
+    wasm_simd_detail::Lanes<uint16_t> r;
+    for (int i = 0; i < 8; ++i) {
+        r.lane[i] = uint16_t(x.lane[i] * y.lane[i]);
+    }
+    return r.get();
+}
+
+inline v128_t wasm_u16x8_extmul_high_u8x16(v128_t a, v128_t b) {
+    wasm_simd_detail::Lanes<uint8_t> x(a), y(b);
+    wasm_simd_detail::Lanes<uint16_t> r;
+    for (int i = 0; i < 8; ++i) {
+        r.lane[i] = uint16_t(x.lane[i + 8] * y.lane[i + 8]);
+    }
+    return r.get();
+}
+
+inline v128_t wasm_u32x4_extadd_pairwise_u16x8(v128_t a) {
+    wasm_simd_detail::Lanes<uint16_t> x(a);
+    wasm_simd_detail::Lanes<uint32_t> r;
+    for (int i = 0; i < 4; ++i) {
+        r.lane[i] = uint32_t(x.lane[2 * i]) + x.lane[2 * i + 1];
+    }
+    return r.get();
+}
+
+// Signed lanes of a, then b, saturated to the unsigned range
+inline v128_t wasm_u8x16_narrow_i16x8(v128_t a, v128_t b) {
+    wasm_simd_detail::Lanes<int16_t> x(a), y(b);
+    wasm_simd_detail::Lanes<uint8_t> r;
+    for (int i = 0; i < 8; ++i) {
+        r.lane[i] = wasm_simd_detail::saturate<uint8_t>(x.lane[i]);
+        r.lane[i + 8] = wasm_simd_detail::saturate<uint8_t>(y.lane[i]);
+    }
+    return r.get();
+}
+
+inline v128_t wasm_u16x8_narrow_i32x4(v128_t a, v128_t b) {
+    wasm_simd_detail::Lanes<int32_t> x(a), y(b);
+    wasm_simd_detail::Lanes<uint16_t> r;
+    for (int i = 0; i < 4; ++i) {
+        r.lane[i] = wasm_simd_detail::saturate<uint16_t>(x.lane[i]);
+        r.lane[i + 4] = wasm_simd_detail::saturate<uint16_t>(y.lane[i]);
+    }
+    return r.get();
+}
+
+// Floating point
+
+inline v128_t wasm_f32x4_add(v128_t a, v128_t b) {
+    return wasm_simd_detail::map<float>(a, b, [](float x, float y) { return x + y; });
+}
+
+inline v128_t wasm_f32x4_sub(v128_t a, v128_t b) {
+    return wasm_simd_detail::map<float>(a, b, [](float x, float y) { return x - y; });
+}
+
+inline v128_t wasm_f32x4_mul(v128_t a, v128_t b) {
+    return wasm_simd_detail::map<float>(a, b, [](float x, float y) { return x * y; });
+}
+
+inline v128_t wasm_f32x4_min(v128_t a, v128_t b) {
+    return wasm_simd_detail::map<float>(a, b, wasm_simd_detail::minLane);
+}
+
+inline v128_t wasm_f32x4_max(v128_t a, v128_t b) {
+    return wasm_simd_detail::map<float>(a, b, wasm_simd_detail::maxLane);
+}
+
+inline v128_t wasm_f32x4_floor(v128_t a) {
+    return wasm_simd_detail::map<float>(a, [](float x) { return std::floor(x); });
+}
+
+// Round to nearest, ties to even
+inline v128_t wasm_f32x4_nearest(v128_t a) {
+    return wasm_simd_detail::map<float>(a, [](float x) { return std::nearbyint(x); });
+}
+
+inline v128_t wasm_f32x4_lt(v128_t a, v128_t b) {
+    return wasm_simd_detail::compare<float, uint32_t>(a, b, [](float x, float y) { return x < y; });
+}
+
+inline v128_t wasm_f32x4_convert_i32x4(v128_t a) {
+    wasm_simd_detail::Lanes<int32_t> x(a);
+    wasm_simd_detail::Lanes<float> r;
+    for (int i = 0; i < 4; ++i) {
+        r.lane[i] = float(x.lane[i]);
+    }
+    return r.get();
+}
+
+inline v128_t wasm_f32x4_convert_u32x4(v128_t a) {
+    wasm_simd_detail::Lanes<uint32_t> x(a);
+    wasm_simd_detail::Lanes<float> r;
+    for (int i = 0; i < 4; ++i) {
+        r.lane[i] = float(x.lane[i]);
+    }
+    return r.get();
+}
+
+// Truncated toward zero; NaN and negative lanes become 0, large ones the maximum
+inline v128_t wasm_u32x4_trunc_sat_f32x4(v128_t a) {
+    wasm_simd_detail::Lanes<float> x(a);
+    wasm_simd_detail::Lanes<uint32_t> r;
+    for (int i = 0; i < 4; ++i) {
+        float v = x.lane[i];
+        r.lane[i] = !(v > 0.0f) ? 0u : v >= 4294967296.0f ? 0xffffffffu : uint32_t(v);
+    }
+    return r.get();
+}
+
+inline v128_t wasm_f64x2_add(v128_t a, v128_t b) {
+    return wasm_simd_detail::map<double>(a, b, [](double x, double y) { return x + y; });
+}
+
+inline v128_t wasm_f64x2_mul(v128_t a, v128_t b) {
+    return wasm_simd_detail::map<double>(a, b, [](double x, double y) { return x * y; });
+}
+
+inline v128_t wasm_f64x2_promote_low_f32x4(v128_t a) {
+    wasm_simd_detail::Lanes<float> x(a);
+    wasm_simd_detail::Lanes<double> r;
+    r.lane[0] = x.lane[0];
+    r.lane[1] = x.lane[1];
+    return r.get();
+}